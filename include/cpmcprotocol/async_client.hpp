@@ -0,0 +1,146 @@
+#pragma once
+
+#include "cpmcprotocol/device.hpp"
+#include "cpmcprotocol/event_transport.hpp"
+#include "cpmcprotocol/session_config.hpp"
+#include "cpmcprotocol/task.hpp"
+#include "cpmcprotocol/value_codec.hpp"
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace cpmcprotocol {
+
+/// McAsyncClientの操作（co_awaitした時点で要求を開始し、完了するまでコルーチンを中断する）
+/// 完了したコルーチンはEventLoopのスレッドで再開する
+/// @tparam T 操作の結果の型（書き込みはvoid）
+template <typename T>
+class [[nodiscard]] AsyncOperation {
+public:
+    /// 完了通知で受け渡す値（voidの場合はstd::monostate）
+    using Value = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+    /// 完了通知（成功時はerrorがnullptr）
+    using Callback = std::function<void(std::exception_ptr error, Value value)>;
+
+    /// @param start 要求を開始し、完了時に渡されたコールバックを1回呼ぶ関数
+    explicit AsyncOperation(std::function<void(Callback)> start) : start_(std::move(start)) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> waiting) {
+        waiting_ = waiting;
+        start_([this](std::exception_ptr error, Value value) {
+            error_ = std::move(error);
+            value_.emplace(std::move(value));
+            if (suspended_) {
+                waiting_.resume();
+            }
+        });
+        // 開始中に完了した（送信前に失敗した）場合は中断しない
+        suspended_ = !value_.has_value();
+        return suspended_;
+    }
+
+    T await_resume() {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        if constexpr (!std::is_void_v<T>) {
+            return std::move(*value_);
+        }
+    }
+
+private:
+    std::function<void(Callback)> start_;
+    std::coroutine_handle<> waiting_;
+    bool suspended_ = false;
+    std::exception_ptr error_;
+    std::optional<Value> value_;
+};
+
+/// コルーチン（C++20）で使用する非同期MCクライアント
+/// EventLoop上のAsyncTcpTransportで通信し、操作はco_awaitで完了を待つ
+/// 操作を待つ間はスレッドを占有しないため、1つのEventLoopスレッドで多数の接続・多数の操作を同時に扱える
+///
+/// 要求の送信:
+/// - 4Eフレームでは応答を待たずにSessionConfig::max_in_flight件まで送信し、シリアル番号で応答を対応付ける
+///   3Eフレームは1件ずつ往復する。それを超える要求は操作の開始順に送信を待つ
+/// - 要求ごとのデッドライン（SessionConfig::timeout_250ms）を超えた操作はTransportTimeoutErrorで完了する
+///   （3Eフレームでは応答の対応が崩れるため接続を切断する）
+///
+/// スレッドモデル:
+/// - 接続・操作の開始・完了後のコルーチンの再開はすべてEventLoopのスレッドで行う
+///   （他のスレッドからはEventLoop::post()で開始する）
+/// - 操作を待っているコルーチンがある間にクライアントを破棄しないこと
+///
+/// 使用例:
+/// @code
+/// EventLoop loop;
+/// McAsyncClient client(loop);
+/// client.connect(config);
+///
+/// spawn([](McAsyncClient& client) -> Task<> {
+///     auto values = co_await client.readWords(makeDeviceRange("D100", 10));
+///     const std::vector<std::uint16_t> ack{values[0]};
+///     co_await client.writeWords(makeDeviceRange("D200", 1), ack);
+/// }(client));
+/// loop.run();
+/// @endcode
+class McAsyncClient {
+public:
+    /// イベントループに登録して使用する
+    /// @note loopはこのクライアントより長く生存すること
+    explicit McAsyncClient(EventLoop& loop);
+    ~McAsyncClient();
+
+    McAsyncClient(const McAsyncClient&) = delete;
+    McAsyncClient& operator=(const McAsyncClient&) = delete;
+
+    // ========================================
+    // 接続管理
+    // ========================================
+
+    /// PLCへの接続を開始する（確立はEventLoopが待ち、直後から操作を開始できる）
+    /// timeout_250msのデッドラインまでに確立しなければ、開始済みの操作はTransportTimeoutError/TransportErrorを送出する
+    /// （ホスト名の名前解決だけは呼び出したスレッドで待つ）
+    /// @throws TransportError 名前解決に失敗した場合、または接続がその場で拒否された場合
+    void connect(const SessionConfig& config);
+
+    /// 切断する（実行中・送信待ちの操作はTransportErrorで完了する）
+    void disconnect() noexcept;
+
+    bool isConnected() const noexcept;
+
+    /// 完了していない操作の要求フレーム数（送信済み＋送信待ち）
+    std::size_t pendingCount() const noexcept;
+
+    // ========================================
+    // 操作（意味と分割の動作はMcClientの同名関数と同じ）
+    // 引数の不正はstd::invalid_argument、通信エラーはTransportError、PLCエラーはstd::runtime_errorを
+    // co_awaitした箇所で送出する
+    // ========================================
+
+    AsyncOperation<std::vector<std::uint16_t>> readWords(const DeviceRange& range);
+    AsyncOperation<std::vector<std::uint16_t>> readWordArea(const DeviceAddress& head, std::size_t count);
+    AsyncOperation<std::vector<bool>> readBits(const DeviceRange& range);
+    AsyncOperation<std::vector<bool>> readBitArea(const DeviceAddress& head, std::size_t count);
+    AsyncOperation<void> writeWords(const DeviceRange& range, std::vector<std::uint16_t> values);
+    AsyncOperation<void> writeBits(const DeviceRange& range, std::vector<bool> values);
+    AsyncOperation<std::vector<DeviceValue>> randomRead(const DeviceReadPlan& plan);
+    AsyncOperation<std::vector<DeviceValue>> randomRead(const ResolvedReadPlan& plan);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace cpmcprotocol
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "cpmcprotocol/mc_client.hpp"
+#include "cpmcprotocol/session_config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace cpmcprotocol {
+
+/// 同じPLCへの複数接続のプール
+/// CPU/Ethernetユニットに設定した複数のオープンポート（同じポートへの複数接続も可）に1つずつ接続し、
+/// 要求を最も空いている接続（実行中の要求が最も少ない接続）に振り分ける
+/// 1接続あたりのスループットは往復時間で頭打ちになるため、大容量の範囲読み取り（readWordArea()/readBitArea()）は
+/// 範囲を接続数で分割し、各接続で並行して読み取る
+///
+/// スレッドモデル:
+/// - 要求のメンバ関数とacquire()はどのスレッドから呼んでもよい（各接続はMcClientとして多重化される）
+///   Leaseを保持したまま要求のメンバ関数やacquire()を呼んでもよい
+/// - connect()/disconnect()は実行中の要求と貸し出し中のLeaseの解放を待ってから行う
+///   （Leaseを保持したスレッドから呼ばないこと）
+///
+/// 使用例:
+/// @code
+/// SessionConfig config;
+/// config.host = "192.168.0.10";
+/// config.frame_type = FrameType::Frame4E;
+///
+/// McClientPool pool;
+/// pool.connect(config, {5010, 5011, 5012, 5013});
+///
+/// auto values = pool.readWordArea(makeDeviceAddress("ZR0"), 100000);  // 4接続で並行して読み取る
+///
+/// auto lease = pool.acquire();  // プールにない操作は接続を借りて行う
+/// lease->setCacheEnabled(true);
+/// @endcode
+class McClientPool {
+    struct Slot;
+    struct Impl;
+
+public:
+    /// 貸し出した接続（破棄すると返却する）
+    /// 貸し出し中はその接続の実行中の要求として数え、connect()/disconnect()は返却を待つ
+    /// （プールのロックは保持しない）
+    class Lease {
+    public:
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        McClient& operator*() const noexcept;
+        McClient* operator->() const noexcept;
+
+        /// プール内の接続の位置（connect()に渡したポートの順）
+        std::size_t index() const noexcept;
+
+    private:
+        friend class McClientPool;
+        Lease(Impl& pool, Slot& slot) noexcept;
+        void release() noexcept;
+
+        Impl* pool_ = nullptr;
+        Slot* slot_ = nullptr;
+    };
+
+    McClientPool();
+    ~McClientPool();
+
+    McClientPool(const McClientPool&) = delete;
+    McClientPool& operator=(const McClientPool&) = delete;
+
+    // ========================================
+    // 接続管理
+    // ========================================
+
+    /// portsの各ポートに1つずつ接続する（ポート以外の設定はconfigを共通で使用する）
+    /// 各ポートへの接続は並行して行う（McClient::connectAll()）。接続済みの場合は切断してから接続し直す
+    /// @throws std::invalid_argument portsが空の場合
+    /// @throws TransportError いずれかの接続に失敗した場合（接続済みの分も切断する）
+    void connect(const SessionConfig& config, const std::vector<std::uint16_t>& ports);
+
+    /// すべての接続を切断する
+    void disconnect();
+
+    /// すべての接続が確立している場合true
+    /// 各接続の状態をプールのロックを取って確認するため、connect()/disconnect()の間は待つ
+    bool isConnected() const;
+
+    /// 接続数（ロックを取らずに返す）
+    std::size_t size() const noexcept;
+
+    /// 最も空いている接続を貸し出す
+    /// 接続を選ぶ間だけプールをロックする（Leaseを保持したまま別のLeaseを借りてもよい）
+    /// @throws std::runtime_error 接続されていない場合
+    Lease acquire();
+
+    // ========================================
+    // 要求（最も空いている接続で実行する。意味はMcClientの同名関数と同じ）
+    // ========================================
+
+    std::vector<std::uint16_t> readWords(const DeviceRange& range);
+    std::vector<bool> readBits(const DeviceRange& range);
+    void writeWords(const DeviceRange& range, const std::vector<std::uint16_t>& values);
+    void writeBits(const DeviceRange& range, const std::vector<bool>& values);
+    std::vector<DeviceValue> randomRead(const DeviceReadPlan& plan);
+    std::vector<DeviceValue> randomRead(const ResolvedReadPlan& plan);
+    void randomWrite(const DeviceWritePlan& plan);
+    void writeBatch(const WriteBatch& batch);
+
+    /// 大容量のワードデバイス範囲を読み取る
+    /// 範囲を1要求の上限（960点）単位で最大接続数個の区間に分け、空いている接続に割り当てて並行して読み取る
+    /// （先頭の区間は呼び出したスレッドで、残りは接続ごとのワーカースレッドで読み取る。
+    /// ワーカーは最初に区間を割り当てたときに起動し、切断まで使い回す）
+    /// @throws std::invalid_argument デバイス名が不正、countが0、またはデバイス番号の範囲を超える場合
+    /// @throws TransportError 通信エラーの場合（すべての分割の完了を待ってから送出する）
+    /// @throws std::runtime_error PLCエラーの場合
+    std::vector<std::uint16_t> readWordArea(const DeviceAddress& head, std::size_t count);
+
+    /// 大容量のビットデバイス範囲を読み取る（分割の動作はreadWordArea()と同じ、1要求の上限は7168点）
+    std::vector<bool> readBitArea(const DeviceAddress& head, std::size_t count);
+
+private:
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace cpmcprotocol
@@ -26,6 +26,18 @@ class DeviceCodeMap {
 public:
     BinaryDeviceCodeInfo resolveBinary(PlcSeries series, const std::string& device_name) const;
     AsciiDeviceCodeInfo resolveAscii(PlcSeries series, const std::string& device_name) const;
+
+    // Lookups for pre-resolved devices: O(1) table access, no string parsing.
+    BinaryDeviceCodeInfo resolveBinary(PlcSeries series, const ResolvedDevice& device) const;
+    AsciiDeviceCodeInfo resolveAscii(PlcSeries series, const ResolvedDevice& device) const;
+
+    // Parse a (normalized) device name into its packed form.
+    // Throws std::invalid_argument for unknown prefixes or malformed numbers.
+    static ResolvedDevice resolve(const std::string& device_name, DeviceType type);
+
+    // Device prefix ("D", "ZR", ...) and number base of a resolved device.
+    static const char* prefix(const ResolvedDevice& device);
+    static int numberBase(const ResolvedDevice& device);
 };
 
 } // namespace cpmcprotocol::codec
@@ -1,8 +1,14 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <optional>
+#include <span>
 #include <vector>
 
+#include "cpmcprotocol/communication_mode.hpp"
+#include "cpmcprotocol/frame_type.hpp"
+
 namespace cpmcprotocol::codec {
 
 struct BatchReadResponse {
@@ -27,6 +33,23 @@ struct RandomWriteResponse {
     std::vector<std::uint8_t> diagnostic_data;
 };
 
+struct MultiBlockReadResponse {
+    std::uint16_t completion_code = 0;
+    // One entry per requested block (word blocks first, then bit blocks), as 16-bit words.
+    std::vector<std::vector<std::uint16_t>> blocks;
+    std::vector<std::uint8_t> diagnostic_data;
+};
+
+// Zero-copy view of a response frame. Spans refer into the frame passed to
+// FrameDecoder::parseResponse and are valid only while that buffer is alive.
+// The payload is exposed as device_data on success (completion code 0) and
+// as diagnostic_data otherwise.
+struct ResponseView {
+    std::uint16_t completion_code = 0;
+    std::span<const std::uint8_t> device_data;
+    std::span<const std::uint8_t> diagnostic_data;
+};
+
 class FrameDecoder {
 public:
     FrameDecoder();
@@ -36,6 +59,22 @@ public:
     BatchWriteResponse parseBatchWriteResponse(const std::vector<std::uint8_t>& frame) const;
     RandomReadResponse parseRandomReadResponse(const std::vector<std::uint8_t>& frame) const;
     RandomWriteResponse parseRandomWriteResponse(const std::vector<std::uint8_t>& frame) const;
+
+    // Parse a multiple-block batch read (0x0406) response. block_lengths are the word counts
+    // of the requested blocks in request order; throws when the payload is shorter.
+    MultiBlockReadResponse parseMultiBlockReadResponse(std::span<const std::uint8_t> frame,
+                                                       std::span<const std::uint16_t> block_lengths) const;
+
+    // Parse any response frame without copying the payload
+    ResponseView parseResponse(std::span<const std::uint8_t> frame) const;
+
+    // Serial number of a 4E response frame, or std::nullopt for 3E frames
+    std::optional<std::uint16_t> parseSerialNumber(std::span<const std::uint8_t> frame) const;
+
+    // Response header size up to and including the data length field
+    static std::size_t headerSize(CommunicationMode mode, FrameType type);
+    // Data length (completion code + payload) read from a received response header
+    static std::size_t bodyLength(const std::uint8_t* header, CommunicationMode mode, FrameType type);
 };
 
 } // namespace cpmcprotocol::codec
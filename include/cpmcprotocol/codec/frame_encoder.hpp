@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include "cpmcprotocol/codec/device_code_map.hpp"
@@ -23,12 +25,131 @@ public:
                                                      const std::vector<std::uint32_t>& dword_data,
                                                      const std::vector<std::uint64_t>& lword_data,
                                                      const std::vector<bool>& bit_data) const;
+    std::vector<std::uint8_t> makeMultiBlockReadRequest(const SessionConfig& config, const MultiBlockRequest& request) const;
+    // `data` holds the word blocks' values followed by the bit blocks' packed words, in request order.
+    std::vector<std::uint8_t> makeMultiBlockWriteRequest(const SessionConfig& config,
+                                                         const MultiBlockRequest& request,
+                                                         const std::vector<std::uint16_t>& data) const;
     std::vector<std::uint8_t> makeSimpleCommand(const SessionConfig& config,
                                                 std::uint16_t command,
                                                 std::uint16_t subcommand,
                                                 const std::vector<std::uint8_t>& binary_payload,
                                                 const std::string& ascii_payload) const;
 
+    // Encode-into-buffer overloads: the frame replaces the contents of `out`, reusing
+    // its capacity, so a loop that keeps the same buffer performs no heap allocation
+    // once the buffer has grown to the largest frame. On exception `out` is unspecified.
+    void makeBatchReadRequest(std::vector<std::uint8_t>& out, const SessionConfig& config, const DeviceRange& range) const;
+    void makeBatchWriteRequest(std::vector<std::uint8_t>& out,
+                               const SessionConfig& config,
+                               const DeviceRange& range,
+                               const std::vector<std::uint16_t>& data) const;
+    void makeRandomReadRequest(std::vector<std::uint8_t>& out,
+                               const SessionConfig& config,
+                               const RandomDeviceRequest& request) const;
+    void makeRandomWriteRequest(std::vector<std::uint8_t>& out,
+                                const SessionConfig& config,
+                                const RandomDeviceRequest& request,
+                                const std::vector<std::uint16_t>& word_data,
+                                const std::vector<std::uint32_t>& dword_data,
+                                const std::vector<std::uint64_t>& lword_data,
+                                const std::vector<bool>& bit_data) const;
+    void makeMultiBlockReadRequest(std::vector<std::uint8_t>& out,
+                                   const SessionConfig& config,
+                                   const MultiBlockRequest& request) const;
+    void makeMultiBlockWriteRequest(std::vector<std::uint8_t>& out,
+                                    const SessionConfig& config,
+                                    const MultiBlockRequest& request,
+                                    const std::vector<std::uint16_t>& data) const;
+    void makeSimpleCommand(std::vector<std::uint8_t>& out,
+                           const SessionConfig& config,
+                           std::uint16_t command,
+                           std::uint16_t subcommand,
+                           const std::vector<std::uint8_t>& binary_payload,
+                           const std::string& ascii_payload) const;
+
+    // Overloads for pre-resolved devices (see resolveDevice()): no device-name parsing.
+    void makeBatchReadRequest(std::vector<std::uint8_t>& out, const SessionConfig& config, const ResolvedRange& range) const;
+    void makeBatchWriteRequest(std::vector<std::uint8_t>& out,
+                               const SessionConfig& config,
+                               const ResolvedRange& range,
+                               const std::vector<std::uint16_t>& data) const;
+    void makeRandomReadRequest(std::vector<std::uint8_t>& out,
+                               const SessionConfig& config,
+                               const ResolvedRandomRequest& request) const;
+    void makeRandomWriteRequest(std::vector<std::uint8_t>& out,
+                                const SessionConfig& config,
+                                const ResolvedRandomRequest& request,
+                                const std::vector<std::uint16_t>& word_data,
+                                const std::vector<std::uint32_t>& dword_data,
+                                const std::vector<std::uint64_t>& lword_data,
+                                const std::vector<bool>& bit_data) const;
+
+    // Monitor registration (0x0801) carries the same device list as a random read and is
+    // subject to the same point limit. The monitor request (0x0802) has no request data and
+    // is answered like the registered random read.
+    void makeMonitorRegisterRequest(std::vector<std::uint8_t>& out,
+                                    const SessionConfig& config,
+                                    const ResolvedRandomRequest& request) const;
+    void makeMonitorRequest(std::vector<std::uint8_t>& out, const SessionConfig& config) const;
+
+    // Device points one batch read (0x0401) may carry: 960 in word units, 7168 in bit units.
+    static constexpr std::size_t kMaxBatchReadWords = 960;
+    static constexpr std::size_t kMaxBatchReadBits = 7168;
+    // Limit for a batch read whose head device has the given type (bit devices read in bit units).
+    static constexpr std::size_t maxBatchReadPoints(DeviceType type) {
+        return type == DeviceType::Bit ? kMaxBatchReadBits : kMaxBatchReadWords;
+    }
+    // Device points one batch write (0x1401) may carry: 960 in word units, 7168 in bit units.
+    static constexpr std::size_t kMaxBatchWriteWords = 960;
+    static constexpr std::size_t kMaxBatchWriteBits = 7168;
+    // Limit for a batch write whose head device has the given type (bit devices written in bit units).
+    static constexpr std::size_t maxBatchWritePoints(DeviceType type) {
+        return type == DeviceType::Bit ? kMaxBatchWriteBits : kMaxBatchWriteWords;
+    }
+    void makeMultiBlockReadRequest(std::vector<std::uint8_t>& out,
+                                   const SessionConfig& config,
+                                   const ResolvedMultiBlockRequest& request) const;
+    void makeMultiBlockWriteRequest(std::vector<std::uint8_t>& out,
+                                    const SessionConfig& config,
+                                    const ResolvedMultiBlockRequest& request,
+                                    const std::vector<std::uint16_t>& data) const;
+
+    // Per-request limits of random read (0x0403) and random write (0x1402).
+    // Read: word, dword and bit devices count one point each, lword devices two.
+    // Write: word*12 + dword*14 + lword*28 must stay within write_cost; bits count against write_bits.
+    struct RandomAccessLimits {
+        std::size_t read_points;
+        std::size_t write_cost;
+        std::size_t write_bits;
+    };
+    static constexpr std::size_t kRandomWordWriteCost = 12;
+    static constexpr std::size_t kRandomDwordWriteCost = 14;
+    static constexpr std::size_t kRandomLwordWriteCost = 2 * kRandomDwordWriteCost;
+    // iQ-R subcommands (0x0002) halve the limits of the Q/L format.
+    static constexpr RandomAccessLimits randomAccessLimits(PlcSeries series) {
+        return series == PlcSeries::IQ_R ? RandomAccessLimits{96, 960, 94} : RandomAccessLimits{192, 1920, 188};
+    }
+
+    // Per-request limits of multiple-block batch read (0x0406) and write (0x1406).
+    // At most 120 blocks; read: total words <= 960; write: blocks*4 + total words <= 960.
+    static constexpr std::size_t kMaxMultiBlocks = 120;
+    static constexpr std::size_t kMaxMultiBlockPoints = 960;
+    static constexpr std::size_t kMultiBlockWriteBlockCost = 4;
+
+    // Request header size up to and including the monitoring timer
+    static std::size_t headerSize(const SessionConfig& config);
+    // Exact size of a batch read request frame, for sizing buffers up front
+    static std::size_t batchReadRequestSize(const SessionConfig& config);
+
+    // Overwrite the monitoring timer of an encoded request frame (3E/4E, binary or ASCII).
+    // Throws std::invalid_argument when the frame is not a request frame.
+    static void setMonitoringTimer(std::vector<std::uint8_t>& frame, std::uint16_t timer_250ms);
+
+    // Set the serial number field of an encoded 4E request frame (binary or ASCII).
+    // Throws std::invalid_argument when the frame is not a 4E request.
+    static void setSerialNumber(std::vector<std::uint8_t>& frame, std::uint16_t serial);
+
 private:
     DeviceCodeMap device_code_map_;
 };
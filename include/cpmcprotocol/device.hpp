@@ -18,7 +18,7 @@ enum class PlcSeries {
 
 /// デバイスのデータ型
 /// PLCのデバイスはビット単位かワード単位でアクセスする
-enum class DeviceType {
+enum class DeviceType : std::uint8_t {
     Word,       // ワードデバイス（16bit単位）: D, W, R等
     Bit,        // ビットデバイス（1bit単位）: X, Y, M, L等
     DoubleWord  // ダブルワードデバイス（32bit単位）
@@ -48,6 +48,49 @@ struct RandomDeviceRequest {
     std::vector<DeviceAddress> bit_devices;    // ビットデバイスのリスト
 };
 
+/// 解決済みデバイスアドレス
+/// デバイス名を一度だけ解析し、デバイスコードと数値のデバイス番号を保持する（8バイト、トリビアルコピー可能）
+/// エンコード時に文字列解析やプレフィックス検索を行わないため、多数のタグを扱う場合に使用する
+/// resolveDevice()で作成する
+struct ResolvedDevice {
+    std::uint32_t number = 0;            // デバイス番号（数値）
+    std::uint16_t code = 0;              // バイナリデバイスコード（例: D=0xA8）
+    std::uint8_t kind = 0;               // デバイステーブル上の識別子（0は未解決）
+    DeviceType type = DeviceType::Word;  // デバイスの型
+
+    friend constexpr bool operator==(const ResolvedDevice&, const ResolvedDevice&) = default;
+};
+
+static_assert(sizeof(ResolvedDevice) == 8, "ResolvedDevice must stay packed into 8 bytes");
+
+/// 解決済みデバイス範囲
+struct ResolvedRange {
+    ResolvedDevice head;       // 範囲の先頭デバイス
+    std::uint16_t length = 0;  // 読み書きする個数（ワード数またはビット数）
+};
+
+/// 解決済みデバイスによるランダムアクセス要求
+struct ResolvedRandomRequest {
+    std::vector<ResolvedDevice> word_devices;   // 16bitワードデバイスのリスト
+    std::vector<ResolvedDevice> dword_devices;  // 32bitダブルワードデバイスのリスト
+    std::vector<ResolvedDevice> lword_devices;  // 64bitロングワードデバイスのリスト
+    std::vector<ResolvedDevice> bit_devices;    // ビットデバイスのリスト
+};
+
+/// 複数ブロック一括読み書きの要求
+/// 離れた複数の連続範囲を1フレームでまとめて読み書きする際に使用
+/// ビットブロックは16点を1ワードとして扱い、lengthはワード数で指定する（先頭デバイスは16の倍数を推奨）
+struct MultiBlockRequest {
+    std::vector<DeviceRange> word_blocks;  // ワードデバイスのブロック（lengthはワード数）
+    std::vector<DeviceRange> bit_blocks;   // ビットデバイスのブロック（lengthはワード数 = 16点単位）
+};
+
+/// 解決済みデバイスによる複数ブロック要求
+struct ResolvedMultiBlockRequest {
+    std::vector<ResolvedRange> word_blocks;  // ワードデバイスのブロック（lengthはワード数）
+    std::vector<ResolvedRange> bit_blocks;   // ビットデバイスのブロック（lengthはワード数 = 16点単位）
+};
+
 // ========================================
 // デバイスカタログユーティリティ関数
 // ========================================
@@ -81,4 +124,28 @@ DeviceAddress makeDeviceAddress(const std::string& device_name);
 /// @throws std::invalid_argument デバイス名が不正または長さが0の場合
 DeviceRange makeDeviceRange(const std::string& device_name, std::uint16_t length);
 
+/// DeviceAddressを解決済みアドレスに変換する（型はaddress.typeを使用）
+/// @throws std::invalid_argument デバイス名が不正な場合
+ResolvedDevice resolveDevice(const DeviceAddress& address);
+
+/// デバイス名を解決済みアドレスに変換する（正規化・型判定も行う）
+/// @throws std::invalid_argument デバイス名が不正な場合
+ResolvedDevice resolveDevice(const std::string& device_name);
+
+/// DeviceRangeを解決済み範囲に変換する
+/// @throws std::invalid_argument デバイス名が不正な場合
+ResolvedRange resolveRange(const DeviceRange& range);
+
+/// RandomDeviceRequestを解決済み要求に変換する
+/// @throws std::invalid_argument デバイス名が不正な場合
+ResolvedRandomRequest resolveRandomRequest(const RandomDeviceRequest& request);
+
+/// MultiBlockRequestを解決済み要求に変換する
+/// @throws std::invalid_argument デバイス名が不正な場合
+ResolvedMultiBlockRequest resolveMultiBlockRequest(const MultiBlockRequest& request);
+
+/// 解決済みアドレスをデバイス名に戻す（例: "D1000", "X1F"）
+/// @throws std::invalid_argument 未解決のアドレスの場合
+std::string formatDevice(const ResolvedDevice& device);
+
 } // namespace cpmcprotocol
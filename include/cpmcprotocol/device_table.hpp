@@ -0,0 +1,174 @@
+#pragma once
+
+#include "cpmcprotocol/device.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace cpmcprotocol {
+
+/// デバイス種別の定義
+/// デバイスカタログ（型判定・名前検証）とデバイスコード変換が共有する唯一のテーブル
+struct DeviceSpec {
+    std::string_view prefix;    // デバイス名のプレフィックス（例: "D", "ZR"）
+    std::uint16_t binary_code;  // バイナリデバイスコード
+    int number_base;            // デバイス番号の基数（10または16）
+    DeviceType type;            // デバイスの型
+    std::uint8_t series_mask;   // 対応シリーズ（seriesBit()の論理和）
+};
+
+/// シリーズに対応するビット
+constexpr std::uint8_t seriesBit(PlcSeries series) noexcept {
+    return static_cast<std::uint8_t>(1U << static_cast<unsigned>(series));
+}
+
+/// 全シリーズ対応を表すマスク
+inline constexpr std::uint8_t kAllSeries = seriesBit(PlcSeries::Q) | seriesBit(PlcSeries::L) |
+                                          seriesBit(PlcSeries::QnA) | seriesBit(PlcSeries::IQ_L) |
+                                          seriesBit(PlcSeries::IQ_R);
+
+/// デバイステーブル（ResolvedDevice::kind はこの配列の位置 + 1）
+inline constexpr std::array<DeviceSpec, 14> kDeviceTable{{
+    {"X", 0x9C, 16, DeviceType::Bit, kAllSeries},
+    {"Y", 0x9D, 16, DeviceType::Bit, kAllSeries},
+    {"M", 0x90, 10, DeviceType::Bit, kAllSeries},
+    {"L", 0x92, 10, DeviceType::Bit, kAllSeries},
+    {"F", 0x93, 10, DeviceType::Bit, kAllSeries},
+    {"B", 0xA0, 16, DeviceType::Bit, kAllSeries},
+    {"T", 0xC2, 10, DeviceType::Bit, kAllSeries},
+    {"C", 0xC5, 10, DeviceType::Bit, kAllSeries},
+    {"D", 0xA8, 10, DeviceType::Word, kAllSeries},
+    {"W", 0xB4, 16, DeviceType::Word, kAllSeries},
+    {"R", 0xAF, 10, DeviceType::Word, kAllSeries},
+    {"Z", 0xCC, 10, DeviceType::Word, kAllSeries},
+    {"ZR", 0xB0, 16, DeviceType::Word, kAllSeries},
+    {"RD", 0x2C, 10, DeviceType::Word, seriesBit(PlcSeries::IQ_R)},
+}};
+
+/// デバイスが指定シリーズで使用可能か判定する
+constexpr bool supportsSeries(const DeviceSpec& spec, PlcSeries series) noexcept {
+    return (spec.series_mask & seriesBit(series)) != 0;
+}
+
+/// プレフィックスに完全一致するデバイス定義の kDeviceTable 内の位置を返す（見つからない場合はnullopt）
+/// 定数評価中のポインタ比較を避けるため、ポインタではなく位置を返す
+constexpr std::optional<std::size_t> findDeviceIndex(std::string_view prefix) noexcept {
+    for (std::size_t i = 0; i < kDeviceTable.size(); ++i) {
+        if (kDeviceTable[i].prefix == prefix) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+/// デバイス名の解析エラー
+enum class DeviceParseError : std::uint8_t {
+    None,           // 成功
+    Empty,          // デバイス名が空
+    MissingPrefix,  // プレフィックスがない
+    UnknownPrefix,  // 未知のプレフィックス
+    MissingNumber,  // 数値部分がない
+    InvalidNumber   // 数値部分が基数に合わない、または32bitを超える
+};
+
+/// デバイス名の解析結果
+struct DeviceParseResult {
+    ResolvedDevice device{};                          // 解決済みアドレス（成功時のみ有効）
+    DeviceParseError error = DeviceParseError::None;  // 解析エラー
+    std::size_t prefix_length = 0;                    // 先頭の数字以外の文字数
+};
+
+/// 正規化済み（大文字）のデバイス名を解析する
+/// プレフィックスは最初の数字より前の部分で、テーブルと完全一致する必要がある
+/// 数値部分は基数16のデバイスに限り "0x" 接頭辞を許容する
+constexpr DeviceParseResult parseDeviceName(std::string_view name) noexcept {
+    DeviceParseResult result{};
+    if (name.empty()) {
+        result.error = DeviceParseError::Empty;
+        return result;
+    }
+
+    std::size_t pos = 0;
+    while (pos < name.size() && (name[pos] < '0' || name[pos] > '9')) {
+        ++pos;
+    }
+    result.prefix_length = pos;
+    if (pos == 0) {
+        result.error = DeviceParseError::MissingPrefix;
+        return result;
+    }
+
+    const auto index = findDeviceIndex(name.substr(0, pos));
+    if (!index) {
+        result.error = DeviceParseError::UnknownPrefix;
+        return result;
+    }
+    const DeviceSpec& spec = kDeviceTable[*index];
+    if (pos == name.size()) {
+        result.error = DeviceParseError::MissingNumber;
+        return result;
+    }
+
+    std::string_view digits = name.substr(pos);
+    if (spec.number_base == 16 && digits.size() >= 2 && digits[0] == '0' &&
+        (digits[1] == 'x' || digits[1] == 'X')) {
+        digits.remove_prefix(2);
+    }
+    if (digits.empty()) {
+        result.error = DeviceParseError::InvalidNumber;
+        return result;
+    }
+
+    std::uint64_t value = 0;
+    for (const char c : digits) {
+        int digit = -1;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        }
+        if (digit < 0 || digit >= spec.number_base) {
+            result.error = DeviceParseError::InvalidNumber;
+            return result;
+        }
+        value = value * static_cast<std::uint64_t>(spec.number_base) + static_cast<std::uint64_t>(digit);
+        if (value > 0xFFFFFFFFULL) {
+            result.error = DeviceParseError::InvalidNumber;
+            return result;
+        }
+    }
+
+    result.device.number = static_cast<std::uint32_t>(value);
+    result.device.code = spec.binary_code;
+    result.device.kind = static_cast<std::uint8_t>(*index + 1);
+    result.device.type = spec.type;
+    return result;
+}
+
+namespace literals {
+
+/// コンパイル時にデバイス名を解決するリテラル
+/// 不正なデバイス名はコンパイルエラーになる
+///
+/// 使用例:
+/// @code
+/// using namespace cpmcprotocol::literals;
+/// constexpr ResolvedDevice level = "D1000"_dev;
+/// constexpr ResolvedDevice start = "X1F"_dev;
+/// @endcode
+consteval ResolvedDevice operator""_dev(const char* text, std::size_t length) {
+    const auto result = parseDeviceName(std::string_view(text, length));
+    if (result.error != DeviceParseError::None) {
+        throw "invalid device name in _dev literal";
+    }
+    return result.device;
+}
+
+} // namespace literals
+
+} // namespace cpmcprotocol
@@ -0,0 +1,202 @@
+#pragma once
+
+#include "cpmcprotocol/session_config.hpp"
+#include "cpmcprotocol/transport.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace cpmcprotocol {
+
+/// ソケットのネイティブハンドル（POSIXではファイルディスクリプタ、WindowsではSOCKET）
+#ifdef _WIN32
+using NativeSocket = std::uintptr_t;
+#else
+using NativeSocket = int;
+#endif
+
+/// 応答フレームの区切り方と要求との照合方法
+struct FrameFormat {
+    /// データ長フィールドまでのヘッダー長
+    std::size_t header_size = 0;
+    /// ヘッダーから後続データ長を取り出す関数
+    std::function<std::size_t(const std::uint8_t*, std::size_t)> length_extractor;
+    /// 完成したフレームから照合キー（4Eのシリアル番号）を取り出す関数
+    /// 未設定の場合、応答は送信順（FIFO）に要求と対応付けられる
+    std::function<std::optional<std::uint16_t>(const std::uint8_t*, std::size_t)> key_extractor;
+};
+
+/// セッション設定（通信モード・フレーム種別）に対応するMC応答フレームの形式を作成する
+/// 4Eフレームの場合はシリアル番号で照合する
+FrameFormat makeResponseFrameFormat(const SessionConfig& config);
+
+class AsyncTcpTransport;
+
+/// EventLoopのI/O多重化の方式
+enum class EventLoopBackend {
+    Poll,     // poll/WSAPoll（Linux以外）
+    Epoll,    // epoll（Linux）
+    IoUring   // io_uring（CPMCPROTOCOL_ENABLE_IO_URINGでビルドし、カーネルが対応している場合）
+};
+
+/// イベントループ
+/// 多数のAsyncTcpTransportのソケットを1スレッドで多重化する（Linuxではepoll、その他の環境ではpoll）
+/// CPMCPROTOCOL_ENABLE_IO_URINGでビルドした場合はio_uringを使用し、送受信を接続ごとのシステムコールではなく
+/// リングにまとめて提出する（受信には登録済みの固定バッファを使う）。カーネルが対応していない場合（5.11未満、
+/// seccomp等で禁止されている場合）はepollを使用する
+/// 要求ごとのデッドラインもこのループで監視する
+///
+/// スレッドモデル:
+/// - runOnce()/run()を呼ぶスレッドが「ループスレッド」となる
+/// - ループに登録したAsyncTcpTransportの操作と完了コールバックはループスレッド上で行う
+/// - 他スレッドからはpost()/stop()のみ呼び出せる
+class EventLoop {
+public:
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /// イベントを1回待機して処理する
+    /// @param max_wait 最大待機時間（直近のデッドラインが早ければそちらまで）
+    /// @return 処理したイベント数
+    std::size_t runOnce(std::chrono::milliseconds max_wait);
+
+    /// stop()が呼ばれるまでイベントを処理し続ける
+    void run();
+
+    /// run()を終了させる（スレッドセーフ）
+    void stop();
+
+    /// ループスレッドで関数を実行する（スレッドセーフ）
+    void post(std::function<void()> task);
+
+    /// 登録中のトランスポート数
+    std::size_t size() const noexcept;
+
+    /// 使用しているI/O多重化の方式
+    EventLoopBackend backend() const noexcept;
+
+private:
+    friend class AsyncTcpTransport;
+
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+/// ノンブロッキングTCPトランスポート
+/// TcpTransportと同じ接続/送信/フレーム受信の責務を持つが、ソケット単位のタイムアウトではなく
+/// 要求単位のデッドラインで動作し、結果は完了コールバックで通知する
+///
+/// 使用例:
+/// @code
+/// EventLoop loop;
+/// AsyncTcpTransport transport(loop);
+/// transport.connect(config);
+/// transport.submit(request, std::nullopt, std::chrono::steady_clock::now() + 1s,
+///                  [](std::exception_ptr error, std::vector<std::uint8_t> frame) { ... });
+/// loop.run();
+/// @endcode
+///
+/// EventLoopなしで構築した場合は、利用者のイベントループ（epoll等）から駆動する:
+/// - nativeHandle()を読み取り可能の監視対象に登録し、wantsWrite()がtrueの間は書き込み可能も監視する
+/// - 通知を受けたらprocessReadable()/processWritable()を呼び、nextDeadline()までにprocessTimeouts()を呼ぶ
+/// - 接続の確立中はnativeHandle()が変わることがあるため、待機のたびに読み直す
+/// - 完了コールバックはこれらの関数（およびsubmit()）を呼んだスレッドで呼ばれる
+class AsyncTcpTransport {
+public:
+    /// 完了コールバック（成功時はerrorがnullptr、失敗時はTransportError/TransportTimeoutError）
+    /// コールバック内で同じトランスポートを破棄しないこと（必要ならEventLoop::post()で遅延させる）
+    using Completion = std::function<void(std::exception_ptr error, std::vector<std::uint8_t> frame)>;
+
+    /// イベントループに登録して使用する
+    /// @note loopはこのトランスポートより長く生存すること
+    explicit AsyncTcpTransport(EventLoop& loop);
+    /// EventLoopに登録せず、利用者のイベントループから駆動する
+    AsyncTcpTransport();
+    ~AsyncTcpTransport();
+
+    AsyncTcpTransport(const AsyncTcpTransport&) = delete;
+    AsyncTcpTransport& operator=(const AsyncTcpTransport&) = delete;
+
+    /// PLCへのノンブロッキング接続を開始してループに登録する（接続の確立を待たずに戻る）
+    /// 確立は書き込み可能の通知で確認し、確立までにsubmit()した要求は確立後に送信する
+    /// 接続の確立はTcpTransport::connect()と同じくtimeout_250msのデッドラインで打ち切り、
+    /// 失敗した場合は応答待ちの要求をTransportTimeoutError/TransportErrorで完了して切断する
+    /// 応答フレーム形式はmakeResponseFrameFormat(config)で初期化される
+    /// @note ホスト名の名前解決は呼び出したスレッドで待つ（数値アドレスは待たない）
+    /// @throws TransportError 名前解決に失敗した場合、またはすべてのアドレスへの接続がその場で失敗した場合
+    void connect(const SessionConfig& config);
+
+    /// 切断する（応答待ちの要求はTransportErrorで完了する）
+    void disconnect() noexcept;
+
+    /// 接続している（確立を待っている間も含む）場合true
+    bool isConnected() const noexcept;
+
+    /// connect()の後、接続の確立を待っている場合true
+    bool isConnecting() const noexcept;
+
+    /// 応答フレーム形式を変更する
+    void setFrameFormat(FrameFormat format);
+
+    /// 要求を送信キューに積み、応答受信時またはデッドライン超過時にcompletionを呼ぶ
+    /// @param request 送信するフレーム（4Eの場合はシリアル番号設定済み）
+    /// @param key 応答照合キー（4Eのシリアル番号、FIFO照合時はstd::nullopt）
+    /// @param deadline 応答受信の期限
+    /// @param completion 完了コールバック（ループスレッドで呼ばれる）
+    /// @throws TransportError 接続されていない場合
+    /// @note FIFO照合でデッドラインを超過した場合、応答順序が保証できないため接続を切断する
+    void submit(std::vector<std::uint8_t> request,
+                std::optional<std::uint16_t> key,
+                std::chrono::steady_clock::time_point deadline,
+                Completion completion);
+
+    /// 応答待ちの要求数
+    std::size_t pendingCount() const noexcept;
+
+    /// 以降のsubmit()の送信を保留する（入れ子にできる）
+    /// 続けて積んだ要求は、対応するuncork()でまとめて1回のsendで送信される
+    void cork() noexcept;
+
+    /// cork()を解除し、最も外側の解除であれば保留した要求を送信する
+    void uncork();
+
+    // ========================================
+    // 外部イベントループからの駆動（EventLoopなしで構築した場合のみ使用する）
+    // ========================================
+
+    /// 監視対象のソケット（未接続の場合は無効値）
+    /// 接続の確立を待っている間は、接続先のアドレスを切り替えるたびに変わることがある
+    NativeSocket nativeHandle() const noexcept;
+
+    /// 接続の確立を待っているか、送信しきれていないデータがあり、書き込み可能を監視する必要がある場合true
+    bool wantsWrite() const noexcept;
+
+    /// ソケットが読み取り可能（またはエラー）になったときに呼ぶ。受信した応答の完了コールバックを呼ぶ
+    void processReadable();
+
+    /// ソケットが書き込み可能になったときに呼ぶ（接続の確立もこの通知で確認する）
+    void processWritable();
+
+    /// デッドラインを超えた要求（確立しなかった接続を含む）をTransportTimeoutErrorで完了する
+    void processTimeouts();
+
+    /// 接続の確立と応答待ちの要求のうち最も早いデッドライン（どちらもなければstd::nullopt）
+    std::optional<std::chrono::steady_clock::time_point> nextDeadline() const;
+
+private:
+    friend class EventLoop;
+
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace cpmcprotocol
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace cpmcprotocol {
+
+/// MCプロトコルのフレーム種別
+/// 4Eフレームは要求ごとにシリアル番号を持ち、複数要求の同時送信（パイプライン）に対応する
+enum class FrameType {
+    Frame3E,  // 3Eフレーム: 1要求ずつ応答を待つ（既定）
+    Frame4E   // 4Eフレーム: シリアル番号で要求と応答を対応付ける
+};
+
+} // namespace cpmcprotocol
@@ -1,9 +1,16 @@
 #pragma once
 
 #include "cpmcprotocol/device.hpp"
+#include "cpmcprotocol/read_optimizer.hpp"
+#include "cpmcprotocol/reconnect_policy.hpp"
 #include "cpmcprotocol/value_codec.hpp"
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -22,9 +29,111 @@ class FrameEncoder;
 class FrameDecoder;
 }
 
+/// 事前エンコード済みの要求
+/// McClient::prepareReadWords() で作成し、McClient::readWords(PreparedRequest&) で繰り返し実行する
+/// 実行時は監視タイマーと4Eシリアル番号のみを書き換えるため、要求の組み立て処理が発生しない
+/// 通信モードや経路がsetAccessOption()で変更された場合は、次回実行時に自動で再エンコードされる
+/// @note 作成したMcClientでのみ使用すること。実行時にフレームを書き換えるため、同じオブジェクトを複数スレッドから同時に実行しないこと
+class PreparedRequest {
+public:
+    PreparedRequest() = default;
+
+    /// 対象のデバイス範囲
+    const DeviceRange& range() const noexcept { return range_; }
+
+    /// エンコード済みフレーム
+    const std::vector<std::uint8_t>& frame() const noexcept { return frame_; }
+
+    /// 未作成（デフォルト構築）の場合true
+    bool empty() const noexcept { return frame_.empty(); }
+
+private:
+    friend class McClient;
+
+    DeviceRange range_{};
+    std::vector<std::uint8_t> frame_;
+    std::uint64_t generation_ = 0;
+    std::uint16_t timer_ = 0;
+};
+
+/// モニタ登録済みの読み取りセット
+/// McClient::registerMonitor() で作成し、McClient::readMonitor(MonitorSet&) で繰り返し読み取る
+/// 先頭から1要求の点数上限（iQ-R 96点、Q/L 192点）までをモニタ登録（コマンド0x0801）し、
+/// 以降はデバイス指定を含まないモニタ要求（コマンド0x0802）で読み取る
+/// 上限を超える分は事前エンコード済みのランダム読み出し要求で読み取り、モニタ要求とまとめてパイプラインで送信する
+/// PLCが保持するモニタ登録は接続ごとに1つのため、再接続・経路変更の後や別のセットを登録した後は
+/// 次回の読み取り時に自動で再登録する
+/// @note 作成したMcClientでのみ使用すること
+class MonitorSet {
+public:
+    MonitorSet() = default;
+
+    /// 読み取りプラン（登録時の順序）
+    const ResolvedReadPlan& plan() const noexcept { return plan_; }
+
+    /// モニタ登録で読み取るエントリ数（残りはランダム読み出しで読み取る）
+    std::size_t monitoredCount() const noexcept { return orders_.empty() ? 0 : orders_.front().size(); }
+
+    /// 未作成（デフォルト構築）の場合true
+    bool empty() const noexcept { return plan_.empty(); }
+
+private:
+    friend class McClient;
+
+    ResolvedReadPlan plan_;
+    std::vector<ResolvedRandomRequest> requests_;        // [0]がモニタ登録、以降はランダム読み出し
+    std::vector<std::vector<std::size_t>> orders_;       // requests_[i]の応答の並び順に対応するプラン位置
+    std::vector<std::uint8_t> register_frame_;           // モニタ登録要求（0x0801）
+    std::vector<std::vector<std::uint8_t>> frames_;      // [0]がモニタ要求（0x0802）、以降はランダム読み出し要求
+    std::uint64_t id_ = 0;
+    std::uint64_t generation_ = 0;
+    std::uint16_t timer_ = 0;
+};
+
+/// 複数ブロック一括読み書きのデータ
+/// MultiBlockRequestのブロックと同じ順序・長さで値を保持する
+/// ビットブロックの各ワードは16点分で、下位ビットがブロック内の若い番号のデバイスに対応する
+struct MultiBlockData {
+    std::vector<std::vector<std::uint16_t>> word_blocks;  // ワードブロックごとの値
+    std::vector<std::vector<std::uint16_t>> bit_blocks;   // ビットブロックごとの値（16点/ワード）
+};
+
+/// まとめて送信する書き込みの組
+/// WriteQueueが積まれた書き込みを合成して作成し、McClient::writeBatch()で送信する
+/// 1つのデバイスは組の中で1回だけ書き込むこと（フレームの送信順は保証しない）
+struct WriteBatch {
+    /// 一括書き込み（コマンド0x1401）する範囲（各範囲は1要求あたりの上限以内）
+    std::vector<ResolvedRange> ranges;
+    /// ranges[i]の書き込み値（ワードデバイスは1ワード1要素、ビットデバイスは1点1要素で0以外がON）
+    std::vector<std::vector<std::uint16_t>> range_values;
+    /// ランダム書き込み（コマンド0x1402）するデバイス（点数上限を超える分は分割して送信する）
+    ResolvedRandomRequest random;
+    std::vector<std::uint16_t> word_values;   // random.word_devices[i]の値
+    std::vector<std::uint32_t> dword_values;  // random.dword_devices[i]の値
+    std::vector<std::uint64_t> lword_values;  // random.lword_devices[i]の値
+    std::vector<bool> bit_values;             // random.bit_devices[i]の値
+
+    /// 書き込みがない場合true
+    bool empty() const noexcept {
+        return ranges.empty() && random.word_devices.empty() && random.dword_devices.empty() &&
+               random.lword_devices.empty() && random.bit_devices.empty();
+    }
+};
+
 /// MCプロトコルクライアント
 /// 三菱電機製PLCとの通信を行うメインクラス
-/// MCプロトコル（3Eフレーム）を使用してPLCとデータをやり取りする
+/// MCプロトコル（3E/4Eフレーム）を使用してPLCとデータをやり取りする
+///
+/// スレッドモデル:
+/// - すべてのメンバ関数はスレッドセーフで、複数のスレッドが1つの接続を共有できる
+/// - 同時に呼ばれた要求は1本の接続に多重化する。専用のスレッドは持たず、要求したスレッドの1つが
+///   待機中の要求からラウンドロビンで1フレームずつ送信する（大きな分割読み出しの間も他の要求が割り込める）
+/// - 4Eフレームでは全スレッドの要求を合わせてSessionConfig::max_in_flight件まで応答を待たずに送信し、
+///   シリアル番号で応答を振り分ける。3Eフレームは応答を対応付けられないため1件ずつ往復する
+/// - 通信エラー（タイムアウト・切断）は応答待ちだったすべての要求に送出する。PLCエラーは要求したスレッドにのみ返る
+/// - connect()/disconnect()/setAccessOption()は実行中の要求の完了を待ってから行う
+/// - readMonitor()はモニタ登録が接続ごとに1つのため、モニタの読み取り同士は順に実行する
+/// - setReconnectPolicy()/setConnectionStateHandler()を使うと、状態の通知と再接続を行う監視スレッドを1つ起動する
 ///
 /// 使用例:
 /// @code
@@ -67,10 +176,22 @@ public:
     // ========================================
 
     /// PLCに接続する
+    /// 接続はtimeout_250msのデッドラインで打ち切る（電源の入っていないPLCでも長く待たない）
     /// @param config 接続設定（ホスト、ポート、タイムアウト等）
+    /// @throws TransportTimeoutError デッドラインまでに接続できなかった場合
     /// @throws TransportError 接続に失敗した場合
     void connect(const SessionConfig& config);
 
+    /// 複数のクライアントをまとめて接続する（clients[i]をconfigs[i]へ接続する）
+    /// すべての接続を並行して進めるため、多数のPLCへの接続も最も遅い接続先のデッドライン程度で終わる
+    /// 一部の接続先に接続できなくても他のクライアントは接続される
+    /// 接続を待つ間、各クライアントは未接続として振る舞う（ロックは保持しないため、要求は待たずに失敗する）
+    /// 待つ間に同じクライアントがconnect()/disconnect()された場合、そのクライアントの結果はTransportErrorになる
+    /// @return clientsと同じ順の接続結果（成功はnullptr、失敗はconnect()が送出する例外）
+    /// @throws std::invalid_argument 要素数が一致しない場合、nullptrまたは重複を含む場合
+    static std::vector<std::exception_ptr> connectAll(std::span<McClient* const> clients,
+                                                      std::span<const SessionConfig> configs);
+
     /// PLCとの接続を切断する
     void disconnect();
 
@@ -78,6 +199,31 @@ public:
     /// @return 接続中の場合true、切断中の場合false
     bool isConnected() const noexcept;
 
+    /// 接続状態（再接続中かどうかを含む）
+    ConnectionState connectionState() const noexcept;
+
+    /// 自動再接続を設定する
+    /// 有効な間は、通信中に接続が失われると監視スレッドがconnect()と同じ設定で再接続する
+    /// （間隔はpolicyの指数バックオフとジッターに従う）
+    /// - 読み取り（read*()/randomRead()/readMonitor()/readCpuType()）は、接続が失われて失敗した場合に
+    ///   再接続をread_retry_timeoutまで待って1回だけ再試行する
+    /// - 再接続中の書き込み・モニタ登録・ランタイム制御は送信せずにTransportReconnectingErrorを送出する。
+    ///   送信後に接続が失われた書き込みは、PLCに反映されたか分からないため再試行せずにTransportErrorを送出する
+    /// - 再接続するとシャドウキャッシュを破棄し、モニタは次回の読み取りで再登録する
+    /// - max_attemptsに達した場合はDisconnectedになり、以降はconnect()で接続し直す
+    /// 無効にすると再接続中の試行を打ち切ってDisconnectedにする
+    /// @throws std::invalid_argument 設定が不正な場合（間隔が負、initial_delay > max_delay、multiplier < 1、jitterが0〜1の範囲外）
+    void setReconnectPolicy(const ReconnectPolicy& policy);
+
+    /// 接続状態の変化を受け取るハンドラーを設定する（空の関数で解除）
+    /// ハンドラーは監視スレッドから変化の順に呼ばれる。ロックを保持せずに呼ぶため、ハンドラーからこのクライアントを
+    /// 操作してよいが、長く処理を止めると以降の通知と再接続が遅れる（デストラクタはハンドラーから呼ばないこと）
+    void setConnectionStateHandler(ConnectionStateHandler handler);
+
+    /// 接続先のPLCシリーズ（最後にconnect()した設定）
+    /// optimizeReadPlan()など、シリーズごとの上限に合わせてプランを作る際に使用する
+    PlcSeries series() const noexcept;
+
     /// アクセスオプションを設定する
     /// 接続後に通信パラメータを動的に変更する際に使用
     /// @param option アクセスオプション（タイムアウト、通信モード等）
@@ -88,17 +234,67 @@ public:
     // ========================================
 
     /// ワードデバイスを連続読み取りする
+    /// 1要求あたりの上限（960点）を超える範囲は自動で分割して読み取る（readWordArea()と同じ）
     /// @param range 読み取り範囲（先頭デバイスと個数）
     /// @return 読み取った値のリスト（16bit符号なし整数）
     /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
     std::vector<std::uint16_t> readWords(const DeviceRange& range);
 
+    /// 大容量のワードデバイス範囲を読み取る
+    /// 1要求あたりの上限（ワード単位960点、ビットデバイスはビット単位7168点）ごとに分割し、
+    /// 4Eフレーム設定時は応答を待たずに連続送信（SessionConfig::max_in_flight件まで）して、結果を範囲の順に結合する
+    /// @param head 先頭デバイス
+    /// @param count 読み取る点数（DeviceRangeの上限65535点を超えてもよい）
+    /// @return 読み取った値のリスト（count個）
+    /// @throws std::invalid_argument countが0、またはデバイス番号の範囲を超える場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    std::vector<std::uint16_t> readWordArea(const DeviceAddress& head, std::size_t count);
+
+    /// 解決済みの先頭デバイスから大容量のワードデバイス範囲を読み取る（デバイス名の解析を省く。動作は同上）
+    std::vector<std::uint16_t> readWordArea(const ResolvedDevice& head, std::size_t count);
+
+    /// ワード連続読み取り要求を事前にエンコードする
+    /// 同じ範囲を高頻度でポーリングする場合、readWords(PreparedRequest&)と組み合わせて使用する
+    /// @param range 読み取り範囲（先頭デバイスと個数）
+    /// @return 事前エンコード済みの要求
+    /// @throws std::invalid_argument デバイス名または範囲が不正な場合
+    /// @throws TransportError 接続されていない場合
+    PreparedRequest prepareReadWords(const DeviceRange& range);
+
+    /// 事前エンコード済みの要求でワードデバイスを連続読み取りする
+    /// @param prepared prepareReadWords()で作成した要求（タイマー・シリアル番号が書き換えられる）
+    /// @return 読み取った値のリスト（16bit符号なし整数）
+    /// @throws std::invalid_argument preparedが未作成の場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    std::vector<std::uint16_t> readWords(PreparedRequest& prepared);
+
+    /// 複数範囲のワードデバイスをパイプラインで読み取る
+    /// 4Eフレーム設定時はSessionConfig::max_in_flight件まで応答を待たずに要求を送信し、
+    /// シリアル番号で応答を対応付ける（3Eフレームでは1件ずつ往復する）
+    /// 各範囲は1要求あたりの上限（960点）以内であること
+    /// @param ranges 読み取り範囲のリスト
+    /// @return 範囲ごとの読み取り値（rangesと同じ順序）
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    std::vector<std::vector<std::uint16_t>> readWordsPipelined(const std::vector<DeviceRange>& ranges);
+
     /// ビットデバイスを連続読み取りする
+    /// 1要求あたりの上限（7168点）を超える範囲は自動で分割して読み取る（readBitArea()と同じ）
     /// @param range 読み取り範囲（先頭デバイスと個数）
     /// @return 読み取った値のリスト（bool）
     /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
     std::vector<bool> readBits(const DeviceRange& range);
 
+    /// 大容量のビットデバイス範囲を読み取る（分割・パイプラインの動作はreadWordArea()と同じ）
+    /// @param head 先頭デバイス
+    /// @param count 読み取る点数
+    /// @return 読み取った値のリスト（count個）
+    /// @throws std::invalid_argument countが0、またはデバイス番号の範囲を超える場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    std::vector<bool> readBitArea(const DeviceAddress& head, std::size_t count);
+
+    /// 解決済みの先頭デバイスから大容量のビットデバイス範囲を読み取る（デバイス名の解析を省く。動作は同上）
+    std::vector<bool> readBitArea(const ResolvedDevice& head, std::size_t count);
+
     /// ワードデバイスに連続書き込みする
     /// @param range 書き込み範囲（先頭デバイスと個数）
     /// @param values 書き込む値のリスト（16bit符号なし整数）
@@ -113,6 +309,23 @@ public:
     /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
     void writeBits(const DeviceRange& range, const std::vector<bool>& values);
 
+    /// 複数ブロックを一括読み取りする（コマンド0x0406）
+    /// 離れた複数の連続範囲（例: D100-D199、W0-W3F、M0-M255）を1往復で読み取る
+    /// 1要求あたりの上限（120ブロック、合計960ワード）を超える場合は分割してパイプラインで送信する
+    /// @param request 読み取るブロック（ワードブロックとビットブロック）
+    /// @return ブロックごとの読み取り値（requestと同じ順序）
+    /// @throws std::invalid_argument ブロックがない、または長さが0のブロックがある場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    MultiBlockData readMultipleBlocks(const MultiBlockRequest& request);
+
+    /// 複数ブロックに一括書き込みする（コマンド0x1406）
+    /// 1要求あたりの上限（120ブロック、ブロック数×4＋合計ワード数が960）を超える場合は分割して送信する
+    /// @param request 書き込むブロック（ワードブロックとビットブロック）
+    /// @param data ブロックごとの書き込み値（requestと同じ順序・長さ以上）
+    /// @throws std::invalid_argument ブロックとデータの個数・長さが一致しない場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    void writeMultipleBlocks(const MultiBlockRequest& request, const MultiBlockData& data);
+
     // ========================================
     // ランダムアクセス（非連続デバイスの読み書き）
     // ========================================
@@ -124,12 +337,115 @@ public:
     /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
     std::vector<DeviceValue> randomRead(const DeviceReadPlan& plan);
 
+    /// 解決済みプランで複数の非連続デバイスを一度に読み取る
+    /// デバイス名の解析を行わないため、同じプランを繰り返し読み取る場合に使用する
+    /// @param plan resolveReadPlan()で作成した読み取りプラン
+    /// @return 読み取った値のリスト（型はDeviceValue）
+    /// @throws std::invalid_argument プランのフォーマットが不正な場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    std::vector<DeviceValue> randomRead(const ResolvedReadPlan& plan);
+
+    /// 読み取りプランを最適化して読み取る
+    /// 近接したアドレスをまとめ、一括読み出し/複数ブロック読み出し/ランダム読み出しの
+    /// うちフレーム数が最小になる組み合わせで送信する（詳細はoptimizeReadPlan()を参照）
+    /// @param plan 読み取りプラン（任意の順序）
+    /// @return 読み取った値のリスト（プランの順序）
+    /// @throws std::invalid_argument プランのフォーマットが不正な場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    std::vector<DeviceValue> readOptimized(const DeviceReadPlan& plan);
+
+    /// 最適化済みプランで読み取る
+    /// 最適化を行わないため、同じプランを周期的に読み取る場合に使用する
+    /// @param plan optimizeReadPlan()で作成したプラン
+    /// @return 読み取った値のリスト（元のプランの順序）
+    /// @throws std::invalid_argument プランのPLCシリーズが接続設定と異なる場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    std::vector<DeviceValue> readOptimized(const OptimizedReadPlan& plan);
+
+    /// 最適化済みプランで読み取り、値に変換する前のワード列を返す
+    /// 値はdecodeOptimizedRead()で取り出せる。前回のワード列と比較して変化を検出する場合に使用する
+    /// @param plan optimizeReadPlan()で作成したプラン
+    /// @return 全フレームの応答ワードを連結した列（plan.total_words個）
+    /// @throws std::invalid_argument プランのPLCシリーズが接続設定と異なる場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    std::vector<std::uint16_t> readOptimizedWords(const OptimizedReadPlan& plan);
+
+    /// 固定の読み取りセットをモニタ登録する（コマンド0x0801）
+    /// 同じデバイス群を高頻度で読み取る場合、readMonitor()と組み合わせて要求フレームを大幅に短縮する
+    /// 接続ごとに登録できるセットは1つで、別のセットを登録すると以前のセットは次回読み取り時に再登録される
+    /// @param plan 読み取りプラン（フォーマットはrandomRead()と同じ）
+    /// @return モニタ登録済みのセット
+    /// @throws std::invalid_argument プランが空、またはフォーマットが不正な場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    MonitorSet registerMonitor(const DeviceReadPlan& plan);
+
+    /// 解決済みプランでモニタ登録する（registerMonitor(DeviceReadPlan)と同じ規則）
+    MonitorSet registerMonitor(const ResolvedReadPlan& plan);
+
+    /// モニタ登録済みのセットを読み取る（コマンド0x0802）
+    /// 再接続・経路変更の後や別のセットを登録した後は、読み取りの前に自動で再登録する
+    /// @param monitor registerMonitor()で作成したセット（タイマー・シリアル番号が書き換えられる）
+    /// @return 読み取った値のリスト（プランの順序）
+    /// @throws std::invalid_argument monitorが未作成の場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    std::vector<DeviceValue> readMonitor(MonitorSet& monitor);
+
     /// 複数の非連続デバイスに一度に書き込む
     /// @param plan 書き込みプラン（各デバイスのアドレス、フォーマット、値）
     /// @throws std::invalid_argument プランのフォーマットまたは値が不正な場合
     /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
     void randomWrite(const DeviceWritePlan& plan);
 
+    /// 書き込みの組をまとめて送信する
+    /// 一括書き込みとランダム書き込みのフレームを作り、4Eフレーム設定時はパイプラインで送信する
+    /// @param batch 書き込みの組（通常はWriteQueueが作成する）
+    /// @throws std::invalid_argument 範囲と値の個数が一致しない、または範囲が1要求あたりの上限を超える場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    void writeBatch(const WriteBatch& batch);
+
+    // ========================================
+    // シャドウキャッシュ
+    // ========================================
+
+    /// シャドウキャッシュを有効/無効にする（既定は無効、無効にするとキャッシュを破棄する）
+    /// 有効な間は、ワードデバイスの読み取り結果をデバイス種別・番号ごとに取得時刻とともに保持する
+    /// 許容する古さ（max_age）を指定したreadWords()/randomRead()は、max_age以内に取得したワードをキャッシュから返し、
+    /// 古いか未取得のワードだけをPLCから読み取る（readOptimized()と同じ規則で最小限のフレームにまとめる）
+    /// - readWords()/readWordArea()の結果もキャッシュに格納する
+    /// - writeWords()は書き込んだ値でキャッシュを更新し、randomWrite()/writeMultipleBlocks()は書き込み先を未取得に戻す
+    /// - ビットデバイスとダブルワードデバイス（LZ等）はキャッシュせず、常にPLCから読み取る
+    /// - connect()、経路の変更、RUN/ラッチクリア/リセットの実行でキャッシュを破棄する
+    /// @note PLCのプログラムや他のクライアントによる変更は検出しないため、max_ageはその変化を許容できる長さにすること
+    void setCacheEnabled(bool enabled);
+
+    /// シャドウキャッシュが有効な場合true
+    bool isCacheEnabled() const noexcept;
+
+    /// キャッシュを破棄する（次回の読み取りはすべてPLCから行う）
+    void clearCache();
+
+    /// キャッシュを使ってワードデバイスを連続読み取りする
+    /// キャッシュが無効、またはワードデバイス以外の場合はreadWords(DeviceRange)と同じ
+    /// @param range 読み取り範囲（先頭デバイスと個数）
+    /// @param max_age キャッシュの値を使う古さの上限（0以下の場合は常にPLCから読み取る）
+    /// @return 読み取った値のリスト（16bit符号なし整数）
+    /// @throws std::invalid_argument 範囲が不正な場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    std::vector<std::uint16_t> readWords(const DeviceRange& range, std::chrono::milliseconds max_age);
+
+    /// キャッシュを使って複数の非連続デバイスを読み取る
+    /// キャッシュが無効な場合はrandomRead(DeviceReadPlan)と同じ
+    /// ワードデバイス以外のエントリは毎回PLCから読み取る（フォーマットはoptimizeReadPlan()と同じ規則）
+    /// @param plan 読み取りプラン
+    /// @param max_age キャッシュの値を使う古さの上限（0以下の場合は常にPLCから読み取る）
+    /// @return 読み取った値のリスト（プランの順序）
+    /// @throws std::invalid_argument プランのフォーマットが不正な場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    std::vector<DeviceValue> randomRead(const DeviceReadPlan& plan, std::chrono::milliseconds max_age);
+
+    /// 解決済みプランでキャッシュを使って読み取る（randomRead(DeviceReadPlan, max_age)と同じ規則）
+    std::vector<DeviceValue> randomRead(const ResolvedReadPlan& plan, std::chrono::milliseconds max_age);
+
     // ========================================
     // ランタイム制御
     // ========================================
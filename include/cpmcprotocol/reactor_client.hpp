@@ -0,0 +1,147 @@
+#pragma once
+
+#include "cpmcprotocol/device.hpp"
+#include "cpmcprotocol/event_transport.hpp"
+#include "cpmcprotocol/session_config.hpp"
+#include "cpmcprotocol/value_codec.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <variant>
+#include <vector>
+
+namespace cpmcprotocol {
+
+/// 利用者のイベントループ（epoll等のリアクター）から駆動するノンブロッキングMCクライアント
+/// スレッドを持たず、ソケットの準備完了の通知を受けてプロトコルを進める。操作の結果は完了キューに積まれ、
+/// pollCompletions()で取り出す
+///
+/// 駆動の手順:
+/// - connect()後、nativeHandle()を読み取り可能の監視対象に登録する（接続の確立中は待機のたびに読み直す）
+/// - wantsWrite()がtrueの間は書き込み可能も監視する（操作の開始・process*()の後に変わることがある）
+/// - 通知を受けたらprocessReadable()/processWritable()を呼ぶ
+/// - nextDeadline()を待機のタイムアウトに使い、待機の後にprocessTimeouts()を呼ぶ
+/// - pollCompletions()で完了した操作を取り出す
+/// - process*()の後にisConnected()がfalseになった場合は監視対象から外す（ソケットは閉じられている）
+///
+/// 要求の送信とタイムアウトの動作はMcAsyncClientと同じ
+/// （4Eフレームはmax_in_flight件まで、3Eフレームは1件ずつ送信し、それを超える要求は開始順に送信を待つ）
+///
+/// スレッドモデル:
+/// - スレッドセーフではない。すべての関数をリアクターのスレッドから呼ぶこと
+///
+/// 使用例:
+/// @code
+/// McReactorClient client;
+/// client.connect(config);
+/// epoll_event ev{EPOLLIN, {.fd = client.nativeHandle()}};
+/// epoll_ctl(epfd, EPOLL_CTL_ADD, client.nativeHandle(), &ev);
+///
+/// const auto id = client.readWords(makeDeviceRange("D100", 10));
+/// std::vector<McReactorClient::Completion> done;
+/// while (client.pendingCount() > 0) {
+///     // wantsWrite()に合わせてEPOLLOUTを切り替え、nextDeadline()までepoll_wait()する
+///     ...
+///     client.processReadable();
+///     client.processTimeouts();
+///     client.pollCompletions(done);
+/// }
+/// @endcode
+class McReactorClient {
+public:
+    /// 操作の識別番号（操作を開始した順に1から振られる）
+    using OperationId = std::uint64_t;
+
+    /// 操作の完了
+    struct Completion {
+        /// 結果（書き込みはstd::monostate、読み出しは操作に対応するvector）
+        using Result = std::variant<std::monostate,
+                                    std::vector<std::uint16_t>,
+                                    std::vector<bool>,
+                                    std::vector<DeviceValue>>;
+
+        OperationId id = 0;
+        /// 失敗した場合のエラー（通信エラーはTransportError、PLCエラーはstd::runtime_error）
+        std::exception_ptr error;
+        Result result;
+    };
+
+    McReactorClient();
+    ~McReactorClient();
+
+    McReactorClient(const McReactorClient&) = delete;
+    McReactorClient& operator=(const McReactorClient&) = delete;
+
+    // ========================================
+    // 接続管理
+    // ========================================
+
+    /// PLCへのノンブロッキング接続を開始する（確立を待たずに戻り、直後から操作を開始できる）
+    /// 確立はwantsWrite()で監視する書き込み可能の通知で確認する。timeout_250msのデッドラインまでに
+    /// 確立しなければ、開始済みの操作はTransportTimeoutError/TransportErrorで完了キューに積まれる
+    /// （ホスト名の名前解決だけは呼び出したスレッドで待つ）
+    /// @throws TransportError 名前解決に失敗した場合、または接続がその場で拒否された場合
+    void connect(const SessionConfig& config);
+
+    /// 切断する（実行中・送信待ちの操作はTransportErrorで完了キューに積まれる）
+    void disconnect() noexcept;
+
+    bool isConnected() const noexcept;
+
+    /// 完了していない操作の要求フレーム数（送信済み＋送信待ち）
+    std::size_t pendingCount() const noexcept;
+
+    // ========================================
+    // リアクターからの駆動
+    // ========================================
+
+    /// 監視対象のソケット（未接続の場合は無効値。接続の確立中は変わることがある）
+    NativeSocket nativeHandle() const noexcept;
+
+    /// 書き込み可能を監視する必要がある場合true
+    bool wantsWrite() const noexcept;
+
+    /// ソケットが読み取り可能（またはエラー）になったときに呼ぶ
+    void processReadable();
+
+    /// ソケットが書き込み可能になったときに呼ぶ
+    void processWritable();
+
+    /// デッドラインを超えた操作（確立しなかった接続を含む）をTransportTimeoutErrorで完了する
+    void processTimeouts();
+
+    /// 接続の確立と送信済みの要求のうち最も早いデッドライン（どちらもなければstd::nullopt）
+    /// 接続の確立中は、応答待ちの要求がなくても確立のデッドラインを返す
+    std::optional<std::chrono::steady_clock::time_point> nextDeadline() const;
+
+    /// 完了した操作を完了順にoutの末尾へ移す
+    /// @return 取り出した数
+    std::size_t pollCompletions(std::vector<Completion>& out);
+
+    /// 取り出されていない完了の数
+    std::size_t completionCount() const noexcept;
+
+    // ========================================
+    // 操作（意味と分割の動作はMcClientの同名関数と同じ）
+    // 引数の不正はstd::invalid_argumentをその場で送出し、それ以外の結果は完了キューに積まれる
+    // ========================================
+
+    OperationId readWords(const DeviceRange& range);
+    OperationId readWordArea(const DeviceAddress& head, std::size_t count);
+    OperationId readBits(const DeviceRange& range);
+    OperationId readBitArea(const DeviceAddress& head, std::size_t count);
+    OperationId writeWords(const DeviceRange& range, const std::vector<std::uint16_t>& values);
+    OperationId writeBits(const DeviceRange& range, const std::vector<bool>& values);
+    OperationId randomRead(const DeviceReadPlan& plan);
+    OperationId randomRead(const ResolvedReadPlan& plan);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace cpmcprotocol
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "cpmcprotocol/device.hpp"
+#include "cpmcprotocol/value_codec.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cpmcprotocol {
+
+/// 最適化済み読み取りプランの1フレーム
+struct OptimizedReadFrame {
+    /// フレームの種類
+    enum class Kind : std::uint8_t {
+        Batch,       // 一括読み出し（0x0401、ワード単位）
+        MultiBlock,  // 複数ブロック一括読み出し（0x0406）
+        Random       // ランダム読み出し（0x0403）
+    };
+
+    Kind kind = Kind::Batch;
+    /// Batch/MultiBlockで読み取るブロック
+    /// Batchはword_blocks[0]のみを使用し、ビットデバイスも先頭デバイスの型をWordにしてワード単位で読み出す
+    ResolvedMultiBlockRequest blocks;
+    /// Randomで読み取るデバイス
+    ResolvedRandomRequest random;
+    /// 全フレームの応答ワードを連結した列における、このフレームの先頭位置
+    std::size_t word_offset = 0;
+    /// このフレームの応答ワード数
+    std::size_t word_count = 0;
+};
+
+/// 最適化済み読み取りプラン
+/// optimizeReadPlan()で作成し、McClient::readOptimized()で繰り返し読み取る
+struct OptimizedReadPlan {
+    /// 最適化の前提としたPLCシリーズ（1要求あたりの上限とデバイス指定のサイズが異なる）
+    PlcSeries series = PlcSeries::IQ_R;
+    /// 元のプラン（解決済み、元の順序）
+    ResolvedReadPlan entries;
+    /// 送信するフレーム
+    std::vector<OptimizedReadFrame> frames;
+    /// entries[i]の値の先頭位置（全フレームの応答ワードを連結した列上）
+    std::vector<std::size_t> word_offsets;
+    /// entries[i]がBitArrayの場合、先頭ワード内のビット位置
+    std::vector<std::uint8_t> bit_offsets;
+    /// 全フレームの応答ワード数の合計
+    std::size_t total_words = 0;
+};
+
+/// 読み取りプランを最小限のフレームに変換する
+/// 同じデバイス種別の近接したアドレスは、間のワードを読む方がデバイス指定を増やすより安い場合に1つの範囲にまとめる
+/// 範囲は一括読み出し/複数ブロック読み出しで、単独の1〜4ワード値はランダム読み出しでも読めるため、
+/// フレーム数（次いで送受信バイト数）が少ない組み合わせを選ぶ
+/// 各フレームは1要求あたりの上限（ブロック数・点数）に収まる
+/// @param plan 読み取りプラン（任意の順序・重複可）
+/// @param series PLCシリーズ
+/// @return 最適化済みプラン
+/// @throws std::invalid_argument デバイス名やフォーマットが不正な場合、BitArrayをワードデバイスに指定した場合、
+///         ビットデバイスを16の倍数以外の位置からワード以外のフォーマットで読む場合
+OptimizedReadPlan optimizeReadPlan(const DeviceReadPlan& plan, PlcSeries series);
+
+/// 解決済みプランを最適化する（optimizeReadPlan(DeviceReadPlan)と同じ規則）
+OptimizedReadPlan optimizeReadPlan(const ResolvedReadPlan& plan, PlcSeries series);
+
+/// 全フレームの応答ワードを連結した列から値を取り出す
+/// @param plan 最適化済みプラン
+/// @param words 各フレームの応答ワードをframes[i].word_offsetの位置に並べた列
+/// @return 読み取った値のリスト（元のプランの順序）
+/// @throws std::invalid_argument ワード数が不足している場合
+std::vector<DeviceValue> decodeOptimizedRead(const OptimizedReadPlan& plan, const std::vector<std::uint16_t>& words);
+
+} // namespace cpmcprotocol
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+
+namespace cpmcprotocol {
+
+/// 接続状態
+/// McClient::connectionState()で取得し、McClient::setConnectionStateHandler()で変化を受け取る
+enum class ConnectionState {
+    Disconnected,  // 未接続（disconnect()の後、接続の失敗、または再接続を打ち切った後）
+    Connected,     // 接続中
+    Reconnecting,  // 接続が失われ、自動で再接続している
+};
+
+/// 接続状態の変化の通知（新しい状態, 原因）
+/// 原因はReconnecting/Disconnectedに変わった通信エラー（disconnect()による場合などはnullptr）
+using ConnectionStateHandler = std::function<void(ConnectionState, std::exception_ptr)>;
+
+/// 自動再接続の設定
+/// McClient::setReconnectPolicy()で設定する
+///
+/// 再接続の間隔は試行ごとにmultiplier倍に延ばし（max_delayまで）、jitterの割合だけランダムに短くする。
+/// 同じスイッチの先にある多数のクライアントが同時に切断されても、再接続の時刻が揃わない
+struct ReconnectPolicy {
+    bool enabled = false;                              // 自動再接続を行う
+    std::chrono::milliseconds initial_delay{500};      // 最初の再接続までの間隔
+    std::chrono::milliseconds max_delay{30000};        // 再接続の間隔の上限
+    double multiplier = 2.0;                           // 再接続に失敗するたびに間隔に掛ける倍率（1以上）
+    double jitter = 0.5;                               // 間隔をランダムに短くする割合（0〜1、1で0〜間隔の一様分布）
+    std::size_t max_attempts = 0;                      // 再接続の試行回数の上限（0は無制限）
+    std::chrono::milliseconds read_retry_timeout{5000}; // 読み取りが再接続を待つ時間（0は待たずに失敗する）
+};
+
+} // namespace cpmcprotocol
@@ -7,6 +7,7 @@
 
 #include "cpmcprotocol/communication_mode.hpp"
 #include "cpmcprotocol/device.hpp"
+#include "cpmcprotocol/frame_type.hpp"
 
 namespace cpmcprotocol {
 
@@ -34,6 +35,8 @@ struct SessionConfig {
 
     PlcSeries series = PlcSeries::IQ_R;           // PLCシリーズ
     CommunicationMode mode = CommunicationMode::Binary;  // 通信モード
+    FrameType frame_type = FrameType::Frame3E;    // フレーム種別（3E/4E）
+    std::uint16_t max_in_flight = 8;              // 4Eフレーム時に応答を待たずに送信できる最大要求数
 
     // ========================================
     // バリデーションヘルパー
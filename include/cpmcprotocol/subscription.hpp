@@ -0,0 +1,125 @@
+#pragma once
+
+#include "cpmcprotocol/device.hpp"
+#include "cpmcprotocol/value_codec.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace cpmcprotocol {
+
+class McClient;
+
+/// 購読ID（SubscriptionEngine::subscribe()が払い出す、0は無効）
+using SubscriptionId = std::uint64_t;
+
+/// 購読の更新通知
+struct SubscriptionUpdate {
+    /// 購読ID
+    SubscriptionId id = 0;
+    /// 読み取りが完了した時刻
+    std::chrono::steady_clock::time_point timestamp{};
+    /// 通知するタグの位置（subscribe()に渡したプラン上の位置、昇順）
+    std::vector<std::size_t> indices;
+    /// indices[k]のタグの値
+    std::vector<DeviceValue> values;
+};
+
+/// 購読のオプション
+struct SubscriptionOptions {
+    /// trueの場合、前回の読み取りから変化したタグだけを通知する（変化がなければコールバックを呼ばない）
+    /// 変化はタグの生のワード列で判定し、最初の読み取りでは全タグを通知する
+    bool changes_only = false;
+    /// タグごとの不感帯（changes_only指定時のみ、空またはタグと同数）
+    /// 数値フォーマットのタグは、最後に通知した値との差がこの値を超えた場合だけ通知する
+    /// 0以下、および数値以外のフォーマットのタグは不感帯なしとして扱う
+    std::vector<double> deadbands;
+};
+
+/// タグ購読エンジン
+/// タグの組を読み取り周期とコールバックとともに登録し、周期ごとに読み取って値を通知する
+/// 同じ時刻に周期が来た購読のタグはまとめてoptimizeReadPlan()で最小限のフレームに変換して読み取る
+/// 周期はエンジン作成時刻を起点とした倍数の時刻に揃えるため、100msと1sの購読は1sごとに同じ読み取りにまとまる
+///
+/// スレッドモデル:
+/// - subscribe()/unsubscribe()/poll()/run()は同じスレッドから呼ぶ（McClientは他のスレッドと共有してよい）
+/// - コールバックはpoll()を呼んだスレッド上で実行され、コールバック内からsubscribe()/unsubscribe()を呼んでもよい
+/// - 他スレッドからはstop()のみ呼び出せる
+///
+/// 使用例:
+/// @code
+/// SubscriptionEngine engine(client);
+/// engine.subscribe({{makeDeviceAddress("D100"), ValueFormat::Int16()}}, std::chrono::milliseconds(100),
+///                  [](const SubscriptionUpdate& update) {
+///                      auto level = std::get<std::int16_t>(update.values[0]);
+///                  });
+/// engine.run();  // 別スレッドからengine.stop()で終了
+/// @endcode
+class SubscriptionEngine {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void(const SubscriptionUpdate&)>;
+
+    /// @param client 読み取りに使用するクライアント（エンジンより長く生存し、接続済みであること）
+    explicit SubscriptionEngine(McClient& client);
+    ~SubscriptionEngine();
+
+    SubscriptionEngine(const SubscriptionEngine&) = delete;
+    SubscriptionEngine& operator=(const SubscriptionEngine&) = delete;
+
+    /// タグの組を購読する
+    /// 最初の読み取りは次のpoll()で行い、以降はperiodの倍数の時刻ごとに読み取る
+    /// @param tags 読み取るタグ（フォーマットはoptimizeReadPlan()と同じ規則）
+    /// @param period 読み取り周期
+    /// @param callback 読み取るたびに呼ばれるコールバック（changes_only指定時は変化があった場合のみ）
+    /// @param options 変化検出・不感帯の設定
+    /// @return 購読ID
+    /// @throws std::invalid_argument tagsが空、periodが0以下、callbackが空、
+    ///         またはdeadbandsの個数がタグと一致しない（changes_onlyなしで指定した）場合
+    SubscriptionId subscribe(const DeviceReadPlan& tags,
+                             std::chrono::milliseconds period,
+                             Callback callback,
+                             SubscriptionOptions options = {});
+
+    /// 解決済みプランで購読する（subscribe(DeviceReadPlan)と同じ規則）
+    SubscriptionId subscribe(const ResolvedReadPlan& tags,
+                             std::chrono::milliseconds period,
+                             Callback callback,
+                             SubscriptionOptions options = {});
+
+    /// 購読を解除する
+    /// @return 購読が存在した場合true
+    bool unsubscribe(SubscriptionId id);
+
+    /// 周期が来た購読をまとめて読み取り、コールバックを呼ぶ
+    /// 読み取りに失敗した場合も、該当する購読は次の周期に進めてから例外を送出する
+    /// @param now 現在時刻
+    /// @return 読み取った購読の数
+    /// @throws std::invalid_argument タグのフォーマットが不正な場合
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    std::size_t poll(Clock::time_point now = Clock::now());
+
+    /// 次に周期が来る時刻（購読がない場合はstd::nullopt）
+    std::optional<Clock::time_point> nextDue() const;
+
+    /// stop()が呼ばれるまで、周期の時刻まで待機してpoll()を繰り返す
+    /// @throws std::runtime_error poll()が例外を送出した場合（そのまま伝播する）
+    void run();
+
+    /// run()を終了させる（スレッドセーフ）
+    void stop();
+
+    /// 購読数
+    std::size_t size() const noexcept;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace cpmcprotocol
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace cpmcprotocol {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+// Task の promise に共通する部分（完了時に待機中のコルーチンへ制御を移す）
+class TaskPromiseBase {
+public:
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            if (auto continuation = handle.promise().continuation_) {
+                return continuation;
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { error_ = std::current_exception(); }
+
+    void setContinuation(std::coroutine_handle<> continuation) noexcept { continuation_ = continuation; }
+
+protected:
+    void rethrowIfFailed() const {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+private:
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr error_;
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase {
+public:
+    Task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& value) {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    T result() {
+        rethrowIfFailed();
+        return std::move(*value_);
+    }
+
+private:
+    std::optional<T> value_;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+    Task<void> get_return_object() noexcept;
+    void return_void() noexcept {}
+    void result() const { rethrowIfFailed(); }
+};
+
+// spawn() が作る、誰にも待たれないコルーチン（完了時に自身を破棄する）
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+} // namespace detail
+
+/// 結果をco_awaitで受け取るコルーチン
+/// 呼び出した時点では実行せず、co_awaitされた時点（またはspawn()に渡した時点）で開始する
+/// 完了すると待機していたコルーチンをそのスレッドで再開する（コルーチン内の例外はco_await側に送出される）
+///
+/// 使用例:
+/// @code
+/// Task<std::uint16_t> readLevel(McAsyncClient& client) {
+///     auto words = co_await client.readWords(makeDeviceRange("D100", 1));
+///     co_return words[0];
+/// }
+///
+/// Task<> poll(McAsyncClient& client) {
+///     auto level = co_await readLevel(client);
+/// }
+/// @endcode
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept { return handle && handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> waiting) noexcept {
+                if (!handle) {
+                    return waiting; // ムーブ元の Task: すぐに再開して await_resume() で送出する
+                }
+                handle.promise().setContinuation(waiting);
+                return handle;
+            }
+
+            T await_resume() {
+                if (!handle) {
+                    throw std::logic_error("Task has no coroutine");
+                }
+                return handle.promise().result();
+            }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    friend class detail::TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+inline DetachedTask runDetached(Task<void> task, std::function<void(std::exception_ptr)> on_error) {
+    try {
+        co_await std::move(task);
+    } catch (...) {
+        if (!on_error) {
+            throw;
+        }
+        on_error(std::current_exception());
+    }
+}
+
+} // namespace detail
+
+/// タスクを待たずに開始する（最初の中断点まで呼び出したスレッドで実行する）
+/// タスクは完了時に破棄される。McAsyncClientの操作を待つタスクはEventLoopのスレッドで開始すること
+/// @param on_error タスクが例外で終了した場合に呼ばれる（未指定の場合はstd::terminate()）
+inline void spawn(Task<void> task, std::function<void(std::exception_ptr)> on_error = {}) {
+    detail::runDetached(std::move(task), std::move(on_error));
+}
+
+} // namespace cpmcprotocol
@@ -4,8 +4,10 @@
 
 #include <chrono>
 #include <cstdint>
+#include <exception>
 #include <functional>
 #include <memory>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -22,6 +24,13 @@ public:
     explicit TransportTimeoutError(const std::string& message);
 };
 
+/// 自動再接続の間に要求を送信せずに失敗させた場合の例外（McClient::setReconnectPolicy()）
+/// 要求はPLCに届いていないため、再接続の後に送り直してよい
+class TransportReconnectingError : public TransportError {
+public:
+    explicit TransportReconnectingError(const std::string& message);
+};
+
 class TcpTransport {
 public:
     TcpTransport();
@@ -32,7 +41,20 @@ public:
     TcpTransport(TcpTransport&&) noexcept;
     TcpTransport& operator=(TcpTransport&&) noexcept;
 
+    /// config.host/portへ接続する
+    /// ソケットはノンブロッキングで接続し、timeout_250ms×250ms（最小250ms）のデッドラインで打ち切る
+    /// 名前解決の結果が複数ある場合はIPv4/IPv6を交互に、250msごとに並行して試す（Happy Eyeballs）
+    /// @throws TransportTimeoutError デッドラインまでに接続できなかった場合
+    /// @throws TransportError 名前解決または接続に失敗した場合
     void connect(const SessionConfig& config);
+
+    /// 複数のトランスポートをまとめて接続する（transports[i]をconfigs[i]へ接続する）
+    /// すべての接続を並行して進めるため、所要時間は最も遅い接続先のデッドラインまでに収まる
+    /// @return transportsと同じ順の接続結果（成功はnullptr、失敗はconnect()が送出する例外）
+    /// @throws std::invalid_argument 要素数が一致しない場合、nullptrまたは重複を含む場合
+    static std::vector<std::exception_ptr> connectAll(std::span<TcpTransport* const> transports,
+                                                      std::span<const SessionConfig> configs);
+
     void disconnect() noexcept;
     bool isConnected() const noexcept;
 
@@ -42,13 +64,28 @@ public:
     void sendAll(const std::uint8_t* data, std::size_t size);
     void sendAll(const std::vector<std::uint8_t>& data);
 
+    /// 複数のバッファを順に送信する（sendmsg/WSASendによるギャザー送信）
+    /// 連続する要求フレームを1回のシステムコールで渡すため、TCP_NODELAYでも小さなセグメントに分かれにくい
+    /// @throws TransportTimeoutError 送信タイムアウトの場合
+    /// @throws TransportError 送信に失敗した場合（接続は切断される）
+    void sendAll(std::span<const std::span<const std::uint8_t>> buffers);
+
     std::size_t receiveSome(std::uint8_t* buffer, std::size_t capacity);
     void receiveAll(std::uint8_t* buffer, std::size_t expected);
     std::vector<std::uint8_t> receiveAll(std::size_t expected);
     std::vector<std::uint8_t> receiveFrame(std::size_t header_size,
                                            const std::function<std::size_t(const std::uint8_t*, std::size_t)>& length_extractor);
 
+    /// 1フレームを接続ごとの受信バッファに受信し、そのビューを返す
+    /// recvはバッファの空き容量分まとめて読み込み、後続フレームの先読み分は次回の受信で使用する
+    /// @return 受信バッファ内のフレーム（次の受信系呼び出しまたは切断まで有効）
+    /// @throws TransportError 受信に失敗した場合（接続は切断される）
+    std::span<const std::uint8_t> receiveFrameView(std::size_t header_size,
+                                                   const std::function<std::size_t(const std::uint8_t*, std::size_t)>& length_extractor);
+
 private:
+    std::size_t receiveFromSocket(std::uint8_t* buffer, std::size_t capacity);
+    void fillReceiveBuffer(std::size_t needed);
     void ensureConnected() const;
     void applySocketOptions();
     bool isTimeoutError(int error_code) const;
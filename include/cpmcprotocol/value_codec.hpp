@@ -3,6 +3,7 @@
 #include "cpmcprotocol/device.hpp"
 
 #include <cstdint>
+#include <span>
 #include <string>
 #include <variant>
 #include <vector>
@@ -77,6 +78,20 @@ struct DeviceReadPlanEntry {
 /// 複数のデバイスを一度に読み取る際の計画
 using DeviceReadPlan = std::vector<DeviceReadPlanEntry>;
 
+/// 解決済みデバイスによる読み取りプランのエントリ（24バイト、トリビアルコピー可能）
+/// 数万点のタグを保持する場合はDeviceReadPlanEntryの代わりに使用する
+struct ResolvedReadPlanEntry {
+    ResolvedDevice address;  // 読み取り対象の解決済みデバイスアドレス
+    ValueFormat format;      // 読み取るデータのフォーマット
+};
+
+/// 解決済みデバイスによる読み取りプラン
+using ResolvedReadPlan = std::vector<ResolvedReadPlanEntry>;
+
+/// 読み取りプランの全デバイスを解決する
+/// @throws std::invalid_argument デバイス名が不正な場合
+ResolvedReadPlan resolveReadPlan(const DeviceReadPlan& plan);
+
 /// デバイス書き込みプランのエントリ
 /// どのデバイスにどの値を書き込むかを指定
 struct DeviceWritePlanEntry {
@@ -100,6 +115,9 @@ public:
     /// @throws std::invalid_argument データサイズが不足している場合
     std::vector<DeviceValue> decode(const DeviceReadPlan& plan, const std::vector<std::uint16_t>& words) const;
 
+    /// 解決済みプランでワードデータをデコードする（decode(DeviceReadPlan)と同じ規則）
+    std::vector<DeviceValue> decode(const ResolvedReadPlan& plan, const std::vector<std::uint16_t>& words) const;
+
     /// 値のリストをエンコードしてワードデータに変換する
     /// @param plan 書き込みプラン（各デバイスのフォーマットと値）
     /// @return エンコードされたワードデータ
@@ -117,14 +135,14 @@ public:
     // ========================================
 
     /// バイナリバイト列からワード列に変換する
-    /// @param bytes バイナリバイト列（リトルエンディアン）
+    /// @param bytes バイナリバイト列（リトルエンディアン、受信フレーム内のビューも可）
     /// @return ワード列
-    static std::vector<std::uint16_t> fromBinaryBytes(const std::vector<std::uint8_t>& bytes);
+    static std::vector<std::uint16_t> fromBinaryBytes(std::span<const std::uint8_t> bytes);
 
     /// ASCIIワード表現（16進数文字列）からワード列に変換する
     /// @param ascii ASCII表現のバイト列（4文字=1ワード）
     /// @return ワード列
-    static std::vector<std::uint16_t> fromAsciiWords(const std::vector<std::uint8_t>& ascii);
+    static std::vector<std::uint16_t> fromAsciiWords(std::span<const std::uint8_t> ascii);
 
     /// ワード列をバイナリバイト列に変換する
     /// @param words ワード列
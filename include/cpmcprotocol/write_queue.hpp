@@ -0,0 +1,101 @@
+#pragma once
+
+#include "cpmcprotocol/device.hpp"
+#include "cpmcprotocol/value_codec.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace cpmcprotocol {
+
+class McClient;
+
+/// 書き込みキューのオプション
+struct WriteQueueOptions {
+    /// run()中、最初の書き込みが積まれてから送信するまでの最大の待ち時間
+    /// この間に積まれた書き込みは1回の送信にまとまる
+    std::chrono::milliseconds max_delay{5};
+    /// 連続する点（ワードデバイスはワード、ビットデバイスはビット）がこの数以上の区間は一括書き込み、
+    /// 未満の区間はランダム書き込みで送信する
+    std::size_t batch_threshold = 8;
+};
+
+/// 書き込みを合成するキュー（ライトビハインド）
+/// 積まれた書き込みをデバイスごとの値として保持し（同じデバイスへの書き込みは最後の値が残る）、送信時に
+/// - 連続する区間は一括書き込み（コマンド0x1401）の1フレームに
+/// - 離れた点はランダム書き込み（コマンド0x1402）にまとめ（1要求の点数上限ごとに分割する）
+/// McClient::writeBatch()でまとめて送信する
+/// 送信はデバイスごとに最後の値を書き込むだけで、積んだ順序はデバイスをまたいでは保たない
+/// 順序が必要な書き込みの間ではflush()/fence()で先の書き込みの完了を待つこと
+/// ダブルワードデバイス（LZ等）は扱わない（McClient::randomWrite()を直接使用する）
+///
+/// スレッドモデル:
+/// - writeWords()/writeBits()/randomWrite()/fence()/stop()/pendingPoints()はどのスレッドから呼んでもよい
+/// - flush()/run()は同時に1つのスレッドからだけ呼ぶ（McClientは他のスレッドと共有してよい）
+///
+/// 使用例:
+/// @code
+/// WriteQueue queue(client);
+/// std::thread writer([&] { queue.run(); });
+///
+/// queue.writeWords(makeDeviceRange("D100", 1), {42});  // 他のスレッドから積んでもよい
+/// queue.writeBits(makeDeviceRange("M10", 1), {true});
+/// queue.fence();  // ここまでに積んだ書き込みの完了を待つ
+///
+/// queue.stop();  // 残りの書き込みを送信してrun()を終了する
+/// writer.join();
+/// @endcode
+class WriteQueue {
+public:
+    /// @param client 送信に使用するクライアント（キューより長く生存し、接続済みであること）
+    /// @param options 送信の待ち時間と一括書き込みにする区間の長さ
+    /// @throws std::invalid_argument batch_thresholdが0の場合
+    explicit WriteQueue(McClient& client, WriteQueueOptions options = {});
+    ~WriteQueue();
+
+    WriteQueue(const WriteQueue&) = delete;
+    WriteQueue& operator=(const WriteQueue&) = delete;
+
+    /// ワードデバイスへの連続書き込みを積む（McClient::writeWords()と同じ意味）
+    /// @throws std::invalid_argument デバイス名が不正、または値の個数が範囲に対して不足している場合
+    void writeWords(const DeviceRange& range, const std::vector<std::uint16_t>& values);
+
+    /// ビットデバイスへの連続書き込みを積む（McClient::writeBits()と同じ意味）
+    /// @throws std::invalid_argument デバイス名が不正、または値の個数が範囲に対して不足している場合
+    void writeBits(const DeviceRange& range, const std::vector<bool>& values);
+
+    /// 非連続デバイスへの書き込みを積む（McClient::randomWrite()と同じ意味）
+    /// ビットデバイスへのワード系フォーマットは16点単位、BitArrayは先頭から連続する点として扱う
+    /// @throws std::invalid_argument デバイス名・フォーマット・値が不正な場合（プラン全体を積まない）
+    void randomWrite(const DeviceWritePlan& plan);
+
+    /// 積まれた書き込みをすべて送信する
+    /// 送信に失敗した場合、送信できなかった可能性のある書き込みはキューに戻す（その後に積まれた値が優先される）
+    /// @return 送信した点数（ワードデバイスはワード数、ビットデバイスはビット数）
+    /// @throws std::runtime_error 通信エラーまたはPLCエラーの場合
+    std::size_t flush();
+
+    /// run()中に、この呼び出しまでに積まれた書き込みの送信完了を待つ（待ち時間を待たずにすぐ送信させる）
+    /// @throws std::runtime_error 送信に失敗した場合、またはrun()が実行されていない（終了した）場合
+    void fence();
+
+    /// stop()が呼ばれるまで、書き込みが積まれるたびに最大max_delay待ってflush()を繰り返す
+    /// stop()では残りの書き込みを送信してから終了する
+    /// @throws std::runtime_error flush()が例外を送出した場合（そのまま伝播する）
+    void run();
+
+    /// run()を終了させる（スレッドセーフ）
+    void stop();
+
+    /// 送信待ちの点数
+    std::size_t pendingPoints() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace cpmcprotocol
@@ -0,0 +1,83 @@
+#include "cpmcprotocol/async_client.hpp"
+
+// コルーチン向けの非同期 MC クライアント。
+// 要求の送信と応答の対応付けは AsyncSession が行い、ここでは操作を AsyncOperation に包む。
+
+#include "async_session.hpp"
+
+namespace cpmcprotocol {
+
+struct McAsyncClient::Impl {
+    explicit Impl(EventLoop& loop) : session(loop) {}
+
+    detail::AsyncSession session;
+};
+
+McAsyncClient::McAsyncClient(EventLoop& loop) : impl_(std::make_unique<Impl>(loop)) {}
+
+McAsyncClient::~McAsyncClient() {
+    // トランスポートの破棄より先に、未完了の操作を Impl が有効なうちに完了させる
+    disconnect();
+}
+
+void McAsyncClient::connect(const SessionConfig& config) {
+    impl_->session.connect(config);
+}
+
+void McAsyncClient::disconnect() noexcept {
+    impl_->session.disconnect();
+}
+
+bool McAsyncClient::isConnected() const noexcept {
+    return impl_->session.transport().isConnected();
+}
+
+std::size_t McAsyncClient::pendingCount() const noexcept {
+    return impl_->session.pendingCount();
+}
+
+AsyncOperation<std::vector<std::uint16_t>> McAsyncClient::readWords(const DeviceRange& range) {
+    return readWordArea(range.head, range.length);
+}
+
+AsyncOperation<std::vector<std::uint16_t>> McAsyncClient::readWordArea(const DeviceAddress& head, std::size_t count) {
+    return AsyncOperation<std::vector<std::uint16_t>>([session = &impl_->session, head, count](auto callback) {
+        session->readWordArea(head, count, std::move(callback));
+    });
+}
+
+AsyncOperation<std::vector<bool>> McAsyncClient::readBits(const DeviceRange& range) {
+    return readBitArea(range.head, range.length);
+}
+
+AsyncOperation<std::vector<bool>> McAsyncClient::readBitArea(const DeviceAddress& head, std::size_t count) {
+    return AsyncOperation<std::vector<bool>>([session = &impl_->session, head, count](auto callback) {
+        session->readBitArea(head, count, std::move(callback));
+    });
+}
+
+AsyncOperation<void> McAsyncClient::writeWords(const DeviceRange& range, std::vector<std::uint16_t> values) {
+    return AsyncOperation<void>([session = &impl_->session, range, values = std::move(values)](auto callback) {
+        session->writeWords(range, values, std::move(callback));
+    });
+}
+
+AsyncOperation<void> McAsyncClient::writeBits(const DeviceRange& range, std::vector<bool> values) {
+    return AsyncOperation<void>([session = &impl_->session, range, values = std::move(values)](auto callback) {
+        session->writeBits(range, values, std::move(callback));
+    });
+}
+
+AsyncOperation<std::vector<DeviceValue>> McAsyncClient::randomRead(const DeviceReadPlan& plan) {
+    return AsyncOperation<std::vector<DeviceValue>>([session = &impl_->session, plan](auto callback) {
+        session->randomRead(plan, std::move(callback));
+    });
+}
+
+AsyncOperation<std::vector<DeviceValue>> McAsyncClient::randomRead(const ResolvedReadPlan& plan) {
+    return AsyncOperation<std::vector<DeviceValue>>([session = &impl_->session, plan](auto callback) {
+        session->randomRead(plan, std::move(callback));
+    });
+}
+
+} // namespace cpmcprotocol
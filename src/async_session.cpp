@@ -0,0 +1,286 @@
+#include "async_session.hpp"
+
+#include "client_codec.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+namespace cpmcprotocol::detail {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void checkRange(const ResolvedDevice& head, std::size_t count) {
+    if (count == 0) {
+        throw std::invalid_argument("DeviceRange.length must be greater than zero");
+    }
+    if (count - 1 > std::numeric_limits<std::uint32_t>::max() - head.number) {
+        throw std::invalid_argument("Device range exceeds the device number space");
+    }
+}
+
+} // namespace
+
+AsyncSession::AsyncSession(EventLoop& loop) : transport_(loop) {}
+
+AsyncSession::AsyncSession() = default;
+
+void AsyncSession::connect(const SessionConfig& config) {
+    transport_.connect(config);
+    config_ = config;
+}
+
+void AsyncSession::disconnect() noexcept {
+    // 送信済みの操作はトランスポートの完了通知で、送信待ちの操作はここで失敗させる。
+    // どちらも pump() を通さず、完了通知から送出された例外は noexcept の外へ出さない
+    // （操作の失敗は各操作の完了通知に渡している）。
+    disconnecting_ = true;
+    transport_.disconnect();
+    const auto error = std::make_exception_ptr(TransportError("Client is not connected"));
+    while (!queue_.empty()) {
+        QueuedFrame next = std::move(queue_.front());
+        queue_.pop_front();
+        if (!next.exchange->error) {
+            next.exchange->error = error;
+        }
+        try {
+            finishFrame(next.exchange);
+        } catch (...) {
+        }
+    }
+    disconnecting_ = false;
+}
+
+std::size_t AsyncSession::pendingCount() const noexcept {
+    return queue_.size() + in_flight_;
+}
+
+std::size_t AsyncSession::window() const {
+    // 3E フレームはシリアル番号を持たないため、McClient と同じく 1 件ずつ往復する
+    return config_.frame_type == FrameType::Frame4E ? std::max<std::size_t>(1, config_.max_in_flight) : 1;
+}
+
+Clock::duration AsyncSession::timeout() const {
+    return std::chrono::milliseconds(250) * std::max<std::uint16_t>(1, config_.timeout_250ms);
+}
+
+// 操作の要求フレームを送信待ちに積む。
+void AsyncSession::start(std::vector<std::vector<std::uint8_t>> requests,
+                         std::function<void(std::size_t, std::span<const std::uint8_t>)> on_frame,
+                         std::function<void(std::exception_ptr)> on_done) {
+    auto exchange = std::make_shared<Exchange>();
+    exchange->remaining = requests.size();
+    exchange->requests = std::move(requests);
+    exchange->on_frame = std::move(on_frame);
+    exchange->on_done = std::move(on_done);
+    for (std::size_t i = 0; i < exchange->remaining; ++i) {
+        queue_.push_back(QueuedFrame{exchange, i});
+    }
+    pump();
+}
+
+// 送信できる数まで送信待ちのフレームをトランスポートに渡す。
+// 完了通知から呼ばれた操作が再入しても、列の状態は常に整合している。
+void AsyncSession::pump() {
+    // 窓に空きができた分のフレームは 1 回の送信にまとめる
+    transport_.cork();
+    try {
+        submitQueued();
+    } catch (...) {
+        transport_.uncork();
+        throw;
+    }
+    transport_.uncork();
+}
+
+void AsyncSession::submitQueued() {
+    while (in_flight_ < window() && !queue_.empty()) {
+        QueuedFrame next = std::move(queue_.front());
+        queue_.pop_front();
+        Exchange& exchange = *next.exchange;
+        if (exchange.error) {
+            // 失敗した操作の残りのフレームは送信しない
+            finishFrame(next.exchange);
+            continue;
+        }
+        if (!transport_.isConnected()) {
+            exchange.error = std::make_exception_ptr(TransportError("Client is not connected"));
+            finishFrame(next.exchange);
+            continue;
+        }
+
+        auto& request = exchange.requests[next.index];
+        std::optional<std::uint16_t> key;
+        if (config_.frame_type == FrameType::Frame4E) {
+            key = next_serial_++;
+            codec::FrameEncoder::setSerialNumber(request, *key);
+        }
+        ++in_flight_;
+        transport_.submit(std::move(request), key, Clock::now() + timeout(),
+                          [this, next](std::exception_ptr error, std::vector<std::uint8_t> frame) {
+                              --in_flight_;
+                              if (disconnecting_) {
+                                  // disconnect() の中から呼ばれた場合は送信せず、例外も送出しない
+                                  try {
+                                      complete(next, std::move(error), frame);
+                                  } catch (...) {
+                                  }
+                                  return;
+                              }
+                              complete(next, std::move(error), frame);
+                              pump();
+                          });
+    }
+}
+
+void AsyncSession::complete(const QueuedFrame& entry,
+                            std::exception_ptr error,
+                            const std::vector<std::uint8_t>& frame) {
+    Exchange& exchange = *entry.exchange;
+    if (!exchange.error) {
+        if (error) {
+            exchange.error = std::move(error);
+        } else {
+            try {
+                exchange.on_frame(entry.index, frame);
+            } catch (...) {
+                exchange.error = std::current_exception();
+            }
+        }
+    }
+    finishFrame(entry.exchange);
+}
+
+void AsyncSession::finishFrame(const std::shared_ptr<Exchange>& exchange) {
+    if (--exchange->remaining > 0) {
+        return;
+    }
+    // 完了通知の中で操作が再開しても呼び出し中の関数オブジェクトが破棄されないよう、取り出してから呼ぶ
+    auto on_done = std::move(exchange->on_done);
+    on_done(exchange->error);
+}
+
+// 一括読み出しを 1 要求あたりの点数上限ごとに分割して送信する。
+// decode(オフセット, 点数, フレーム) で各応答を結果に格納し、finish(エラー) で完了を通知する。
+void AsyncSession::readBatch(const ResolvedDevice& head,
+                             std::size_t count,
+                             std::function<void(std::size_t, std::size_t, std::span<const std::uint8_t>)> decode,
+                             std::function<void(std::exception_ptr)> finish) {
+    checkRange(head, count);
+    const std::size_t limit = codec::FrameEncoder::maxBatchReadPoints(head.type);
+    const std::size_t chunks = (count + limit - 1) / limit;
+    std::vector<std::vector<std::uint8_t>> requests(chunks);
+    for (std::size_t i = 0; i < chunks; ++i) {
+        ResolvedRange chunk{head, static_cast<std::uint16_t>(std::min(limit, count - i * limit))};
+        chunk.head.number += static_cast<std::uint32_t>(i * limit);
+        frame_encoder_.makeBatchReadRequest(requests[i], config_, chunk);
+    }
+    start(std::move(requests),
+          [decode = std::move(decode), limit, count](std::size_t index, std::span<const std::uint8_t> frame) {
+              const std::size_t offset = index * limit;
+              decode(offset, std::min(limit, count - offset), frame);
+          },
+          std::move(finish));
+}
+
+void AsyncSession::readWordArea(const DeviceAddress& head,
+                                std::size_t count,
+                                Callback<std::vector<std::uint16_t>> callback) {
+    auto result = std::make_shared<std::vector<std::uint16_t>>(count);
+    const auto mode = config_.mode;
+    readBatch(
+        resolveDevice(head), count,
+        [this, result, mode](std::size_t offset, std::size_t length, std::span<const std::uint8_t> frame) {
+            const auto words = decodeWords(frame_decoder_, frame, mode, length);
+            std::copy(words.begin(), words.end(), result->begin() + static_cast<std::ptrdiff_t>(offset));
+        },
+        [result, callback = std::move(callback)](std::exception_ptr error) {
+            callback(error, error ? std::vector<std::uint16_t>{} : std::move(*result));
+        });
+}
+
+void AsyncSession::readBitArea(const DeviceAddress& head, std::size_t count, Callback<std::vector<bool>> callback) {
+    auto result = std::make_shared<std::vector<bool>>(count);
+    const auto mode = config_.mode;
+    readBatch(
+        resolveDevice(head), count,
+        [this, result, mode](std::size_t offset, std::size_t length, std::span<const std::uint8_t> frame) {
+            decodeBits(frame_decoder_, frame, mode, *result, offset, length);
+        },
+        [result, callback = std::move(callback)](std::exception_ptr error) {
+            callback(error, error ? std::vector<bool>{} : std::move(*result));
+        });
+}
+
+// 応答にデータを持たない 1 フレームの要求（書き込み）を送信する。
+void AsyncSession::sendCommand(std::vector<std::uint8_t> request, Callback<std::monostate> callback) {
+    std::vector<std::vector<std::uint8_t>> requests;
+    requests.push_back(std::move(request));
+    const auto mode = config_.mode;
+    start(std::move(requests),
+          [this, mode](std::size_t, std::span<const std::uint8_t> frame) {
+              const auto response = frame_decoder_.parseResponse(frame);
+              ensureCompletion(response.completion_code, response.diagnostic_data, mode);
+          },
+          [callback = std::move(callback)](std::exception_ptr error) { callback(error, std::monostate{}); });
+}
+
+void AsyncSession::writeWords(const DeviceRange& range,
+                              const std::vector<std::uint16_t>& values,
+                              Callback<std::monostate> callback) {
+    if (values.size() < range.length) {
+        throw std::invalid_argument("Insufficient word data for write");
+    }
+    std::vector<std::uint8_t> request;
+    frame_encoder_.makeBatchWriteRequest(request, config_, range, values);
+    sendCommand(std::move(request), std::move(callback));
+}
+
+void AsyncSession::writeBits(const DeviceRange& range,
+                             const std::vector<bool>& values,
+                             Callback<std::monostate> callback) {
+    if (values.size() < range.length) {
+        throw std::invalid_argument("Insufficient bit data for write");
+    }
+    std::vector<std::uint16_t> bit_words(values.size());
+    std::transform(values.begin(), values.end(), bit_words.begin(), [](bool bit) { return bit ? 1U : 0U; });
+    std::vector<std::uint8_t> request;
+    frame_encoder_.makeBatchWriteRequest(request, config_, range, bit_words);
+    sendCommand(std::move(request), std::move(callback));
+}
+
+// ランダム読み出し。Request は RandomDeviceRequest / ResolvedRandomRequest、Plan は対応する読み取りプラン。
+template <typename Request, typename Plan>
+void AsyncSession::randomReadImpl(const Plan& plan, Callback<std::vector<DeviceValue>> callback) {
+    auto shared_plan = std::make_shared<const Plan>(plan);
+    auto chunks = std::make_shared<const std::vector<RandomReadChunk<Request>>>(
+        splitRandomRead<Request>(*shared_plan, codec::FrameEncoder::randomAccessLimits(config_.series).read_points));
+    std::vector<std::vector<std::uint8_t>> requests(chunks->size());
+    for (std::size_t i = 0; i < chunks->size(); ++i) {
+        frame_encoder_.makeRandomReadRequest(requests[i], config_, (*chunks)[i].request);
+    }
+
+    auto results = std::make_shared<std::vector<DeviceValue>>(shared_plan->size());
+    const auto mode = config_.mode;
+    start(std::move(requests),
+          [this, shared_plan, chunks, results, mode](std::size_t index, std::span<const std::uint8_t> frame) {
+              decodeRandomResponse(frame_decoder_, value_codec_, *shared_plan, (*chunks)[index].order, frame, mode,
+                                   *results);
+          },
+          [results, callback = std::move(callback)](std::exception_ptr error) {
+              callback(error, error ? std::vector<DeviceValue>{} : std::move(*results));
+          });
+}
+
+void AsyncSession::randomRead(const DeviceReadPlan& plan, Callback<std::vector<DeviceValue>> callback) {
+    randomReadImpl<RandomDeviceRequest>(plan, std::move(callback));
+}
+
+void AsyncSession::randomRead(const ResolvedReadPlan& plan, Callback<std::vector<DeviceValue>> callback) {
+    randomReadImpl<ResolvedRandomRequest>(plan, std::move(callback));
+}
+
+} // namespace cpmcprotocol::detail
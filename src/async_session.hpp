@@ -0,0 +1,113 @@
+#pragma once
+
+// McAsyncClient と McReactorClient が共有する、イベント駆動の MC セッション。
+// 操作ごとの要求フレームを送信待ちの列に積み、送信できる数（4E は max_in_flight、3E は 1）まで
+// AsyncTcpTransport に渡す。応答をすべて受け取った（または失敗した）操作の完了通知を呼ぶ。
+// 完了通知はトランスポートを駆動したスレッド（EventLoop または利用者のイベントループ）で呼ばれる。
+// ライブラリの内部でのみ使用し、公開ヘッダーからは参照しない。
+
+#include "cpmcprotocol/codec/frame_decoder.hpp"
+#include "cpmcprotocol/codec/frame_encoder.hpp"
+#include "cpmcprotocol/device.hpp"
+#include "cpmcprotocol/event_transport.hpp"
+#include "cpmcprotocol/session_config.hpp"
+#include "cpmcprotocol/value_codec.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <span>
+#include <variant>
+#include <vector>
+
+namespace cpmcprotocol::detail {
+
+class AsyncSession {
+public:
+    /// 完了通知（成功時は error が nullptr）。書き込みの値は std::monostate
+    template <typename T>
+    using Callback = std::function<void(std::exception_ptr error, T value)>;
+
+    /// EventLoop に登録したトランスポートで通信する
+    explicit AsyncSession(EventLoop& loop);
+    /// 利用者のイベントループから駆動するトランスポートで通信する
+    AsyncSession();
+
+    AsyncSession(const AsyncSession&) = delete;
+    AsyncSession& operator=(const AsyncSession&) = delete;
+
+    void connect(const SessionConfig& config);
+
+    /// 切断し、実行中・送信待ちの操作を TransportError で完了する
+    void disconnect() noexcept;
+
+    /// 完了していない操作の要求フレーム数（送信済み＋送信待ち）
+    std::size_t pendingCount() const noexcept;
+
+    AsyncTcpTransport& transport() noexcept { return transport_; }
+    const AsyncTcpTransport& transport() const noexcept { return transport_; }
+
+    // 操作（意味と分割の動作は McClient の同名関数と同じ）。
+    // 引数の不正は std::invalid_argument としてその場で送出し、それ以外のエラーは callback に渡す。
+    void readWordArea(const DeviceAddress& head, std::size_t count, Callback<std::vector<std::uint16_t>> callback);
+    void readBitArea(const DeviceAddress& head, std::size_t count, Callback<std::vector<bool>> callback);
+    void writeWords(const DeviceRange& range,
+                    const std::vector<std::uint16_t>& values,
+                    Callback<std::monostate> callback);
+    void writeBits(const DeviceRange& range, const std::vector<bool>& values, Callback<std::monostate> callback);
+    void randomRead(const DeviceReadPlan& plan, Callback<std::vector<DeviceValue>> callback);
+    void randomRead(const ResolvedReadPlan& plan, Callback<std::vector<DeviceValue>> callback);
+
+private:
+    // 1 つの操作の要求フレーム。応答を受信するたびに on_frame(要求インデックス, フレーム) を呼び、
+    // すべての応答を受け取るか失敗すると on_done(エラー) を 1 回呼ぶ。
+    struct Exchange {
+        std::vector<std::vector<std::uint8_t>> requests;
+        std::function<void(std::size_t, std::span<const std::uint8_t>)> on_frame;
+        std::function<void(std::exception_ptr)> on_done;
+        std::size_t remaining = 0;
+        std::exception_ptr error;
+    };
+
+    struct QueuedFrame {
+        std::shared_ptr<Exchange> exchange;
+        std::size_t index = 0;
+    };
+
+    std::size_t window() const;
+    std::chrono::steady_clock::duration timeout() const;
+
+    void start(std::vector<std::vector<std::uint8_t>> requests,
+               std::function<void(std::size_t, std::span<const std::uint8_t>)> on_frame,
+               std::function<void(std::exception_ptr)> on_done);
+    void pump();
+    void submitQueued();
+    void complete(const QueuedFrame& entry, std::exception_ptr error, const std::vector<std::uint8_t>& frame);
+    void finishFrame(const std::shared_ptr<Exchange>& exchange);
+
+    void readBatch(const ResolvedDevice& head,
+                   std::size_t count,
+                   std::function<void(std::size_t, std::size_t, std::span<const std::uint8_t>)> decode,
+                   std::function<void(std::exception_ptr)> finish);
+    void sendCommand(std::vector<std::uint8_t> request, Callback<std::monostate> callback);
+
+    template <typename Request, typename Plan>
+    void randomReadImpl(const Plan& plan, Callback<std::vector<DeviceValue>> callback);
+
+    AsyncTcpTransport transport_;
+    SessionConfig config_{};
+    codec::FrameEncoder frame_encoder_;
+    codec::FrameDecoder frame_decoder_;
+    ValueCodec value_codec_;
+
+    std::deque<QueuedFrame> queue_;
+    std::size_t in_flight_ = 0;
+    std::uint16_t next_serial_ = 0;
+    bool disconnecting_ = false; // disconnect() の実行中（完了通知から送信を再開しない）
+};
+
+} // namespace cpmcprotocol::detail
@@ -0,0 +1,79 @@
+#include "client_codec.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+namespace cpmcprotocol::detail {
+
+std::vector<std::uint16_t> decodeWords(const codec::FrameDecoder& frame_decoder,
+                                       std::span<const std::uint8_t> frame,
+                                       CommunicationMode mode,
+                                       std::size_t length) {
+    const auto response = frame_decoder.parseResponse(frame);
+    ensureCompletion(response.completion_code, response.diagnostic_data, mode);
+
+    std::vector<std::uint16_t> words;
+    if (mode == CommunicationMode::Ascii) {
+        words = ValueCodec::fromAsciiWords(response.device_data);
+    } else {
+        words = ValueCodec::fromBinaryBytes(response.device_data);
+    }
+
+    if (words.size() < length) {
+        throw std::runtime_error("Insufficient data size for word read");
+    }
+    words.resize(length);
+    return words;
+}
+
+void decodeBits(const codec::FrameDecoder& frame_decoder,
+                std::span<const std::uint8_t> frame,
+                CommunicationMode mode,
+                std::vector<bool>& bits,
+                std::size_t offset,
+                std::size_t length) {
+    const auto response = frame_decoder.parseResponse(frame);
+    ensureCompletion(response.completion_code, response.diagnostic_data, mode);
+
+    const auto data = response.device_data;
+    if (mode == CommunicationMode::Ascii) {
+        if (data.size() < length) {
+            throw std::runtime_error("Insufficient ASCII data for bit read");
+        }
+        for (std::size_t i = 0; i < length; ++i) {
+            bits[offset + i] = data[i] == '1';
+        }
+    } else {
+        // 1 バイトに 2 点（上位ニブルが先）
+        std::size_t bit_index = 0;
+        for (std::size_t i = 0; i < data.size() && bit_index < length; ++i) {
+            const std::uint8_t byte = data[i];
+            bits[offset + bit_index++] = (byte & 0x10) != 0;
+            if (bit_index < length) {
+                bits[offset + bit_index++] = (byte & 0x01) != 0;
+            }
+        }
+    }
+}
+
+void ensureCompletion(std::uint16_t code, std::span<const std::uint8_t> diag, CommunicationMode mode) {
+    if (code == 0) {
+        return;
+    }
+
+    std::ostringstream oss;
+    oss << "MC completion error 0x" << std::uppercase << std::hex << std::setw(4) << std::setfill('0') << code;
+    if (!diag.empty()) {
+        oss << " diag=";
+        if (mode == CommunicationMode::Ascii) {
+            oss << std::string(diag.begin(), diag.end());
+        } else {
+            for (auto byte : diag) {
+                oss << std::uppercase << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte) << ' ';
+            }
+        }
+    }
+    throw std::runtime_error(oss.str());
+}
+
+} // namespace cpmcprotocol::detail
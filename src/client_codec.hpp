@@ -0,0 +1,184 @@
+#pragma once
+
+// McClient と McAsyncClient が共有する、要求の分割と応答フレームのデコード。
+// 送受信の方法（ブロッキング／イベント駆動）によらない部分だけを置く。
+// ライブラリの内部でのみ使用し、公開ヘッダーからは参照しない。
+
+#include "cpmcprotocol/communication_mode.hpp"
+#include "cpmcprotocol/device.hpp"
+#include "cpmcprotocol/value_codec.hpp"
+#include "cpmcprotocol/codec/frame_decoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace cpmcprotocol::detail {
+
+inline bool isWordFormat(ValueType type) {
+    switch (type) {
+        case ValueType::Int16:
+        case ValueType::UInt16:
+        case ValueType::RawWords:
+            return true;
+        default:
+            return false;
+    }
+}
+
+inline bool isDwordFormat(ValueType type) {
+    switch (type) {
+        case ValueType::Int32:
+        case ValueType::UInt32:
+        case ValueType::Float32:
+            return true;
+        default:
+            return false;
+    }
+}
+
+inline bool isLwordFormat(ValueType type) {
+    switch (type) {
+        case ValueType::Int64:
+        case ValueType::UInt64:
+        case ValueType::Float64:
+            return true;
+        default:
+            return false;
+    }
+}
+
+inline bool isBitFormat(ValueType type) {
+    return type == ValueType::BitArray;
+}
+
+// ランダムアクセス要求内のデバイス種別（要求内ではこの順に並ぶ）。
+enum class RandomCategory : std::size_t { Word, Dword, Lword, Bit };
+constexpr std::size_t kRandomCategoryCount = 4;
+
+inline std::optional<RandomCategory> randomCategoryOf(ValueType type) {
+    if (isWordFormat(type)) {
+        return RandomCategory::Word;
+    }
+    if (isDwordFormat(type)) {
+        return RandomCategory::Dword;
+    }
+    if (isLwordFormat(type)) {
+        return RandomCategory::Lword;
+    }
+    if (isBitFormat(type)) {
+        return RandomCategory::Bit;
+    }
+    return std::nullopt;
+}
+
+template <typename Request>
+auto& devicesOf(Request& request, RandomCategory category) {
+    switch (category) {
+        case RandomCategory::Word:
+            return request.word_devices;
+        case RandomCategory::Dword:
+            return request.dword_devices;
+        case RandomCategory::Lword:
+            return request.lword_devices;
+        case RandomCategory::Bit:
+            break;
+    }
+    return request.bit_devices;
+}
+
+// ランダム読み出し 1 フレーム分の要求と、要求内の並び順に対応するプラン上の位置。
+template <typename Request>
+struct RandomReadChunk {
+    Request request;
+    std::vector<std::size_t> order;
+};
+
+// 読み取りプランを種別ごとにまとめ、1 要求あたりの点数上限に収まるフレームへ分割する。
+template <typename Request, typename Plan>
+std::vector<RandomReadChunk<Request>> splitRandomRead(const Plan& plan, std::size_t max_points) {
+    std::array<std::vector<std::size_t>, kRandomCategoryCount> groups;
+    for (std::size_t i = 0; i < plan.size(); ++i) {
+        const auto category = randomCategoryOf(plan[i].format.type);
+        if (!category) {
+            throw std::invalid_argument("Unsupported format in randomRead plan");
+        }
+        groups[static_cast<std::size_t>(*category)].push_back(i);
+    }
+
+    std::vector<RandomReadChunk<Request>> chunks(1);
+    std::size_t points = 0;
+    for (std::size_t c = 0; c < kRandomCategoryCount; ++c) {
+        const auto category = static_cast<RandomCategory>(c);
+        const std::size_t cost = (category == RandomCategory::Lword) ? 2 : 1;
+        for (const std::size_t index : groups[c]) {
+            if (points + cost > max_points) {
+                chunks.emplace_back();
+                points = 0;
+            }
+            devicesOf(chunks.back().request, category).push_back(plan[index].address);
+            chunks.back().order.push_back(index);
+            points += cost;
+        }
+    }
+    return chunks;
+}
+
+// 終了コードが 0 以外なら、終了コードと診断情報を含む std::runtime_error を送出する。
+void ensureCompletion(std::uint16_t code, std::span<const std::uint8_t> diag, CommunicationMode mode);
+
+// ワード単位の応答から先頭 length ワードを取り出す。
+std::vector<std::uint16_t> decodeWords(const codec::FrameDecoder& frame_decoder,
+                                       std::span<const std::uint8_t> frame,
+                                       CommunicationMode mode,
+                                       std::size_t length);
+
+// ビット単位の応答を bits[offset, offset + length) に展開する。
+void decodeBits(const codec::FrameDecoder& frame_decoder,
+                std::span<const std::uint8_t> frame,
+                CommunicationMode mode,
+                std::vector<bool>& bits,
+                std::size_t offset,
+                std::size_t length);
+
+// ランダム読み出し（およびモニタ）の応答をデコードし、order が示すプラン位置に格納する。
+template <typename Plan>
+void decodeRandomResponse(const codec::FrameDecoder& frame_decoder,
+                          const ValueCodec& value_codec,
+                          const Plan& plan,
+                          const std::vector<std::size_t>& order,
+                          std::span<const std::uint8_t> frame,
+                          CommunicationMode mode,
+                          std::vector<DeviceValue>& results) {
+    const auto response = frame_decoder.parseResponse(frame);
+    ensureCompletion(response.completion_code, response.diagnostic_data, mode);
+
+    std::vector<std::uint16_t> words;
+    if (mode == CommunicationMode::Ascii) {
+        words = ValueCodec::fromAsciiWords(response.device_data);
+    } else {
+        words = ValueCodec::fromBinaryBytes(response.device_data);
+    }
+
+    // 応答は要求内の並び順（種別ごと）なので、その順のプランでデコードしてから元の位置に戻す
+    if (order.size() == plan.size() && std::is_sorted(order.begin(), order.end())) {
+        results = value_codec.decode(plan, words);
+        return;
+    }
+    Plan chunk_plan;
+    chunk_plan.reserve(order.size());
+    for (const std::size_t position : order) {
+        chunk_plan.push_back(plan[position]);
+    }
+    auto values = value_codec.decode(chunk_plan, words);
+    for (std::size_t k = 0; k < order.size(); ++k) {
+        results[order[k]] = std::move(values[k]);
+    }
+}
+
+} // namespace cpmcprotocol::detail
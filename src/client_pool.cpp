@@ -0,0 +1,429 @@
+#include "cpmcprotocol/client_pool.hpp"
+
+#include "cpmcprotocol/codec/frame_encoder.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace cpmcprotocol {
+
+namespace {
+
+// 分割読み取りの区間を接続ごとに実行するスレッド。最初に区間を割り当てられたときに起動し、
+// 接続を閉じるまで使い回す（読み取りのたびにスレッドを作らない）。
+class StripeWorker {
+public:
+    StripeWorker() = default;
+    ~StripeWorker() { stop(); }
+
+    StripeWorker(const StripeWorker&) = delete;
+    StripeWorker& operator=(const StripeWorker&) = delete;
+
+    // task をワーカーで実行する（積んだ順に 1 つずつ実行する）
+    void post(std::function<void()> task) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!thread_.joinable()) {
+            thread_ = std::thread([this] { run(); });
+        }
+        tasks_.push_back(std::move(task));
+        cv_.notify_one();
+    }
+
+    void stop() noexcept {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            auto task = std::move(tasks_.front());
+            tasks_.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+} // namespace
+
+struct McClientPool::Slot {
+    McClient client;
+    std::size_t index = 0;
+    // 実行中の要求と貸し出し中の Lease の数
+    std::atomic<std::size_t> busy{0};
+    // 呼び出したスレッド以外が受け持つ分割読み取りの区間を実行する（client より先に止める）
+    StripeWorker worker;
+};
+
+struct McClientPool::Impl {
+    // slots を保護する。要求・分割読み取り・Lease は接続を選ぶ間だけロックし、使い終わるまで users で数える。
+    // connect()/disconnect() は users が 0 になるのを待ってから接続を入れ替える。待つ間はロックを外すため、
+    // Lease を保持したスレッドがプールの要求を呼んでも詰まらない。
+    mutable std::mutex mutex;
+    std::condition_variable idle_cv;
+    std::size_t users = 0;
+    std::vector<std::unique_ptr<Slot>> slots;
+    // slots の数（変更は mutex の中で行い、size() はロックを取らずに読む）
+    std::atomic<std::size_t> slot_count{0};
+    // 実行中の要求数が同じ接続の間で、選ぶ接続を巡回させる
+    std::atomic<std::size_t> rotation{0};
+
+    // 分割読み取りの間、選んだ接続の使用を数える
+    class PinGuard {
+    public:
+        explicit PinGuard(Impl& impl) noexcept : impl_(impl) {}
+        ~PinGuard() { impl_.unpin(); }
+
+        PinGuard(const PinGuard&) = delete;
+        PinGuard& operator=(const PinGuard&) = delete;
+
+    private:
+        Impl& impl_;
+    };
+
+    // 分割読み取りの間、選んだ接続を実行中として数える
+    class BusyGuard {
+    public:
+        explicit BusyGuard(const std::vector<Slot*>& slots) noexcept : slots_(slots) {
+            for (Slot* slot : slots_) {
+                ++slot->busy;
+            }
+        }
+        ~BusyGuard() {
+            for (Slot* slot : slots_) {
+                --slot->busy;
+            }
+        }
+
+        BusyGuard(const BusyGuard&) = delete;
+        BusyGuard& operator=(const BusyGuard&) = delete;
+
+    private:
+        const std::vector<Slot*>& slots_;
+    };
+
+    // 選んだ接続の使用を終える（mutex をロックしていない状態で呼ぶ）
+    void unpin() noexcept {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--users == 0) {
+            idle_cv.notify_all();
+        }
+    }
+
+    // すべての接続の使用が終わるまで待つ（lock は mutex のロック）
+    void waitIdle(std::unique_lock<std::mutex>& lock) {
+        idle_cv.wait(lock, [this] { return users == 0; });
+    }
+
+    void ensureConnected() const {
+        if (slots.empty()) {
+            throw std::runtime_error("McClientPool is not connected");
+        }
+    }
+
+    void closeAll() noexcept {
+        for (auto& slot : slots) {
+            slot->client.disconnect();
+        }
+        slots.clear();
+        slot_count = 0;
+    }
+
+    // 実行中の要求が少ない順に count 個の接続を選ぶ（mutex をロックした状態で呼ぶ）
+    std::vector<Slot*> leastBusy(std::size_t count) {
+        const std::size_t n = slots.size();
+        const std::size_t start = rotation.fetch_add(1, std::memory_order_relaxed) % n;
+        std::vector<std::pair<std::size_t, Slot*>> order;
+        order.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            Slot* slot = slots[(start + i) % n].get();
+            order.emplace_back(slot->busy.load(std::memory_order_relaxed), slot);
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+        std::vector<Slot*> chosen;
+        chosen.reserve(count);
+        for (std::size_t i = 0; i < count && i < n; ++i) {
+            chosen.push_back(order[i].second);
+        }
+        return chosen;
+    }
+
+    // 範囲を 1 要求の上限単位で接続数までの区間に分け、各接続で並行して読み取る。
+    // 先頭の区間は呼び出したスレッドで、残りは各接続のワーカーで読み取る。
+    // Read は (McClient&, 区間の先頭, 点数) から区間の値を返す。結果は区間ごとに受け取って最後に連結する
+    // （vector<bool> は要素ごとに並行して書き込めないため）。
+    template <typename T, typename Read>
+    std::vector<T> readStriped(const DeviceAddress& head, std::size_t count, Read&& read) {
+        const ResolvedDevice resolved = resolveDevice(head);
+        if (count == 0) {
+            throw std::invalid_argument("DeviceRange.length must be greater than zero");
+        }
+        if (count - 1 > std::numeric_limits<std::uint32_t>::max() - resolved.number) {
+            throw std::invalid_argument("Device range exceeds the device number space");
+        }
+
+        const std::size_t limit = codec::FrameEncoder::maxBatchReadPoints(resolved.type);
+        const std::size_t chunks = (count + limit - 1) / limit;
+        std::vector<Slot*> chosen;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ensureConnected();
+            chosen = leastBusy(std::min(chunks, slots.size()));
+            ++users;
+        }
+        const PinGuard pin(*this);
+        const std::size_t segments = chosen.size();
+
+        // 区間の先頭は解決済みのまま渡す（デバイス名に戻して解析し直さない）
+        struct Segment {
+            ResolvedDevice head;
+            std::size_t length = 0;
+        };
+        std::vector<Segment> plan(segments);
+        std::size_t first_chunk = 0;
+        for (std::size_t i = 0; i < segments; ++i) {
+            const std::size_t segment_chunks = chunks / segments + (i < chunks % segments ? 1 : 0);
+            const std::size_t offset = first_chunk * limit;
+            plan[i].head = resolved;
+            plan[i].head.number += static_cast<std::uint32_t>(offset);
+            plan[i].length = std::min(segment_chunks * limit, count - offset);
+            first_chunk += segment_chunks;
+        }
+
+        const BusyGuard guard(chosen);
+
+        std::vector<std::vector<T>> parts(segments);
+        std::vector<std::exception_ptr> errors(segments);
+        std::mutex done_mutex;
+        std::condition_variable done_cv;
+        std::size_t remaining = segments - 1;
+        const auto finish = [&] {
+            // 待っている側が戻って done_cv を破棄しないよう、通知までロックを保持する
+            std::lock_guard<std::mutex> done_lock(done_mutex);
+            if (--remaining == 0) {
+                done_cv.notify_one();
+            }
+        };
+        for (std::size_t i = 1; i < segments; ++i) {
+            try {
+                chosen[i]->worker.post([&, i] {
+                    try {
+                        parts[i] = read(chosen[i]->client, plan[i].head, plan[i].length);
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+                    finish();
+                });
+            } catch (...) {
+                errors[i] = std::current_exception();
+                finish();
+            }
+        }
+
+        try {
+            parts[0] = read(chosen[0]->client, plan[0].head, plan[0].length);
+        } catch (...) {
+            errors[0] = std::current_exception();
+        }
+        // 失敗した区間があっても、他の区間の完了を待ってから送出する
+        {
+            std::unique_lock<std::mutex> done_lock(done_mutex);
+            done_cv.wait(done_lock, [&] { return remaining == 0; });
+        }
+        for (const auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        if (segments == 1) {
+            return std::move(parts[0]);
+        }
+        std::vector<T> result;
+        result.reserve(count);
+        for (const auto& part : parts) {
+            result.insert(result.end(), part.begin(), part.end());
+        }
+        return result;
+    }
+};
+
+McClientPool::Lease::Lease(Impl& pool, Slot& slot) noexcept
+    : pool_(&pool), slot_(&slot) {
+    ++slot_->busy;
+}
+
+McClientPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(std::exchange(other.pool_, nullptr)), slot_(std::exchange(other.slot_, nullptr)) {}
+
+McClientPool::Lease& McClientPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = std::exchange(other.pool_, nullptr);
+        slot_ = std::exchange(other.slot_, nullptr);
+    }
+    return *this;
+}
+
+McClientPool::Lease::~Lease() {
+    release();
+}
+
+void McClientPool::Lease::release() noexcept {
+    if (slot_ != nullptr) {
+        --slot_->busy;
+        slot_ = nullptr;
+        std::exchange(pool_, nullptr)->unpin();
+    }
+}
+
+McClient& McClientPool::Lease::operator*() const noexcept {
+    return slot_->client;
+}
+
+McClient* McClientPool::Lease::operator->() const noexcept {
+    return &slot_->client;
+}
+
+std::size_t McClientPool::Lease::index() const noexcept {
+    return slot_->index;
+}
+
+McClientPool::McClientPool() : impl_(std::make_unique<Impl>()) {}
+
+McClientPool::~McClientPool() {
+    disconnect();
+}
+
+void McClientPool::connect(const SessionConfig& config, const std::vector<std::uint16_t>& ports) {
+    if (ports.empty()) {
+        throw std::invalid_argument("McClientPool requires at least one port");
+    }
+
+    std::unique_lock<std::mutex> lock(impl_->mutex);
+    impl_->waitIdle(lock);
+    impl_->closeAll();
+    std::vector<McClient*> clients;
+    std::vector<SessionConfig> members;
+    for (std::size_t i = 0; i < ports.size(); ++i) {
+        auto slot = std::make_unique<Slot>();
+        slot->index = i;
+        clients.push_back(&slot->client);
+        members.push_back(config);
+        members.back().port = ports[i];
+        impl_->slots.push_back(std::move(slot));
+    }
+    // すべてのポートへ並行して接続し、1 つでも失敗したら接続済みの分も切断する
+    const auto errors = McClient::connectAll(clients, members);
+    const auto failed = std::find_if(errors.begin(), errors.end(), [](const std::exception_ptr& e) { return static_cast<bool>(e); });
+    if (failed != errors.end()) {
+        impl_->closeAll();
+        std::rethrow_exception(*failed);
+    }
+    impl_->slot_count = impl_->slots.size();
+}
+
+void McClientPool::disconnect() {
+    std::unique_lock<std::mutex> lock(impl_->mutex);
+    impl_->waitIdle(lock);
+    impl_->closeAll();
+}
+
+bool McClientPool::isConnected() const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    if (impl_->slots.empty()) {
+        return false;
+    }
+    return std::all_of(impl_->slots.begin(), impl_->slots.end(),
+                       [](const auto& slot) { return slot->client.isConnected(); });
+}
+
+std::size_t McClientPool::size() const noexcept {
+    return impl_->slot_count.load();
+}
+
+McClientPool::Lease McClientPool::acquire() {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    impl_->ensureConnected();
+    Slot* slot = impl_->leastBusy(1).front();
+    ++impl_->users;
+    return Lease(*impl_, *slot);
+}
+
+std::vector<std::uint16_t> McClientPool::readWords(const DeviceRange& range) {
+    return acquire()->readWords(range);
+}
+
+std::vector<bool> McClientPool::readBits(const DeviceRange& range) {
+    return acquire()->readBits(range);
+}
+
+void McClientPool::writeWords(const DeviceRange& range, const std::vector<std::uint16_t>& values) {
+    acquire()->writeWords(range, values);
+}
+
+void McClientPool::writeBits(const DeviceRange& range, const std::vector<bool>& values) {
+    acquire()->writeBits(range, values);
+}
+
+std::vector<DeviceValue> McClientPool::randomRead(const DeviceReadPlan& plan) {
+    return acquire()->randomRead(plan);
+}
+
+std::vector<DeviceValue> McClientPool::randomRead(const ResolvedReadPlan& plan) {
+    return acquire()->randomRead(plan);
+}
+
+void McClientPool::randomWrite(const DeviceWritePlan& plan) {
+    acquire()->randomWrite(plan);
+}
+
+void McClientPool::writeBatch(const WriteBatch& batch) {
+    acquire()->writeBatch(batch);
+}
+
+std::vector<std::uint16_t> McClientPool::readWordArea(const DeviceAddress& head, std::size_t count) {
+    return impl_->readStriped<std::uint16_t>(
+        head, count, [](McClient& client, const ResolvedDevice& segment, std::size_t length) {
+            return client.readWordArea(segment, length);
+        });
+}
+
+std::vector<bool> McClientPool::readBitArea(const DeviceAddress& head, std::size_t count) {
+    return impl_->readStriped<bool>(
+        head, count, [](McClient& client, const ResolvedDevice& segment, std::size_t length) {
+            return client.readBitArea(segment, length);
+        });
+}
+
+} // namespace cpmcprotocol
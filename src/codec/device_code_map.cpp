@@ -1,6 +1,8 @@
 #include "cpmcprotocol/codec/device_code_map.hpp"
 
-// デバイス名から MC プロトコル用のコード値を導出するテーブル実装。
+// デバイス名から MC プロトコル用のコード値を導出する。テーブル本体は device_table.hpp。
+
+#include "cpmcprotocol/device_table.hpp"
 
 #include <stdexcept>
 #include <string>
@@ -9,107 +11,52 @@ namespace cpmcprotocol::codec {
 
 namespace {
 
-enum class SeriesMask : std::uint8_t {
-    None = 0,
-    Q = 1 << 0,
-    L = 1 << 1,
-    QnA = 1 << 2,
-    IQ_L = 1 << 3,
-    IQ_R = 1 << 4
-};
-
-constexpr SeriesMask operator|(SeriesMask lhs, SeriesMask rhs) {
-    return static_cast<SeriesMask>(static_cast<std::uint8_t>(lhs) |
-                                   static_cast<std::uint8_t>(rhs));
-}
-
-// シリーズ毎に利用可能なデバイスか判定するヘルパ。
-constexpr bool isSeriesSupported(SeriesMask mask, PlcSeries series) {
-    const auto bit = static_cast<std::uint8_t>(mask);
-    switch (series) {
-        case PlcSeries::Q:
-            return (bit & static_cast<std::uint8_t>(SeriesMask::Q)) != 0;
-        case PlcSeries::L:
-            return (bit & static_cast<std::uint8_t>(SeriesMask::L)) != 0;
-        case PlcSeries::QnA:
-            return (bit & static_cast<std::uint8_t>(SeriesMask::QnA)) != 0;
-        case PlcSeries::IQ_L:
-            return (bit & static_cast<std::uint8_t>(SeriesMask::IQ_L)) != 0;
-        case PlcSeries::IQ_R:
-            return (bit & static_cast<std::uint8_t>(SeriesMask::IQ_R)) != 0;
+// ResolvedDevice::kind はテーブル位置 + 1（0 は未解決）。
+const DeviceSpec& entryOf(const ResolvedDevice& device) {
+    if (device.kind == 0 || device.kind > kDeviceTable.size()) {
+        throw std::invalid_argument("Device is not resolved");
     }
-    return false;
+    return kDeviceTable[device.kind - 1];
 }
 
-struct DeviceEntry {
-    const char* prefix;
-    std::uint16_t binary_code;
-    int base;
-    SeriesMask supported;
-};
-
-const DeviceEntry* lookupDevice(const std::string& name) {
-    static const DeviceEntry table[] = {
-        {"ZR", 0xB0, 16, SeriesMask::Q | SeriesMask::L | SeriesMask::QnA | SeriesMask::IQ_L | SeriesMask::IQ_R},
-        {"RD", 0x2C, 10, SeriesMask::IQ_R},
-        {"X", 0x9C, 16, SeriesMask::Q | SeriesMask::L | SeriesMask::QnA | SeriesMask::IQ_L | SeriesMask::IQ_R},
-        {"Y", 0x9D, 16, SeriesMask::Q | SeriesMask::L | SeriesMask::QnA | SeriesMask::IQ_L | SeriesMask::IQ_R},
-        {"M", 0x90, 10, SeriesMask::Q | SeriesMask::L | SeriesMask::QnA | SeriesMask::IQ_L | SeriesMask::IQ_R},
-        {"D", 0xA8, 10, SeriesMask::Q | SeriesMask::L | SeriesMask::QnA | SeriesMask::IQ_L | SeriesMask::IQ_R},
-        {"W", 0xB4, 16, SeriesMask::Q | SeriesMask::L | SeriesMask::QnA | SeriesMask::IQ_L | SeriesMask::IQ_R},
-        {"L", 0x92, 10, SeriesMask::Q | SeriesMask::L | SeriesMask::QnA | SeriesMask::IQ_L | SeriesMask::IQ_R},
-        {"F", 0x93, 10, SeriesMask::Q | SeriesMask::L | SeriesMask::QnA | SeriesMask::IQ_L | SeriesMask::IQ_R},
-        {"R", 0xAF, 10, SeriesMask::Q | SeriesMask::L | SeriesMask::QnA | SeriesMask::IQ_L | SeriesMask::IQ_R},
-        {"Z", 0xCC, 10, SeriesMask::Q | SeriesMask::L | SeriesMask::QnA | SeriesMask::IQ_L | SeriesMask::IQ_R},
-        {"B", 0xA0, 16, SeriesMask::Q | SeriesMask::L | SeriesMask::QnA | SeriesMask::IQ_L | SeriesMask::IQ_R},
-        {"T", 0xC2, 10, SeriesMask::Q | SeriesMask::L | SeriesMask::QnA | SeriesMask::IQ_L | SeriesMask::IQ_R},
-        {"C", 0xC5, 10, SeriesMask::Q | SeriesMask::L | SeriesMask::QnA | SeriesMask::IQ_L | SeriesMask::IQ_R},
-    };
-
-    for (const auto& entry : table) {
-        if (name.rfind(entry.prefix, 0) == 0) {
-            return &entry;
-        }
+// 共有テーブルでデバイス名を解析し、失敗時は例外に変換する。
+ResolvedDevice parseOrThrow(const std::string& device_name) {
+    const auto result = parseDeviceName(device_name);
+    switch (result.error) {
+        case DeviceParseError::None:
+            return result.device;
+        case DeviceParseError::MissingNumber:
+            throw std::invalid_argument("Device name missing numeric part: " + device_name);
+        case DeviceParseError::InvalidNumber:
+            throw std::invalid_argument("Invalid device number: " + device_name);
+        default:
+            throw std::invalid_argument("Unsupported device name: " + device_name);
     }
-
-    return nullptr;
 }
 
-} // namespace
-
-BinaryDeviceCodeInfo DeviceCodeMap::resolveBinary(PlcSeries series, const std::string& device_name) const {
-    const auto* entry = lookupDevice(device_name);
-    if (!entry) {
-        throw std::invalid_argument("Unsupported device name: " + device_name);
-    }
-
-    if (!isSeriesSupported(entry->supported, series)) {
+const DeviceSpec& supportedEntry(const ResolvedDevice& device, PlcSeries series, const std::string& device_name) {
+    const auto& entry = entryOf(device);
+    if (!supportsSeries(entry, series)) {
         throw std::invalid_argument("Device " + device_name + " is not supported by selected PLC series");
     }
+    return entry;
+}
 
+BinaryDeviceCodeInfo makeBinaryInfo(const DeviceSpec& entry, PlcSeries series) {
     BinaryDeviceCodeInfo info{};
-    info.code = entry->binary_code;
+    info.code = entry.binary_code;
     info.code_width = (series == PlcSeries::IQ_R) ? 2 : 1;
-    info.number_base = entry->base;
+    info.number_base = entry.number_base;
     info.number_width = (series == PlcSeries::IQ_R) ? 4 : 3;
     return info;
 }
 
-AsciiDeviceCodeInfo DeviceCodeMap::resolveAscii(PlcSeries series, const std::string& device_name) const {
-    const auto* entry = lookupDevice(device_name);
-    if (!entry) {
-        throw std::invalid_argument("Unsupported device name: " + device_name);
-    }
-
-    if (!isSeriesSupported(entry->supported, series)) {
-        throw std::invalid_argument("Device " + device_name + " is not supported by selected PLC series");
-    }
-
+AsciiDeviceCodeInfo makeAsciiInfo(const DeviceSpec& entry, PlcSeries series, const std::string& device_name) {
     AsciiDeviceCodeInfo info{};
     const bool is_iqr = (series == PlcSeries::IQ_R);
     const std::size_t code_width = is_iqr ? 4 : 2;
 
-    std::string code(entry->prefix);
+    std::string code(entry.prefix);
     if (code.size() > code_width) {
         throw std::invalid_argument("Device prefix length exceeds ASCII code width: " + device_name);
     }
@@ -117,9 +64,42 @@ AsciiDeviceCodeInfo DeviceCodeMap::resolveAscii(PlcSeries series, const std::str
         code.append(code_width - code.size(), '*');
     }
     info.code = std::move(code);
-    info.number_base = entry->base;
+    info.number_base = entry.number_base;
     info.number_width = is_iqr ? 8 : 6;
     return info;
 }
 
+} // namespace
+
+BinaryDeviceCodeInfo DeviceCodeMap::resolveBinary(PlcSeries series, const std::string& device_name) const {
+    return makeBinaryInfo(supportedEntry(parseOrThrow(device_name), series, device_name), series);
+}
+
+AsciiDeviceCodeInfo DeviceCodeMap::resolveAscii(PlcSeries series, const std::string& device_name) const {
+    return makeAsciiInfo(supportedEntry(parseOrThrow(device_name), series, device_name), series, device_name);
+}
+
+BinaryDeviceCodeInfo DeviceCodeMap::resolveBinary(PlcSeries series, const ResolvedDevice& device) const {
+    return makeBinaryInfo(supportedEntry(device, series, std::string(entryOf(device).prefix)), series);
+}
+
+AsciiDeviceCodeInfo DeviceCodeMap::resolveAscii(PlcSeries series, const ResolvedDevice& device) const {
+    const std::string prefix(entryOf(device).prefix);
+    return makeAsciiInfo(supportedEntry(device, series, prefix), series, prefix);
+}
+
+ResolvedDevice DeviceCodeMap::resolve(const std::string& device_name, DeviceType type) {
+    ResolvedDevice device = parseOrThrow(device_name);
+    device.type = type;
+    return device;
+}
+
+const char* DeviceCodeMap::prefix(const ResolvedDevice& device) {
+    return entryOf(device).prefix.data();
+}
+
+int DeviceCodeMap::numberBase(const ResolvedDevice& device) {
+    return entryOf(device).number_base;
+}
+
 } // namespace cpmcprotocol::codec
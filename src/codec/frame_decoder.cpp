@@ -1,53 +1,81 @@
 #include "cpmcprotocol/codec/frame_decoder.hpp"
 
-// 受信した 3E フレームを解析し、完了コードおよび診断データを抽出する。
+// 受信した 3E/4E フレームを解析し、完了コードおよび診断データを抽出する。
 
 #include <stdexcept>
-#include <string>
 
 namespace cpmcprotocol::codec {
 
 namespace {
 
-std::uint16_t readLittle16(const std::vector<std::uint8_t>& buffer, std::size_t offset) {
+std::uint16_t readLittle16(std::span<const std::uint8_t> buffer, std::size_t offset) {
     return static_cast<std::uint16_t>(buffer[offset] | (buffer[offset + 1] << 8));
 }
 
-std::uint32_t readHexAscii(const std::vector<std::uint8_t>& buffer, std::size_t offset, std::size_t length) {
+std::uint32_t parseHexDigits(const std::uint8_t* digits, std::size_t length) {
+    std::uint32_t value = 0;
+    for (std::size_t i = 0; i < length; ++i) {
+        const char c = static_cast<char>(digits[i]);
+        value <<= 4;
+        if (c >= '0' && c <= '9') {
+            value |= static_cast<std::uint32_t>(c - '0');
+        } else if (c >= 'A' && c <= 'F') {
+            value |= static_cast<std::uint32_t>(c - 'A' + 10);
+        } else if (c >= 'a' && c <= 'f') {
+            value |= static_cast<std::uint32_t>(c - 'a' + 10);
+        } else {
+            throw std::invalid_argument("Invalid hex digit in ASCII frame");
+        }
+    }
+    return value;
+}
+
+std::uint32_t readHexAscii(std::span<const std::uint8_t> buffer, std::size_t offset, std::size_t length) {
     if (offset + length > buffer.size()) {
         throw std::invalid_argument("ASCII slice out of range");
     }
-    std::string text(buffer.begin() + offset, buffer.begin() + offset + length);
-    return static_cast<std::uint32_t>(std::stoul(text, nullptr, 16));
+    return parseHexDigits(buffer.data() + offset, length);
+}
+
+bool isAsciiFrame(std::span<const std::uint8_t> frame) {
+    return frame.size() >= 4 && frame[0] == 'D' && frame[2] == '0' && frame[3] == '0' &&
+           (frame[1] == '0' || frame[1] == '4');
+}
+
+bool is4EBinaryFrame(std::span<const std::uint8_t> frame) {
+    return frame.size() >= 2 && frame[0] == 0xD4 && frame[1] == 0x00;
 }
 
-bool isAsciiFrame(const std::vector<std::uint8_t>& frame) {
-    return frame.size() >= 4 &&
-           frame[0] == 'D' && frame[1] == '0' && frame[2] == '0' && frame[3] == '0';
+bool is4EAsciiFrame(std::span<const std::uint8_t> frame) {
+    return frame.size() >= 4 && frame[0] == 'D' && frame[1] == '4' && frame[2] == '0' && frame[3] == '0';
 }
 
-// 完了コードと後続データを共通的に取り出すための構造体。
+// 完了コードと後続データ（元フレーム内のビュー）を共通的に取り出すための構造体。
 struct FrameData {
     std::uint16_t completion = 0;
-    std::vector<std::uint8_t> payload;
+    std::span<const std::uint8_t> payload;
 };
 
-FrameData parseBinaryFrameData(const std::vector<std::uint8_t>& frame) {
-    // バイナリフレームは 3E 仕様の 9 バイトヘッダーを前提とする。
-    constexpr std::size_t header_size = 9;
-    constexpr std::size_t completion_offset = 9;
-    constexpr std::size_t completion_size = 2;
-
-    if (frame.size() < header_size + completion_size) {
+FrameData parseBinaryFrameData(std::span<const std::uint8_t> frame) {
+    // バイナリフレームは 3E (9 バイト) または 4E (13 バイト) のヘッダーを前提とする。
+    if (frame.size() < 2) {
         throw std::invalid_argument("Binary frame too short");
     }
-
     const std::uint16_t subheader = static_cast<std::uint16_t>((frame[0] << 8) | frame[1]);
-    if (subheader != 0xD000) {
+    if (subheader != 0xD000 && subheader != 0xD400) {
         throw std::invalid_argument("Unexpected subheader in response frame");
     }
 
-    const std::uint16_t data_length = readLittle16(frame, 7);
+    const FrameType type = (subheader == 0xD400) ? FrameType::Frame4E : FrameType::Frame3E;
+    const std::size_t header_size = FrameDecoder::headerSize(CommunicationMode::Binary, type);
+    const std::size_t completion_offset = header_size;
+    constexpr std::size_t completion_size = 2;
+
+    if (frame.size() < header_size + completion_size) {
+        throw std::invalid_argument("Binary frame too short");
+    }
+
+    const std::size_t data_length = FrameDecoder::bodyLength(frame.data(), CommunicationMode::Binary, type);
     if (data_length < completion_size) {
         throw std::invalid_argument("Binary frame reports shorter data section than completion code");
     }
@@ -59,26 +87,23 @@ FrameData parseBinaryFrameData(const std::vector<std::uint8_t>& frame) {
     FrameData fd{};
     fd.completion = readLittle16(frame, completion_offset);
 
-    const std::size_t payload_size = data_length - completion_size;
-    if (payload_size > 0) {
-        fd.payload.assign(frame.begin() + completion_offset + completion_size,
-                          frame.begin() + completion_offset + completion_size + payload_size);
-    }
+    fd.payload = frame.subspan(completion_offset + completion_size, data_length - completion_size);
 
     return fd;
 }
 
-FrameData parseAsciiFrameData(const std::vector<std::uint8_t>& frame) {
-    // ASCII フレームは 3E ASCII 仕様 (先頭 "D000") を前提に解析する。
-    constexpr std::size_t header_size = 18;
-    constexpr std::size_t completion_offset = 18;
+FrameData parseAsciiFrameData(std::span<const std::uint8_t> frame) {
+    // ASCII フレームは 3E ("D000") または 4E ("D400") の ASCII 仕様を前提に解析する。
+    const FrameType type = is4EAsciiFrame(frame) ? FrameType::Frame4E : FrameType::Frame3E;
+    const std::size_t header_size = FrameDecoder::headerSize(CommunicationMode::Ascii, type);
+    const std::size_t completion_offset = header_size;
     constexpr std::size_t completion_size = 4;
 
     if (frame.size() < header_size + completion_size) {
         throw std::invalid_argument("ASCII frame too short");
     }
 
-    const std::uint32_t data_length = readHexAscii(frame, 14, 4);
+    const std::size_t data_length = FrameDecoder::bodyLength(frame.data(), CommunicationMode::Ascii, type);
     if (data_length < completion_size) {
         throw std::invalid_argument("ASCII frame reports shorter data section than completion code");
     }
@@ -90,56 +115,130 @@ FrameData parseAsciiFrameData(const std::vector<std::uint8_t>& frame) {
     FrameData fd{};
     fd.completion = static_cast<std::uint16_t>(readHexAscii(frame, completion_offset, completion_size));
 
-    const std::size_t payload_size = static_cast<std::size_t>(data_length - completion_size);
-    if (payload_size > 0) {
-        fd.payload.assign(frame.begin() + completion_offset + completion_size,
-                          frame.begin() + completion_offset + completion_size + payload_size);
-    }
+    fd.payload = frame.subspan(completion_offset + completion_size, data_length - completion_size);
 
     return fd;
 }
 
+FrameData parseFrameData(std::span<const std::uint8_t> frame) {
+    return isAsciiFrame(frame) ? parseAsciiFrameData(frame) : parseBinaryFrameData(frame);
+}
+
+std::vector<std::uint8_t> toVector(std::span<const std::uint8_t> data) {
+    return std::vector<std::uint8_t>(data.begin(), data.end());
+}
+
 } // namespace
 
 FrameDecoder::FrameDecoder() = default;
 
-BatchReadResponse FrameDecoder::parseBatchReadResponse(const std::vector<std::uint8_t>& frame) const {
-    FrameData data = isAsciiFrame(frame) ? parseAsciiFrameData(frame) : parseBinaryFrameData(frame);
-    BatchReadResponse response{};
-    response.completion_code = data.completion;
-    if (response.completion_code == 0) {
-        response.device_data = std::move(data.payload);
+std::size_t FrameDecoder::headerSize(CommunicationMode mode, FrameType type) {
+    if (mode == CommunicationMode::Ascii) {
+        return (type == FrameType::Frame4E) ? 26 : 18;
+    }
+    return (type == FrameType::Frame4E) ? 13 : 9;
+}
+
+std::size_t FrameDecoder::bodyLength(const std::uint8_t* header, CommunicationMode mode, FrameType type) {
+    // データ長フィールドはヘッダー末尾にあり、完了コード以降のサイズを示す。
+    const std::size_t length_offset = headerSize(mode, type) - (mode == CommunicationMode::Ascii ? 4 : 2);
+    if (mode == CommunicationMode::Ascii) {
+        return parseHexDigits(header + length_offset, 4);
+    }
+    return static_cast<std::size_t>(header[length_offset] | (header[length_offset + 1] << 8));
+}
+
+std::optional<std::uint16_t> FrameDecoder::parseSerialNumber(std::span<const std::uint8_t> frame) const {
+    if (is4EBinaryFrame(frame)) {
+        if (frame.size() < 4) {
+            throw std::invalid_argument("Binary frame too short");
+        }
+        return readLittle16(frame, 2);
+    }
+    if (is4EAsciiFrame(frame)) {
+        return static_cast<std::uint16_t>(readHexAscii(frame, 4, 4));
+    }
+    return std::nullopt;
+}
+
+ResponseView FrameDecoder::parseResponse(std::span<const std::uint8_t> frame) const {
+    const FrameData data = parseFrameData(frame);
+    ResponseView view{};
+    view.completion_code = data.completion;
+    if (view.completion_code == 0) {
+        view.device_data = data.payload;
     } else {
-        response.diagnostic_data = std::move(data.payload);
+        view.diagnostic_data = data.payload;
     }
+    return view;
+}
+
+BatchReadResponse FrameDecoder::parseBatchReadResponse(const std::vector<std::uint8_t>& frame) const {
+    const ResponseView view = parseResponse(frame);
+    BatchReadResponse response{};
+    response.completion_code = view.completion_code;
+    response.device_data = toVector(view.device_data);
+    response.diagnostic_data = toVector(view.diagnostic_data);
     return response;
 }
 
 BatchWriteResponse FrameDecoder::parseBatchWriteResponse(const std::vector<std::uint8_t>& frame) const {
-    FrameData data = isAsciiFrame(frame) ? parseAsciiFrameData(frame) : parseBinaryFrameData(frame);
+    const FrameData data = parseFrameData(frame);
     BatchWriteResponse response{};
     response.completion_code = data.completion;
-    response.diagnostic_data = std::move(data.payload);
+    response.diagnostic_data = toVector(data.payload);
     return response;
 }
 
 RandomReadResponse FrameDecoder::parseRandomReadResponse(const std::vector<std::uint8_t>& frame) const {
-    FrameData data = isAsciiFrame(frame) ? parseAsciiFrameData(frame) : parseBinaryFrameData(frame);
+    const ResponseView view = parseResponse(frame);
     RandomReadResponse response{};
-    response.completion_code = data.completion;
-    if (response.completion_code == 0) {
-        response.device_data = std::move(data.payload);
-    } else {
-        response.diagnostic_data = std::move(data.payload);
-    }
+    response.completion_code = view.completion_code;
+    response.device_data = toVector(view.device_data);
+    response.diagnostic_data = toVector(view.diagnostic_data);
     return response;
 }
 
 RandomWriteResponse FrameDecoder::parseRandomWriteResponse(const std::vector<std::uint8_t>& frame) const {
-    FrameData data = isAsciiFrame(frame) ? parseAsciiFrameData(frame) : parseBinaryFrameData(frame);
+    const FrameData data = parseFrameData(frame);
     RandomWriteResponse response{};
     response.completion_code = data.completion;
-    response.diagnostic_data = std::move(data.payload);
+    response.diagnostic_data = toVector(data.payload);
+    return response;
+}
+
+MultiBlockReadResponse FrameDecoder::parseMultiBlockReadResponse(std::span<const std::uint8_t> frame,
+                                                                 std::span<const std::uint16_t> block_lengths) const {
+    const FrameData data = parseFrameData(frame);
+    MultiBlockReadResponse response{};
+    response.completion_code = data.completion;
+    if (data.completion != 0) {
+        response.diagnostic_data = toVector(data.payload);
+        return response;
+    }
+
+    // ブロックのデータはワード単位で要求順に連続する（ASCII は 1 ワード 4 文字）。
+    const bool ascii = isAsciiFrame(frame);
+    const std::size_t word_size = ascii ? 4 : 2;
+    std::size_t total = 0;
+    for (const auto length : block_lengths) {
+        total += length;
+    }
+    if (data.payload.size() < total * word_size) {
+        throw std::invalid_argument("Multi-block response shorter than requested blocks");
+    }
+
+    response.blocks.reserve(block_lengths.size());
+    std::size_t offset = 0;
+    for (const auto length : block_lengths) {
+        std::vector<std::uint16_t> words(length);
+        for (auto& word : words) {
+            word = ascii ? static_cast<std::uint16_t>(readHexAscii(data.payload, offset, 4))
+                         : readLittle16(data.payload, offset);
+            offset += word_size;
+        }
+        response.blocks.push_back(std::move(words));
+    }
     return response;
 }
 
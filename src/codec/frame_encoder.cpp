@@ -1,88 +1,153 @@
 #include "cpmcprotocol/codec/frame_encoder.hpp"
 
-// 低レイヤで構築したデバイス情報を 3E フレームへ変換するエンコーダ。
+// 低レイヤで構築したデバイス情報を 3E/4E フレームへ変換するエンコーダ。
 
-#include <iomanip>
-#include <sstream>
+#include <initializer_list>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
 namespace cpmcprotocol::codec {
 
 namespace {
 
-void appendLittleEndian(std::vector<std::uint8_t>& buffer, std::uint32_t value, std::size_t width) {
-    for (std::size_t i = 0; i < width; ++i) {
-        buffer.push_back(static_cast<std::uint8_t>((value >> (8 * i)) & 0xFF));
+constexpr char kHexDigits[] = "0123456789ABCDEF";
+
+// 呼び出し側のバッファへ 3E/4E フレームを直接書き込むライタ。
+// バイナリ/ASCII の差異（リトルエンディアン / 固定桁 16 進）をここに閉じ込め、
+// データ長フィールドは finish() で後から埋める。
+class FrameWriter {
+public:
+    FrameWriter(std::vector<std::uint8_t>& out, const SessionConfig& config)
+        : out_(out), ascii_(config.mode == CommunicationMode::Ascii) {
+        out_.clear();
+        if (ascii_) {
+            // 4E はサブヘッダー直後にシリアル番号と固定値 0 を持つ。シリアルは送信直前に設定する。
+            text(config.frame_type == FrameType::Frame4E ? "540000000000" : "5000");
+        } else if (config.frame_type == FrameType::Frame4E) {
+            raw({0x54, 0x00, 0x00, 0x00, 0x00, 0x00});
+        } else {
+            raw({0x50, 0x00});
+        }
+        byte(config.network);
+        byte(config.pc);
+        word(config.module_io);
+        byte(config.module_station);
+        length_pos_ = out_.size();
+        word(0); // データ長（finish() で設定）
+        data_begin_ = out_.size();
+        word(config.timeout_250ms);
     }
-}
 
-std::size_t findDigitPosition(const std::string& device_name) {
-    return device_name.find_first_of("0123456789");
-}
+    bool ascii() const { return ascii_; }
 
-std::uint32_t parseDeviceNumber(const std::string& device_name, int base) {
-    const std::size_t pos = findDigitPosition(device_name);
-    if (pos == std::string::npos) {
-        throw std::invalid_argument("Device name missing numeric part: " + device_name);
+    void byte(std::uint8_t value) { ascii_ ? hex(value, 2) : little(value, 1); }
+    void word(std::uint16_t value) { ascii_ ? hex(value, 4) : little(value, 2); }
+    void dword(std::uint32_t value) { ascii_ ? hex(value, 8) : little(value, 4); }
+
+    void lword(std::uint64_t value) {
+        if (ascii_) {
+            hex(static_cast<std::uint32_t>(value & 0xFFFFFFFF), 8);
+            hex(static_cast<std::uint32_t>((value >> 32) & 0xFFFFFFFF), 8);
+        } else {
+            little(value, 8);
+        }
     }
-    std::string number_part = device_name.substr(pos);
-    if (base == 16 && number_part.rfind("0x", 0) == 0) {
-        number_part = number_part.substr(2);
+
+    void command(std::uint16_t command, std::uint16_t subcommand) {
+        word(command);
+        word(subcommand);
     }
-    return static_cast<std::uint32_t>(std::stoul(number_part, nullptr, base));
-}
 
-// ASCII モードでサブヘッダーや数値を固定桁で表現するためのヘルパ。
-std::string toHex(std::uint32_t value, std::size_t width) {
-    std::ostringstream oss;
-    oss << std::uppercase << std::setw(static_cast<int>(width)) << std::setfill('0') << std::hex << value;
-    return oss.str();
-}
+    void device(const DeviceCodeMap& map, PlcSeries series, const DeviceAddress& address) {
+        device(map, series, DeviceCodeMap::resolve(address.name, address.type));
+    }
 
-std::string toDecimalPadded(std::uint32_t value, std::size_t width) {
-    std::string s = std::to_string(value);
-    if (s.size() > width) {
-        throw std::invalid_argument("Device number exceeds ASCII width");
+    void device(const DeviceCodeMap& map, PlcSeries series, const ResolvedDevice& resolved) {
+        if (ascii_) {
+            const auto info = map.resolveAscii(series, resolved);
+            text(info.code);
+            decimal(resolved.number, info.number_width);
+        } else {
+            const auto info = map.resolveBinary(series, resolved);
+            little(resolved.number, info.number_width);
+            little(info.code, info.code_width);
+        }
     }
-    if (s.size() < width) {
-        s.insert(s.begin(), width - s.size(), '0');
+
+    // ビットデバイスの書き込み値。iQ-R は 1 点 1 ワード、それ以外は
+    // バイナリで 1 バイトに 2 点（上位ニブルが先）、ASCII で 1 点 1 文字。
+    void bitValues(const std::vector<std::uint16_t>& values, PlcSeries series, std::size_t length) {
+        if (series == PlcSeries::IQ_R) {
+            for (std::size_t i = 0; i < length; ++i) {
+                word(static_cast<std::uint16_t>(values[i] ? 1 : 0));
+            }
+            return;
+        }
+        if (ascii_) {
+            for (std::size_t i = 0; i < length; ++i) {
+                out_.push_back(values[i] ? '1' : '0');
+            }
+            return;
+        }
+        for (std::size_t i = 0; i < length; i += 2) {
+            std::uint8_t packed = values[i] ? 0x10 : 0x00;
+            if (i + 1 < length && values[i + 1]) {
+                packed |= 0x01;
+            }
+            out_.push_back(packed);
+        }
     }
-    return s;
-}
 
-std::vector<std::uint8_t> buildBinaryFrame(const SessionConfig& config, const std::vector<std::uint8_t>& request) {
-    std::vector<std::uint8_t> frame;
-    frame.reserve(11 + request.size());
-
-    // 3E フレームの共通ヘッダーを組み立てる。
-    frame.push_back(0x50);
-    frame.push_back(0x00);
-    frame.push_back(config.network);
-    frame.push_back(config.pc);
-    appendLittleEndian(frame, config.module_io, 2);
-    frame.push_back(config.module_station);
-    appendLittleEndian(frame, static_cast<std::uint16_t>(2 + request.size()), 2);
-    appendLittleEndian(frame, config.timeout_250ms, 2);
-    frame.insert(frame.end(), request.begin(), request.end());
+    void raw(std::initializer_list<std::uint8_t> bytes) { out_.insert(out_.end(), bytes.begin(), bytes.end()); }
+    void raw(const std::vector<std::uint8_t>& bytes) { out_.insert(out_.end(), bytes.begin(), bytes.end()); }
+    void text(std::string_view chars) { out_.insert(out_.end(), chars.begin(), chars.end()); }
 
-    return frame;
-}
+    void finish() {
+        const std::size_t length = out_.size() - data_begin_;
+        if (length > 0xFFFF) {
+            throw std::invalid_argument("Request data length exceeds 65535");
+        }
+        if (ascii_) {
+            for (std::size_t i = 0; i < 4; ++i) {
+                out_[length_pos_ + i] = static_cast<std::uint8_t>(kHexDigits[(length >> (12 - 4 * i)) & 0x0F]);
+            }
+        } else {
+            out_[length_pos_] = static_cast<std::uint8_t>(length & 0xFF);
+            out_[length_pos_ + 1] = static_cast<std::uint8_t>((length >> 8) & 0xFF);
+        }
+    }
 
-std::vector<std::uint8_t> buildAsciiFrame(const SessionConfig& config, const std::string& request) {
-    std::string frame;
-    frame.reserve(4 + 2 + 2 + 4 + 2 + 4 + 4 + request.size());
-    frame += "5000";
-    frame += toHex(config.network, 2);
-    frame += toHex(config.pc, 2);
-    frame += toHex(config.module_io, 4);
-    frame += toHex(config.module_station, 2);
-    frame += toHex(static_cast<std::uint32_t>(4 + request.size()), 4);
-    frame += toHex(config.timeout_250ms, 4);
-    frame += request;
+private:
+    void little(std::uint64_t value, std::size_t width) {
+        for (std::size_t i = 0; i < width; ++i) {
+            out_.push_back(static_cast<std::uint8_t>((value >> (8 * i)) & 0xFF));
+        }
+    }
 
-    return std::vector<std::uint8_t>(frame.begin(), frame.end());
-}
+    void hex(std::uint32_t value, std::size_t width) {
+        for (std::size_t i = width; i > 0; --i) {
+            out_.push_back(static_cast<std::uint8_t>(kHexDigits[(value >> (4 * (i - 1))) & 0x0F]));
+        }
+    }
+
+    void decimal(std::uint32_t value, std::size_t width) {
+        const std::size_t begin = out_.size();
+        out_.resize(begin + width, '0');
+        for (std::size_t i = width; i > 0 && value > 0; --i) {
+            out_[begin + i - 1] = static_cast<std::uint8_t>('0' + value % 10);
+            value /= 10;
+        }
+        if (value > 0) {
+            throw std::invalid_argument("Device number exceeds ASCII width");
+        }
+    }
+
+    std::vector<std::uint8_t>& out_;
+    bool ascii_;
+    std::size_t length_pos_ = 0;
+    std::size_t data_begin_ = 0;
+};
 
 std::uint16_t sequentialSubcommand(DeviceType type, PlcSeries series) {
     switch (type) {
@@ -99,205 +164,102 @@ std::uint16_t randomWordSubcommand(PlcSeries series) {
     return (series == PlcSeries::IQ_R) ? 0x0002 : 0x0000;
 }
 
-void appendDeviceBinary(std::vector<std::uint8_t>& buffer, const BinaryDeviceCodeInfo& info, std::uint32_t number) {
-    appendLittleEndian(buffer, number, info.number_width);
-    appendLittleEndian(buffer, info.code, info.code_width);
-}
-
-void appendDeviceAscii(std::string& buffer, const AsciiDeviceCodeInfo& info, std::uint32_t number) {
-    buffer += info.code;
-    buffer += toDecimalPadded(number, info.number_width);
-}
-
-std::vector<std::uint8_t> packBitValuesBinary(const std::vector<std::uint16_t>& values, PlcSeries series, std::size_t length) {
-    if (series == PlcSeries::IQ_R) {
-        // iQ-R はビットでも 2 バイト幅で値を保持するため 16bit 毎に格納する。
-        std::vector<std::uint8_t> bytes;
-        bytes.reserve(length * 2);
-        for (std::size_t i = 0; i < length; ++i) {
-            appendLittleEndian(bytes, static_cast<std::uint16_t>(values[i] ? 1 : 0), 2);
-        }
-        return bytes;
+template <typename Request>
+void checkRandomReadLimits(const SessionConfig& config, const Request& request) {
+    const std::size_t points = request.word_devices.size() + request.dword_devices.size() +
+                               2 * request.lword_devices.size() + request.bit_devices.size();
+    if (points > FrameEncoder::randomAccessLimits(config.series).read_points) {
+        throw std::invalid_argument("Random read exceeds the per-request point limit");
     }
-
-    // それ以外のシリーズは pymcprotocol と同様に 1 バイトに 2 ビット詰めで扱う。
-    std::vector<std::uint8_t> packed((length + 1) / 2, 0);
-    for (std::size_t idx = 0; idx < length; ++idx) {
-        const std::size_t byte_index = idx / 2;
-        const bool high_nibble = (idx % 2 == 0);
-        const std::uint8_t bit_mask = high_nibble ? 0x10 : 0x01;
-        if (values[idx]) {
-            packed[byte_index] |= bit_mask;
-        }
-    }
-    return packed;
 }
 
-std::string packBitValuesAscii(const std::vector<std::uint16_t>& values, PlcSeries series, std::size_t length) {
-    std::string result;
-    result.reserve(length * (series == PlcSeries::IQ_R ? 4 : 1));
-    for (std::size_t i = 0; i < length; ++i) {
-        if (series == PlcSeries::IQ_R) {
-            result += toHex(static_cast<std::uint32_t>(values[i] ? 1 : 0), 4);
-        } else {
-            result += values[i] ? '1' : '0';
-        }
+template <typename Request>
+void checkRandomWriteLimits(const SessionConfig& config, const Request& request) {
+    const auto limits = FrameEncoder::randomAccessLimits(config.series);
+    const std::size_t cost = request.word_devices.size() * FrameEncoder::kRandomWordWriteCost +
+                             request.dword_devices.size() * FrameEncoder::kRandomDwordWriteCost +
+                             request.lword_devices.size() * FrameEncoder::kRandomLwordWriteCost;
+    if (cost > limits.write_cost || request.bit_devices.size() > limits.write_bits) {
+        throw std::invalid_argument("Random write exceeds the per-request point limit");
     }
-    return result;
 }
 
-} // namespace
+template <typename Request>
+void writeRandomCounts(FrameWriter& writer, const Request& request) {
+    writer.byte(static_cast<std::uint8_t>(request.word_devices.size()));
+    writer.byte(static_cast<std::uint8_t>(request.dword_devices.size()));
+    writer.byte(static_cast<std::uint8_t>(request.lword_devices.size()));
+    writer.byte(static_cast<std::uint8_t>(request.bit_devices.size()));
+}
 
-FrameEncoder::FrameEncoder() = default;
+// 以下のエンコード本体は DeviceAddress 系 / ResolvedDevice 系の要求で共通。
 
-std::vector<std::uint8_t> FrameEncoder::makeBatchReadRequest(const SessionConfig& config, const DeviceRange& range) const {
+template <typename Range>
+void encodeBatchRead(std::vector<std::uint8_t>& out, const SessionConfig& config,
+                     const DeviceCodeMap& map, const Range& range) {
     if (range.length == 0) {
         throw std::invalid_argument("DeviceRange.length must be greater than zero");
     }
+    if (range.length > FrameEncoder::maxBatchReadPoints(range.head.type)) {
+        throw std::invalid_argument("DeviceRange.length exceeds the batch read point limit");
+    }
 
-    const auto subcommand = sequentialSubcommand(range.head.type, config.series);
-
-    if (config.mode == CommunicationMode::Ascii) {
-        const auto info = device_code_map_.resolveAscii(config.series, range.head.name);
-        const auto number = parseDeviceNumber(range.head.name, info.number_base);
-        std::string request;
-        request += toHex(0x0401, 4);
-        request += toHex(subcommand, 4);
-        appendDeviceAscii(request, info, number);
-        request += toHex(range.length, 4);
-        return buildAsciiFrame(config, request);
-    }
-
-    const auto info = device_code_map_.resolveBinary(config.series, range.head.name);
-    const auto number = parseDeviceNumber(range.head.name, info.number_base);
-    std::vector<std::uint8_t> request;
-    appendLittleEndian(request, 0x0401, 2);
-    appendLittleEndian(request, subcommand, 2);
-    appendDeviceBinary(request, info, number);
-    appendLittleEndian(request, range.length, 2);
-    return buildBinaryFrame(config, request);
+    FrameWriter writer(out, config);
+    writer.command(0x0401, sequentialSubcommand(range.head.type, config.series));
+    writer.device(map, config.series, range.head);
+    writer.word(range.length);
+    writer.finish();
 }
 
-std::vector<std::uint8_t> FrameEncoder::makeBatchWriteRequest(const SessionConfig& config,
-                                                              const DeviceRange& range,
-                                                              const std::vector<std::uint16_t>& data) const {
+template <typename Range>
+void encodeBatchWrite(std::vector<std::uint8_t>& out, const SessionConfig& config,
+                      const DeviceCodeMap& map, const Range& range,
+                      const std::vector<std::uint16_t>& data) {
     if (range.length == 0 || data.size() < range.length) {
         throw std::invalid_argument("Insufficient write data");
     }
-
-    const auto subcommand = sequentialSubcommand(range.head.type, config.series);
-
-    if (config.mode == CommunicationMode::Ascii) {
-        const auto info = device_code_map_.resolveAscii(config.series, range.head.name);
-        const auto number = parseDeviceNumber(range.head.name, info.number_base);
-        std::string request;
-        request += toHex(0x1401, 4);
-        request += toHex(subcommand, 4);
-        appendDeviceAscii(request, info, number);
-        request += toHex(range.length, 4);
-        if (range.head.type == DeviceType::Bit) {
-            request += packBitValuesAscii(data, config.series, range.length);
-        } else {
-            for (std::size_t i = 0; i < range.length; ++i) {
-                request += toHex(data[i], 4);
-            }
-        }
-        return buildAsciiFrame(config, request);
+    if (range.length > FrameEncoder::maxBatchWritePoints(range.head.type)) {
+        throw std::invalid_argument("DeviceRange.length exceeds the batch write point limit");
     }
 
-    const auto info = device_code_map_.resolveBinary(config.series, range.head.name);
-    const auto number = parseDeviceNumber(range.head.name, info.number_base);
-    std::vector<std::uint8_t> request;
-    appendLittleEndian(request, 0x1401, 2);
-    appendLittleEndian(request, subcommand, 2);
-    appendDeviceBinary(request, info, number);
-    appendLittleEndian(request, range.length, 2);
+    FrameWriter writer(out, config);
+    writer.command(0x1401, sequentialSubcommand(range.head.type, config.series));
+    writer.device(map, config.series, range.head);
+    writer.word(range.length);
     if (range.head.type == DeviceType::Bit) {
-        auto packed = packBitValuesBinary(data, config.series, range.length);
-        request.insert(request.end(), packed.begin(), packed.end());
+        writer.bitValues(data, config.series, range.length);
     } else {
         for (std::size_t i = 0; i < range.length; ++i) {
-            appendLittleEndian(request, data[i], 2);
+            writer.word(data[i]);
         }
     }
-    return buildBinaryFrame(config, request);
+    writer.finish();
 }
 
-std::vector<std::uint8_t> FrameEncoder::makeRandomReadRequest(const SessionConfig& config,
-                                                              const RandomDeviceRequest& request) const {
-    const auto subcommand = randomWordSubcommand(config.series);
-    const std::uint8_t word_count = static_cast<std::uint8_t>(request.word_devices.size());
-    const std::uint8_t dword_count = static_cast<std::uint8_t>(request.dword_devices.size());
-    const std::uint8_t lword_count = static_cast<std::uint8_t>(request.lword_devices.size());
-    const std::uint8_t bit_count = static_cast<std::uint8_t>(request.bit_devices.size());
-
-    if (config.mode == CommunicationMode::Ascii) {
-        std::string req;
-        req += toHex(0x0403, 4);
-        req += toHex(subcommand, 4);
-        req += toHex(word_count, 2);
-        req += toHex(dword_count, 2);
-        req += toHex(lword_count, 2);
-        req += toHex(bit_count, 2);
-        for (const auto& device : request.word_devices) {
-            const auto info = device_code_map_.resolveAscii(config.series, device.name);
-            const auto number = parseDeviceNumber(device.name, info.number_base);
-            appendDeviceAscii(req, info, number);
-        }
-        for (const auto& device : request.dword_devices) {
-            const auto info = device_code_map_.resolveAscii(config.series, device.name);
-            const auto number = parseDeviceNumber(device.name, info.number_base);
-            appendDeviceAscii(req, info, number);
+template <typename Request>
+void encodeRandomRead(std::vector<std::uint8_t>& out, const SessionConfig& config,
+                      const DeviceCodeMap& map, const Request& request, std::uint16_t command = 0x0403) {
+    checkRandomReadLimits(config, request);
+
+    FrameWriter writer(out, config);
+    writer.command(command, randomWordSubcommand(config.series));
+    writeRandomCounts(writer, request);
+    for (const auto* devices : {&request.word_devices, &request.dword_devices,
+                                &request.lword_devices, &request.bit_devices}) {
+        for (const auto& device : *devices) {
+            writer.device(map, config.series, device);
         }
-        for (const auto& device : request.lword_devices) {
-            const auto info = device_code_map_.resolveAscii(config.series, device.name);
-            const auto number = parseDeviceNumber(device.name, info.number_base);
-            appendDeviceAscii(req, info, number);
-        }
-        for (const auto& device : request.bit_devices) {
-            const auto info = device_code_map_.resolveAscii(config.series, device.name);
-            const auto number = parseDeviceNumber(device.name, info.number_base);
-            appendDeviceAscii(req, info, number);
-        }
-        return buildAsciiFrame(config, req);
-    }
-
-    std::vector<std::uint8_t> req;
-    appendLittleEndian(req, 0x0403, 2);
-    appendLittleEndian(req, subcommand, 2);
-    req.push_back(word_count);
-    req.push_back(dword_count);
-    req.push_back(lword_count);
-    req.push_back(bit_count);
-    for (const auto& device : request.word_devices) {
-        const auto info = device_code_map_.resolveBinary(config.series, device.name);
-        const auto number = parseDeviceNumber(device.name, info.number_base);
-        appendDeviceBinary(req, info, number);
-    }
-    for (const auto& device : request.dword_devices) {
-        const auto info = device_code_map_.resolveBinary(config.series, device.name);
-        const auto number = parseDeviceNumber(device.name, info.number_base);
-        appendDeviceBinary(req, info, number);
-    }
-    for (const auto& device : request.lword_devices) {
-        const auto info = device_code_map_.resolveBinary(config.series, device.name);
-        const auto number = parseDeviceNumber(device.name, info.number_base);
-        appendDeviceBinary(req, info, number);
     }
-    for (const auto& device : request.bit_devices) {
-        const auto info = device_code_map_.resolveBinary(config.series, device.name);
-        const auto number = parseDeviceNumber(device.name, info.number_base);
-        appendDeviceBinary(req, info, number);
-    }
-    return buildBinaryFrame(config, req);
+    writer.finish();
 }
 
-std::vector<std::uint8_t> FrameEncoder::makeRandomWriteRequest(const SessionConfig& config,
-                                                               const RandomDeviceRequest& request,
-                                                               const std::vector<std::uint16_t>& word_data,
-                                                               const std::vector<std::uint32_t>& dword_data,
-                                                               const std::vector<std::uint64_t>& lword_data,
-                                                               const std::vector<bool>& bit_data) const {
+template <typename Request>
+void encodeRandomWrite(std::vector<std::uint8_t>& out, const SessionConfig& config,
+                       const DeviceCodeMap& map, const Request& request,
+                       const std::vector<std::uint16_t>& word_data,
+                       const std::vector<std::uint32_t>& dword_data,
+                       const std::vector<std::uint64_t>& lword_data,
+                       const std::vector<bool>& bit_data) {
     if (request.word_devices.size() != word_data.size()) {
         throw std::invalid_argument("word device/value count mismatch");
     }
@@ -311,88 +273,247 @@ std::vector<std::uint8_t> FrameEncoder::makeRandomWriteRequest(const SessionConf
         throw std::invalid_argument("bit device/value count mismatch");
     }
 
-    const auto subcommand = randomWordSubcommand(config.series);
-    const std::uint8_t word_count = static_cast<std::uint8_t>(request.word_devices.size());
-    const std::uint8_t dword_count = static_cast<std::uint8_t>(request.dword_devices.size());
-    const std::uint8_t lword_count = static_cast<std::uint8_t>(request.lword_devices.size());
-    const std::uint8_t bit_count = static_cast<std::uint8_t>(request.bit_devices.size());
-
-    if (config.mode == CommunicationMode::Ascii) {
-        std::string req;
-        req += toHex(0x1402, 4);
-        req += toHex(subcommand, 4);
-        req += toHex(word_count, 2);
-        req += toHex(dword_count, 2);
-        req += toHex(lword_count, 2);
-        req += toHex(bit_count, 2);
-        for (std::size_t i = 0; i < request.word_devices.size(); ++i) {
-            const auto& device = request.word_devices[i];
-            const auto info = device_code_map_.resolveAscii(config.series, device.name);
-            const auto number = parseDeviceNumber(device.name, info.number_base);
-            appendDeviceAscii(req, info, number);
-            req += toHex(word_data[i], 4);
-        }
-        for (std::size_t i = 0; i < request.dword_devices.size(); ++i) {
-            const auto& device = request.dword_devices[i];
-            const auto info = device_code_map_.resolveAscii(config.series, device.name);
-            const auto number = parseDeviceNumber(device.name, info.number_base);
-            appendDeviceAscii(req, info, number);
-            req += toHex(dword_data[i], 8);
-        }
-        for (std::size_t i = 0; i < request.lword_devices.size(); ++i) {
-            const auto& device = request.lword_devices[i];
-            const auto info = device_code_map_.resolveAscii(config.series, device.name);
-            const auto number = parseDeviceNumber(device.name, info.number_base);
-            appendDeviceAscii(req, info, number);
-            req += toHex(static_cast<std::uint32_t>(lword_data[i] & 0xFFFFFFFF), 8);
-            req += toHex(static_cast<std::uint32_t>((lword_data[i] >> 32) & 0xFFFFFFFF), 8);
-        }
-        for (std::size_t i = 0; i < request.bit_devices.size(); ++i) {
-            const auto& device = request.bit_devices[i];
-            const auto info = device_code_map_.resolveAscii(config.series, device.name);
-            const auto number = parseDeviceNumber(device.name, info.number_base);
-            appendDeviceAscii(req, info, number);
-            req += bit_data[i] ? "0001" : "0000";
-        }
-        return buildAsciiFrame(config, req);
-    }
+    checkRandomWriteLimits(config, request);
 
-    std::vector<std::uint8_t> req;
-    appendLittleEndian(req, 0x1402, 2);
-    appendLittleEndian(req, subcommand, 2);
-    req.push_back(word_count);
-    req.push_back(dword_count);
-    req.push_back(lword_count);
-    req.push_back(bit_count);
+    FrameWriter writer(out, config);
+    writer.command(0x1402, randomWordSubcommand(config.series));
+    writeRandomCounts(writer, request);
     for (std::size_t i = 0; i < request.word_devices.size(); ++i) {
-        const auto& device = request.word_devices[i];
-        const auto info = device_code_map_.resolveBinary(config.series, device.name);
-        const auto number = parseDeviceNumber(device.name, info.number_base);
-        appendDeviceBinary(req, info, number);
-        appendLittleEndian(req, word_data[i], 2);
+        writer.device(map, config.series, request.word_devices[i]);
+        writer.word(word_data[i]);
     }
     for (std::size_t i = 0; i < request.dword_devices.size(); ++i) {
-        const auto& device = request.dword_devices[i];
-        const auto info = device_code_map_.resolveBinary(config.series, device.name);
-        const auto number = parseDeviceNumber(device.name, info.number_base);
-        appendDeviceBinary(req, info, number);
-        appendLittleEndian(req, dword_data[i], 4);
+        writer.device(map, config.series, request.dword_devices[i]);
+        writer.dword(dword_data[i]);
     }
     for (std::size_t i = 0; i < request.lword_devices.size(); ++i) {
-        const auto& device = request.lword_devices[i];
-        const auto info = device_code_map_.resolveBinary(config.series, device.name);
-        const auto number = parseDeviceNumber(device.name, info.number_base);
-        appendDeviceBinary(req, info, number);
-        appendLittleEndian(req, lword_data[i], 8);
+        writer.device(map, config.series, request.lword_devices[i]);
+        writer.lword(lword_data[i]);
     }
     for (std::size_t i = 0; i < request.bit_devices.size(); ++i) {
-        const auto& device = request.bit_devices[i];
-        const auto info = device_code_map_.resolveBinary(config.series, device.name);
-        const auto number = parseDeviceNumber(device.name, info.number_base);
-        appendDeviceBinary(req, info, number);
-        appendLittleEndian(req, static_cast<std::uint16_t>(bit_data[i] ? 1 : 0), 2);
+        writer.device(map, config.series, request.bit_devices[i]);
+        writer.word(static_cast<std::uint16_t>(bit_data[i] ? 1 : 0));
+    }
+    writer.finish();
+}
+
+template <typename Request>
+std::size_t multiBlockPoints(const Request& request) {
+    std::size_t points = 0;
+    for (const auto* blocks : {&request.word_blocks, &request.bit_blocks}) {
+        for (const auto& block : *blocks) {
+            if (block.length == 0) {
+                throw std::invalid_argument("Multi-block length must be greater than zero");
+            }
+            points += block.length;
+        }
+    }
+    return points;
+}
+
+template <typename Request>
+void writeMultiBlockCounts(FrameWriter& writer, const Request& request) {
+    const std::size_t blocks = request.word_blocks.size() + request.bit_blocks.size();
+    if (blocks == 0 || blocks > FrameEncoder::kMaxMultiBlocks) {
+        throw std::invalid_argument("Multi-block request must have 1 to 120 blocks");
+    }
+    writer.byte(static_cast<std::uint8_t>(request.word_blocks.size()));
+    writer.byte(static_cast<std::uint8_t>(request.bit_blocks.size()));
+}
+
+template <typename Request>
+void encodeMultiBlockRead(std::vector<std::uint8_t>& out, const SessionConfig& config,
+                          const DeviceCodeMap& map, const Request& request) {
+    if (multiBlockPoints(request) > FrameEncoder::kMaxMultiBlockPoints) {
+        throw std::invalid_argument("Multi-block read exceeds the per-request point limit");
+    }
+
+    FrameWriter writer(out, config);
+    writer.command(0x0406, randomWordSubcommand(config.series));
+    writeMultiBlockCounts(writer, request);
+    for (const auto* blocks : {&request.word_blocks, &request.bit_blocks}) {
+        for (const auto& block : *blocks) {
+            writer.device(map, config.series, block.head);
+            writer.word(block.length);
+        }
+    }
+    writer.finish();
+}
+
+template <typename Request>
+void encodeMultiBlockWrite(std::vector<std::uint8_t>& out, const SessionConfig& config,
+                           const DeviceCodeMap& map, const Request& request,
+                           const std::vector<std::uint16_t>& data) {
+    const std::size_t points = multiBlockPoints(request);
+    const std::size_t blocks = request.word_blocks.size() + request.bit_blocks.size();
+    if (data.size() < points) {
+        throw std::invalid_argument("Insufficient write data");
+    }
+    if (blocks * FrameEncoder::kMultiBlockWriteBlockCost + points > FrameEncoder::kMaxMultiBlockPoints) {
+        throw std::invalid_argument("Multi-block write exceeds the per-request point limit");
     }
-    return buildBinaryFrame(config, req);
+
+    FrameWriter writer(out, config);
+    writer.command(0x1406, randomWordSubcommand(config.series));
+    writeMultiBlockCounts(writer, request);
+    std::size_t next = 0;
+    for (const auto* blocks_of_kind : {&request.word_blocks, &request.bit_blocks}) {
+        for (const auto& block : *blocks_of_kind) {
+            writer.device(map, config.series, block.head);
+            writer.word(block.length);
+            for (std::size_t i = 0; i < block.length; ++i) {
+                writer.word(data[next++]);
+            }
+        }
+    }
+    writer.finish();
+}
+
+} // namespace
+
+FrameEncoder::FrameEncoder() = default;
+
+std::vector<std::uint8_t> FrameEncoder::makeBatchReadRequest(const SessionConfig& config, const DeviceRange& range) const {
+    std::vector<std::uint8_t> frame;
+    makeBatchReadRequest(frame, config, range);
+    return frame;
+}
+
+void FrameEncoder::makeBatchReadRequest(std::vector<std::uint8_t>& out,
+                                        const SessionConfig& config,
+                                        const DeviceRange& range) const {
+    encodeBatchRead(out, config, device_code_map_, range);
+}
+
+void FrameEncoder::makeBatchReadRequest(std::vector<std::uint8_t>& out,
+                                        const SessionConfig& config,
+                                        const ResolvedRange& range) const {
+    encodeBatchRead(out, config, device_code_map_, range);
+}
+
+std::vector<std::uint8_t> FrameEncoder::makeBatchWriteRequest(const SessionConfig& config,
+                                                              const DeviceRange& range,
+                                                              const std::vector<std::uint16_t>& data) const {
+    std::vector<std::uint8_t> frame;
+    makeBatchWriteRequest(frame, config, range, data);
+    return frame;
+}
+
+void FrameEncoder::makeBatchWriteRequest(std::vector<std::uint8_t>& out,
+                                         const SessionConfig& config,
+                                         const DeviceRange& range,
+                                         const std::vector<std::uint16_t>& data) const {
+    encodeBatchWrite(out, config, device_code_map_, range, data);
+}
+
+void FrameEncoder::makeBatchWriteRequest(std::vector<std::uint8_t>& out,
+                                         const SessionConfig& config,
+                                         const ResolvedRange& range,
+                                         const std::vector<std::uint16_t>& data) const {
+    encodeBatchWrite(out, config, device_code_map_, range, data);
+}
+
+std::vector<std::uint8_t> FrameEncoder::makeRandomReadRequest(const SessionConfig& config,
+                                                              const RandomDeviceRequest& request) const {
+    std::vector<std::uint8_t> frame;
+    makeRandomReadRequest(frame, config, request);
+    return frame;
+}
+
+void FrameEncoder::makeRandomReadRequest(std::vector<std::uint8_t>& out,
+                                         const SessionConfig& config,
+                                         const RandomDeviceRequest& request) const {
+    encodeRandomRead(out, config, device_code_map_, request);
+}
+
+void FrameEncoder::makeRandomReadRequest(std::vector<std::uint8_t>& out,
+                                         const SessionConfig& config,
+                                         const ResolvedRandomRequest& request) const {
+    encodeRandomRead(out, config, device_code_map_, request);
+}
+
+void FrameEncoder::makeMonitorRegisterRequest(std::vector<std::uint8_t>& out,
+                                              const SessionConfig& config,
+                                              const ResolvedRandomRequest& request) const {
+    encodeRandomRead(out, config, device_code_map_, request, 0x0801);
+}
+
+void FrameEncoder::makeMonitorRequest(std::vector<std::uint8_t>& out, const SessionConfig& config) const {
+    FrameWriter writer(out, config);
+    writer.command(0x0802, 0x0000);
+    writer.finish();
+}
+
+std::vector<std::uint8_t> FrameEncoder::makeRandomWriteRequest(const SessionConfig& config,
+                                                               const RandomDeviceRequest& request,
+                                                               const std::vector<std::uint16_t>& word_data,
+                                                               const std::vector<std::uint32_t>& dword_data,
+                                                               const std::vector<std::uint64_t>& lword_data,
+                                                               const std::vector<bool>& bit_data) const {
+    std::vector<std::uint8_t> frame;
+    makeRandomWriteRequest(frame, config, request, word_data, dword_data, lword_data, bit_data);
+    return frame;
+}
+
+void FrameEncoder::makeRandomWriteRequest(std::vector<std::uint8_t>& out,
+                                          const SessionConfig& config,
+                                          const RandomDeviceRequest& request,
+                                          const std::vector<std::uint16_t>& word_data,
+                                          const std::vector<std::uint32_t>& dword_data,
+                                          const std::vector<std::uint64_t>& lword_data,
+                                          const std::vector<bool>& bit_data) const {
+    encodeRandomWrite(out, config, device_code_map_, request, word_data, dword_data, lword_data, bit_data);
+}
+
+void FrameEncoder::makeRandomWriteRequest(std::vector<std::uint8_t>& out,
+                                          const SessionConfig& config,
+                                          const ResolvedRandomRequest& request,
+                                          const std::vector<std::uint16_t>& word_data,
+                                          const std::vector<std::uint32_t>& dword_data,
+                                          const std::vector<std::uint64_t>& lword_data,
+                                          const std::vector<bool>& bit_data) const {
+    encodeRandomWrite(out, config, device_code_map_, request, word_data, dword_data, lword_data, bit_data);
+}
+
+std::vector<std::uint8_t> FrameEncoder::makeMultiBlockReadRequest(const SessionConfig& config,
+                                                                  const MultiBlockRequest& request) const {
+    std::vector<std::uint8_t> frame;
+    makeMultiBlockReadRequest(frame, config, request);
+    return frame;
+}
+
+void FrameEncoder::makeMultiBlockReadRequest(std::vector<std::uint8_t>& out,
+                                             const SessionConfig& config,
+                                             const MultiBlockRequest& request) const {
+    encodeMultiBlockRead(out, config, device_code_map_, request);
+}
+
+void FrameEncoder::makeMultiBlockReadRequest(std::vector<std::uint8_t>& out,
+                                             const SessionConfig& config,
+                                             const ResolvedMultiBlockRequest& request) const {
+    encodeMultiBlockRead(out, config, device_code_map_, request);
+}
+
+std::vector<std::uint8_t> FrameEncoder::makeMultiBlockWriteRequest(const SessionConfig& config,
+                                                                   const MultiBlockRequest& request,
+                                                                   const std::vector<std::uint16_t>& data) const {
+    std::vector<std::uint8_t> frame;
+    makeMultiBlockWriteRequest(frame, config, request, data);
+    return frame;
+}
+
+void FrameEncoder::makeMultiBlockWriteRequest(std::vector<std::uint8_t>& out,
+                                              const SessionConfig& config,
+                                              const MultiBlockRequest& request,
+                                              const std::vector<std::uint16_t>& data) const {
+    encodeMultiBlockWrite(out, config, device_code_map_, request, data);
+}
+
+void FrameEncoder::makeMultiBlockWriteRequest(std::vector<std::uint8_t>& out,
+                                              const SessionConfig& config,
+                                              const ResolvedMultiBlockRequest& request,
+                                              const std::vector<std::uint16_t>& data) const {
+    encodeMultiBlockWrite(out, config, device_code_map_, request, data);
 }
 
 std::vector<std::uint8_t> FrameEncoder::makeSimpleCommand(const SessionConfig& config,
@@ -400,19 +521,83 @@ std::vector<std::uint8_t> FrameEncoder::makeSimpleCommand(const SessionConfig& c
                                                           std::uint16_t subcommand,
                                                           const std::vector<std::uint8_t>& binary_payload,
                                                           const std::string& ascii_payload) const {
+    std::vector<std::uint8_t> frame;
+    makeSimpleCommand(frame, config, command, subcommand, binary_payload, ascii_payload);
+    return frame;
+}
+
+void FrameEncoder::makeSimpleCommand(std::vector<std::uint8_t>& out,
+                                     const SessionConfig& config,
+                                     std::uint16_t command,
+                                     std::uint16_t subcommand,
+                                     const std::vector<std::uint8_t>& binary_payload,
+                                     const std::string& ascii_payload) const {
+    FrameWriter writer(out, config);
+    writer.command(command, subcommand);
+    if (writer.ascii()) {
+        writer.text(ascii_payload);
+    } else {
+        writer.raw(binary_payload);
+    }
+    writer.finish();
+}
+
+std::size_t FrameEncoder::headerSize(const SessionConfig& config) {
+    if (config.mode == CommunicationMode::Ascii) {
+        return (config.frame_type == FrameType::Frame4E) ? 30 : 22;
+    }
+    return (config.frame_type == FrameType::Frame4E) ? 15 : 11;
+}
+
+std::size_t FrameEncoder::batchReadRequestSize(const SessionConfig& config) {
+    const bool iqr = config.series == PlcSeries::IQ_R;
     if (config.mode == CommunicationMode::Ascii) {
-        std::string request;
-        request += toHex(command, 4);
-        request += toHex(subcommand, 4);
-        request += ascii_payload;
-        return buildAsciiFrame(config, request);
-    }
-
-    std::vector<std::uint8_t> request;
-    appendLittleEndian(request, command, 2);
-    appendLittleEndian(request, subcommand, 2);
-    request.insert(request.end(), binary_payload.begin(), binary_payload.end());
-    return buildBinaryFrame(config, request);
+        // コマンド + サブコマンド + デバイスコード + デバイス番号 + 点数
+        return headerSize(config) + 4 + 4 + (iqr ? 4 + 8 : 2 + 6) + 4;
+    }
+    return headerSize(config) + 2 + 2 + (iqr ? 2 + 4 : 1 + 3) + 2;
+}
+
+void FrameEncoder::setMonitoringTimer(std::vector<std::uint8_t>& frame, std::uint16_t timer_250ms) {
+    // 監視タイマーはデータ長フィールドの直後にある。
+    const bool binary3e = frame.size() >= 2 && frame[0] == 0x50 && frame[1] == 0x00;
+    const bool binary4e = frame.size() >= 2 && frame[0] == 0x54 && frame[1] == 0x00;
+    if (binary3e || binary4e) {
+        const std::size_t offset = binary4e ? 13 : 9;
+        if (frame.size() < offset + 2) {
+            throw std::invalid_argument("Binary request frame too short");
+        }
+        frame[offset] = static_cast<std::uint8_t>(timer_250ms & 0xFF);
+        frame[offset + 1] = static_cast<std::uint8_t>((timer_250ms >> 8) & 0xFF);
+        return;
+    }
+    if (frame.size() >= 4 && (frame[0] == '5') && (frame[1] == '0' || frame[1] == '4') && frame[2] == '0' &&
+        frame[3] == '0') {
+        const std::size_t offset = (frame[1] == '4') ? 26 : 18;
+        if (frame.size() < offset + 4) {
+            throw std::invalid_argument("ASCII request frame too short");
+        }
+        for (std::size_t i = 0; i < 4; ++i) {
+            frame[offset + i] = static_cast<std::uint8_t>(kHexDigits[(timer_250ms >> (12 - 4 * i)) & 0x0F]);
+        }
+        return;
+    }
+    throw std::invalid_argument("Frame is not a 3E/4E request frame");
+}
+
+void FrameEncoder::setSerialNumber(std::vector<std::uint8_t>& frame, std::uint16_t serial) {
+    if (frame.size() >= 6 && frame[0] == 0x54 && frame[1] == 0x00) {
+        frame[2] = static_cast<std::uint8_t>(serial & 0xFF);
+        frame[3] = static_cast<std::uint8_t>((serial >> 8) & 0xFF);
+        return;
+    }
+    if (frame.size() >= 12 && frame[0] == '5' && frame[1] == '4' && frame[2] == '0' && frame[3] == '0') {
+        for (std::size_t i = 0; i < 4; ++i) {
+            frame[4 + i] = static_cast<std::uint8_t>(kHexDigits[(serial >> (12 - 4 * i)) & 0x0F]);
+        }
+        return;
+    }
+    throw std::invalid_argument("Frame is not a 4E request frame");
 }
 
 } // namespace cpmcprotocol::codec
@@ -1,7 +1,11 @@
 #include "cpmcprotocol/device.hpp"
 
+#include "cpmcprotocol/codec/device_code_map.hpp"
+#include "cpmcprotocol/device_table.hpp"
+
 #include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <stdexcept>
 #include <string>
 
@@ -18,28 +22,12 @@ std::string extractDevicePrefix(const std::string& device_name) {
     return device_name.substr(0, pos);
 }
 
-// デバイス名からデバイス番号を抽出（数値部分）
-bool hasDeviceNumber(const std::string& device_name) {
-    return device_name.find_first_of("0123456789") != std::string::npos;
-}
-
 } // namespace
 
 // デバイスタイプの判定ヘルパー
 DeviceType getDeviceType(const std::string& device_name) {
-    std::string prefix = extractDevicePrefix(device_name);
-
-    // ビットデバイス
-    if (prefix == "X" || prefix == "Y" || prefix == "M" ||
-        prefix == "L" || prefix == "F" || prefix == "B" ||
-        prefix == "T" || prefix == "C") {
-        return DeviceType::Bit;
-    }
-
-    // ワードデバイス
-    if (prefix == "D" || prefix == "W" || prefix == "R" ||
-        prefix == "Z" || prefix == "ZR" || prefix == "RD") {
-        return DeviceType::Word;
+    if (const auto index = findDeviceIndex(extractDevicePrefix(device_name))) {
+        return kDeviceTable[*index].type;
     }
 
     // 不明な場合はWordとして扱う（後でエラーになる）
@@ -48,52 +36,32 @@ DeviceType getDeviceType(const std::string& device_name) {
 
 // デバイス名の検証
 bool isValidDeviceName(const std::string& device_name, std::string* error_message) {
-    if (device_name.empty()) {
-        if (error_message) {
-            *error_message = "Device name is empty";
-        }
-        return false;
+    const auto result = parseDeviceName(device_name);
+    if (result.error == DeviceParseError::None) {
+        return true;
     }
 
-    // プレフィックスの抽出
-    std::string prefix = extractDevicePrefix(device_name);
-    if (prefix.empty()) {
-        if (error_message) {
-            *error_message = "Device name has no prefix";
+    if (error_message) {
+        switch (result.error) {
+            case DeviceParseError::Empty:
+                *error_message = "Device name is empty";
+                break;
+            case DeviceParseError::MissingPrefix:
+                *error_message = "Device name has no prefix";
+                break;
+            case DeviceParseError::UnknownPrefix:
+                *error_message = "Unknown device prefix: " + device_name.substr(0, result.prefix_length);
+                break;
+            case DeviceParseError::MissingNumber:
+                *error_message = "Device name missing numeric part: " + device_name;
+                break;
+            case DeviceParseError::InvalidNumber:
+            case DeviceParseError::None:
+                *error_message = "Invalid device number: " + device_name;
+                break;
         }
-        return false;
     }
-
-    // 既知のデバイスプレフィックスかチェック
-    static const char* known_prefixes[] = {
-        "X", "Y", "M", "L", "F", "B", "T", "C",  // Bit devices
-        "D", "W", "R", "Z", "ZR", "RD"           // Word devices
-    };
-
-    bool found = false;
-    for (const auto* known : known_prefixes) {
-        if (prefix == known) {
-            found = true;
-            break;
-        }
-    }
-
-    if (!found) {
-        if (error_message) {
-            *error_message = "Unknown device prefix: " + prefix;
-        }
-        return false;
-    }
-
-    // 数値部分の検証
-    if (!hasDeviceNumber(device_name)) {
-        if (error_message) {
-            *error_message = "Device name missing numeric part: " + device_name;
-        }
-        return false;
-    }
-
-    return true;
+    return false;
 }
 
 // デバイス名の正規化（大文字化）
@@ -131,4 +99,60 @@ DeviceRange makeDeviceRange(const std::string& device_name, std::uint16_t length
     return range;
 }
 
+ResolvedDevice resolveDevice(const DeviceAddress& address) {
+    return codec::DeviceCodeMap::resolve(address.name, address.type);
+}
+
+ResolvedDevice resolveDevice(const std::string& device_name) {
+    return resolveDevice(makeDeviceAddress(device_name));
+}
+
+ResolvedRange resolveRange(const DeviceRange& range) {
+    return ResolvedRange{resolveDevice(range.head), range.length};
+}
+
+ResolvedRandomRequest resolveRandomRequest(const RandomDeviceRequest& request) {
+    auto resolveAll = [](const std::vector<DeviceAddress>& addresses) {
+        std::vector<ResolvedDevice> resolved;
+        resolved.reserve(addresses.size());
+        for (const auto& address : addresses) {
+            resolved.push_back(resolveDevice(address));
+        }
+        return resolved;
+    };
+
+    ResolvedRandomRequest resolved;
+    resolved.word_devices = resolveAll(request.word_devices);
+    resolved.dword_devices = resolveAll(request.dword_devices);
+    resolved.lword_devices = resolveAll(request.lword_devices);
+    resolved.bit_devices = resolveAll(request.bit_devices);
+    return resolved;
+}
+
+ResolvedMultiBlockRequest resolveMultiBlockRequest(const MultiBlockRequest& request) {
+    auto resolveAll = [](const std::vector<DeviceRange>& ranges) {
+        std::vector<ResolvedRange> resolved;
+        resolved.reserve(ranges.size());
+        for (const auto& range : ranges) {
+            resolved.push_back(resolveRange(range));
+        }
+        return resolved;
+    };
+
+    ResolvedMultiBlockRequest resolved;
+    resolved.word_blocks = resolveAll(request.word_blocks);
+    resolved.bit_blocks = resolveAll(request.bit_blocks);
+    return resolved;
+}
+
+std::string formatDevice(const ResolvedDevice& device) {
+    std::string name = codec::DeviceCodeMap::prefix(device);
+    char digits[16];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), device.number,
+                                      codec::DeviceCodeMap::numberBase(device));
+    std::transform(digits, result.ptr, digits, [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    name.append(digits, result.ptr);
+    return name;
+}
+
 } // namespace cpmcprotocol
@@ -0,0 +1,1327 @@
+#include "cpmcprotocol/event_transport.hpp"
+
+// 多数の PLC 接続を少数スレッドで扱うためのイベント駆動トランスポート。
+// ソケットはノンブロッキングで扱い、タイムアウトは要求ごとのデッドラインで管理する。
+
+#include "cpmcprotocol/codec/frame_decoder.hpp"
+#include "socket_ops.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+#include "io_uring.hpp"
+
+#include <poll.h>
+#endif
+#elif !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#endif
+
+namespace cpmcprotocol {
+
+using detail::SocketHandle;
+using detail::kInvalidSocket;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr std::size_t kReceiveChunk = 4096;
+
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+// io_uring の送信キューの長さと、受信用に登録する固定バッファの数（1 接続 1 つ、kReceiveChunk バイト）。
+// 固定バッファが足りない接続は通常のバッファで受信する。
+constexpr unsigned kUringEntries = 512;
+constexpr std::size_t kFixedBuffers = 256;
+
+// 完了の user_data は (チャネル番号 << 2) | 操作。チャネル番号 0 は待機解除用の eventfd。
+constexpr std::uint64_t kOpConnect = 0; // 接続の確立待ち（書き込み可能のポーリング）
+constexpr std::uint64_t kOpReceive = 1;
+constexpr std::uint64_t kOpSend = 2;
+constexpr std::uint64_t kOpCancel = 3;
+constexpr std::uint64_t kWakeUserData = 0;
+#endif
+
+struct PendingRequest {
+    std::optional<std::uint16_t> key;
+    Clock::time_point deadline;
+    AsyncTcpTransport::Completion completion;
+};
+
+struct ReadyEvent {
+    SocketHandle socket = kInvalidSocket;
+    bool readable = false;
+    bool writable = false;
+    bool error = false;
+};
+
+} // namespace
+
+FrameFormat makeResponseFrameFormat(const SessionConfig& config) {
+    const auto mode = config.mode;
+    const auto type = config.frame_type;
+
+    FrameFormat format;
+    format.header_size = codec::FrameDecoder::headerSize(mode, type);
+    format.length_extractor = [mode, type](const std::uint8_t* header, std::size_t) {
+        return codec::FrameDecoder::bodyLength(header, mode, type);
+    };
+    if (type == FrameType::Frame4E) {
+        // 4E 応答のシリアル番号はサブヘッダー直後（バイナリ 2 バイト LE / ASCII 4 桁 16 進）にある。
+        format.key_extractor = [mode](const std::uint8_t* frame, std::size_t size) -> std::optional<std::uint16_t> {
+            if (mode == CommunicationMode::Binary) {
+                if (size < 4 || frame[0] != 0xD4) {
+                    return std::nullopt;
+                }
+                return static_cast<std::uint16_t>(frame[2] | (frame[3] << 8));
+            }
+            if (size < 8 || frame[1] != '4') {
+                return std::nullopt;
+            }
+            std::uint16_t serial = 0;
+            for (std::size_t i = 4; i < 8; ++i) {
+                const char c = static_cast<char>(frame[i]);
+                serial = static_cast<std::uint16_t>(serial << 4);
+                if (c >= '0' && c <= '9') {
+                    serial = static_cast<std::uint16_t>(serial | (c - '0'));
+                } else if (c >= 'A' && c <= 'F') {
+                    serial = static_cast<std::uint16_t>(serial | (c - 'A' + 10));
+                } else if (c >= 'a' && c <= 'f') {
+                    serial = static_cast<std::uint16_t>(serial | (c - 'a' + 10));
+                } else {
+                    throw std::invalid_argument("Invalid hex digit in ASCII serial number");
+                }
+            }
+            return serial;
+        };
+    }
+    return format;
+}
+
+// 接続 1 本分の送受信状態。イベントループからの通知で送信キューの吐き出しとフレーム切り出しを行う。
+struct AsyncTcpTransport::Impl {
+    EventLoop* loop = nullptr;
+    SocketHandle socket = kInvalidSocket;
+    FrameFormat format;
+
+    std::vector<std::uint8_t> tx;
+    std::size_t tx_offset = 0;
+    std::vector<std::uint8_t> rx;
+    std::size_t rx_begin = 0;
+    std::size_t rx_end = 0;
+
+    std::deque<PendingRequest> pending;
+    // pending のデッドライン（最も早いものを走査せずに求める）
+    std::multiset<Clock::time_point> deadlines;
+    // ループのデッドライン表に登録している、この接続の直近のデッドライン
+    std::optional<Clock::time_point> scheduled;
+    bool want_write = false;
+    std::size_t corked = 0;
+
+    // 接続の確立待ち（connect() から確立または失敗まで）。アドレスは名前解決の順に 1 つずつ試す
+    bool connecting = false;
+    std::vector<detail::SocketAddress> addresses;
+    std::size_t next_address = 0;
+    Clock::time_point connect_deadline;
+    std::chrono::milliseconds connect_timeout{0};
+    std::string endpoint;
+    int connect_error = 0; // 直近に失敗したアドレスのエラー
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+    // io_uring バックエンドのチャネル番号（0 はチャネルなし）
+    std::uint64_t channel = 0;
+#endif
+
+    bool connectNext();
+    void checkConnect();
+    void finishConnect();
+    std::string connectFailure() const;
+    void onReadable();
+    void onReceived(const std::uint8_t* data, std::size_t size);
+    void reserveReceive(std::size_t size);
+    void onWritable();
+    void flush();
+    void extractFrames();
+    void dispatch(std::vector<std::uint8_t> frame);
+    void processTimeouts(Clock::time_point now);
+    std::optional<Clock::time_point> nextDeadline() const;
+    void updateDeadline();
+    void fail(std::exception_ptr error);
+    static void notifyAll(std::vector<Completion>& completions, const std::exception_ptr& error);
+    void releaseSocket();
+    void close();
+    void setWantWrite(bool enabled);
+};
+
+// ========================================
+// EventLoop
+// ========================================
+
+struct EventLoop::Impl {
+    std::unordered_map<SocketHandle, AsyncTcpTransport::Impl*> sources;
+    std::vector<ReadyEvent> ready;
+    // 接続ごとの直近のデッドライン（接続の確立・応答待ちの要求のうち最も早いもの）。
+    // 要求の追加・完了・失敗のたびに接続が更新するため、待機のたびに全接続の要求を走査しない。
+    std::set<std::pair<Clock::time_point, AsyncTcpTransport::Impl*>> deadlines;
+    std::vector<std::pair<Clock::time_point, AsyncTcpTransport::Impl*>> due;
+
+    std::mutex task_mutex;
+    std::vector<std::function<void()>> tasks;
+    std::atomic<bool> stop_requested{false};
+
+#ifdef __linux__
+    int epoll_fd = -1;
+    int wake_fd = -1;
+    std::vector<epoll_event> epoll_events = std::vector<epoll_event>(64);
+#elif !defined(_WIN32)
+    int wake_read = -1;
+    int wake_write = -1;
+    std::vector<pollfd> poll_fds;
+#else
+    std::vector<WSAPOLLFD> poll_fds;
+#endif
+
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+    // io_uring バックエンドの接続 1 本分の状態。送受信中のバッファはカーネルが完了を返すまで保持するため、
+    // 切断後も未完了の操作がなくなるまでトランスポートから切り離して残す。
+    struct Channel {
+        AsyncTcpTransport::Impl* source = nullptr; // 切断後は nullptr
+        SocketHandle socket = kInvalidSocket;
+        std::size_t slot = kFixedBuffers;           // 固定バッファの番号（kFixedBuffers は通常のバッファ）
+        std::unique_ptr<std::uint8_t[]> buffer;     // 固定バッファがない場合の受信バッファ
+        std::vector<std::uint8_t> sending;          // 送信中のデータ（トランスポートの tx から移す）
+        std::size_t sent = 0;
+        bool polling = false; // 接続の確立を待っている
+        bool receiving = false;
+        bool send_in_flight = false;
+    };
+
+    // fixed_buffers は登録したリングより長く生存させる
+    std::vector<std::uint8_t> fixed_buffers;
+    std::vector<std::size_t> free_slots;
+    std::unique_ptr<detail::IoUring> uring; // カーネルが対応していない場合は nullptr（epoll を使う）
+    std::unordered_map<std::uint64_t, Channel> channels;
+    std::vector<std::uint64_t> closed_channels;
+    std::uint64_t next_channel = 1;
+    bool wake_armed = false;
+    std::vector<detail::IoUring::Completion> completions;
+#endif
+
+    Impl() {
+#ifdef __linux__
+        epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0) {
+            throw TransportError("epoll_create1 failed: " + detail::lastSocketErrorMessage(0));
+        }
+        wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wake_fd < 0) {
+            ::close(epoll_fd);
+            throw TransportError("eventfd failed: " + detail::lastSocketErrorMessage(0));
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = wake_fd;
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+        initUring();
+#endif
+#elif !defined(_WIN32)
+        int fds[2];
+        if (::pipe(fds) != 0) {
+            throw TransportError("pipe failed: " + detail::lastSocketErrorMessage(0));
+        }
+        wake_read = fds[0];
+        wake_write = fds[1];
+        ::fcntl(wake_read, F_SETFL, ::fcntl(wake_read, F_GETFL, 0) | O_NONBLOCK);
+        ::fcntl(wake_write, F_SETFL, ::fcntl(wake_write, F_GETFL, 0) | O_NONBLOCK);
+#else
+        detail::ensureWinsock();
+#endif
+    }
+
+    ~Impl() {
+#ifdef __linux__
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+        shutdownUring();
+#endif
+        ::close(wake_fd);
+        ::close(epoll_fd);
+#elif !defined(_WIN32)
+        ::close(wake_read);
+        ::close(wake_write);
+#endif
+    }
+
+    void add(AsyncTcpTransport::Impl* source) {
+        sources[source->socket] = source;
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+        if (uring) {
+            attachChannel(source);
+            return;
+        }
+#endif
+#ifdef __linux__
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP | (source->want_write ? static_cast<std::uint32_t>(EPOLLOUT) : 0U);
+        ev.data.fd = source->socket;
+        if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, source->socket, &ev) != 0) {
+            sources.erase(source->socket);
+            throw TransportError("epoll_ctl(ADD) failed: " + detail::lastSocketErrorMessage(0));
+        }
+#endif
+    }
+
+    void modify(AsyncTcpTransport::Impl* source) {
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+        if (uring) {
+            return; // 送信の完了はリングで通知されるため、書き込み可能の監視はない
+        }
+#endif
+#ifdef __linux__
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP | (source->want_write ? static_cast<std::uint32_t>(EPOLLOUT) : 0U);
+        ev.data.fd = source->socket;
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, source->socket, &ev);
+#else
+        (void)source; // poll 版は待機のたびに監視対象を組み立てる
+#endif
+    }
+
+    void remove(SocketHandle socket) {
+        auto it = sources.find(socket);
+        if (it == sources.end()) {
+            return;
+        }
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+        if (uring) {
+            detachChannel(it->second);
+            sources.erase(it);
+            return;
+        }
+#endif
+        sources.erase(it);
+#ifdef __linux__
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, socket, nullptr);
+#endif
+    }
+
+    void wake() {
+#ifdef __linux__
+        const std::uint64_t one = 1;
+        [[maybe_unused]] auto written = ::write(wake_fd, &one, sizeof(one));
+#elif !defined(_WIN32)
+        const char byte = 1;
+        [[maybe_unused]] auto written = ::write(wake_write, &byte, 1);
+#endif
+    }
+
+    void drainWake() {
+#ifdef __linux__
+        std::uint64_t value = 0;
+        [[maybe_unused]] auto read_bytes = ::read(wake_fd, &value, sizeof(value));
+#elif !defined(_WIN32)
+        char buffer[64];
+        while (::read(wake_read, buffer, sizeof(buffer)) > 0) {
+        }
+#endif
+    }
+
+    // 監視対象のソケットのうち準備のできたものを ready に格納する。
+    void wait(std::chrono::milliseconds timeout) {
+        ready.clear();
+        const int timeout_ms = static_cast<int>(std::min<std::chrono::milliseconds::rep>(
+            std::max<std::chrono::milliseconds::rep>(0, timeout.count()), std::numeric_limits<int>::max()));
+#ifdef __linux__
+        const int count = ::epoll_wait(epoll_fd, epoll_events.data(), static_cast<int>(epoll_events.size()), timeout_ms);
+        for (int i = 0; i < count; ++i) {
+            const auto& ev = epoll_events[static_cast<std::size_t>(i)];
+            if (ev.data.fd == wake_fd) {
+                drainWake();
+                continue;
+            }
+            ReadyEvent event;
+            event.socket = ev.data.fd;
+            event.readable = (ev.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) != 0;
+            event.writable = (ev.events & EPOLLOUT) != 0;
+            event.error = (ev.events & EPOLLERR) != 0;
+            ready.push_back(event);
+        }
+        if (count == static_cast<int>(epoll_events.size())) {
+            epoll_events.resize(epoll_events.size() * 2);
+        }
+#else
+        poll_fds.clear();
+#ifndef _WIN32
+        poll_fds.push_back(pollfd{wake_read, POLLIN, 0});
+#endif
+        for (const auto& [socket, source] : sources) {
+            short events = POLLIN;
+            if (source->want_write) {
+                events |= POLLOUT;
+            }
+#ifdef _WIN32
+            poll_fds.push_back(WSAPOLLFD{socket, events, 0});
+#else
+            poll_fds.push_back(pollfd{socket, events, 0});
+#endif
+        }
+#ifdef _WIN32
+        // Windows には待機解除用の fd がないため、post()/stop() への反応性を保つよう待機を短く区切る。
+        const int wait_ms = std::min(timeout_ms, 10);
+        if (poll_fds.empty()) {
+            ::Sleep(static_cast<DWORD>(wait_ms));
+            return;
+        }
+        const int count = ::WSAPoll(poll_fds.data(), static_cast<ULONG>(poll_fds.size()), wait_ms);
+#else
+        const int count = ::poll(poll_fds.data(), static_cast<nfds_t>(poll_fds.size()), timeout_ms);
+#endif
+        if (count <= 0) {
+            return;
+        }
+        for (const auto& pfd : poll_fds) {
+            if (pfd.revents == 0) {
+                continue;
+            }
+#ifndef _WIN32
+            if (pfd.fd == wake_read) {
+                drainWake();
+                continue;
+            }
+#endif
+            ReadyEvent event;
+            event.socket = pfd.fd;
+            event.readable = (pfd.revents & (POLLIN | POLLHUP)) != 0;
+            event.writable = (pfd.revents & POLLOUT) != 0;
+            event.error = (pfd.revents & (POLLERR | POLLNVAL)) != 0;
+            ready.push_back(event);
+        }
+#endif
+    }
+
+    void runTasks() {
+        std::vector<std::function<void()>> current;
+        {
+            std::lock_guard<std::mutex> lock(task_mutex);
+            current.swap(tasks);
+        }
+        for (auto& task : current) {
+            task();
+        }
+    }
+
+    bool hasTasks() {
+        std::lock_guard<std::mutex> lock(task_mutex);
+        return !tasks.empty();
+    }
+
+    std::optional<Clock::time_point> nextDeadline() const {
+        if (deadlines.empty()) {
+            return std::nullopt;
+        }
+        return deadlines.begin()->first;
+    }
+
+    void processTimeouts(Clock::time_point now) {
+        due.clear();
+        for (auto it = deadlines.begin(); it != deadlines.end() && it->first <= now; ++it) {
+            due.push_back(*it);
+        }
+        // コールバック内で接続が破棄・更新されても安全なよう、表に残っている場合だけ処理する。
+        for (const auto& entry : due) {
+            if (deadlines.count(entry) != 0) {
+                entry.second->processTimeouts(now);
+            }
+        }
+    }
+
+    // 準備のできたソケットの読み書きを行う（epoll / poll）。
+    std::size_t dispatchReady() {
+        std::size_t handled = 0;
+        // ready はコールバック中の wait() 呼び出しで上書きされないが、念のためコピーしてから処理する。
+        const auto events = ready;
+        for (const auto& event : events) {
+            auto it = sources.find(event.socket);
+            if (it == sources.end()) {
+                continue;
+            }
+            auto* source = it->second;
+            ++handled;
+            if (event.writable && !event.error) {
+                source->onWritable();
+            }
+            if (event.readable || event.error) {
+                // エラー時も recv でエラー内容を取得して切断処理を行う。
+                if (sources.count(event.socket) != 0) {
+                    source->onReadable();
+                }
+            }
+        }
+        return handled;
+    }
+
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+    // ========================================
+    // io_uring バックエンド
+    // 送受信はソケットの準備完了を待たずにリングへ積み、次の待機でまとめて提出する。
+    // 多数の接続の送受信と完了の刈り取りが 1 回の io_uring_enter で済む。
+    // ========================================
+
+    void initUring() {
+        uring = detail::IoUring::create(kUringEntries);
+        if (!uring) {
+            return;
+        }
+        // 受信用の固定バッファを登録する。ロック可能なメモリの上限（RLIMIT_MEMLOCK）で失敗した場合は
+        // 通常のバッファで受信する。
+        fixed_buffers.resize(kFixedBuffers * kReceiveChunk);
+        std::vector<iovec> iovecs(kFixedBuffers);
+        for (std::size_t i = 0; i < kFixedBuffers; ++i) {
+            iovecs[i].iov_base = fixed_buffers.data() + i * kReceiveChunk;
+            iovecs[i].iov_len = kReceiveChunk;
+        }
+        if (uring->registerBuffers(iovecs)) {
+            for (std::size_t i = kFixedBuffers; i > 0; --i) {
+                free_slots.push_back(i - 1);
+            }
+        } else {
+            fixed_buffers = {};
+        }
+        armWake();
+    }
+
+    // 未完了の操作を取り消し、カーネルがバッファを参照しなくなるまで待ってからリングを閉じる。
+    void shutdownUring() {
+        if (!uring) {
+            return;
+        }
+        for (auto& [token, channel] : channels) {
+            cancel(token, channel);
+        }
+        io_uring_sqe& sqe = uring->prepare();
+        sqe.opcode = IORING_OP_ASYNC_CANCEL;
+        sqe.addr = kWakeUserData;
+        sqe.user_data = kOpCancel;
+        const auto give_up = Clock::now() + std::chrono::seconds(1);
+        while ((wake_armed || !closed_channels.empty()) && Clock::now() < give_up) {
+            waitCompletions(std::chrono::milliseconds(100));
+        }
+        uring.reset();
+    }
+
+    void armWake() {
+        io_uring_sqe& sqe = uring->prepare();
+        sqe.opcode = IORING_OP_POLL_ADD;
+        sqe.fd = wake_fd;
+        sqe.poll32_events = POLLIN;
+        sqe.user_data = kWakeUserData;
+        wake_armed = true;
+    }
+
+    void attachChannel(AsyncTcpTransport::Impl* source) {
+        if (!source->connecting) {
+            // O_NONBLOCK のソケットへの読み出しは準備ができていないと EAGAIN で完了するため、
+            // ブロッキングに戻してリング側で準備完了を待たせる（呼び出しスレッドがブロックすることはない）。
+            detail::setNonBlocking(source->socket, false);
+        }
+        const std::uint64_t token = next_channel++;
+        Channel& channel = channels[token];
+        channel.source = source;
+        channel.socket = source->socket;
+        if (!free_slots.empty()) {
+            channel.slot = free_slots.back();
+            free_slots.pop_back();
+        } else {
+            channel.buffer = std::make_unique<std::uint8_t[]>(kReceiveChunk);
+        }
+        source->channel = token;
+        if (source->connecting) {
+            // 接続中のソケットはノンブロッキングのまま、確立（書き込み可能）をリングで待つ
+            armConnect(token, channel);
+        } else {
+            armReceive(token, channel);
+        }
+    }
+
+    // 接続を待っているトランスポートの書き込み可能を再び待つ。
+    void watchConnect(AsyncTcpTransport::Impl* source) {
+        auto it = channels.find(source->channel);
+        if (it != channels.end() && !it->second.polling) {
+            armConnect(it->first, it->second);
+        }
+    }
+
+    // 接続が確立したトランスポートの受信を開始する。
+    void startReceive(AsyncTcpTransport::Impl* source) {
+        auto it = channels.find(source->channel);
+        if (it == channels.end() || it->second.receiving) {
+            return;
+        }
+        detail::setNonBlocking(source->socket, false);
+        armReceive(it->first, it->second);
+    }
+
+    void detachChannel(AsyncTcpTransport::Impl* source) {
+        auto it = channels.find(source->channel);
+        source->channel = 0;
+        if (it == channels.end()) {
+            return;
+        }
+        Channel& channel = it->second;
+        channel.source = nullptr;
+        // 受信待ちを即座に完了させ、リングに積んだままの操作はソケットを閉じる前に提出する
+        // （提出前に閉じると、同じ番号で開かれた別のソケットに対して実行されてしまう）。
+        ::shutdown(channel.socket, SHUT_RDWR);
+        uring->submit();
+        cancel(it->first, channel);
+        closed_channels.push_back(it->first);
+    }
+
+    void cancel(std::uint64_t token, const Channel& channel) {
+        for (const auto op : {kOpConnect, kOpReceive, kOpSend}) {
+            if ((op == kOpConnect && !channel.polling) || (op == kOpReceive && !channel.receiving) ||
+                (op == kOpSend && !channel.send_in_flight)) {
+                continue;
+            }
+            io_uring_sqe& sqe = uring->prepare();
+            sqe.opcode = IORING_OP_ASYNC_CANCEL;
+            sqe.addr = (token << 2) | op;
+            sqe.user_data = (token << 2) | kOpCancel;
+        }
+    }
+
+    std::uint8_t* receiveBuffer(Channel& channel) {
+        return channel.slot < kFixedBuffers ? fixed_buffers.data() + channel.slot * kReceiveChunk
+                                            : channel.buffer.get();
+    }
+
+    void armConnect(std::uint64_t token, Channel& channel) {
+        io_uring_sqe& sqe = uring->prepare();
+        sqe.opcode = IORING_OP_POLL_ADD;
+        sqe.fd = channel.socket;
+        sqe.poll32_events = POLLOUT;
+        sqe.user_data = (token << 2) | kOpConnect;
+        channel.polling = true;
+    }
+
+    void armReceive(std::uint64_t token, Channel& channel) {
+        io_uring_sqe& sqe = uring->prepare();
+        if (channel.slot < kFixedBuffers) {
+            sqe.opcode = IORING_OP_READ_FIXED;
+            sqe.buf_index = static_cast<std::uint16_t>(channel.slot);
+        } else {
+            sqe.opcode = IORING_OP_RECV;
+        }
+        sqe.fd = channel.socket;
+        sqe.addr = reinterpret_cast<std::uint64_t>(receiveBuffer(channel));
+        sqe.len = static_cast<std::uint32_t>(kReceiveChunk);
+        sqe.user_data = (token << 2) | kOpReceive;
+        channel.receiving = true;
+    }
+
+    void armSend(std::uint64_t token, Channel& channel) {
+        io_uring_sqe& sqe = uring->prepare();
+        sqe.opcode = IORING_OP_SEND;
+        sqe.fd = channel.socket;
+        sqe.addr = reinterpret_cast<std::uint64_t>(channel.sending.data() + channel.sent);
+        sqe.len = static_cast<std::uint32_t>(
+            std::min<std::size_t>(channel.sending.size() - channel.sent, std::numeric_limits<std::uint32_t>::max()));
+        sqe.msg_flags = MSG_NOSIGNAL;
+        sqe.user_data = (token << 2) | kOpSend;
+        channel.send_in_flight = true;
+    }
+
+    // トランスポートの送信キューをリングに積む（送信中なら完了後に続きを積む）。
+    void send(AsyncTcpTransport::Impl* source) {
+        auto it = channels.find(source->channel);
+        if (it == channels.end() || it->second.send_in_flight || source->tx_offset >= source->tx.size()) {
+            return;
+        }
+        Channel& channel = it->second;
+        channel.sending = std::move(source->tx);
+        channel.sent = source->tx_offset;
+        source->tx.clear();
+        source->tx_offset = 0;
+        armSend(it->first, channel);
+    }
+
+    // 完了を 1 件処理する。トランスポートに通知した場合 true。
+    bool handleCompletion(const detail::IoUring::Completion& completion) {
+        if (completion.user_data == kWakeUserData) {
+            wake_armed = false;
+            if (completion.result != -ECANCELED) {
+                drainWake();
+                armWake();
+            }
+            return false;
+        }
+        const std::uint64_t op = completion.user_data & 3;
+        auto it = channels.find(completion.user_data >> 2);
+        if (op == kOpCancel || it == channels.end()) {
+            return false;
+        }
+        const std::uint64_t token = it->first;
+        Channel& channel = it->second; // 切断されてもチャネルの破棄は sweepClosed() まで遅らせる
+        if (op == kOpConnect) {
+            channel.polling = false;
+            if (channel.source == nullptr) {
+                return false;
+            }
+            // 接続の結果はソケットから取得する（接続中のままなら再び待つ）
+            channel.source->onWritable();
+            return true;
+        }
+        (op == kOpReceive ? channel.receiving : channel.send_in_flight) = false;
+        AsyncTcpTransport::Impl* source = channel.source;
+        if (source == nullptr) {
+            return false;
+        }
+
+        const int result = completion.result;
+        if (result == -EINTR || result == -EAGAIN) {
+            if (op == kOpReceive) {
+                armReceive(token, channel);
+            } else {
+                armSend(token, channel);
+            }
+        } else if (result < 0) {
+            source->fail(std::make_exception_ptr(TransportError(detail::lastSocketErrorMessage(-result))));
+        } else if (op == kOpReceive) {
+            if (result == 0) {
+                source->fail(std::make_exception_ptr(TransportError("Remote host closed the connection")));
+            } else {
+                source->onReceived(receiveBuffer(channel), static_cast<std::size_t>(result));
+                if (channel.source != nullptr) {
+                    armReceive(token, channel);
+                }
+            }
+        } else {
+            channel.sent += static_cast<std::size_t>(result);
+            if (channel.sent < channel.sending.size()) {
+                armSend(token, channel);
+            } else {
+                channel.sending.clear();
+                channel.sent = 0;
+                send(source);
+            }
+        }
+        return true;
+    }
+
+    // 切断したチャネルのうち、カーネルの処理が残っていないものを破棄する。
+    void sweepClosed() {
+        auto still_open = closed_channels.begin();
+        for (const auto token : closed_channels) {
+            auto it = channels.find(token);
+            if (it == channels.end()) {
+                continue;
+            }
+            if (it->second.polling || it->second.receiving || it->second.send_in_flight) {
+                *still_open++ = token;
+                continue;
+            }
+            if (it->second.slot < kFixedBuffers) {
+                free_slots.push_back(it->second.slot);
+            }
+            channels.erase(it);
+        }
+        closed_channels.erase(still_open, closed_channels.end());
+    }
+
+    std::size_t waitCompletions(std::chrono::milliseconds timeout) {
+        completions.clear();
+        uring->submitAndWait(timeout, completions);
+        std::size_t handled = 0;
+        for (const auto& completion : completions) {
+            if (handleCompletion(completion)) {
+                ++handled;
+            }
+        }
+        sweepClosed();
+        return handled;
+    }
+#endif
+};
+
+EventLoop::EventLoop()
+    : impl_(std::make_unique<Impl>()) {}
+
+EventLoop::~EventLoop() = default;
+
+std::size_t EventLoop::runOnce(std::chrono::milliseconds max_wait) {
+    auto timeout = max_wait;
+    if (impl_->hasTasks()) {
+        timeout = std::chrono::milliseconds(0);
+    } else if (auto deadline = impl_->nextDeadline()) {
+        const auto until = std::chrono::ceil<std::chrono::milliseconds>(*deadline - Clock::now());
+        timeout = std::max(std::chrono::milliseconds(0), std::min(timeout, until));
+    }
+
+    std::size_t handled = 0;
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+    if (impl_->uring) {
+        handled = impl_->waitCompletions(timeout);
+    } else
+#endif
+    {
+        impl_->wait(timeout);
+        handled = impl_->dispatchReady();
+    }
+
+    impl_->processTimeouts(Clock::now());
+    impl_->runTasks();
+    return handled;
+}
+
+void EventLoop::run() {
+    impl_->stop_requested.store(false);
+    while (!impl_->stop_requested.load()) {
+        runOnce(std::chrono::milliseconds(1000));
+    }
+}
+
+void EventLoop::stop() {
+    impl_->stop_requested.store(true);
+    impl_->wake();
+}
+
+void EventLoop::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(impl_->task_mutex);
+        impl_->tasks.push_back(std::move(task));
+    }
+    impl_->wake();
+}
+
+std::size_t EventLoop::size() const noexcept {
+    return impl_->sources.size();
+}
+
+EventLoopBackend EventLoop::backend() const noexcept {
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+    if (impl_->uring) {
+        return EventLoopBackend::IoUring;
+    }
+#endif
+#ifdef __linux__
+    return EventLoopBackend::Epoll;
+#else
+    return EventLoopBackend::Poll;
+#endif
+}
+
+// ========================================
+// AsyncTcpTransport
+// ========================================
+
+void AsyncTcpTransport::Impl::setWantWrite(bool enabled) {
+    if (want_write == enabled) {
+        return;
+    }
+    want_write = enabled;
+    if (socket != kInvalidSocket && loop != nullptr) {
+        loop->impl_->modify(this);
+    }
+}
+
+void AsyncTcpTransport::Impl::flush() {
+    if (connecting) {
+        return; // 接続の確立後に送信する
+    }
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+    if (channel != 0) {
+        loop->impl_->send(this);
+        return;
+    }
+#endif
+    while (tx_offset < tx.size()) {
+        const std::size_t remaining = tx.size() - tx_offset;
+        const int chunk = static_cast<int>(std::min<std::size_t>(remaining, std::numeric_limits<int>::max()));
+#ifdef _WIN32
+        const int sent = ::send(socket, reinterpret_cast<const char*>(tx.data() + tx_offset), chunk, 0);
+#elif defined(MSG_NOSIGNAL)
+        const auto sent = ::send(socket, tx.data() + tx_offset, static_cast<std::size_t>(chunk), MSG_NOSIGNAL);
+#else
+        const auto sent = ::send(socket, tx.data() + tx_offset, static_cast<std::size_t>(chunk), 0);
+#endif
+        if (sent < 0) {
+            const int code = detail::lastSocketError();
+            if (detail::isInterrupted(code)) {
+                continue;
+            }
+            if (detail::isWouldBlock(code)) {
+                setWantWrite(true);
+                return;
+            }
+            fail(std::make_exception_ptr(TransportError(detail::lastSocketErrorMessage(code))));
+            return;
+        }
+        tx_offset += static_cast<std::size_t>(sent);
+    }
+    tx.clear();
+    tx_offset = 0;
+    setWantWrite(false);
+}
+
+void AsyncTcpTransport::Impl::onWritable() {
+    if (connecting) {
+        checkConnect(); // 確立した場合は送信キューも吐き出す
+        return;
+    }
+    flush();
+}
+
+// 残りのアドレスへ順に接続を開始する。開始できたアドレスがなければ false。
+bool AsyncTcpTransport::Impl::connectNext() {
+    while (next_address < addresses.size()) {
+        const detail::ConnectAttempt attempt = detail::startConnect(addresses[next_address++]);
+        if (attempt.socket == kInvalidSocket) {
+            connect_error = attempt.error;
+            continue;
+        }
+        detail::applyLatencyOptions(attempt.socket);
+        socket = attempt.socket;
+        want_write = true; // 確立は書き込み可能で通知される
+        if (loop != nullptr) {
+            loop->impl_->add(this);
+        }
+        if (attempt.connected) {
+            finishConnect();
+        }
+        return true;
+    }
+    return false;
+}
+
+// 接続中のソケットに通知があったときに、接続の結果を確認する。
+// 失敗した場合は次のアドレスを試し、残っていなければ応答待ちの要求を失敗させる。
+void AsyncTcpTransport::Impl::checkConnect() {
+    const int error = detail::connectError(socket);
+    if (detail::isConnectInProgress(error)) {
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+        if (channel != 0) {
+            loop->impl_->watchConnect(this);
+        }
+#endif
+        return;
+    }
+    try {
+        if (error == 0) {
+            finishConnect();
+            return;
+        }
+        connect_error = error;
+        releaseSocket();
+        if (connectNext()) {
+            return;
+        }
+        fail(std::make_exception_ptr(TransportError(connectFailure())));
+    } catch (...) {
+        fail(std::current_exception());
+    }
+}
+
+void AsyncTcpTransport::Impl::finishConnect() {
+    connecting = false;
+    addresses.clear();
+    updateDeadline();
+    setWantWrite(false);
+#ifdef CPMCPROTOCOL_HAVE_IO_URING
+    if (channel != 0) {
+        loop->impl_->startReceive(this);
+    }
+#endif
+    if (corked == 0) {
+        flush();
+    }
+}
+
+std::string AsyncTcpTransport::Impl::connectFailure() const {
+    std::string message = "Failed to connect to " + endpoint;
+    if (connect_error != 0) {
+        message += ": " + detail::lastSocketErrorMessage(connect_error);
+    }
+    return message;
+}
+
+void AsyncTcpTransport::Impl::reserveReceive(std::size_t size) {
+    if (rx.size() - rx_end < size) {
+        // 未処理データを先頭に詰めてから必要なら拡張する。
+        if (rx_begin > 0) {
+            std::copy(rx.begin() + static_cast<std::ptrdiff_t>(rx_begin),
+                      rx.begin() + static_cast<std::ptrdiff_t>(rx_end), rx.begin());
+            rx_end -= rx_begin;
+            rx_begin = 0;
+        }
+        if (rx.size() - rx_end < size) {
+            rx.resize(rx_end + size);
+        }
+    }
+}
+
+void AsyncTcpTransport::Impl::onReceived(const std::uint8_t* data, std::size_t size) {
+    reserveReceive(size);
+    std::copy(data, data + size, rx.begin() + static_cast<std::ptrdiff_t>(rx_end));
+    rx_end += size;
+    extractFrames();
+}
+
+void AsyncTcpTransport::Impl::onReadable() {
+    if (connecting) {
+        // 接続の失敗はエラー（読み取り可能）として通知されることがある
+        checkConnect();
+        if (connecting) {
+            return;
+        }
+    }
+    while (socket != kInvalidSocket) {
+        reserveReceive(kReceiveChunk);
+
+        const std::size_t capacity = rx.size() - rx_end;
+#ifdef _WIN32
+        const int received = ::recv(socket, reinterpret_cast<char*>(rx.data() + rx_end), static_cast<int>(capacity), 0);
+#else
+        const auto received = ::recv(socket, rx.data() + rx_end, capacity, 0);
+#endif
+        if (received == 0) {
+            fail(std::make_exception_ptr(TransportError("Remote host closed the connection")));
+            return;
+        }
+        if (received < 0) {
+            const int code = detail::lastSocketError();
+            if (detail::isInterrupted(code)) {
+                continue;
+            }
+            if (detail::isWouldBlock(code)) {
+                return;
+            }
+            fail(std::make_exception_ptr(TransportError(detail::lastSocketErrorMessage(code))));
+            return;
+        }
+        rx_end += static_cast<std::size_t>(received);
+        extractFrames();
+
+        if (static_cast<std::size_t>(received) < capacity) {
+            // カーネルバッファを読み切ったので、次の通知まで待つ。
+            return;
+        }
+    }
+}
+
+void AsyncTcpTransport::Impl::extractFrames() {
+    while (socket != kInvalidSocket && rx_end - rx_begin >= format.header_size) {
+        const std::uint8_t* header = rx.data() + rx_begin;
+        std::size_t body_size = 0;
+        try {
+            body_size = format.length_extractor(header, format.header_size);
+        } catch (const std::exception& ex) {
+            fail(std::make_exception_ptr(TransportError(std::string("Invalid frame header: ") + ex.what())));
+            return;
+        }
+        if (body_size == 0) {
+            fail(std::make_exception_ptr(TransportError("Frame body length reported as zero")));
+            return;
+        }
+        const std::size_t total = format.header_size + body_size;
+        if (rx_end - rx_begin < total) {
+            return;
+        }
+        std::vector<std::uint8_t> frame(header, header + total);
+        rx_begin += total;
+        if (rx_begin == rx_end) {
+            rx_begin = 0;
+            rx_end = 0;
+        }
+        dispatch(std::move(frame));
+    }
+}
+
+void AsyncTcpTransport::Impl::dispatch(std::vector<std::uint8_t> frame) {
+    auto it = pending.end();
+    if (format.key_extractor) {
+        std::optional<std::uint16_t> key;
+        try {
+            key = format.key_extractor(frame.data(), frame.size());
+        } catch (const std::exception& ex) {
+            fail(std::make_exception_ptr(TransportError(std::string("Invalid response frame: ") + ex.what())));
+            return;
+        }
+        it = std::find_if(pending.begin(), pending.end(),
+                          [&](const PendingRequest& request) { return request.key == key; });
+        if (it == pending.end()) {
+            return; // タイムアウト済み要求への遅延応答は読み捨てる
+        }
+    } else {
+        if (pending.empty()) {
+            fail(std::make_exception_ptr(TransportError("Received response without pending request")));
+            return;
+        }
+        it = pending.begin();
+    }
+
+    auto completion = std::move(it->completion);
+    deadlines.erase(deadlines.find(it->deadline));
+    pending.erase(it);
+    updateDeadline();
+    completion(nullptr, std::move(frame));
+}
+
+std::optional<Clock::time_point> AsyncTcpTransport::Impl::nextDeadline() const {
+    std::optional<Clock::time_point> earliest;
+    if (connecting) {
+        earliest = connect_deadline;
+    }
+    if (!deadlines.empty() && (!earliest || *deadlines.begin() < *earliest)) {
+        earliest = *deadlines.begin();
+    }
+    return earliest;
+}
+
+// ループのデッドライン表に、この接続の直近のデッドラインを反映する（EventLoop に登録した場合のみ）。
+void AsyncTcpTransport::Impl::updateDeadline() {
+    if (loop == nullptr) {
+        return;
+    }
+    const auto next = nextDeadline();
+    if (next == scheduled) {
+        return;
+    }
+    auto& table = loop->impl_->deadlines;
+    if (scheduled) {
+        table.erase({*scheduled, this});
+        scheduled.reset();
+    }
+    if (next) {
+        table.emplace(*next, this);
+        scheduled = next;
+    }
+}
+
+void AsyncTcpTransport::Impl::processTimeouts(Clock::time_point now) {
+    if (connecting && connect_deadline <= now) {
+        fail(std::make_exception_ptr(TransportTimeoutError("Connection to " + endpoint + " timed out after " +
+                                                           std::to_string(connect_timeout.count()) + " ms")));
+        return;
+    }
+    if (deadlines.empty() || *deadlines.begin() > now) {
+        return;
+    }
+    if (!format.key_extractor) {
+        // FIFO 照合では以降の応答との対応が崩れるため、接続ごと破棄する。
+        fail(std::make_exception_ptr(TransportTimeoutError("Timed out while waiting for response")));
+        return;
+    }
+
+    std::vector<Completion> expired;
+    for (auto it = pending.begin(); it != pending.end();) {
+        if (it->deadline <= now) {
+            expired.push_back(std::move(it->completion));
+            it = pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    deadlines.erase(deadlines.begin(), deadlines.upper_bound(now));
+    updateDeadline();
+    notifyAll(expired, std::make_exception_ptr(TransportTimeoutError("Timed out while waiting for response")));
+}
+
+// 要求をまとめて失敗させる。途中の完了コールバックが例外を送出しても残りのコールバックを呼び、
+// 最初の例外をすべて呼んだ後に送出する（呼ばれないコールバックの呼び出し元が待ち続けないように）。
+void AsyncTcpTransport::Impl::notifyAll(std::vector<Completion>& completions, const std::exception_ptr& error) {
+    std::exception_ptr first;
+    for (auto& completion : completions) {
+        try {
+            completion(error, {});
+        } catch (...) {
+            if (!first) {
+                first = std::current_exception();
+            }
+        }
+    }
+    if (first) {
+        std::rethrow_exception(first);
+    }
+}
+
+// ソケットをループから外して閉じる（送信キューと応答待ちの要求は残す）。
+void AsyncTcpTransport::Impl::releaseSocket() {
+    if (loop != nullptr) {
+        loop->impl_->remove(socket);
+    }
+    detail::closeSocket(socket);
+    socket = kInvalidSocket;
+}
+
+void AsyncTcpTransport::Impl::close() {
+    connecting = false;
+    addresses.clear();
+    if (socket == kInvalidSocket) {
+        return;
+    }
+    releaseSocket();
+    tx.clear();
+    tx_offset = 0;
+    rx_begin = 0;
+    rx_end = 0;
+    want_write = false;
+}
+
+void AsyncTcpTransport::Impl::fail(std::exception_ptr error) {
+    close();
+    std::vector<Completion> failed;
+    failed.reserve(pending.size());
+    for (auto& request : pending) {
+        failed.push_back(std::move(request.completion));
+    }
+    pending.clear();
+    deadlines.clear();
+    updateDeadline();
+    notifyAll(failed, error);
+}
+
+AsyncTcpTransport::AsyncTcpTransport(EventLoop& loop)
+    : impl_(std::make_unique<Impl>()) {
+    impl_->loop = &loop;
+}
+
+AsyncTcpTransport::AsyncTcpTransport()
+    : impl_(std::make_unique<Impl>()) {}
+
+AsyncTcpTransport::~AsyncTcpTransport() {
+    disconnect();
+}
+
+void AsyncTcpTransport::connect(const SessionConfig& config) {
+    disconnect();
+
+    Impl& impl = *impl_;
+    impl.addresses = detail::resolveEndpoint(config);
+    impl.next_address = 0;
+    impl.connect_error = 0;
+    impl.endpoint = detail::endpointName(config);
+    impl.connect_timeout = detail::deriveTimeout(config);
+    impl.connect_deadline = Clock::now() + impl.connect_timeout;
+    impl.format = makeResponseFrameFormat(config);
+    impl.connecting = true;
+    try {
+        if (impl.connectNext()) {
+            impl.updateDeadline();
+            return;
+        }
+    } catch (...) {
+        impl.close();
+        impl.updateDeadline();
+        throw;
+    }
+    impl.close();
+    impl.updateDeadline();
+    throw TransportError(impl.connectFailure());
+}
+
+void AsyncTcpTransport::disconnect() noexcept {
+    if (!impl_) {
+        return;
+    }
+    try {
+        impl_->fail(std::make_exception_ptr(TransportError("Transport disconnected")));
+    } catch (...) {
+        // 完了コールバックの例外は呼び出し元へ返せない（すべての要求は完了済み）
+    }
+}
+
+bool AsyncTcpTransport::isConnected() const noexcept {
+    return impl_ && impl_->socket != kInvalidSocket;
+}
+
+bool AsyncTcpTransport::isConnecting() const noexcept {
+    return impl_ && impl_->connecting;
+}
+
+void AsyncTcpTransport::setFrameFormat(FrameFormat format) {
+    impl_->format = std::move(format);
+}
+
+void AsyncTcpTransport::submit(std::vector<std::uint8_t> request,
+                               std::optional<std::uint16_t> key,
+                               std::chrono::steady_clock::time_point deadline,
+                               Completion completion) {
+    if (!isConnected()) {
+        throw TransportError("Transport is not connected");
+    }
+    if (impl_->tx.empty()) {
+        impl_->tx = std::move(request);
+        impl_->tx_offset = 0;
+    } else {
+        impl_->tx.insert(impl_->tx.end(), request.begin(), request.end());
+    }
+    const auto position = impl_->deadlines.insert(deadline);
+    try {
+        impl_->pending.push_back(PendingRequest{key, deadline, std::move(completion)});
+    } catch (...) {
+        impl_->deadlines.erase(position);
+        throw;
+    }
+    impl_->updateDeadline();
+    if (impl_->corked == 0) {
+        impl_->flush();
+    }
+}
+
+void AsyncTcpTransport::cork() noexcept {
+    ++impl_->corked;
+}
+
+void AsyncTcpTransport::uncork() {
+    if (impl_->corked == 0 || --impl_->corked > 0) {
+        return;
+    }
+    if (impl_->socket != kInvalidSocket) {
+        impl_->flush();
+    }
+}
+
+std::size_t AsyncTcpTransport::pendingCount() const noexcept {
+    return impl_ ? impl_->pending.size() : 0;
+}
+
+NativeSocket AsyncTcpTransport::nativeHandle() const noexcept {
+    return static_cast<NativeSocket>(impl_->socket);
+}
+
+bool AsyncTcpTransport::wantsWrite() const noexcept {
+    return impl_->want_write;
+}
+
+void AsyncTcpTransport::processReadable() {
+    if (impl_->socket != kInvalidSocket) {
+        impl_->onReadable();
+    }
+}
+
+void AsyncTcpTransport::processWritable() {
+    if (impl_->socket != kInvalidSocket) {
+        impl_->onWritable();
+    }
+}
+
+void AsyncTcpTransport::processTimeouts() {
+    impl_->processTimeouts(Clock::now());
+}
+
+std::optional<std::chrono::steady_clock::time_point> AsyncTcpTransport::nextDeadline() const {
+    return impl_->nextDeadline();
+}
+
+} // namespace cpmcprotocol
@@ -0,0 +1,176 @@
+#include "io_uring.hpp"
+
+#include "cpmcprotocol/transport.hpp"
+#include "socket_ops.hpp"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+namespace cpmcprotocol::detail {
+
+namespace {
+
+unsigned loadAcquire(const unsigned* value) {
+    return std::atomic_ref<unsigned>(*const_cast<unsigned*>(value)).load(std::memory_order_acquire);
+}
+
+void storeRelease(unsigned* value, unsigned desired) {
+    std::atomic_ref<unsigned>(*value).store(desired, std::memory_order_release);
+}
+
+} // namespace
+
+std::unique_ptr<IoUring> IoUring::create(unsigned entries) {
+    io_uring_params params{};
+    const int fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+        return nullptr; // ENOSYS（未対応のカーネル）や EPERM（seccomp 等で禁止）
+    }
+    // 1 回の mmap で両方のリングを扱い、タイムアウト付きの待機を 1 回のシステムコールで行う（5.11 以降）
+    constexpr unsigned kRequired = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & kRequired) != kRequired) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    std::unique_ptr<IoUring> ring(new IoUring());
+    ring->fd_ = fd;
+    ring->ring_size_ = std::max<std::size_t>(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                                             params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    ring->ring_ = ::mmap(nullptr, ring->ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                         IORING_OFF_SQ_RING);
+    if (ring->ring_ == MAP_FAILED) {
+        ring->ring_ = nullptr;
+        return nullptr;
+    }
+    ring->sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, ring->sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                        IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return nullptr;
+    }
+    ring->sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    auto* base = static_cast<std::uint8_t*>(ring->ring_);
+    ring->sq_head_ = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    ring->sq_tail_ = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    ring->sq_array_ = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    ring->sq_mask_ = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    ring->sq_entries_ = params.sq_entries;
+    ring->sq_local_tail_ = *ring->sq_tail_;
+    ring->cq_head_ = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    ring->cq_tail_ = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    ring->cqes_ = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+    ring->cq_mask_ = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    return ring;
+}
+
+IoUring::~IoUring() {
+    if (sqes_ != nullptr) {
+        ::munmap(sqes_, sqes_size_);
+    }
+    if (ring_ != nullptr) {
+        ::munmap(ring_, ring_size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool IoUring::registerBuffers(const std::vector<iovec>& buffers) {
+    return ::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, buffers.data(),
+                     static_cast<unsigned>(buffers.size())) == 0;
+}
+
+io_uring_sqe& IoUring::prepare() {
+    // 満杯のまま書き込むとカーネルが未取得のエントリを上書きするため、空きができるまで提出を繰り返す。
+    // 完了キューが溢れていると提出が EBUSY/EAGAIN で進まないので、完了を刈り取って backlog_ に退避し、
+    // 次の submitAndWait() で返す。
+    for (int attempt = 0; sq_local_tail_ - loadAcquire(sq_head_) >= sq_entries_; ++attempt) {
+        if (attempt == kFullRetries) {
+            throw TransportError("io_uring submission queue is full");
+        }
+        reap(backlog_);
+        if (attempt == 0) {
+            submit();
+            continue;
+        }
+        __kernel_timespec ts{};
+        ts.tv_nsec = static_cast<long long>(kFullWait.count()) * 1000000;
+        io_uring_getevents_arg arg{};
+        arg.sigmask_sz = _NSIG / 8;
+        arg.ts = reinterpret_cast<std::uint64_t>(&ts);
+        enter(to_submit_, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    }
+    const unsigned index = sq_local_tail_ & sq_mask_;
+    io_uring_sqe& sqe = sqes_[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sq_array_[index] = index;
+    ++sq_local_tail_;
+    ++to_submit_;
+    storeRelease(sq_tail_, sq_local_tail_);
+    return sqe;
+}
+
+int IoUring::enter(unsigned to_submit, unsigned min_complete, unsigned flags, const void* arg, std::size_t arg_size) {
+    for (;;) {
+        const int result =
+            static_cast<int>(::syscall(__NR_io_uring_enter, fd_, to_submit, min_complete, flags, arg, arg_size));
+        if (result >= 0) {
+            to_submit_ -= std::min(to_submit_, static_cast<unsigned>(result));
+            return result;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == ETIME || errno == EBUSY || errno == EAGAIN) {
+            // ETIME: 待機のタイムアウト、EBUSY/EAGAIN: 完了キューが溢れている（刈り取れば解消する）
+            return 0;
+        }
+        throw TransportError("io_uring_enter failed: " + lastSocketErrorMessage(errno));
+    }
+}
+
+void IoUring::submit() {
+    if (to_submit_ > 0) {
+        enter(to_submit_, 0, 0, nullptr, 0);
+    }
+}
+
+void IoUring::submitAndWait(std::chrono::milliseconds timeout, std::vector<Completion>& out) {
+    out.insert(out.end(), backlog_.begin(), backlog_.end());
+    backlog_.clear();
+    reap(out);
+    if (!out.empty()) {
+        // 既に完了がある場合は待たずに提出だけ行う
+        submit();
+        return;
+    }
+    __kernel_timespec ts{};
+    ts.tv_sec = static_cast<std::int64_t>(timeout.count() / 1000);
+    ts.tv_nsec = static_cast<long long>(timeout.count() % 1000) * 1000000;
+    io_uring_getevents_arg arg{};
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<std::uint64_t>(&ts);
+    enter(to_submit_, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    reap(out);
+}
+
+void IoUring::reap(std::vector<Completion>& out) {
+    unsigned head = *cq_head_;
+    const unsigned tail = loadAcquire(cq_tail_);
+    for (; head != tail; ++head) {
+        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        out.push_back(Completion{cqe.user_data, cqe.res});
+    }
+    storeRelease(cq_head_, head);
+}
+
+} // namespace cpmcprotocol::detail
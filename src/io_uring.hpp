@@ -0,0 +1,80 @@
+#pragma once
+
+// io_uring の送信キュー／完了キューの最小限のラッパー（liburing を使わずシステムコールを直接呼ぶ）。
+// EventLoop の io_uring バックエンドでのみ使用し、公開ヘッダーからは参照しない。
+// CPMCPROTOCOL_ENABLE_IO_URING でビルドした場合のみコンパイルされる。
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace cpmcprotocol::detail {
+
+class IoUring {
+public:
+    struct Completion {
+        std::uint64_t user_data = 0;
+        std::int32_t result = 0;
+    };
+
+    /// リングを作成する。カーネルが io_uring（または待機のタイムアウト指定）に対応していない場合は nullptr
+    static std::unique_ptr<IoUring> create(unsigned entries);
+
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    /// 固定バッファを登録する（READ_FIXED で使用する。ロック可能なメモリが足りない場合は false）
+    bool registerBuffers(const std::vector<iovec>& buffers);
+
+    /// 送信キューのエントリを確保してゼロで初期化する（満杯なら空きができるまで提出する）
+    /// 空きができない場合は TransportError
+    io_uring_sqe& prepare();
+
+    /// 溜めたエントリを提出し、完了を最大 timeout 待って out の末尾に追加する
+    /// 提出と待機は 1 回のシステムコールで行う
+    void submitAndWait(std::chrono::milliseconds timeout, std::vector<Completion>& out);
+
+    /// 溜めたエントリを提出する（待機しない）
+    void submit();
+
+private:
+    // 送信キューが満杯のときに空きを待つ回数と 1 回の待機時間
+    static constexpr int kFullRetries = 100;
+    static constexpr std::chrono::milliseconds kFullWait{10};
+
+    IoUring() = default;
+
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags, const void* arg, std::size_t arg_size);
+    void reap(std::vector<Completion>& out);
+
+    int fd_ = -1;
+    void* ring_ = nullptr;
+    std::size_t ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    std::size_t sqes_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned sq_local_tail_ = 0;
+    unsigned to_submit_ = 0;
+
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned cq_mask_ = 0;
+
+    // prepare() で空きを作るために刈り取った完了（次の submitAndWait() で返す）
+    std::vector<Completion> backlog_;
+};
+
+} // namespace cpmcprotocol::detail
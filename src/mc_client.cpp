@@ -2,22 +2,46 @@
 
 #include "cpmcprotocol/access_option.hpp"
 #include "cpmcprotocol/device.hpp"
+#include "cpmcprotocol/read_optimizer.hpp"
+#include "cpmcprotocol/reconnect_policy.hpp"
 #include "cpmcprotocol/runtime_control.hpp"
 #include "cpmcprotocol/session_config.hpp"
 #include "cpmcprotocol/transport.hpp"
 #include "cpmcprotocol/codec/frame_decoder.hpp"
 #include "cpmcprotocol/codec/frame_encoder.hpp"
 #include "cpmcprotocol/value_codec.hpp"
+#include "client_codec.hpp"
+#include "request_dispatcher.hpp"
+#include "shadow_cache.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <iomanip>
+#include <limits>
+#include <mutex>
 #include <optional>
+#include <random>
+#include <shared_mutex>
+#include <span>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
 
 namespace cpmcprotocol {
 
+using detail::isBitFormat;
+using detail::isDwordFormat;
+using detail::isLwordFormat;
+using detail::isWordFormat;
+using detail::RandomReadChunk;
+using detail::splitRandomRead;
+
 namespace {
 
 std::uint16_t secondsToTicks(std::uint16_t seconds) {
@@ -30,41 +54,105 @@ std::chrono::milliseconds toMilliseconds(std::uint16_t seconds) {
     return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::seconds(seconds));
 }
 
-bool isWordFormat(ValueType type) {
-    switch (type) {
-        case ValueType::Int16:
-        case ValueType::UInt16:
-        case ValueType::RawWords:
-            return true;
-        default:
-            return false;
-    }
-}
+// 複数ブロック要求 1 フレーム分。blocks[k] は request 内 k 番目のブロック片が
+// 元の要求の何番目のブロック（ワードブロック→ビットブロックの通し番号）の、どのオフセットからかを示す。
+struct MultiBlockChunk {
+    struct Segment {
+        std::size_t block = 0;
+        std::size_t offset = 0;
+    };
 
-bool isDwordFormat(ValueType type) {
-    switch (type) {
-        case ValueType::Int32:
-        case ValueType::UInt32:
-        case ValueType::Float32:
-            return true;
-        default:
-            return false;
-    }
-}
+    ResolvedMultiBlockRequest request;
+    std::vector<Segment> segments;
+    std::vector<std::uint16_t> lengths;
+};
 
-bool isLwordFormat(ValueType type) {
-    switch (type) {
-        case ValueType::Int64:
-        case ValueType::UInt64:
-        case ValueType::Float64:
-            return true;
-        default:
-            return false;
+// ブロック数と点数の上限に収まるようにブロックを詰め、収まらないブロックは途中で分割する。
+// block_cost は 1 ブロックあたりに加算される点数（書き込みでは 4）。
+std::vector<MultiBlockChunk> splitMultiBlock(const ResolvedMultiBlockRequest& request, std::size_t block_cost) {
+    constexpr std::size_t kMaxBlocks = codec::FrameEncoder::kMaxMultiBlocks;
+    constexpr std::size_t kMaxPoints = codec::FrameEncoder::kMaxMultiBlockPoints;
+
+    std::vector<MultiBlockChunk> chunks(1);
+    std::size_t used = 0;
+    for (const bool bit : {false, true}) {
+        const auto& blocks = bit ? request.bit_blocks : request.word_blocks;
+        const std::size_t first_index = bit ? request.word_blocks.size() : 0;
+        // ビットブロックの 1 点（1 ワード）はデバイス番号 16 個分
+        const std::uint32_t stride = bit ? 16 : 1;
+        for (std::size_t b = 0; b < blocks.size(); ++b) {
+            if (blocks[b].length == 0) {
+                throw std::invalid_argument("Multi-block length must be greater than zero");
+            }
+            std::size_t offset = 0;
+            while (offset < blocks[b].length) {
+                if (chunks.back().segments.size() == kMaxBlocks || used + block_cost >= kMaxPoints) {
+                    chunks.emplace_back();
+                    used = 0;
+                }
+                auto& chunk = chunks.back();
+                const std::size_t take = std::min<std::size_t>(blocks[b].length - offset, kMaxPoints - used - block_cost);
+                ResolvedRange segment{blocks[b].head, static_cast<std::uint16_t>(take)};
+                segment.head.number += static_cast<std::uint32_t>(offset) * stride;
+                (bit ? chunk.request.bit_blocks : chunk.request.word_blocks).push_back(segment);
+                chunk.segments.push_back({first_index + b, offset});
+                chunk.lengths.push_back(static_cast<std::uint16_t>(take));
+                used += block_cost + take;
+                offset += take;
+            }
+        }
     }
+    return chunks;
 }
 
-bool isBitFormat(ValueType type) {
-    return type == ValueType::BitArray;
+// ランダム書き込み 1 フレーム分の要求と書き込み値。Request は RandomDeviceRequest / ResolvedRandomRequest。
+template <typename Request>
+struct RandomWriteChunk {
+    Request request;
+    std::vector<std::uint16_t> word_data;
+    std::vector<std::uint32_t> dword_data;
+    std::vector<std::uint64_t> lword_data;
+    std::vector<bool> bit_data;
+};
+
+// 1 要求あたりの上限（ワード/ダブルワードの重み付き点数、ビット点数）ごとに分割する
+template <typename Request>
+std::vector<RandomWriteChunk<Request>> splitRandomWrite(RandomWriteChunk<Request>& all,
+                                                        const codec::FrameEncoder::RandomAccessLimits& limits) {
+    std::vector<RandomWriteChunk<Request>> chunks(1);
+    std::size_t cost = 0;
+    auto reserve = [&](std::size_t point_cost) {
+        if (cost + point_cost > limits.write_cost) {
+            chunks.emplace_back();
+            cost = 0;
+        }
+        cost += point_cost;
+        return &chunks.back();
+    };
+    for (std::size_t i = 0; i < all.word_data.size(); ++i) {
+        auto* chunk = reserve(codec::FrameEncoder::kRandomWordWriteCost);
+        chunk->request.word_devices.push_back(std::move(all.request.word_devices[i]));
+        chunk->word_data.push_back(all.word_data[i]);
+    }
+    for (std::size_t i = 0; i < all.dword_data.size(); ++i) {
+        auto* chunk = reserve(codec::FrameEncoder::kRandomDwordWriteCost);
+        chunk->request.dword_devices.push_back(std::move(all.request.dword_devices[i]));
+        chunk->dword_data.push_back(all.dword_data[i]);
+    }
+    for (std::size_t i = 0; i < all.lword_data.size(); ++i) {
+        auto* chunk = reserve(codec::FrameEncoder::kRandomLwordWriteCost);
+        chunk->request.lword_devices.push_back(std::move(all.request.lword_devices[i]));
+        chunk->lword_data.push_back(all.lword_data[i]);
+    }
+    for (std::size_t i = 0; i < all.bit_data.size(); ++i) {
+        if (chunks.back().bit_data.size() >= limits.write_bits) {
+            chunks.emplace_back();
+            cost = 0;
+        }
+        chunks.back().request.bit_devices.push_back(std::move(all.request.bit_devices[i]));
+        chunks.back().bit_data.push_back(all.bit_data[i]);
+    }
+    return chunks;
 }
 
 std::string hexUpper(std::uint32_t value, std::size_t width) {
@@ -96,6 +184,17 @@ void appendByte(std::vector<std::uint8_t>& binary,
     }
 }
 
+// 単発要求の送信フレームと応答フレームのコピー先。スレッドごとに容量を使い回し、定常状態ではヒープ確保を行わない。
+std::vector<std::uint8_t>& requestBuffer() {
+    thread_local std::vector<std::uint8_t> buffer;
+    return buffer;
+}
+
+std::vector<std::uint8_t>& responseBuffer() {
+    thread_local std::vector<std::uint8_t> buffer;
+    return buffer;
+}
+
 std::string rtrimSpaces(const std::string& text) {
     std::string result = text;
     while (!result.empty() && result.back() == ' ') {
@@ -113,9 +212,65 @@ struct McClient::Impl {
     codec::FrameEncoder frame_encoder;
     codec::FrameDecoder frame_decoder;
     ValueCodec value_codec;
-    bool connected = false;
+    // 複数スレッドからの要求を 1 本の接続に多重化する（送受信はすべてこれを経由する）。
+    detail::RequestDispatcher dispatcher{transport, frame_decoder};
+
+    // 接続状態と設定（connected の変更・effective_config・layout_generation など）を保護する。
+    // 要求の間は共有ロックを保持し、connect()/disconnect()/setAccessOption() は排他ロックで要求の完了を待つ。
+    mutable std::shared_mutex state_mutex;
+
+    // connect()/setAccessOption() 時にのみ再計算する実効設定（要求ごとのコピーを避ける）。
+    SessionConfig effective_config{};
+    // フレームの配置（通信モード・経路・フレーム種別）が変わるたびに進める世代番号。
+    // PreparedRequest はこれが一致する間、監視タイマーとシリアル番号の書き換えだけで再利用できる。
+    std::uint64_t layout_generation = 0;
+    // PLC に登録中のモニタセット（0 は未登録）。モニタ登録は接続ごとに 1 つで、再接続や経路変更で無効になる。
+    // 登録と読み取りの間に別のセットが登録されないよう、monitor_mutex を保持して行う。
+    std::mutex monitor_mutex;
+    std::uint64_t registered_monitor = 0;
+    std::uint64_t next_monitor_id = 0;
+    // ワードデバイスのシャドウキャッシュ（setCacheEnabled(true) の間だけ使用する）。
+    // 接続先や経路が変わると別の PLC の値になるため、connect() と配置の変更で破棄する。
+    // cache_epoch は破棄・書き込みのたびに進め、読み取り中に変わった場合は読み取った値を格納しない。
+    std::mutex cache_mutex;
+    detail::ShadowCache cache;
+    std::uint64_t cache_epoch = 0;
+    std::atomic<bool> cache_enabled{false};
+    // connect()/disconnect() のたびに進める番号。ロックの外で接続している間（再接続・connectAll()）に
+    // 接続し直された、または切断された場合は、確立した接続を捨てる。
+    std::uint64_t connection_generation = 0;
+
+    // 接続状態の通知と自動再接続（監視スレッドが状態の通知と再接続の試行を行う）。
+    // supervisor_mutex は state_mutex を保持したまま取ってよいが、supervisor_mutex を保持したまま state_mutex は取らない。
+    std::mutex supervisor_mutex;
+    std::condition_variable supervisor_cv;
+    std::atomic<ConnectionState> state{ConnectionState::Disconnected};
+    // 変更は state_mutex の排他ロックの中で行い、isConnected() はロックを取らずに読む。
+    std::atomic<bool> connected{false};
+    // 再接続に成功するたびに進める（読み取りの再試行で、失敗した後に再接続されたかを判定する）。
+    std::atomic<std::uint64_t> reconnect_count{0};
+    ReconnectPolicy reconnect_policy;
+    ConnectionStateHandler state_handler;
+    std::deque<std::pair<ConnectionState, std::exception_ptr>> state_events;
+    std::size_t reconnect_attempts = 0;
+    std::chrono::steady_clock::time_point next_reconnect;
+    // クライアントごとに異なる系列にし、同時に切断されたクライアントの再接続の時刻をずらす
+    std::mt19937 jitter_rng{std::random_device{}()};
+    std::thread supervisor;
+    bool stopping = false;
 
-    SessionConfig makeEffectiveConfig() const {
+    ~Impl() {
+        {
+            std::lock_guard<std::mutex> lock(supervisor_mutex);
+            stopping = true;
+        }
+        supervisor_cv.notify_all();
+        if (supervisor.joinable()) {
+            supervisor.join();
+        }
+    }
+
+    void refreshEffectiveConfig() {
         SessionConfig cfg = base_config;
         cfg.mode = access.mode;
         cfg.network = access.network;
@@ -123,49 +278,636 @@ struct McClient::Impl {
         cfg.module_io = access.module_io;
         cfg.module_station = access.module_station;
         cfg.timeout_250ms = secondsToTicks(access.timeout_seconds);
-        return cfg;
+
+        const auto& old = effective_config;
+        if (layout_generation == 0 || cfg.mode != old.mode || cfg.frame_type != old.frame_type ||
+            cfg.series != old.series || cfg.network != old.network || cfg.pc != old.pc ||
+            cfg.module_io != old.module_io || cfg.module_station != old.module_station) {
+            ++layout_generation;
+            registered_monitor = 0;
+            resetCache();
+        }
+        effective_config = std::move(cfg);
+    }
+
+    // connect() の前半（排他ロック中に呼ぶ）。接続先が変わるため、設定を更新してモニタ登録とキャッシュを破棄する。
+    void beginConnect(const SessionConfig& config) {
+        connected = false;
+        ++connection_generation;
+        base_config = config;
+        access.mode = config.mode;
+        access.network = config.network;
+        access.pc = config.pc;
+        access.module_io = config.module_io;
+        access.module_station = config.module_station;
+        access.timeout_seconds = std::max<std::uint16_t>(1, config.timeout_250ms / 4);
+
+        refreshEffectiveConfig();
+
+        registered_monitor = 0;
+        resetCache();
+    }
+
+    // connect() の後半（トランスポートの接続に成功した後、排他ロック中に呼ぶ）。
+    void finishConnect() {
+        transport.setTimeout(toMilliseconds(access.timeout_seconds), toMilliseconds(access.timeout_seconds));
+        dispatcher.reset();
+        connected = true;
+        setState(ConnectionState::Connected);
     }
 
     void ensureConnected() const {
-        if (!connected || !transport.isConnected()) {
+        // トランスポートの状態は送受信中のスレッドが変えるため、ディスパッチャが記録した切断を見る
+        if (!connected || dispatcher.linkLost()) {
+            if (state.load() == ConnectionState::Reconnecting) {
+                throw TransportReconnectingError("Client is reconnecting; the request was not sent");
+            }
             throw TransportError("Client is not connected");
         }
     }
 
-    std::vector<std::uint8_t> receiveFrame(const SessionConfig& cfg) {
-        if (cfg.mode == CommunicationMode::Ascii) {
-            return transport.receiveFrame(
-                22, [](const std::uint8_t* header, std::size_t) {
-                    std::string length(reinterpret_cast<const char*>(header + 14), 4);
-                    return static_cast<std::size_t>(std::stoul(length, nullptr, 16));
-                });
+    // 接続状態を変え、監視スレッドに通知を渡す。supervisor_mutex を保持して呼ぶ。
+    void changeState(ConnectionState next, std::exception_ptr cause) {
+        if (state.load() == next) {
+            return;
+        }
+        state.store(next);
+        if (next == ConnectionState::Reconnecting) {
+            reconnect_attempts = 0;
+            scheduleReconnect();
+        }
+        if (state_handler) {
+            state_events.emplace_back(next, std::move(cause));
+        }
+        supervisor_cv.notify_all();
+    }
+
+    void setState(ConnectionState next, std::exception_ptr cause = nullptr) {
+        std::lock_guard<std::mutex> lock(supervisor_mutex);
+        changeState(next, std::move(cause));
+    }
+
+    // 次の再接続の時刻を決める（指数バックオフ＋ジッター）。supervisor_mutex を保持して呼ぶ。
+    void scheduleReconnect() {
+        using Millis = std::chrono::duration<double, std::milli>;
+        const auto& policy = reconnect_policy;
+        const double growth = std::pow(policy.multiplier, static_cast<double>(reconnect_attempts));
+        const Millis delay = std::min(Millis(policy.initial_delay) * growth, Millis(policy.max_delay));
+        std::uniform_real_distribution<double> shorten(0.0, policy.jitter);
+        next_reconnect = std::chrono::steady_clock::now() +
+                         std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay * (1.0 - shorten(jitter_rng)));
+    }
+
+    // 送受信の失敗で接続が失われた場合に、再接続中（自動再接続が無効なら未接続）にする。
+    // 要求の共有ロックを保持したまま呼ぶ。
+    void noteTransportFailure(std::exception_ptr cause) {
+        if (!connected || !dispatcher.linkLost()) {
+            return; // タイムアウトなど接続が残っている失敗
+        }
+        std::lock_guard<std::mutex> lock(supervisor_mutex);
+        changeState(reconnect_policy.enabled ? ConnectionState::Reconnecting : ConnectionState::Disconnected,
+                    std::move(cause));
+    }
+
+    // 読み取りを実行し、接続が失われて失敗した場合は再接続を待って 1 回だけ再試行する。
+    // 読み取りは PLC の状態を変えないため、応答を受け取れなかった要求を送り直してよい。
+    template <typename Operation>
+    auto retryRead(Operation operation) -> decltype(operation()) {
+        const auto reconnects = reconnect_count.load();
+        try {
+            return operation();
+        } catch (const TransportError&) {
+            if (!waitReconnected(reconnects)) {
+                throw;
+            }
+        }
+        return operation();
+    }
+
+    // 再接続中なら read_retry_timeout を上限に再接続を待つ。since の後に再接続した場合 true。
+    bool waitReconnected(std::uint64_t since) {
+        std::unique_lock<std::mutex> lock(supervisor_mutex);
+        const auto timeout = reconnect_policy.read_retry_timeout;
+        if (!reconnect_policy.enabled || timeout <= std::chrono::milliseconds::zero()) {
+            return false;
+        }
+        supervisor_cv.wait_for(lock, timeout, [&] {
+            return stopping || reconnect_count.load() != since || state.load() != ConnectionState::Reconnecting;
+        });
+        return reconnect_count.load() != since && state.load() == ConnectionState::Connected;
+    }
+
+    void startSupervisor() {
+        if (!supervisor.joinable()) {
+            supervisor = std::thread([this] { supervise(); });
         }
-        return transport.receiveFrame(
-            9, [](const std::uint8_t* header, std::size_t) {
-                return static_cast<std::size_t>(header[7] | (header[8] << 8));
-            });
     }
 
-    void ensureCompletion(std::uint16_t code,
-                          const std::vector<std::uint8_t>& diag,
-                          CommunicationMode mode) const {
-        if (code == 0) {
+    // 監視スレッド。状態の通知を順にハンドラーへ渡し、再接続中は時刻が来たら再接続を試みる。
+    void supervise() {
+        std::unique_lock<std::mutex> lock(supervisor_mutex);
+        while (!stopping) {
+            if (!state_events.empty()) {
+                auto event = std::move(state_events.front());
+                state_events.pop_front();
+                auto handler = state_handler;
+                lock.unlock();
+                if (handler) {
+                    try {
+                        handler(event.first, event.second);
+                    } catch (...) {
+                        // ハンドラーの例外は監視スレッドを止めないよう無視する
+                    }
+                }
+                lock.lock();
+                continue;
+            }
+            if (state.load() == ConnectionState::Reconnecting && reconnect_policy.enabled) {
+                if (std::chrono::steady_clock::now() < next_reconnect) {
+                    supervisor_cv.wait_until(lock, next_reconnect);
+                    continue;
+                }
+                ++reconnect_attempts;
+                lock.unlock();
+                auto error = reconnect();
+                lock.lock();
+                if (error && state.load() == ConnectionState::Reconnecting) {
+                    const auto limit = reconnect_policy.max_attempts;
+                    if (limit != 0 && reconnect_attempts >= limit) {
+                        changeState(ConnectionState::Disconnected, error);
+                    } else {
+                        scheduleReconnect();
+                    }
+                }
+                continue;
+            }
+            supervisor_cv.wait(lock);
+        }
+    }
+
+    // 監視スレッドから呼ぶ。新しい接続をロックの外で確立し、実行中の要求が終わってから差し替える。
+    // 接続できなかった場合はその例外を返す。
+    std::exception_ptr reconnect() {
+        SessionConfig config;
+        std::uint64_t generation = 0;
+        {
+            std::shared_lock<std::shared_mutex> lock(state_mutex);
+            if (!connected || !dispatcher.linkLost()) {
+                return nullptr; // connect()/disconnect() で状態が変わった
+            }
+            config = base_config;
+            generation = connection_generation;
+        }
+
+        TcpTransport fresh;
+        try {
+            fresh.connect(config);
+        } catch (...) {
+            return std::current_exception();
+        }
+
+        std::unique_lock<std::shared_mutex> lock(state_mutex);
+        if (!connected || !dispatcher.linkLost() || generation != connection_generation) {
+            return nullptr;
+        }
+        transport = std::move(fresh);
+        // 切断されていた間に PLC の値が変わっている可能性があるため、キャッシュは引き継がない
+        registered_monitor = 0;
+        resetCache();
+        ++reconnect_count;
+        finishConnect();
+        return nullptr;
+    }
+
+    // 要求の間保持する共有ロックを取り、接続中であることを確認する。
+    std::shared_lock<std::shared_mutex> acquire() const {
+        std::shared_lock<std::shared_mutex> lock(state_mutex);
+        ensureConnected();
+        return lock;
+    }
+
+    void resetCache() {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        cache.clear();
+        ++cache_epoch;
+    }
+
+    // 1 要求を送信して応答フレームを受け取る。
+    // 4E フレームではシリアル番号を付与し、一致しない応答（タイムアウト済み要求の遅延応答など）は読み捨てる。
+    // 応答は他のスレッドが受信する場合があるため、呼び出し元スレッドのバッファにコピーして返す（次の transact() まで有効）。
+    std::span<const std::uint8_t> transact(const SessionConfig& cfg, std::vector<std::uint8_t>& request) {
+        auto& response = responseBuffer();
+        try {
+            dispatcher.transact(cfg, std::span<std::vector<std::uint8_t>>(&request, 1),
+                                [&response](std::size_t, std::span<const std::uint8_t> frame) {
+                                    response.assign(frame.begin(), frame.end());
+                                });
+        } catch (const TransportError&) {
+            noteTransportFailure(std::current_exception());
+            throw;
+        }
+        return response;
+    }
+
+    // 複数要求をパイプラインで送信し、応答フレームを受信するたびに (要求インデックス, フレーム) で通知する。
+    // 4E フレームでは max_in_flight 件まで応答を待たずに送信し、シリアル番号で応答を対応付ける（通知順は到着順）。
+    // 3E フレームはシリアル番号を持たないため 1 件ずつ往復する。
+    // 他のスレッドの要求と同じ接続を共有し、on_response は送受信を担当するスレッドで呼ばれる。
+    void transactPipelined(const SessionConfig& cfg,
+                           std::vector<std::vector<std::uint8_t>>& requests,
+                           const std::function<void(std::size_t, std::span<const std::uint8_t>)>& on_response) {
+        try {
+            dispatcher.transact(cfg, requests, on_response);
+        } catch (const TransportError&) {
+            noteTransportFailure(std::current_exception());
+            throw;
+        }
+    }
+
+    // 要求フレームが 1 つならスレッドごとの送信バッファで往復し、複数ならパイプラインで送信する。
+    // encode(out, chunk) でフレームを作り、on_response(チャンク番号, 応答フレーム) で結果を受け取る。
+    template <typename Chunk, typename Encode, typename OnResponse>
+    void transactChunks(const SessionConfig& cfg,
+                        const std::vector<Chunk>& chunks,
+                        Encode&& encode,
+                        const OnResponse& on_response) {
+        if (chunks.size() == 1) {
+            auto& request = requestBuffer();
+            encode(request, chunks.front());
+            on_response(std::size_t{0}, transact(cfg, request));
             return;
         }
 
-        std::ostringstream oss;
-        oss << "MC completion error 0x" << std::uppercase << std::hex << std::setw(4) << std::setfill('0') << code;
-        if (!diag.empty()) {
-            oss << " diag=";
-            if (mode == CommunicationMode::Ascii) {
-                oss << std::string(diag.begin(), diag.end());
-            } else {
-                for (auto byte : diag) {
-                    oss << std::uppercase << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte) << ' ';
+        std::vector<std::vector<std::uint8_t>> requests(chunks.size());
+        for (std::size_t i = 0; i < chunks.size(); ++i) {
+            encode(requests[i], chunks[i]);
+        }
+        transactPipelined(cfg, requests, on_response);
+    }
+
+    // 一括読み出しを 1 要求あたりの点数上限ごとに分割する。
+    // 上限以内なら 1 往復し、超える場合は分割した要求をパイプラインで送信する。
+    // on_chunk(先頭からのオフセット, 点数, 応答フレーム) は応答の到着順に呼ばれる。
+    template <typename OnChunk>
+    void readBatchChunked(const ResolvedDevice& head, std::size_t count, OnChunk&& on_chunk) {
+        if (count == 0) {
+            throw std::invalid_argument("DeviceRange.length must be greater than zero");
+        }
+        if (count - 1 > std::numeric_limits<std::uint32_t>::max() - head.number) {
+            throw std::invalid_argument("Device range exceeds the device number space");
+        }
+
+        const SessionConfig& cfg = effective_config;
+        const std::size_t limit = codec::FrameEncoder::maxBatchReadPoints(head.type);
+        if (count <= limit) {
+            auto& request = requestBuffer();
+            frame_encoder.makeBatchReadRequest(request, cfg, ResolvedRange{head, static_cast<std::uint16_t>(count)});
+            on_chunk(std::size_t{0}, count, transact(cfg, request));
+            return;
+        }
+
+        const std::size_t chunks = (count + limit - 1) / limit;
+        std::vector<std::vector<std::uint8_t>> requests(chunks);
+        for (std::size_t i = 0; i < chunks; ++i) {
+            ResolvedRange chunk{head, static_cast<std::uint16_t>(std::min(limit, count - i * limit))};
+            chunk.head.number += static_cast<std::uint32_t>(i * limit);
+            frame_encoder.makeBatchReadRequest(requests[i], cfg, chunk);
+        }
+        transactPipelined(cfg, requests, [&](std::size_t index, std::span<const std::uint8_t> frame) {
+            const std::size_t offset = index * limit;
+            on_chunk(offset, std::min(limit, count - offset), frame);
+        });
+    }
+
+    std::vector<std::uint16_t> readWordArea(const ResolvedDevice& head, std::size_t count) {
+        const CommunicationMode mode = effective_config.mode;
+        std::vector<std::uint16_t> result;
+        readBatchChunked(head, count, [&](std::size_t offset, std::size_t length, std::span<const std::uint8_t> frame) {
+            auto words = detail::decodeWords(frame_decoder, frame, mode, length);
+            if (length == count) {
+                result = std::move(words);
+                return;
+            }
+            result.resize(count);
+            std::copy(words.begin(), words.end(), result.begin() + static_cast<std::ptrdiff_t>(offset));
+        });
+        return result;
+    }
+
+    std::vector<bool> readBitArea(const ResolvedDevice& head, std::size_t count) {
+        const CommunicationMode mode = effective_config.mode;
+        std::vector<bool> bits(count);
+        readBatchChunked(head, count, [&](std::size_t offset, std::size_t length, std::span<const std::uint8_t> frame) {
+            detail::decodeBits(frame_decoder, frame, mode, bits, offset, length);
+        });
+        return bits;
+    }
+
+    // ランダム読み出し。Request は RandomDeviceRequest / ResolvedRandomRequest、Plan は対応する読み取りプラン。
+    // 点数上限を超えるプランは複数フレームに分割してパイプラインで送信し、結果をプランの順に戻す。
+    template <typename Request, typename Plan>
+    std::vector<DeviceValue> randomRead(const Plan& plan) {
+        const SessionConfig& cfg = effective_config;
+        const auto chunks = splitRandomRead<Request>(plan, codec::FrameEncoder::randomAccessLimits(cfg.series).read_points);
+
+        std::vector<DeviceValue> results(plan.size());
+        transactChunks(
+            cfg, chunks,
+            [&](std::vector<std::uint8_t>& out, const RandomReadChunk<Request>& chunk) {
+                frame_encoder.makeRandomReadRequest(out, cfg, chunk.request);
+            },
+            [&](std::size_t index, std::span<const std::uint8_t> frame) {
+                detail::decodeRandomResponse(frame_decoder, value_codec, plan, chunks[index].order, frame, cfg.mode,
+                                             results);
+            });
+        return results;
+    }
+
+    // 最適化済みプランのフレームを送信し、応答ワードを連結した列を返す。
+    std::vector<std::uint16_t> readOptimizedWords(const OptimizedReadPlan& plan) {
+        const SessionConfig& cfg = effective_config;
+        if (plan.series != cfg.series) {
+            throw std::invalid_argument("Optimized read plan was built for a different PLC series");
+        }
+        if (plan.frames.empty()) {
+            return {};
+        }
+
+        std::vector<std::uint16_t> words(plan.total_words);
+        transactChunks(
+            cfg, plan.frames,
+            [&](std::vector<std::uint8_t>& out, const OptimizedReadFrame& frame) {
+                switch (frame.kind) {
+                    case OptimizedReadFrame::Kind::Batch:
+                        frame_encoder.makeBatchReadRequest(out, cfg, frame.blocks.word_blocks.front());
+                        break;
+                    case OptimizedReadFrame::Kind::MultiBlock:
+                        frame_encoder.makeMultiBlockReadRequest(out, cfg, frame.blocks);
+                        break;
+                    case OptimizedReadFrame::Kind::Random:
+                        frame_encoder.makeRandomReadRequest(out, cfg, frame.random);
+                        break;
+                }
+            },
+            [&](std::size_t index, std::span<const std::uint8_t> response) {
+                const auto& frame = plan.frames[index];
+                const auto chunk = detail::decodeWords(frame_decoder, response, cfg.mode, frame.word_count);
+                std::copy(chunk.begin(), chunk.end(), words.begin() + static_cast<std::ptrdiff_t>(frame.word_offset));
+            });
+        return words;
+    }
+
+    // キャッシュを使ったワード範囲の読み取り。max_age 以内に取得したワードはキャッシュから返し、
+    // 古いか未取得の区間だけを読み取ってキャッシュに格納する。
+    std::vector<std::uint16_t> readWordsCached(const ResolvedDevice& head,
+                                               std::size_t count,
+                                               std::chrono::milliseconds max_age) {
+        if (!cache_enabled || !detail::ShadowCache::cacheable(head)) {
+            return readWordArea(head, count);
+        }
+        if (count == 0) {
+            throw std::invalid_argument("DeviceRange.length must be greater than zero");
+        }
+        if (count - 1 > std::numeric_limits<std::uint32_t>::max() - head.number) {
+            throw std::invalid_argument("Device range exceeds the device number space");
+        }
+
+        // 取得時刻は要求の送信前に取る（応答の値はそれ以降のもの）
+        const auto now = detail::ShadowCache::Clock::now();
+        const auto oldest = detail::ShadowCache::oldestAllowed(now, max_age);
+        ResolvedReadPlan fetch;
+        std::uint64_t epoch = 0;
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            epoch = cache_epoch;
+            for (const auto& run : cache.staleRuns(head.kind, head.number, count, oldest)) {
+                ResolvedDevice device = head;
+                device.number = run.number;
+                fetch.push_back(ResolvedReadPlanEntry{device, ValueFormat::RawWords(run.length)});
+            }
+        }
+
+        std::vector<std::uint16_t> result(count);
+        const bool cached = fetchIntoCache(fetch, fetch.size(), now, epoch, [&] {
+            cache.load(head.kind, head.number, count, result.data());
+        });
+        if (!cached) {
+            return readWordArea(head, count);
+        }
+        return result;
+    }
+
+    // キャッシュを使ったランダム読み出し。ワードデバイスのエントリは古いか未取得のワードだけを、
+    // それ以外（ビットデバイス・ダブルワードデバイス）のエントリは毎回読み取り、まとめて最適化したフレームで送信する。
+    std::vector<DeviceValue> randomReadCached(const ResolvedReadPlan& plan, std::chrono::milliseconds max_age) {
+        if (!cache_enabled) {
+            return randomRead<ResolvedRandomRequest>(plan);
+        }
+
+        const auto now = detail::ShadowCache::Clock::now();
+        const auto oldest = detail::ShadowCache::oldestAllowed(now, max_age);
+        ResolvedReadPlan fetch;
+        ResolvedReadPlan cached_plan;
+        std::vector<std::size_t> cached_positions;
+        std::vector<std::size_t> uncached_positions;
+        std::unique_lock<std::mutex> lock(cache_mutex);
+        const std::uint64_t epoch = cache_epoch;
+        for (std::size_t i = 0; i < plan.size(); ++i) {
+            const auto& entry = plan[i];
+            if (!detail::ShadowCache::cacheable(entry.address) || entry.format.type == ValueType::BitArray) {
+                uncached_positions.push_back(i);
+                continue;
+            }
+            const std::size_t words = ValueCodec::requiredWords(entry.format);
+            if (words - 1 > std::numeric_limits<std::uint32_t>::max() - entry.address.number) {
+                throw std::invalid_argument("Read plan entry exceeds the device number space");
+            }
+            for (const auto& run : cache.staleRuns(entry.address.kind, entry.address.number, words, oldest)) {
+                ResolvedDevice device = entry.address;
+                device.number = run.number;
+                fetch.push_back(ResolvedReadPlanEntry{device, ValueFormat::RawWords(run.length)});
+            }
+            cached_plan.push_back(entry);
+            cached_positions.push_back(i);
+        }
+        lock.unlock();
+        const std::size_t cached_runs = fetch.size();
+        for (const std::size_t position : uncached_positions) {
+            fetch.push_back(plan[position]);
+        }
+
+        std::vector<DeviceValue> results(plan.size());
+        std::vector<std::uint16_t> words;
+        std::vector<DeviceValue> fetched;
+        const bool cached = fetchIntoCache(
+            fetch, cached_runs, now, epoch,
+            [&] {
+                for (const auto& entry : cached_plan) {
+                    const std::size_t offset = words.size();
+                    words.resize(offset + ValueCodec::requiredWords(entry.format));
+                    cache.load(entry.address.kind, entry.address.number, words.size() - offset, words.data() + offset);
+                }
+            },
+            &fetched);
+        if (!cached) {
+            return randomRead<ResolvedRandomRequest>(plan);
+        }
+        for (std::size_t k = 0; k < uncached_positions.size(); ++k) {
+            results[uncached_positions[k]] = std::move(fetched[k]);
+        }
+        if (cached_plan.empty()) {
+            return results;
+        }
+
+        auto values = value_codec.decode(cached_plan, words);
+        for (std::size_t k = 0; k < cached_positions.size(); ++k) {
+            results[cached_positions[k]] = std::move(values[k]);
+        }
+        return results;
+    }
+
+    // plan の先頭 cached_runs 個（RawWords の区間）を読み取ってキャッシュに格納し、同じロックの中で load() を呼ぶ。
+    // 残りのエントリの値は uncached に返す。
+    // epoch（区間を決めた時点の cache_epoch）から読み取り中にキャッシュが破棄・書き込みされた場合は、
+    // 書き込み前の値を格納しないよう何も格納せずに false を返す（呼び出し側はキャッシュを使わずに読み直す）。
+    template <typename Load>
+    bool fetchIntoCache(const ResolvedReadPlan& plan,
+                        std::size_t cached_runs,
+                        detail::ShadowCache::Clock::time_point stamp,
+                        std::uint64_t epoch,
+                        Load&& load,
+                        std::vector<DeviceValue>* uncached = nullptr) {
+        OptimizedReadPlan optimized;
+        std::vector<std::uint16_t> words;
+        if (!plan.empty()) {
+            optimized = optimizeReadPlan(plan, effective_config.series);
+            words = readOptimizedWords(optimized);
+        }
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            if (cache_epoch != epoch) {
+                return false;
+            }
+            for (std::size_t i = 0; i < cached_runs; ++i) {
+                const auto& run = plan[i];
+                cache.store(run.address.kind, run.address.number, words.data() + optimized.word_offsets[i],
+                            run.format.parameter, stamp);
+            }
+            load();
+        }
+        if (uncached != nullptr && cached_runs < plan.size()) {
+            *uncached = decodeOptimizedRead(optimized, words);
+            uncached->erase(uncached->begin(), uncached->begin() + static_cast<std::ptrdiff_t>(cached_runs));
+        }
+        return true;
+    }
+
+    // 書き込み先のワードを未取得に戻す（書き込みの成否にかかわらず、PLC の値が変わった可能性がある）
+    void invalidateCache(const ResolvedDevice& head, std::size_t count) {
+        if (cache_enabled && detail::ShadowCache::cacheable(head)) {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            cache.invalidate(head.kind, head.number, count);
+            ++cache_epoch;
+        }
+    }
+
+    // モニタ登録要求とモニタ要求（およびモニタに収まらない分のランダム読み出し要求）をエンコードする。
+    void encodeMonitor(const std::vector<ResolvedRandomRequest>& requests,
+                       std::vector<std::uint8_t>& register_frame,
+                       std::vector<std::vector<std::uint8_t>>& frames) const {
+        const SessionConfig& cfg = effective_config;
+        frame_encoder.makeMonitorRegisterRequest(register_frame, cfg, requests.front());
+        frames.resize(requests.size());
+        frame_encoder.makeMonitorRequest(frames.front(), cfg);
+        for (std::size_t i = 1; i < requests.size(); ++i) {
+            frame_encoder.makeRandomReadRequest(frames[i], cfg, requests[i]);
+        }
+    }
+
+    void registerMonitor(std::uint64_t id, std::vector<std::uint8_t>& register_frame) {
+        const SessionConfig& cfg = effective_config;
+        auto frame = transact(cfg, register_frame);
+        const auto response = frame_decoder.parseResponse(frame);
+        detail::ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
+        registered_monitor = id;
+    }
+
+    MultiBlockData readMultipleBlocks(const ResolvedMultiBlockRequest& request) {
+        const SessionConfig& cfg = effective_config;
+        const auto chunks = splitMultiBlock(request, 0);
+
+        MultiBlockData result;
+        for (const auto& block : request.word_blocks) {
+            result.word_blocks.emplace_back(block.length);
+        }
+        for (const auto& block : request.bit_blocks) {
+            result.bit_blocks.emplace_back(block.length);
+        }
+        const std::size_t word_block_count = request.word_blocks.size();
+
+        transactChunks(
+            cfg, chunks,
+            [&](std::vector<std::uint8_t>& out, const MultiBlockChunk& chunk) {
+                frame_encoder.makeMultiBlockReadRequest(out, cfg, chunk.request);
+            },
+            [&](std::size_t index, std::span<const std::uint8_t> frame) {
+                const auto& chunk = chunks[index];
+                const auto response = frame_decoder.parseMultiBlockReadResponse(frame, chunk.lengths);
+                detail::ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
+                for (std::size_t k = 0; k < chunk.segments.size(); ++k) {
+                    const auto& segment = chunk.segments[k];
+                    auto& block = segment.block < word_block_count
+                                      ? result.word_blocks[segment.block]
+                                      : result.bit_blocks[segment.block - word_block_count];
+                    std::copy(response.blocks[k].begin(), response.blocks[k].end(),
+                              block.begin() + static_cast<std::ptrdiff_t>(segment.offset));
                 }
+            });
+        return result;
+    }
+
+    void writeMultipleBlocks(const ResolvedMultiBlockRequest& request, const MultiBlockData& data) {
+        if (data.word_blocks.size() != request.word_blocks.size() ||
+            data.bit_blocks.size() != request.bit_blocks.size()) {
+            throw std::invalid_argument("Multi-block data count mismatch");
+        }
+        for (std::size_t i = 0; i < request.word_blocks.size(); ++i) {
+            if (data.word_blocks[i].size() < request.word_blocks[i].length) {
+                throw std::invalid_argument("Insufficient word block data for write");
             }
         }
-        throw std::runtime_error(oss.str());
+        for (std::size_t i = 0; i < request.bit_blocks.size(); ++i) {
+            if (data.bit_blocks[i].size() < request.bit_blocks[i].length) {
+                throw std::invalid_argument("Insufficient bit block data for write");
+            }
+        }
+        for (const auto& block : request.word_blocks) {
+            invalidateCache(block.head, block.length);
+        }
+
+        const SessionConfig& cfg = effective_config;
+        const auto chunks = splitMultiBlock(request, codec::FrameEncoder::kMultiBlockWriteBlockCost);
+        const std::size_t word_block_count = request.word_blocks.size();
+        std::vector<std::uint16_t> values;
+
+        transactChunks(
+            cfg, chunks,
+            [&](std::vector<std::uint8_t>& out, const MultiBlockChunk& chunk) {
+                values.clear();
+                for (std::size_t k = 0; k < chunk.segments.size(); ++k) {
+                    const auto& segment = chunk.segments[k];
+                    const auto& block = segment.block < word_block_count
+                                            ? data.word_blocks[segment.block]
+                                            : data.bit_blocks[segment.block - word_block_count];
+                    const auto first = block.begin() + static_cast<std::ptrdiff_t>(segment.offset);
+                    values.insert(values.end(), first, first + chunk.lengths[k]);
+                }
+                frame_encoder.makeMultiBlockWriteRequest(out, cfg, chunk.request, values);
+            },
+            [&](std::size_t, std::span<const std::uint8_t> frame) {
+                const auto response = frame_decoder.parseResponse(frame);
+                detail::ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
+            });
     }
 };
 
@@ -187,110 +929,254 @@ McClient::McClient(TcpTransport&& transport,
 McClient::~McClient() = default;
 
 void McClient::connect(const SessionConfig& config) {
-    impl_->base_config = config;
-    impl_->access.mode = config.mode;
-    impl_->access.network = config.network;
-    impl_->access.pc = config.pc;
-    impl_->access.module_io = config.module_io;
-    impl_->access.module_station = config.module_station;
-    impl_->access.timeout_seconds = std::max<std::uint16_t>(1, config.timeout_250ms / 4);
+    std::unique_lock<std::shared_mutex> lock(impl_->state_mutex);
+    impl_->beginConnect(config);
+    try {
+        impl_->transport.connect(config);
+    } catch (...) {
+        impl_->setState(ConnectionState::Disconnected, std::current_exception());
+        throw;
+    }
+    impl_->finishConnect();
+}
+
+std::vector<std::exception_ptr> McClient::connectAll(std::span<McClient* const> clients,
+                                                     std::span<const SessionConfig> configs) {
+    if (clients.size() != configs.size()) {
+        throw std::invalid_argument("connectAll requires one SessionConfig per client");
+    }
+    std::vector<McClient*> order(clients.begin(), clients.end());
+    std::sort(order.begin(), order.end(), std::less<McClient*>());
+    if (!order.empty() && order.front() == nullptr) {
+        throw std::invalid_argument("connectAll requires non-null clients");
+    }
+    if (std::adjacent_find(order.begin(), order.end()) != order.end()) {
+        throw std::invalid_argument("connectAll requires distinct clients");
+    }
+
+    // 接続の確立はロックの外で行い、接続を待つ間も他のクライアントや呼び出し元を止めない。
+    // 待っている間に connect()/disconnect() された場合は世代番号が変わるため、確立した接続を捨てる。
+    std::vector<std::uint64_t> generations(clients.size());
+    for (std::size_t i = 0; i < clients.size(); ++i) {
+        Impl& impl = *clients[i]->impl_;
+        std::unique_lock<std::shared_mutex> lock(impl.state_mutex);
+        impl.beginConnect(configs[i]);
+        impl.transport.disconnect();
+        generations[i] = impl.connection_generation;
+    }
 
-    impl_->transport.connect(config);
-    impl_->transport.setTimeout(toMilliseconds(impl_->access.timeout_seconds),
-                                toMilliseconds(impl_->access.timeout_seconds));
+    std::vector<TcpTransport> fresh(clients.size());
+    std::vector<TcpTransport*> transports;
+    transports.reserve(fresh.size());
+    for (auto& transport : fresh) {
+        transports.push_back(&transport);
+    }
+    auto errors = TcpTransport::connectAll(transports, configs);
 
-    impl_->connected = true;
+    for (std::size_t i = 0; i < clients.size(); ++i) {
+        Impl& impl = *clients[i]->impl_;
+        std::unique_lock<std::shared_mutex> lock(impl.state_mutex);
+        if (generations[i] != impl.connection_generation) {
+            errors[i] = std::make_exception_ptr(
+                TransportError("Connection attempt was superseded by a later connect() or disconnect()"));
+        } else if (errors[i]) {
+            impl.setState(ConnectionState::Disconnected, errors[i]);
+        } else {
+            impl.transport = std::move(fresh[i]);
+            impl.finishConnect();
+        }
+    }
+    return errors;
 }
 
 void McClient::disconnect() {
+    std::unique_lock<std::shared_mutex> lock(impl_->state_mutex);
     impl_->transport.disconnect();
     impl_->connected = false;
+    ++impl_->connection_generation;
+    impl_->registered_monitor = 0;
+    impl_->setState(ConnectionState::Disconnected);
 }
 
 bool McClient::isConnected() const noexcept {
-    return impl_->connected && impl_->transport.isConnected();
+    return impl_->connected.load() && !impl_->dispatcher.linkLost();
+}
+
+ConnectionState McClient::connectionState() const noexcept {
+    return impl_->state.load();
+}
+
+void McClient::setReconnectPolicy(const ReconnectPolicy& policy) {
+    if (policy.initial_delay < std::chrono::milliseconds::zero() || policy.max_delay < policy.initial_delay) {
+        throw std::invalid_argument("ReconnectPolicy delays must satisfy 0 <= initial_delay <= max_delay");
+    }
+    if (!(policy.multiplier >= 1.0)) {
+        throw std::invalid_argument("ReconnectPolicy.multiplier must be at least 1");
+    }
+    if (!(policy.jitter >= 0.0 && policy.jitter <= 1.0)) {
+        throw std::invalid_argument("ReconnectPolicy.jitter must be between 0 and 1");
+    }
+    if (policy.read_retry_timeout < std::chrono::milliseconds::zero()) {
+        throw std::invalid_argument("ReconnectPolicy.read_retry_timeout must not be negative");
+    }
+
+    std::lock_guard<std::mutex> lock(impl_->supervisor_mutex);
+    impl_->reconnect_policy = policy;
+    if (policy.enabled) {
+        impl_->startSupervisor();
+    } else if (impl_->state.load() == ConnectionState::Reconnecting) {
+        impl_->changeState(ConnectionState::Disconnected, nullptr);
+    }
+    impl_->supervisor_cv.notify_all();
+}
+
+void McClient::setConnectionStateHandler(ConnectionStateHandler handler) {
+    std::lock_guard<std::mutex> lock(impl_->supervisor_mutex);
+    impl_->state_handler = std::move(handler);
+    if (impl_->state_handler) {
+        impl_->startSupervisor();
+    }
+}
+
+PlcSeries McClient::series() const noexcept {
+    std::shared_lock<std::shared_mutex> lock(impl_->state_mutex);
+    return impl_->effective_config.series;
 }
 
 void McClient::setAccessOption(const AccessOption& option) {
+    std::unique_lock<std::shared_mutex> lock(impl_->state_mutex);
     impl_->access = option;
+    impl_->refreshEffectiveConfig();
     impl_->transport.setTimeout(toMilliseconds(option.timeout_seconds),
                                 toMilliseconds(option.timeout_seconds));
 }
 
 std::vector<std::uint16_t> McClient::readWords(const DeviceRange& range) {
-    impl_->ensureConnected();
-
-    SessionConfig cfg = impl_->makeEffectiveConfig();
-    auto request = impl_->frame_encoder.makeBatchReadRequest(cfg, range);
-    impl_->transport.sendAll(request);
-    auto frame = impl_->receiveFrame(cfg);
-    auto response = impl_->frame_decoder.parseBatchReadResponse(frame);
-    impl_->ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
-
-    std::vector<std::uint16_t> words;
-    if (cfg.mode == CommunicationMode::Ascii) {
-        words = ValueCodec::fromAsciiWords(response.device_data);
-    } else {
-        words = ValueCodec::fromBinaryBytes(response.device_data);
-    }
+    return impl_->retryRead([&]() -> std::vector<std::uint16_t> {
+        const auto access = impl_->acquire();
+        // キャッシュが有効な場合は常に読み取り、結果をキャッシュに格納する
+        return impl_->readWordsCached(resolveDevice(range.head), range.length, std::chrono::milliseconds(0));
+    });
+}
 
-    if (words.size() < range.length) {
-        throw std::runtime_error("Insufficient data size for word read");
-    }
-    words.resize(range.length);
-    return words;
+std::vector<std::uint16_t> McClient::readWordArea(const DeviceAddress& head, std::size_t count) {
+    return impl_->retryRead([&]() -> std::vector<std::uint16_t> {
+        const auto access = impl_->acquire();
+        return impl_->readWordsCached(resolveDevice(head), count, std::chrono::milliseconds(0));
+    });
 }
 
-std::vector<bool> McClient::readBits(const DeviceRange& range) {
-    impl_->ensureConnected();
+std::vector<std::uint16_t> McClient::readWordArea(const ResolvedDevice& head, std::size_t count) {
+    return impl_->retryRead([&]() -> std::vector<std::uint16_t> {
+        const auto access = impl_->acquire();
+        return impl_->readWordsCached(head, count, std::chrono::milliseconds(0));
+    });
+}
 
-    SessionConfig cfg = impl_->makeEffectiveConfig();
-    auto request = impl_->frame_encoder.makeBatchReadRequest(cfg, range);
-    impl_->transport.sendAll(request);
-    auto frame = impl_->receiveFrame(cfg);
-    auto response = impl_->frame_decoder.parseBatchReadResponse(frame);
-    impl_->ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
+PreparedRequest McClient::prepareReadWords(const DeviceRange& range) {
+    const auto access = impl_->acquire();
 
-    std::vector<bool> bits(range.length);
-    if (cfg.mode == CommunicationMode::Ascii) {
-        if (response.device_data.size() < range.length) {
-            throw std::runtime_error("Insufficient ASCII data for bit read");
+    PreparedRequest prepared;
+    prepared.range_ = range;
+    impl_->frame_encoder.makeBatchReadRequest(prepared.frame_, impl_->effective_config, range);
+    prepared.generation_ = impl_->layout_generation;
+    prepared.timer_ = impl_->effective_config.timeout_250ms;
+    return prepared;
+}
+
+std::vector<std::uint16_t> McClient::readWords(PreparedRequest& prepared) {
+    return impl_->retryRead([&]() -> std::vector<std::uint16_t> {
+        const auto access = impl_->acquire();
+        if (prepared.frame_.empty()) {
+            throw std::invalid_argument("PreparedRequest is empty");
         }
-        for (std::size_t i = 0; i < range.length; ++i) {
-            bits[i] = response.device_data[i] == '1';
+
+        const SessionConfig& cfg = impl_->effective_config;
+        if (prepared.generation_ != impl_->layout_generation) {
+            // 通信モードや経路が変わった場合のみ再エンコードする
+            impl_->frame_encoder.makeBatchReadRequest(prepared.frame_, cfg, prepared.range_);
+            prepared.generation_ = impl_->layout_generation;
+            prepared.timer_ = cfg.timeout_250ms;
+        } else if (prepared.timer_ != cfg.timeout_250ms) {
+            codec::FrameEncoder::setMonitoringTimer(prepared.frame_, cfg.timeout_250ms);
+            prepared.timer_ = cfg.timeout_250ms;
         }
-    } else {
-        const auto& packed = response.device_data;
-        std::size_t bit_index = 0;
-        for (std::size_t i = 0; i < packed.size() && bit_index < range.length; ++i) {
-            std::uint8_t byte = packed[i];
-            if (bit_index < range.length) {
-                bits[bit_index++] = (byte & 0x10) != 0;
-            }
-            if (bit_index < range.length) {
-                bits[bit_index++] = (byte & 0x01) != 0;
-            }
+
+        auto frame = impl_->transact(cfg, prepared.frame_);
+        return detail::decodeWords(impl_->frame_decoder, frame, cfg.mode, prepared.range_.length);
+    });
+}
+
+std::vector<std::vector<std::uint16_t>> McClient::readWordsPipelined(const std::vector<DeviceRange>& ranges) {
+    return impl_->retryRead([&]() -> std::vector<std::vector<std::uint16_t>> {
+        const auto access = impl_->acquire();
+
+        const SessionConfig& cfg = impl_->effective_config;
+        std::vector<std::vector<std::uint8_t>> requests;
+        requests.reserve(ranges.size());
+        for (const auto& range : ranges) {
+            requests.push_back(impl_->frame_encoder.makeBatchReadRequest(cfg, range));
         }
-    }
-    return bits;
+
+        std::vector<std::vector<std::uint16_t>> results(ranges.size());
+        impl_->transactPipelined(cfg, requests, [&](std::size_t index, std::span<const std::uint8_t> frame) {
+            results[index] = detail::decodeWords(impl_->frame_decoder, frame, cfg.mode, ranges[index].length);
+        });
+        return results;
+    });
+}
+
+std::vector<bool> McClient::readBits(const DeviceRange& range) {
+    return impl_->retryRead([&]() -> std::vector<bool> {
+        const auto access = impl_->acquire();
+        return impl_->readBitArea(resolveDevice(range.head), range.length);
+    });
+}
+
+std::vector<bool> McClient::readBitArea(const DeviceAddress& head, std::size_t count) {
+    return impl_->retryRead([&]() -> std::vector<bool> {
+        const auto access = impl_->acquire();
+        return impl_->readBitArea(resolveDevice(head), count);
+    });
+}
+
+std::vector<bool> McClient::readBitArea(const ResolvedDevice& head, std::size_t count) {
+    return impl_->retryRead([&]() -> std::vector<bool> {
+        const auto access = impl_->acquire();
+        return impl_->readBitArea(head, count);
+    });
 }
 
 void McClient::writeWords(const DeviceRange& range, const std::vector<std::uint16_t>& values) {
-    impl_->ensureConnected();
+    const auto access = impl_->acquire();
     if (values.size() < range.length) {
         throw std::invalid_argument("Insufficient word data for write");
     }
 
-    SessionConfig cfg = impl_->makeEffectiveConfig();
-    auto request = impl_->frame_encoder.makeBatchWriteRequest(cfg, range, values);
-    impl_->transport.sendAll(request);
-    auto frame = impl_->receiveFrame(cfg);
-    auto response = impl_->frame_decoder.parseBatchWriteResponse(frame);
-    impl_->ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
+    std::optional<ResolvedDevice> cached_head;
+    if (impl_->cache_enabled) {
+        cached_head = resolveDevice(range.head);
+        impl_->invalidateCache(*cached_head, range.length);
+    }
+
+    const SessionConfig& cfg = impl_->effective_config;
+    auto& request = requestBuffer();
+    impl_->frame_encoder.makeBatchWriteRequest(request, cfg, range, values);
+    const auto stamp = detail::ShadowCache::Clock::now();
+    auto frame = impl_->transact(cfg, request);
+    const auto response = impl_->frame_decoder.parseResponse(frame);
+    detail::ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
+
+    // 書き込みが完了した値は PLC から読み直さずにキャッシュへ反映する
+    if (cached_head && detail::ShadowCache::cacheable(*cached_head)) {
+        std::lock_guard<std::mutex> lock(impl_->cache_mutex);
+        impl_->cache.store(cached_head->kind, cached_head->number, values.data(), range.length, stamp);
+        ++impl_->cache_epoch;
+    }
 }
 
 void McClient::writeBits(const DeviceRange& range, const std::vector<bool>& values) {
-    impl_->ensureConnected();
+    const auto access = impl_->acquire();
     if (values.size() < range.length) {
         throw std::invalid_argument("Insufficient bit data for write");
     }
@@ -299,56 +1185,151 @@ void McClient::writeBits(const DeviceRange& range, const std::vector<bool>& valu
     std::transform(values.begin(), values.end(), bit_words.begin(),
                    [](bool bit) { return bit ? 1U : 0U; });
 
-    SessionConfig cfg = impl_->makeEffectiveConfig();
-    auto request = impl_->frame_encoder.makeBatchWriteRequest(cfg, range, bit_words);
-    impl_->transport.sendAll(request);
-    auto frame = impl_->receiveFrame(cfg);
-    auto response = impl_->frame_decoder.parseBatchWriteResponse(frame);
-    impl_->ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
+    const SessionConfig& cfg = impl_->effective_config;
+    auto& request = requestBuffer();
+    impl_->frame_encoder.makeBatchWriteRequest(request, cfg, range, bit_words);
+    auto frame = impl_->transact(cfg, request);
+    const auto response = impl_->frame_decoder.parseResponse(frame);
+    detail::ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
+}
+
+MultiBlockData McClient::readMultipleBlocks(const MultiBlockRequest& request) {
+    return impl_->retryRead([&]() -> MultiBlockData {
+        const auto access = impl_->acquire();
+        return impl_->readMultipleBlocks(resolveMultiBlockRequest(request));
+    });
+}
+
+void McClient::writeMultipleBlocks(const MultiBlockRequest& request, const MultiBlockData& data) {
+    const auto access = impl_->acquire();
+    impl_->writeMultipleBlocks(resolveMultiBlockRequest(request), data);
 }
 
 std::vector<DeviceValue> McClient::randomRead(const DeviceReadPlan& plan) {
-    impl_->ensureConnected();
-    RandomDeviceRequest request;
-    for (const auto& entry : plan) {
-        if (isWordFormat(entry.format.type)) {
-            request.word_devices.push_back(entry.address);
-        } else if (isDwordFormat(entry.format.type)) {
-            request.dword_devices.push_back(entry.address);
-        } else if (isLwordFormat(entry.format.type)) {
-            request.lword_devices.push_back(entry.address);
-        } else if (isBitFormat(entry.format.type)) {
-            request.bit_devices.push_back(entry.address);
-        } else {
-            throw std::invalid_argument("Unsupported format in randomRead plan");
-        }
+    return impl_->retryRead([&]() -> std::vector<DeviceValue> {
+        const auto access = impl_->acquire();
+        return impl_->randomRead<RandomDeviceRequest>(plan);
+    });
+}
+
+std::vector<DeviceValue> McClient::randomRead(const ResolvedReadPlan& plan) {
+    return impl_->retryRead([&]() -> std::vector<DeviceValue> {
+        const auto access = impl_->acquire();
+        return impl_->randomRead<ResolvedRandomRequest>(plan);
+    });
+}
+
+std::vector<DeviceValue> McClient::randomRead(const DeviceReadPlan& plan, std::chrono::milliseconds max_age) {
+    return randomRead(resolveReadPlan(plan), max_age);
+}
+
+std::vector<DeviceValue> McClient::randomRead(const ResolvedReadPlan& plan, std::chrono::milliseconds max_age) {
+    return impl_->retryRead([&]() -> std::vector<DeviceValue> {
+        const auto access = impl_->acquire();
+        return impl_->randomReadCached(plan, max_age);
+    });
+}
+
+std::vector<DeviceValue> McClient::readOptimized(const DeviceReadPlan& plan) {
+    return impl_->retryRead([&]() -> std::vector<DeviceValue> {
+        const auto access = impl_->acquire();
+        const auto optimized = optimizeReadPlan(plan, impl_->effective_config.series);
+        return decodeOptimizedRead(optimized, impl_->readOptimizedWords(optimized));
+    });
+}
+
+std::vector<DeviceValue> McClient::readOptimized(const OptimizedReadPlan& plan) {
+    return impl_->retryRead([&]() -> std::vector<DeviceValue> {
+        const auto access = impl_->acquire();
+        return decodeOptimizedRead(plan, impl_->readOptimizedWords(plan));
+    });
+}
+
+std::vector<std::uint16_t> McClient::readOptimizedWords(const OptimizedReadPlan& plan) {
+    return impl_->retryRead([&]() -> std::vector<std::uint16_t> {
+        const auto access = impl_->acquire();
+        return impl_->readOptimizedWords(plan);
+    });
+}
+
+MonitorSet McClient::registerMonitor(const DeviceReadPlan& plan) {
+    return registerMonitor(resolveReadPlan(plan));
+}
+
+MonitorSet McClient::registerMonitor(const ResolvedReadPlan& plan) {
+    const auto access = impl_->acquire();
+    if (plan.empty()) {
+        throw std::invalid_argument("Monitor plan is empty");
     }
 
-    SessionConfig cfg = impl_->makeEffectiveConfig();
-    auto frame_request = impl_->frame_encoder.makeRandomReadRequest(cfg, request);
-    impl_->transport.sendAll(frame_request);
-    auto frame = impl_->receiveFrame(cfg);
-    auto response = impl_->frame_decoder.parseRandomReadResponse(frame);
-    impl_->ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
+    const SessionConfig& cfg = impl_->effective_config;
+    auto chunks = splitRandomRead<ResolvedRandomRequest>(
+        plan, codec::FrameEncoder::randomAccessLimits(cfg.series).read_points);
 
-    std::vector<std::uint16_t> words;
-    if (cfg.mode == CommunicationMode::Ascii) {
-        words = ValueCodec::fromAsciiWords(response.device_data);
-    } else {
-        words = ValueCodec::fromBinaryBytes(response.device_data);
+    MonitorSet monitor;
+    monitor.plan_ = plan;
+    for (auto& chunk : chunks) {
+        monitor.requests_.push_back(std::move(chunk.request));
+        monitor.orders_.push_back(std::move(chunk.order));
     }
-    return impl_->value_codec.decode(plan, words);
+    impl_->encodeMonitor(monitor.requests_, monitor.register_frame_, monitor.frames_);
+    monitor.generation_ = impl_->layout_generation;
+    monitor.timer_ = cfg.timeout_250ms;
+
+    std::lock_guard<std::mutex> lock(impl_->monitor_mutex);
+    monitor.id_ = ++impl_->next_monitor_id;
+    impl_->registerMonitor(monitor.id_, monitor.register_frame_);
+    return monitor;
+}
+
+std::vector<DeviceValue> McClient::readMonitor(MonitorSet& monitor) {
+    return impl_->retryRead([&]() -> std::vector<DeviceValue> {
+        const auto access = impl_->acquire();
+        if (monitor.empty()) {
+            throw std::invalid_argument("MonitorSet is empty");
+        }
+
+        // 登録から読み取りまでの間に他のスレッドが別のセットを登録しないよう、読み取りの完了まで保持する
+        std::lock_guard<std::mutex> lock(impl_->monitor_mutex);
+        const SessionConfig& cfg = impl_->effective_config;
+        if (monitor.generation_ != impl_->layout_generation) {
+            impl_->encodeMonitor(monitor.requests_, monitor.register_frame_, monitor.frames_);
+            monitor.generation_ = impl_->layout_generation;
+            monitor.timer_ = cfg.timeout_250ms;
+        } else if (monitor.timer_ != cfg.timeout_250ms) {
+            codec::FrameEncoder::setMonitoringTimer(monitor.register_frame_, cfg.timeout_250ms);
+            for (auto& frame : monitor.frames_) {
+                codec::FrameEncoder::setMonitoringTimer(frame, cfg.timeout_250ms);
+            }
+            monitor.timer_ = cfg.timeout_250ms;
+        }
+
+        if (impl_->registered_monitor != monitor.id_) {
+            impl_->registerMonitor(monitor.id_, monitor.register_frame_);
+        }
+
+        std::vector<DeviceValue> results(monitor.plan_.size());
+        auto on_response = [&](std::size_t index, std::span<const std::uint8_t> frame) {
+            detail::decodeRandomResponse(impl_->frame_decoder, impl_->value_codec, monitor.plan_, monitor.orders_[index],
+                                         frame, cfg.mode, results);
+        };
+        if (monitor.frames_.size() == 1) {
+            on_response(0, impl_->transact(cfg, monitor.frames_.front()));
+        } else {
+            impl_->transactPipelined(cfg, monitor.frames_, on_response);
+        }
+        return results;
+    });
 }
 
 void McClient::randomWrite(const DeviceWritePlan& plan) {
-    impl_->ensureConnected();
+    const auto access = impl_->acquire();
 
-    RandomDeviceRequest request;
-    std::vector<std::uint16_t> word_data;
-    std::vector<std::uint32_t> dword_data;
-    std::vector<std::uint64_t> lword_data;
-    std::vector<bool> bit_data;
+    const SessionConfig& cfg = impl_->effective_config;
+    const auto limits = codec::FrameEncoder::randomAccessLimits(cfg.series);
 
+    // 書き込み値を種別ごとにまとめる（要求内の並び順）
+    RandomWriteChunk<RandomDeviceRequest> all;
     for (const auto& entry : plan) {
         DeviceWritePlan single{entry};
         auto encoded = impl_->value_codec.encode(single);
@@ -356,26 +1337,26 @@ void McClient::randomWrite(const DeviceWritePlan& plan) {
             if (encoded.size() != 1) {
                 throw std::runtime_error("Unexpected word encoding size");
             }
-            request.word_devices.push_back(entry.address);
-            word_data.push_back(encoded[0]);
+            all.request.word_devices.push_back(entry.address);
+            all.word_data.push_back(encoded[0]);
         } else if (isDwordFormat(entry.format.type)) {
             if (encoded.size() != 2) {
                 throw std::runtime_error("Unexpected dword encoding size");
             }
-            request.dword_devices.push_back(entry.address);
+            all.request.dword_devices.push_back(entry.address);
             std::uint32_t value = static_cast<std::uint32_t>(encoded[0]) |
                                   (static_cast<std::uint32_t>(encoded[1]) << 16);
-            dword_data.push_back(value);
+            all.dword_data.push_back(value);
         } else if (isLwordFormat(entry.format.type)) {
             if (encoded.size() != 4) {
                 throw std::runtime_error("Unexpected lword encoding size");
             }
-            request.lword_devices.push_back(entry.address);
+            all.request.lword_devices.push_back(entry.address);
             std::uint64_t value = static_cast<std::uint64_t>(encoded[0]) |
                                   (static_cast<std::uint64_t>(encoded[1]) << 16) |
                                   (static_cast<std::uint64_t>(encoded[2]) << 32) |
                                   (static_cast<std::uint64_t>(encoded[3]) << 48);
-            lword_data.push_back(value);
+            all.lword_data.push_back(value);
         } else if (isBitFormat(entry.format.type)) {
             if (!std::holds_alternative<std::vector<bool>>(entry.value)) {
                 throw std::invalid_argument("BitArray format requires vector<bool> value");
@@ -384,68 +1365,174 @@ void McClient::randomWrite(const DeviceWritePlan& plan) {
             if (bits.size() != 1) {
                 throw std::invalid_argument("Random bit write only supports single bit per device");
             }
-            request.bit_devices.push_back(entry.address);
-            bit_data.push_back(bits[0]);
+            all.request.bit_devices.push_back(entry.address);
+            all.bit_data.push_back(bits[0]);
         } else {
             throw std::invalid_argument("Unsupported format in randomWrite plan");
         }
     }
+    if (impl_->cache_enabled) {
+        for (const auto& entry : plan) {
+            if (!isBitFormat(entry.format.type)) {
+                impl_->invalidateCache(resolveDevice(entry.address), ValueCodec::requiredWords(entry.format));
+            }
+        }
+    }
 
-    SessionConfig cfg = impl_->makeEffectiveConfig();
-    auto frame_request = impl_->frame_encoder.makeRandomWriteRequest(cfg, request, word_data, dword_data, lword_data, bit_data);
-    impl_->transport.sendAll(frame_request);
-    auto frame = impl_->receiveFrame(cfg);
-    auto response = impl_->frame_decoder.parseRandomWriteResponse(frame);
-    impl_->ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
+    const auto chunks = splitRandomWrite(all, limits);
+    impl_->transactChunks(
+        cfg, chunks,
+        [&](std::vector<std::uint8_t>& out, const RandomWriteChunk<RandomDeviceRequest>& chunk) {
+            impl_->frame_encoder.makeRandomWriteRequest(out, cfg, chunk.request, chunk.word_data, chunk.dword_data,
+                                                        chunk.lword_data, chunk.bit_data);
+        },
+        [&](std::size_t, std::span<const std::uint8_t> frame) {
+            const auto response = impl_->frame_decoder.parseResponse(frame);
+            detail::ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
+        });
 }
 
-CpuInfo McClient::readCpuType() {
-    impl_->ensureConnected();
-
-    SessionConfig cfg = impl_->makeEffectiveConfig();
-    auto request = impl_->frame_encoder.makeSimpleCommand(cfg, 0x0101, 0x0000, {}, "");
-    impl_->transport.sendAll(request);
-    auto frame = impl_->receiveFrame(cfg);
-    auto response = impl_->frame_decoder.parseBatchReadResponse(frame);
-    impl_->ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
-
-    CpuInfo info{};
-    const auto& data = response.device_data;
-    if (cfg.mode == CommunicationMode::Binary) {
-        if (data.size() < 18) {
-            throw std::runtime_error("CPU type response too short");
-        }
-        std::string type(reinterpret_cast<const char*>(data.data()), 16);
-        info.cpu_type = rtrimSpaces(type);
-        std::uint16_t code_val = static_cast<std::uint16_t>(data[16] | (data[17] << 8));
-        info.cpu_code = hexUpper(code_val, 4);
-    } else {
-        if (data.size() < 20) {
-            throw std::runtime_error("CPU type response too short");
+void McClient::writeBatch(const WriteBatch& batch) {
+    const auto access = impl_->acquire();
+    if (batch.range_values.size() != batch.ranges.size()) {
+        throw std::invalid_argument("Write batch range/value count mismatch");
+    }
+    for (std::size_t i = 0; i < batch.ranges.size(); ++i) {
+        const auto& range = batch.ranges[i];
+        if (range.length == 0 || batch.range_values[i].size() != range.length) {
+            throw std::invalid_argument("Write batch range/value count mismatch");
         }
-        std::string type(data.begin(), data.begin() + 16);
-        info.cpu_type = rtrimSpaces(type);
-        info.cpu_code = std::string(data.begin() + 16, data.end());
+        if (range.length > codec::FrameEncoder::maxBatchWritePoints(range.head.type)) {
+            throw std::invalid_argument("Batch write exceeds the per-request point limit");
+        }
+    }
+    if (batch.empty()) {
+        return;
     }
-    return info;
+
+    const SessionConfig& cfg = impl_->effective_config;
+    RandomWriteChunk<ResolvedRandomRequest> all{batch.random, batch.word_values, batch.dword_values,
+                                                batch.lword_values, batch.bit_values};
+    const bool has_random = !all.request.word_devices.empty() || !all.request.dword_devices.empty() ||
+                            !all.request.lword_devices.empty() || !all.request.bit_devices.empty();
+    const auto random_chunks =
+        has_random ? splitRandomWrite(all, codec::FrameEncoder::randomAccessLimits(cfg.series))
+                   : std::vector<RandomWriteChunk<ResolvedRandomRequest>>{};
+
+    for (const auto& range : batch.ranges) {
+        impl_->invalidateCache(range.head, range.length);
+    }
+    for (const auto& device : batch.random.word_devices) {
+        impl_->invalidateCache(device, 1);
+    }
+    for (const auto& device : batch.random.dword_devices) {
+        impl_->invalidateCache(device, 2);
+    }
+    for (const auto& device : batch.random.lword_devices) {
+        impl_->invalidateCache(device, 4);
+    }
+
+    // フレーム番号 i < ranges.size() は一括書き込み、以降はランダム書き込みのチャンク
+    std::vector<std::size_t> frames(batch.ranges.size() + random_chunks.size());
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        frames[i] = i;
+    }
+    impl_->transactChunks(
+        cfg, frames,
+        [&](std::vector<std::uint8_t>& out, std::size_t frame) {
+            if (frame < batch.ranges.size()) {
+                impl_->frame_encoder.makeBatchWriteRequest(out, cfg, batch.ranges[frame], batch.range_values[frame]);
+                return;
+            }
+            const auto& chunk = random_chunks[frame - batch.ranges.size()];
+            impl_->frame_encoder.makeRandomWriteRequest(out, cfg, chunk.request, chunk.word_data, chunk.dword_data,
+                                                        chunk.lword_data, chunk.bit_data);
+        },
+        [&](std::size_t, std::span<const std::uint8_t> frame) {
+            const auto response = impl_->frame_decoder.parseResponse(frame);
+            detail::ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
+        });
+}
+
+void McClient::setCacheEnabled(bool enabled) {
+    // 無効な間の書き込みはキャッシュに反映しないため、有効・無効を切り替えるたびに破棄する
+    std::lock_guard<std::mutex> lock(impl_->cache_mutex);
+    if (impl_->cache_enabled.exchange(enabled) != enabled) {
+        impl_->cache.clear();
+        ++impl_->cache_epoch;
+    }
+}
+
+bool McClient::isCacheEnabled() const noexcept {
+    return impl_->cache_enabled;
+}
+
+void McClient::clearCache() {
+    impl_->resetCache();
+}
+
+std::vector<std::uint16_t> McClient::readWords(const DeviceRange& range, std::chrono::milliseconds max_age) {
+    return impl_->retryRead([&]() -> std::vector<std::uint16_t> {
+        const auto access = impl_->acquire();
+        return impl_->readWordsCached(resolveDevice(range.head), range.length, max_age);
+    });
+}
+
+CpuInfo McClient::readCpuType() {
+    return impl_->retryRead([&]() -> CpuInfo {
+        const auto access = impl_->acquire();
+
+        const SessionConfig& cfg = impl_->effective_config;
+        auto& request = requestBuffer();
+        impl_->frame_encoder.makeSimpleCommand(request, cfg, 0x0101, 0x0000, {}, "");
+        auto frame = impl_->transact(cfg, request);
+        const auto response = impl_->frame_decoder.parseResponse(frame);
+        detail::ensureCompletion(response.completion_code, response.diagnostic_data, cfg.mode);
+
+        CpuInfo info{};
+        const auto data = response.device_data;
+        if (cfg.mode == CommunicationMode::Binary) {
+            if (data.size() < 18) {
+                throw std::runtime_error("CPU type response too short");
+            }
+            std::string type(reinterpret_cast<const char*>(data.data()), 16);
+            info.cpu_type = rtrimSpaces(type);
+            std::uint16_t code_val = static_cast<std::uint16_t>(data[16] | (data[17] << 8));
+            info.cpu_code = hexUpper(code_val, 4);
+        } else {
+            if (data.size() < 20) {
+                throw std::runtime_error("CPU type response too short");
+            }
+            std::string type(data.begin(), data.begin() + 16);
+            info.cpu_type = rtrimSpaces(type);
+            info.cpu_code = std::string(data.begin() + 16, data.end());
+        }
+        return info;
+    });
 }
 
 void McClient::applyRuntimeControl(const RuntimeControl& command) {
-    impl_->ensureConnected();
+    const auto access = impl_->acquire();
 
-    SessionConfig cfg = impl_->makeEffectiveConfig();
+    const SessionConfig& cfg = impl_->effective_config;
     auto mode = cfg.mode;
     std::vector<std::uint8_t> payload_binary;
     std::string payload_ascii;
 
     auto sendCommand = [&](std::uint16_t cmd, std::uint16_t sub) {
-        auto frame = impl_->frame_encoder.makeSimpleCommand(cfg, cmd, sub, payload_binary, payload_ascii);
-        impl_->transport.sendAll(frame);
-        auto resp = impl_->receiveFrame(cfg);
-        auto decoded = impl_->frame_decoder.parseBatchWriteResponse(resp);
-        impl_->ensureCompletion(decoded.completion_code, decoded.diagnostic_data, cfg.mode);
+        auto& frame = requestBuffer();
+        impl_->frame_encoder.makeSimpleCommand(frame, cfg, cmd, sub, payload_binary, payload_ascii);
+        auto resp = impl_->transact(cfg, frame);
+        const auto decoded = impl_->frame_decoder.parseResponse(resp);
+        detail::ensureCompletion(decoded.completion_code, decoded.diagnostic_data, cfg.mode);
     };
 
+    // RUN（デバイスのクリア指定）・ラッチクリア・リセットはデバイスの値を変えるため、キャッシュを破棄する
+    if (command.type == RuntimeCommandType::Run || command.type == RuntimeCommandType::LatchClear ||
+        command.type == RuntimeCommandType::Reset) {
+        impl_->resetCache();
+    }
+
     switch (command.type) {
         case RuntimeCommandType::Run: {
             RuntimeRunOption opt = command.run_option.value_or(RuntimeRunOption{});
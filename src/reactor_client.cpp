@@ -0,0 +1,128 @@
+#include "cpmcprotocol/reactor_client.hpp"
+
+// 利用者のリアクターから駆動する MC クライアント。
+// 要求の送信と応答の対応付けは AsyncSession が行い、ここでは完了通知を完了キューに積む。
+
+#include "async_session.hpp"
+
+#include <deque>
+#include <iterator>
+
+namespace cpmcprotocol {
+
+struct McReactorClient::Impl {
+    detail::AsyncSession session;
+    std::deque<Completion> completions;
+    OperationId next_id = 1;
+
+    // 操作を開始し、完了通知を完了キューに積む。
+    // 引数の不正で開始できなかった場合は識別番号を消費しない。
+    template <typename T, typename Start>
+    OperationId submit(Start start) {
+        const OperationId id = next_id;
+        start([this, id](std::exception_ptr error, T value) {
+            completions.push_back(Completion{id, std::move(error), std::move(value)});
+        });
+        ++next_id;
+        return id;
+    }
+};
+
+McReactorClient::McReactorClient() : impl_(std::make_unique<Impl>()) {}
+
+McReactorClient::~McReactorClient() {
+    disconnect();
+}
+
+void McReactorClient::connect(const SessionConfig& config) {
+    impl_->session.connect(config);
+}
+
+void McReactorClient::disconnect() noexcept {
+    impl_->session.disconnect();
+}
+
+bool McReactorClient::isConnected() const noexcept {
+    return impl_->session.transport().isConnected();
+}
+
+std::size_t McReactorClient::pendingCount() const noexcept {
+    return impl_->session.pendingCount();
+}
+
+NativeSocket McReactorClient::nativeHandle() const noexcept {
+    return impl_->session.transport().nativeHandle();
+}
+
+bool McReactorClient::wantsWrite() const noexcept {
+    return impl_->session.transport().wantsWrite();
+}
+
+void McReactorClient::processReadable() {
+    impl_->session.transport().processReadable();
+}
+
+void McReactorClient::processWritable() {
+    impl_->session.transport().processWritable();
+}
+
+void McReactorClient::processTimeouts() {
+    impl_->session.transport().processTimeouts();
+}
+
+std::optional<std::chrono::steady_clock::time_point> McReactorClient::nextDeadline() const {
+    return impl_->session.transport().nextDeadline();
+}
+
+std::size_t McReactorClient::pollCompletions(std::vector<Completion>& out) {
+    const std::size_t count = impl_->completions.size();
+    out.insert(out.end(), std::make_move_iterator(impl_->completions.begin()),
+               std::make_move_iterator(impl_->completions.end()));
+    impl_->completions.clear();
+    return count;
+}
+
+std::size_t McReactorClient::completionCount() const noexcept {
+    return impl_->completions.size();
+}
+
+McReactorClient::OperationId McReactorClient::readWords(const DeviceRange& range) {
+    return readWordArea(range.head, range.length);
+}
+
+McReactorClient::OperationId McReactorClient::readWordArea(const DeviceAddress& head, std::size_t count) {
+    return impl_->submit<std::vector<std::uint16_t>>(
+        [&](auto callback) { impl_->session.readWordArea(head, count, std::move(callback)); });
+}
+
+McReactorClient::OperationId McReactorClient::readBits(const DeviceRange& range) {
+    return readBitArea(range.head, range.length);
+}
+
+McReactorClient::OperationId McReactorClient::readBitArea(const DeviceAddress& head, std::size_t count) {
+    return impl_->submit<std::vector<bool>>(
+        [&](auto callback) { impl_->session.readBitArea(head, count, std::move(callback)); });
+}
+
+McReactorClient::OperationId McReactorClient::writeWords(const DeviceRange& range,
+                                                         const std::vector<std::uint16_t>& values) {
+    return impl_->submit<std::monostate>(
+        [&](auto callback) { impl_->session.writeWords(range, values, std::move(callback)); });
+}
+
+McReactorClient::OperationId McReactorClient::writeBits(const DeviceRange& range, const std::vector<bool>& values) {
+    return impl_->submit<std::monostate>(
+        [&](auto callback) { impl_->session.writeBits(range, values, std::move(callback)); });
+}
+
+McReactorClient::OperationId McReactorClient::randomRead(const DeviceReadPlan& plan) {
+    return impl_->submit<std::vector<DeviceValue>>(
+        [&](auto callback) { impl_->session.randomRead(plan, std::move(callback)); });
+}
+
+McReactorClient::OperationId McReactorClient::randomRead(const ResolvedReadPlan& plan) {
+    return impl_->submit<std::vector<DeviceValue>>(
+        [&](auto callback) { impl_->session.randomRead(plan, std::move(callback)); });
+}
+
+} // namespace cpmcprotocol
@@ -0,0 +1,362 @@
+#include "cpmcprotocol/read_optimizer.hpp"
+
+// 読み取りプランを一括・複数ブロック・ランダム読み出しのフレームに振り分ける。
+
+#include "cpmcprotocol/codec/device_code_map.hpp"
+#include "cpmcprotocol/codec/frame_encoder.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+namespace cpmcprotocol {
+
+namespace {
+
+using codec::FrameEncoder;
+
+// ランダム読み出しで読める値の種別（要求内ではこの順に並ぶ）。
+enum class RandomKind : std::uint8_t { Word, Dword, Lword, Bit };
+
+std::optional<RandomKind> randomKindOf(const ValueFormat& format) {
+    switch (format.type) {
+        case ValueType::Int16:
+        case ValueType::UInt16:
+            return RandomKind::Word;
+        case ValueType::RawWords:
+            return format.parameter == 1 ? std::optional(RandomKind::Word) : std::nullopt;
+        case ValueType::Int32:
+        case ValueType::UInt32:
+        case ValueType::Float32:
+            return RandomKind::Dword;
+        case ValueType::Int64:
+        case ValueType::UInt64:
+        case ValueType::Float64:
+            return RandomKind::Lword;
+        case ValueType::BitArray:
+            return format.parameter == 1 ? std::optional(RandomKind::Bit) : std::nullopt;
+        case ValueType::AsciiString:
+            break;
+    }
+    return std::nullopt;
+}
+
+std::size_t randomWords(RandomKind kind) {
+    switch (kind) {
+        case RandomKind::Dword:
+            return 2;
+        case RandomKind::Lword:
+            return 4;
+        case RandomKind::Word:
+        case RandomKind::Bit:
+            break;
+    }
+    return 1;
+}
+
+// 範囲にまとめる単位。位置はワード単位で、ビットデバイスはデバイス番号 / 16 をワード位置とする。
+struct Interval {
+    std::size_t entry = 0;
+    bool bit_domain = false;
+    std::uint32_t start = 0;
+    std::uint32_t end = 0;
+};
+
+struct Range {
+    ResolvedDevice head;
+    bool bit_domain = false;
+    std::uint32_t start = 0;
+    std::uint32_t end = 0;
+    std::vector<const Interval*> members;
+};
+
+struct Layout {
+    std::vector<OptimizedReadFrame> frames;
+    std::vector<std::size_t> word_offsets;
+    std::vector<std::uint8_t> bit_offsets;
+    std::size_t total_words = 0;
+    std::size_t bytes = 0;  // 要求のデバイス指定と応答データのバイト数（比較用の概算）
+};
+
+class Optimizer {
+public:
+    Optimizer(const ResolvedReadPlan& plan, PlcSeries series) : plan_(plan), series_(series) {}
+
+    OptimizedReadPlan run() {
+        classify();
+        mergeRanges();
+
+        // 単独の 1〜4 ワード値を範囲として読む案とランダム読み出しに回す案を比較する
+        Layout all_blocks = layout(false);
+        Layout with_random = layout(true);
+        Layout& best = (std::make_pair(with_random.frames.size(), with_random.bytes) <
+                        std::make_pair(all_blocks.frames.size(), all_blocks.bytes))
+                           ? with_random
+                           : all_blocks;
+
+        OptimizedReadPlan result;
+        result.series = series_;
+        result.entries = plan_;
+        result.frames = std::move(best.frames);
+        result.word_offsets = std::move(best.word_offsets);
+        result.bit_offsets = std::move(best.bit_offsets);
+        result.total_words = best.total_words;
+        return result;
+    }
+
+private:
+    // デバイス指定 1 つのバイト数（番号 + コード）。DeviceCodeMap がシリーズ非対応のデバイスを弾く。
+    std::size_t specBytes(const ResolvedDevice& device) const {
+        const auto info = map_.resolveBinary(series_, device);
+        return info.code_width + info.number_width;
+    }
+
+    void classify() {
+        for (std::size_t i = 0; i < plan_.size(); ++i) {
+            const auto& entry = plan_[i];
+            const std::uint64_t words = ValueCodec::requiredWords(entry.format);
+            specBytes(entry.address);
+
+            const std::uint64_t number = entry.address.number;
+            const bool bit_format = entry.format.type == ValueType::BitArray;
+            Interval interval{i, false, 0, 0};
+            std::uint64_t end = 0;
+            if (entry.address.type == DeviceType::Bit) {
+                interval.bit_domain = true;
+                interval.start = static_cast<std::uint32_t>(number / 16);
+                if (bit_format) {
+                    end = (number + entry.format.parameter - 1) / 16 + 1;
+                } else if (number % 16 == 0) {
+                    end = interval.start + words;
+                } else if (randomKindOf(entry.format)) {
+                    random_only_.push_back(i);
+                    continue;
+                } else {
+                    throw std::invalid_argument("Word formats on bit devices must start at a multiple of 16");
+                }
+            } else {
+                if (bit_format) {
+                    throw std::invalid_argument("BitArray format requires a bit device");
+                }
+                interval.start = static_cast<std::uint32_t>(number);
+                end = number + words;
+            }
+            if (end > std::numeric_limits<std::uint32_t>::max()) {
+                throw std::invalid_argument("Read plan entry exceeds the device number space");
+            }
+            interval.end = static_cast<std::uint32_t>(end);
+            intervals_.push_back(interval);
+        }
+    }
+
+    // 同じデバイス種別の区間を番号順に並べ、間のワードを読む方がブロックを増やすより安ければ連結する。
+    void mergeRanges() {
+        auto key = [this](const Interval& interval) {
+            return std::make_tuple(interval.bit_domain, plan_[interval.entry].address.kind, interval.start, interval.end);
+        };
+        std::sort(intervals_.begin(), intervals_.end(),
+                  [&](const Interval& lhs, const Interval& rhs) { return key(lhs) < key(rhs); });
+
+        for (const auto& interval : intervals_) {
+            const auto& device = plan_[interval.entry].address;
+            if (!ranges_.empty()) {
+                auto& last = ranges_.back();
+                // ブロック 1 つ分のデバイス指定（番号 + コード + 点数）をワードに換算した長さまでの隙間は読む
+                const std::size_t gap_words = (specBytes(device) + 2) / 2;
+                if (last.bit_domain == interval.bit_domain && last.head.kind == device.kind &&
+                    interval.start <= static_cast<std::uint64_t>(last.end) + gap_words) {
+                    last.end = std::max(last.end, interval.end);
+                    last.members.push_back(&interval);
+                    continue;
+                }
+            }
+
+            Range range;
+            range.head = device;
+            range.head.type = DeviceType::Word;
+            range.head.number = interval.bit_domain ? interval.start * 16 : interval.start;
+            range.bit_domain = interval.bit_domain;
+            range.start = interval.start;
+            range.end = interval.end;
+            range.members.push_back(&interval);
+            ranges_.push_back(std::move(range));
+        }
+    }
+
+    Layout layout(bool use_random) const {
+        Layout out;
+        out.word_offsets.resize(plan_.size());
+        out.bit_offsets.resize(plan_.size());
+
+        std::vector<std::size_t> randoms = random_only_;
+        std::size_t cursor = 0;
+        std::size_t used = 0;
+        bool block_frame_open = false;
+        for (const auto& range : ranges_) {
+            if (use_random && range.members.size() == 1 && randomKindOf(plan_[range.members.front()->entry].format)) {
+                randoms.push_back(range.members.front()->entry);
+                continue;
+            }
+
+            for (const auto* member : range.members) {
+                const auto& entry = plan_[member->entry];
+                out.word_offsets[member->entry] = cursor + (member->start - range.start);
+                if (entry.format.type == ValueType::BitArray) {
+                    out.bit_offsets[member->entry] = static_cast<std::uint8_t>(entry.address.number % 16);
+                }
+            }
+
+            // 上限に達したらフレームを切り替え、範囲の途中でも分割する（応答ワードは連結後も連続する）
+            const std::size_t spec = specBytes(range.head) + 2;
+            const std::uint32_t stride = range.bit_domain ? 16 : 1;
+            const std::size_t length = range.end - range.start;
+            std::size_t offset = 0;
+            while (offset < length) {
+                if (!block_frame_open || used == FrameEncoder::kMaxMultiBlockPoints ||
+                    blockCount(out.frames.back()) == FrameEncoder::kMaxMultiBlocks) {
+                    out.frames.emplace_back();
+                    out.frames.back().kind = OptimizedReadFrame::Kind::MultiBlock;
+                    out.frames.back().word_offset = cursor;
+                    block_frame_open = true;
+                    used = 0;
+                }
+                auto& frame = out.frames.back();
+                const std::size_t take = std::min(length - offset, FrameEncoder::kMaxMultiBlockPoints - used);
+                ResolvedRange piece{range.head, static_cast<std::uint16_t>(take)};
+                piece.head.number += static_cast<std::uint32_t>(offset) * stride;
+                (range.bit_domain ? frame.blocks.bit_blocks : frame.blocks.word_blocks).push_back(piece);
+                frame.word_count += take;
+                used += take;
+                cursor += take;
+                offset += take;
+                out.bytes += spec + take * 2;
+            }
+        }
+
+        // 1 ブロックだけのフレームは一括読み出しにする（ブロック数の指定が不要な分だけ短い）
+        for (auto& frame : out.frames) {
+            if (blockCount(frame) == 1) {
+                frame.kind = OptimizedReadFrame::Kind::Batch;
+                if (frame.blocks.word_blocks.empty()) {
+                    frame.blocks.word_blocks = std::move(frame.blocks.bit_blocks);
+                    frame.blocks.bit_blocks.clear();
+                }
+            }
+        }
+
+        layoutRandom(out, randoms, cursor);
+        return out;
+    }
+
+    static std::size_t blockCount(const OptimizedReadFrame& frame) {
+        return frame.blocks.word_blocks.size() + frame.blocks.bit_blocks.size();
+    }
+
+    // ランダム読み出しを種別順に点数上限まで詰める。フレーム内の応答は種別順に並ぶ。
+    void layoutRandom(Layout& out, std::vector<std::size_t>& randoms, std::size_t cursor) const {
+        std::stable_sort(randoms.begin(), randoms.end(), [this](std::size_t lhs, std::size_t rhs) {
+            return *randomKindOf(plan_[lhs].format) < *randomKindOf(plan_[rhs].format);
+        });
+
+        const std::size_t limit = FrameEncoder::randomAccessLimits(series_).read_points;
+        std::size_t points = 0;
+        bool random_frame_open = false;
+        for (const std::size_t index : randoms) {
+            const auto& entry = plan_[index];
+            const RandomKind kind = *randomKindOf(entry.format);
+            const std::size_t cost = (kind == RandomKind::Lword) ? 2 : 1;
+            if (!random_frame_open || points + cost > limit) {
+                out.frames.emplace_back();
+                out.frames.back().kind = OptimizedReadFrame::Kind::Random;
+                out.frames.back().word_offset = cursor;
+                random_frame_open = true;
+                points = 0;
+            }
+            auto& frame = out.frames.back();
+            switch (kind) {
+                case RandomKind::Word:
+                    frame.random.word_devices.push_back(entry.address);
+                    break;
+                case RandomKind::Dword:
+                    frame.random.dword_devices.push_back(entry.address);
+                    break;
+                case RandomKind::Lword:
+                    frame.random.lword_devices.push_back(entry.address);
+                    break;
+                case RandomKind::Bit:
+                    frame.random.bit_devices.push_back(entry.address);
+                    break;
+            }
+            const std::size_t words = randomWords(kind);
+            out.word_offsets[index] = cursor;
+            out.bit_offsets[index] = 0;
+            frame.word_count += words;
+            cursor += words;
+            points += cost;
+            out.bytes += specBytes(entry.address) + words * 2;
+        }
+        out.total_words = cursor;
+    }
+
+    const ResolvedReadPlan& plan_;
+    PlcSeries series_;
+    codec::DeviceCodeMap map_;
+    std::vector<Interval> intervals_;
+    std::vector<Range> ranges_;
+    std::vector<std::size_t> random_only_;
+};
+
+} // namespace
+
+OptimizedReadPlan optimizeReadPlan(const DeviceReadPlan& plan, PlcSeries series) {
+    return optimizeReadPlan(resolveReadPlan(plan), series);
+}
+
+OptimizedReadPlan optimizeReadPlan(const ResolvedReadPlan& plan, PlcSeries series) {
+    return Optimizer(plan, series).run();
+}
+
+std::vector<DeviceValue> decodeOptimizedRead(const OptimizedReadPlan& plan, const std::vector<std::uint16_t>& words) {
+    if (words.size() < plan.total_words) {
+        throw std::invalid_argument("Insufficient word data for decode");
+    }
+
+    std::vector<DeviceValue> values(plan.entries.size());
+
+    // ワード系の値は元の順に並べ直して一度にデコードする
+    ResolvedReadPlan word_plan;
+    std::vector<std::size_t> word_indices;
+    std::vector<std::uint16_t> gathered;
+    for (std::size_t i = 0; i < plan.entries.size(); ++i) {
+        const auto& entry = plan.entries[i];
+        const std::size_t offset = plan.word_offsets[i];
+        if (entry.format.type == ValueType::BitArray) {
+            std::vector<bool> bits(entry.format.parameter);
+            for (std::size_t k = 0; k < bits.size(); ++k) {
+                const std::size_t position = plan.bit_offsets[i] + k;
+                bits[k] = ((words[offset + position / 16] >> (position % 16)) & 0x1) != 0;
+            }
+            values[i] = std::move(bits);
+            continue;
+        }
+
+        const std::size_t required = ValueCodec::requiredWords(entry.format);
+        word_plan.push_back(entry);
+        word_indices.push_back(i);
+        gathered.insert(gathered.end(), words.begin() + static_cast<std::ptrdiff_t>(offset),
+                        words.begin() + static_cast<std::ptrdiff_t>(offset + required));
+    }
+
+    if (!word_plan.empty()) {
+        auto decoded = ValueCodec{}.decode(word_plan, gathered);
+        for (std::size_t k = 0; k < decoded.size(); ++k) {
+            values[word_indices[k]] = std::move(decoded[k]);
+        }
+    }
+    return values;
+}
+
+} // namespace cpmcprotocol
@@ -0,0 +1,183 @@
+#include "request_dispatcher.hpp"
+
+#include "cpmcprotocol/transport.hpp"
+#include "cpmcprotocol/codec/frame_decoder.hpp"
+#include "cpmcprotocol/codec/frame_encoder.hpp"
+
+#include <algorithm>
+
+namespace cpmcprotocol::detail {
+
+RequestDispatcher::RequestDispatcher(TcpTransport& transport, const codec::FrameDecoder& decoder)
+    : transport_(transport), decoder_(decoder) {}
+
+void RequestDispatcher::transact(const SessionConfig& cfg,
+                                 std::span<std::vector<std::uint8_t>> requests,
+                                 const ResponseHandler& on_response) {
+    if (requests.empty()) {
+        return;
+    }
+
+    Job job;
+    job.requests = requests;
+    job.on_response = &on_response;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    jobs_.push_back(&job);
+    while (!job.done) {
+        if (!leading_) {
+            leading_ = true;
+            lead(cfg, job, lock);
+        } else {
+            // リーダーが要求を完了させるか、リーダーを引き継ぐまで待つ
+            job.cv.wait(lock);
+        }
+    }
+    lock.unlock();
+
+    if (job.error) {
+        std::rethrow_exception(job.error);
+    }
+}
+
+void RequestDispatcher::lead(const SessionConfig& cfg, Job& own, std::unique_lock<std::mutex>& lock) {
+    const bool use_serial = cfg.frame_type == FrameType::Frame4E;
+    // 3E フレームはシリアル番号を持たず応答を対応付けられないため、1 件ずつ往復する
+    const std::size_t window = use_serial ? std::max<std::size_t>(1, cfg.max_in_flight) : 1;
+    const auto mode = cfg.mode;
+    const auto type = cfg.frame_type;
+
+    while (!own.done) {
+        sending_.clear();
+        while (in_flight_.size() < window) {
+            Job* job = nextSendable();
+            if (job == nullptr) {
+                break;
+            }
+            in_flight_.push_back(InFlight{next_serial_++, job, job->next++});
+            ++job->outstanding;
+            sending_.push_back(in_flight_.back());
+        }
+        lock.unlock();
+
+        // 送受信はロックの外で行う（その間も他のスレッドは要求を追加できる）。
+        // 受信したフレームはトランスポートの受信バッファを指し、次の受信まで有効。
+        std::span<const std::uint8_t> frame;
+        std::exception_ptr failure;
+        try {
+            // 窓に空きができた分の要求は 1 回のシステムコールでまとめて送る
+            frames_.clear();
+            for (const auto& entry : sending_) {
+                auto& request = entry.job->requests[entry.index];
+                if (use_serial) {
+                    codec::FrameEncoder::setSerialNumber(request, entry.serial);
+                }
+                frames_.emplace_back(request);
+            }
+            if (!frames_.empty()) {
+                transport_.sendAll(frames_);
+            }
+            frame = transport_.receiveFrameView(
+                codec::FrameDecoder::headerSize(mode, type),
+                [mode, type](const std::uint8_t* header, std::size_t) {
+                    return codec::FrameDecoder::bodyLength(header, mode, type);
+                });
+        } catch (...) {
+            failure = std::current_exception();
+            if (!transport_.isConnected()) {
+                link_lost_.store(true, std::memory_order_release);
+            }
+        }
+
+        lock.lock();
+        if (failure) {
+            failInFlight(failure, own);
+            continue;
+        }
+
+        auto it = in_flight_.begin();
+        if (use_serial) {
+            const auto serial = decoder_.parseSerialNumber(frame);
+            it = std::find_if(in_flight_.begin(), in_flight_.end(),
+                              [&](const InFlight& pending) { return serial == pending.serial; });
+        }
+        if (it == in_flight_.end()) {
+            continue; // 以前の要求に対する遅延応答は読み捨てる
+        }
+        const InFlight entry = *it;
+        in_flight_.erase(it);
+
+        Job& job = *entry.job;
+        if (!job.error) {
+            // 要求元のスレッドは完了を待っているため、結果の格納先にはロックの外から書き込める
+            std::exception_ptr error;
+            lock.unlock();
+            try {
+                (*job.on_response)(entry.index, frame);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            lock.lock();
+            job.error = error;
+        }
+        --job.outstanding;
+        complete(job, own);
+    }
+
+    // 自分の要求が完了したら、待機中の要求のスレッドにリーダーを引き継ぐ
+    leading_ = false;
+    if (!jobs_.empty()) {
+        jobs_.front()->cv.notify_one();
+    }
+}
+
+RequestDispatcher::Job* RequestDispatcher::nextSendable() {
+    // 1 つの要求が大量のフレームを持っていても、他の要求が 1 フレームずつ割り込めるように巡回する
+    for (std::size_t n = 0; n < jobs_.size(); ++n) {
+        const std::size_t position = (cursor_ + n) % jobs_.size();
+        Job* job = jobs_[position];
+        if (!job->error && job->next < job->requests.size()) {
+            cursor_ = (position + 1) % jobs_.size();
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void RequestDispatcher::complete(Job& job, const Job& own) {
+    if (job.outstanding > 0 || (!job.error && job.next < job.requests.size())) {
+        return;
+    }
+    job.done = true;
+    const auto it = std::find(jobs_.begin(), jobs_.end(), &job);
+    const auto position = static_cast<std::size_t>(it - jobs_.begin());
+    jobs_.erase(it);
+    if (position < cursor_) {
+        --cursor_;
+    }
+    if (cursor_ >= jobs_.size()) {
+        cursor_ = 0;
+    }
+    // 要求元はロックを取り直すまで戻らないため、通知後も解放するまでは job に触れてよい
+    if (&job != &own) {
+        job.cv.notify_one();
+    }
+}
+
+void RequestDispatcher::failInFlight(std::exception_ptr error, const Job& own) {
+    // 応答待ちの要求はどれに対する失敗か区別できないため、すべて失敗させる
+    for (const auto& entry : in_flight_) {
+        if (!entry.job->error) {
+            entry.job->error = error;
+        }
+        --entry.job->outstanding;
+    }
+    for (const auto& entry : in_flight_) {
+        if (!entry.job->done) {
+            complete(*entry.job, own);
+        }
+    }
+    in_flight_.clear();
+}
+
+} // namespace cpmcprotocol::detail
@@ -0,0 +1,94 @@
+#pragma once
+
+// McClient の要求ディスパッチャ。複数スレッドからの要求を 1 本の接続に多重化する。
+// 専用のスレッドは持たず、要求を出したスレッドのうち 1 つ（リーダー）が送受信を行う。
+// リーダーは待機中の要求からラウンドロビンで 1 フレームずつ送信し（4E フレームでは max_in_flight 件まで
+// 応答を待たずに送信してシリアル番号で対応付け、3E フレームでは 1 件ずつ往復する）、
+// 自分の要求が完了すると待機中のスレッドにリーダーを引き継ぐ。
+// McClient の内部でのみ使用し、公開ヘッダーからは参照しない。
+
+#include "cpmcprotocol/session_config.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace cpmcprotocol {
+
+class TcpTransport;
+
+namespace codec {
+class FrameDecoder;
+}
+
+namespace detail {
+
+class RequestDispatcher {
+public:
+    /// 応答フレームの通知（要求インデックス, フレーム）。フレームは呼び出しの間だけ有効
+    using ResponseHandler = std::function<void(std::size_t, std::span<const std::uint8_t>)>;
+
+    RequestDispatcher(TcpTransport& transport, const codec::FrameDecoder& decoder);
+
+    RequestDispatcher(const RequestDispatcher&) = delete;
+    RequestDispatcher& operator=(const RequestDispatcher&) = delete;
+
+    /// 要求フレームを送信し、応答を受信するたびに on_response を呼ぶ（通知順は到着順）
+    /// on_response は送受信を行うスレッド（他の要求のスレッドの場合もある）で呼ばれる。
+    /// 4E フレームではシリアル番号を書き換える。呼び出しは全応答の受信（または失敗）まで戻らない。
+    /// on_response の例外は残りの要求を送信せずに呼び出し元へ送出する（送信済みの応答は読み捨てる）。
+    /// 通信エラーは応答待ちだったすべての要求に送出する。
+    void transact(const SessionConfig& cfg,
+                  std::span<std::vector<std::uint8_t>> requests,
+                  const ResponseHandler& on_response);
+
+    /// 送受信中に接続が切れた場合 true（reset() まで保持する）
+    bool linkLost() const noexcept { return link_lost_.load(std::memory_order_acquire); }
+
+    /// 再接続時に呼ぶ（要求の処理中に呼ばないこと）
+    void reset() noexcept { link_lost_.store(false, std::memory_order_release); }
+
+private:
+    struct Job {
+        std::span<std::vector<std::uint8_t>> requests;
+        const ResponseHandler* on_response = nullptr;
+        std::size_t next = 0;         // 次に送信する要求
+        std::size_t outstanding = 0;  // 送信済みで応答待ちの要求数
+        bool done = false;
+        std::exception_ptr error;
+        std::condition_variable cv;
+    };
+
+    struct InFlight {
+        std::uint16_t serial = 0;
+        Job* job = nullptr;
+        std::size_t index = 0;
+    };
+
+    void lead(const SessionConfig& cfg, Job& own, std::unique_lock<std::mutex>& lock);
+    Job* nextSendable();
+    void complete(Job& job, const Job& own);
+    void failInFlight(std::exception_ptr error, const Job& own);
+
+    TcpTransport& transport_;
+    const codec::FrameDecoder& decoder_;
+
+    std::mutex mutex_;
+    std::vector<Job*> jobs_;          // 完了していない要求（到着順）
+    std::size_t cursor_ = 0;          // 次に送信する jobs_ の位置（ラウンドロビン）
+    std::vector<InFlight> in_flight_;
+    std::vector<InFlight> sending_;   // リーダーが送信する分（容量を使い回す）
+    std::vector<std::span<const std::uint8_t>> frames_; // sending_ の要求フレーム（1 回のギャザー送信で渡す）
+    std::uint16_t next_serial_ = 0;
+    bool leading_ = false;
+    std::atomic<bool> link_lost_{false};
+};
+
+} // namespace detail
+} // namespace cpmcprotocol
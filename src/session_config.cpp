@@ -60,6 +60,11 @@ std::vector<std::string> SessionConfig::getValidationErrors() const {
         errors.push_back(oss.str());
     }
 
+    // Pipelining validation
+    if (max_in_flight == 0) {
+        errors.push_back("max_in_flight must be at least 1");
+    }
+
     return errors;
 }
 
@@ -0,0 +1,101 @@
+#include "shadow_cache.hpp"
+
+#include <algorithm>
+
+namespace cpmcprotocol::detail {
+
+ShadowCache::Clock::time_point ShadowCache::oldestAllowed(Clock::time_point now, std::chrono::milliseconds max_age) {
+    if (max_age.count() <= 0) {
+        return Clock::time_point::max();
+    }
+    if (max_age >= now.time_since_epoch()) {
+        // 未取得・無効化したワードの時刻（time_point::min()）は常に古いとみなす
+        return Clock::time_point::min() + Clock::duration{1};
+    }
+    return now - max_age;
+}
+
+std::vector<ShadowCache::Run> ShadowCache::staleRuns(std::uint8_t kind,
+                                                     std::uint32_t number,
+                                                     std::size_t count,
+                                                     Clock::time_point oldest) const {
+    std::vector<Run> runs;
+    auto mark_stale = [&runs](std::uint64_t word, std::size_t length) {
+        if (!runs.empty() && static_cast<std::uint64_t>(runs.back().number) + runs.back().length == word) {
+            runs.back().length += length;
+        } else {
+            runs.push_back(Run{static_cast<std::uint32_t>(word), length});
+        }
+    };
+
+    std::uint64_t word = number;
+    const std::uint64_t end = word + count;
+    while (word < end) {
+        const std::size_t in_page = static_cast<std::size_t>(word % kPageWords);
+        const std::size_t span = std::min<std::uint64_t>(kPageWords - in_page, end - word);
+        const auto it = pages_.find(pageKey(kind, word));
+        if (it == pages_.end()) {
+            mark_stale(word, span);
+        } else {
+            for (std::size_t i = 0; i < span; ++i) {
+                if (it->second.stamps[in_page + i] < oldest) {
+                    mark_stale(word + i, 1);
+                }
+            }
+        }
+        word += span;
+    }
+    return runs;
+}
+
+void ShadowCache::store(std::uint8_t kind,
+                        std::uint32_t number,
+                        const std::uint16_t* words,
+                        std::size_t count,
+                        Clock::time_point stamp) {
+    std::uint64_t word = number;
+    const std::uint64_t end = word + count;
+    while (word < end) {
+        const std::size_t in_page = static_cast<std::size_t>(word % kPageWords);
+        const std::size_t span = std::min<std::uint64_t>(kPageWords - in_page, end - word);
+        auto& page = pages_[pageKey(kind, word)];
+        std::copy_n(words, span, page.values.begin() + static_cast<std::ptrdiff_t>(in_page));
+        std::fill_n(page.stamps.begin() + static_cast<std::ptrdiff_t>(in_page), span, stamp);
+        words += span;
+        word += span;
+    }
+}
+
+void ShadowCache::load(std::uint8_t kind, std::uint32_t number, std::size_t count, std::uint16_t* out) const {
+    std::uint64_t word = number;
+    const std::uint64_t end = word + count;
+    while (word < end) {
+        const std::size_t in_page = static_cast<std::size_t>(word % kPageWords);
+        const std::size_t span = std::min<std::uint64_t>(kPageWords - in_page, end - word);
+        const auto it = pages_.find(pageKey(kind, word));
+        if (it == pages_.end()) {
+            std::fill_n(out, span, std::uint16_t{0});
+        } else {
+            std::copy_n(it->second.values.begin() + static_cast<std::ptrdiff_t>(in_page), span, out);
+        }
+        out += span;
+        word += span;
+    }
+}
+
+void ShadowCache::invalidate(std::uint8_t kind, std::uint32_t number, std::size_t count) {
+    std::uint64_t word = number;
+    const std::uint64_t end = word + count;
+    while (word < end) {
+        const std::size_t in_page = static_cast<std::size_t>(word % kPageWords);
+        const std::size_t span = std::min<std::uint64_t>(kPageWords - in_page, end - word);
+        const auto it = pages_.find(pageKey(kind, word));
+        if (it != pages_.end()) {
+            std::fill_n(it->second.stamps.begin() + static_cast<std::ptrdiff_t>(in_page), span,
+                        Clock::time_point::min());
+        }
+        word += span;
+    }
+}
+
+} // namespace cpmcprotocol::detail
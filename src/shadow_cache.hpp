@@ -0,0 +1,73 @@
+#pragma once
+
+// McClient のシャドウキャッシュ（PLC のワードデバイスの写し）。
+// デバイス種別とワード位置ごとに値と取得時刻を保持し、許容する古さより新しい部分だけを読み取りに使う。
+// McClient の内部でのみ使用し、公開ヘッダーからは参照しない。
+
+#include "cpmcprotocol/device.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace cpmcprotocol::detail {
+
+class ShadowCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// 連続したワードの区間（先頭デバイス番号とワード数）
+    struct Run {
+        std::uint32_t number = 0;
+        std::size_t length = 0;
+    };
+
+    /// キャッシュの対象になるデバイス（ワード単位で番号を振るワードデバイス）
+    /// ダブルワードデバイスは番号が 32bit 単位のため、ワード位置で管理するキャッシュの対象外とする
+    static bool cacheable(const ResolvedDevice& device) noexcept { return device.type == DeviceType::Word; }
+
+    /// now から max_age 以内に取得したデータだけを新しいとみなす基準時刻
+    static Clock::time_point oldestAllowed(Clock::time_point now, std::chrono::milliseconds max_age);
+
+    /// [number, number + count) のうち、oldest より前に取得した、または未取得の区間を返す
+    std::vector<Run> staleRuns(std::uint8_t kind,
+                               std::uint32_t number,
+                               std::size_t count,
+                               Clock::time_point oldest) const;
+
+    /// 値を取得時刻とともに格納する
+    void store(std::uint8_t kind,
+               std::uint32_t number,
+               const std::uint16_t* words,
+               std::size_t count,
+               Clock::time_point stamp);
+
+    /// 格納済みの値を out に読み出す（未取得のワードは 0）
+    void load(std::uint8_t kind, std::uint32_t number, std::size_t count, std::uint16_t* out) const;
+
+    /// 区間を未取得に戻す
+    void invalidate(std::uint8_t kind, std::uint32_t number, std::size_t count);
+
+    void clear() noexcept { pages_.clear(); }
+
+private:
+    static constexpr std::size_t kPageWords = 64;
+
+    struct Page {
+        std::array<std::uint16_t, kPageWords> values{};
+        std::array<Clock::time_point, kPageWords> stamps;
+
+        Page() { stamps.fill(Clock::time_point::min()); }
+    };
+
+    static std::uint64_t pageKey(std::uint8_t kind, std::uint64_t word) noexcept {
+        return (static_cast<std::uint64_t>(kind) << 32) | (word / kPageWords);
+    }
+
+    std::unordered_map<std::uint64_t, Page> pages_;
+};
+
+} // namespace cpmcprotocol::detail
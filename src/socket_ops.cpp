@@ -0,0 +1,644 @@
+#include "socket_ops.hpp"
+
+#include "cpmcprotocol/transport.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <fcntl.h>
+#include <poll.h>
+#endif
+
+namespace cpmcprotocol::detail {
+
+#ifdef _WIN32
+// Windows ソケット API 周りの薄いラッパ。POSIX と共通の呼び出し口を保つ。
+
+int lastSocketError() {
+    return WSAGetLastError();
+}
+
+std::string lastSocketErrorMessage(int code) {
+    if (code == 0) {
+        code = WSAGetLastError();
+    }
+    LPSTR buffer = nullptr;
+    const DWORD flags = FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM |
+                        FORMAT_MESSAGE_IGNORE_INSERTS;
+    const DWORD lang = MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT);
+    const DWORD result = FormatMessageA(flags, nullptr, static_cast<DWORD>(code), lang,
+                                        reinterpret_cast<LPSTR>(&buffer), 0, nullptr);
+    std::string message;
+    if (result == 0) {
+        message = "Unknown WSA error " + std::to_string(code);
+    } else {
+        message.assign(buffer, buffer + result);
+    }
+    if (buffer) {
+        LocalFree(buffer);
+    }
+    return "WSA error " + std::to_string(code) + ": " + message;
+}
+
+std::string addrInfoErrorMessage(int code) {
+    const char* msg = ::gai_strerrorA(code);
+    if (msg == nullptr) {
+        return std::string("getaddrinfo failed with code ") + std::to_string(code);
+    }
+    return std::string(msg);
+}
+
+void closeSocket(SocketHandle socket) {
+    if (socket != kInvalidSocket) {
+        closesocket(socket);
+    }
+}
+
+void ensureWinsock() {
+    static std::once_flag once;
+    std::call_once(once, []() {
+        WSADATA data{};
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+            throw TransportError("WSAStartup failed");
+        }
+    });
+}
+
+bool isTimeoutError(int code) {
+    return code == WSAEWOULDBLOCK || code == WSAETIMEDOUT;
+}
+
+bool isInterrupted(int code) {
+    return code == WSAEINTR;
+}
+
+bool isWouldBlock(int code) {
+    return code == WSAEWOULDBLOCK;
+}
+
+void setNonBlocking(SocketHandle socket, bool enabled) {
+    u_long mode = enabled ? 1 : 0;
+    if (::ioctlsocket(socket, FIONBIO, &mode) != 0) {
+        throw TransportError(lastSocketErrorMessage(0));
+    }
+}
+
+#else
+
+int lastSocketError() {
+    return errno;
+}
+
+// POSIX 系の errno を文字列に変換するユーティリティ。
+std::string lastSocketErrorMessage(int code) {
+    if (code == 0) {
+        code = errno;
+    }
+    return std::string(std::strerror(code));
+}
+
+std::string addrInfoErrorMessage(int code) {
+    return gai_strerror(code);
+}
+
+void closeSocket(SocketHandle socket) {
+    if (socket != kInvalidSocket) {
+        ::close(socket);
+    }
+}
+
+void ensureWinsock() {
+    // No-op on POSIX systems.
+}
+
+bool isTimeoutError(int code) {
+    return code == EWOULDBLOCK || code == EAGAIN || code == ETIMEDOUT;
+}
+
+bool isInterrupted(int code) {
+    return code == EINTR;
+}
+
+bool isWouldBlock(int code) {
+    return code == EWOULDBLOCK || code == EAGAIN;
+}
+
+void setNonBlocking(SocketHandle socket, bool enabled) {
+    const int flags = ::fcntl(socket, F_GETFL, 0);
+    if (flags < 0) {
+        throw TransportError(lastSocketErrorMessage(errno));
+    }
+    const int updated = enabled ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    if (::fcntl(socket, F_SETFL, updated) < 0) {
+        throw TransportError(lastSocketErrorMessage(errno));
+    }
+}
+
+#endif
+
+std::chrono::milliseconds deriveTimeout(const SessionConfig& config) {
+    constexpr std::uint16_t kMinTicks = 1;
+    auto ticks = std::max(kMinTicks, config.timeout_250ms);
+    return std::chrono::milliseconds(ticks * 250);
+}
+
+void applyLatencyOptions(SocketHandle socket) {
+    // Enable keepalive by default.
+    const int enable = 1;
+    ::setsockopt(socket, SOL_SOCKET, SO_KEEPALIVE,
+#ifdef _WIN32
+                 reinterpret_cast<const char*>(&enable),
+#else
+                 &enable,
+#endif
+                 sizeof(enable));
+
+    // Disable Nagle to reduce latency.
+    ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY,
+#ifdef _WIN32
+                 reinterpret_cast<const char*>(&enable),
+#else
+                 &enable,
+#endif
+                 sizeof(enable));
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 同じ接続先の次のアドレスへの接続を開始するまでの待ち時間（RFC 8305 の Connection Attempt Delay）。
+constexpr std::chrono::milliseconds kAttemptDelay{250};
+// 名前解決を待っている接続先がある間、接続中のソケットの待機を区切る間隔。
+constexpr std::chrono::milliseconds kResolvePollInterval{10};
+
+#ifdef _WIN32
+using PollDescriptor = WSAPOLLFD;
+
+int pollSockets(std::vector<PollDescriptor>& fds, int timeout_ms) {
+    return ::WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeout_ms);
+}
+#else
+using PollDescriptor = pollfd;
+
+int pollSockets(std::vector<PollDescriptor>& fds, int timeout_ms) {
+    return ::poll(fds.data(), static_cast<nfds_t>(fds.size()), timeout_ms);
+}
+#endif
+
+// 接続先 1 件の接続状態。
+struct Target {
+    const SessionConfig* config = nullptr;
+    std::vector<SocketAddress> addresses;
+    std::optional<std::size_t> resolution; // 名前解決を待っている場合、ResolverState::resolutions の位置
+    std::size_t next = 0;                 // 次に試すアドレス
+    std::vector<SocketHandle> attempts;   // 接続中のソケット
+    Clock::time_point deadline;
+    Clock::time_point next_start;         // 次のアドレスへの接続を開始する時刻
+    int last_error = 0;
+    bool done = false;
+};
+
+void validateEndpoint(const SessionConfig& config) {
+    if (config.host.empty()) {
+        throw TransportError("SessionConfig.host must not be empty");
+    }
+    if (config.port == 0) {
+        throw TransportError("SessionConfig.port must be non-zero");
+    }
+}
+
+// 名前解決し、アドレスファミリーが交互になるように並べ替える（RFC 8305 の順序）。
+// 先頭のファミリー（通常は OS の優先順位が最も高いもの）から始める。
+// numeric_only の場合は数値アドレスだけを変換し、ホスト名なら DNS に問い合わせずに nullopt を返す。
+std::optional<std::vector<SocketAddress>> resolveAddresses(const std::string& host, std::uint16_t port, bool numeric_only) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    hints.ai_flags = numeric_only ? AI_NUMERICHOST : 0;
+
+    addrinfo* results = nullptr;
+    const std::string port_str = std::to_string(port);
+    const int gai_result = ::getaddrinfo(host.c_str(), port_str.c_str(), &hints, &results);
+    if (gai_result != 0) {
+        if (numeric_only && gai_result == EAI_NONAME) {
+            return std::nullopt;
+        }
+        throw TransportError(addrInfoErrorMessage(gai_result));
+    }
+
+    std::vector<SocketAddress> preferred;
+    std::vector<SocketAddress> others;
+    for (addrinfo* rp = results; rp != nullptr; rp = rp->ai_next) {
+        if (rp->ai_addrlen > sizeof(sockaddr_storage)) {
+            continue;
+        }
+        SocketAddress address;
+        address.family = rp->ai_family;
+        address.socktype = rp->ai_socktype;
+        address.protocol = rp->ai_protocol;
+        std::memcpy(&address.storage, rp->ai_addr, rp->ai_addrlen);
+        address.length = static_cast<SocketLength>(rp->ai_addrlen);
+        (preferred.empty() || preferred.front().family == address.family ? preferred : others).push_back(address);
+    }
+    ::freeaddrinfo(results);
+
+    std::vector<SocketAddress> ordered;
+    ordered.reserve(preferred.size() + others.size());
+    for (std::size_t i = 0; i < std::max(preferred.size(), others.size()); ++i) {
+        if (i < preferred.size()) {
+            ordered.push_back(preferred[i]);
+        }
+        if (i < others.size()) {
+            ordered.push_back(others[i]);
+        }
+    }
+    return ordered;
+}
+
+// ホスト名の解決結果。
+struct Resolution {
+    bool done = false;
+    std::vector<SocketAddress> addresses;
+    std::exception_ptr error;
+};
+
+// 1 回の connectTcpAll() が待つホスト名の解決。ホスト名ごとにワーカースレッドで並行して解決する。
+// getaddrinfo() はデッドラインで中断できないため、ワーカーはデタッチし、状態を shared_ptr で共有して
+// 呼び出し元がデッドラインで先に戻れるようにする。
+struct ResolverState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<Resolution> resolutions;
+};
+
+void startResolution(const std::shared_ptr<ResolverState>& state, std::size_t index, const SessionConfig& config) {
+    auto resolve = [state, index, host = config.host, port = config.port] {
+        Resolution resolution;
+        try {
+            resolution.addresses = *resolveAddresses(host, port, false);
+        } catch (...) {
+            resolution.error = std::current_exception();
+        }
+        resolution.done = true;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->resolutions[index] = std::move(resolution);
+        }
+        state->cv.notify_all();
+    };
+    try {
+        std::thread(std::move(resolve)).detach();
+    } catch (...) {
+        // スレッドを作れない場合は、同じホスト名を待つ接続先もまとめて失敗させる
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->resolutions[index].done = true;
+        state->resolutions[index].error = std::current_exception();
+    }
+}
+
+void closeAttempts(Target& target) {
+    for (SocketHandle socket : target.attempts) {
+        closeSocket(socket);
+    }
+    target.attempts.clear();
+}
+
+void succeed(Target& target, SocketHandle socket, ConnectResult& result) {
+    target.attempts.erase(std::remove(target.attempts.begin(), target.attempts.end(), socket),
+                          target.attempts.end());
+    closeAttempts(target);
+    target.done = true;
+    try {
+        setNonBlocking(socket, false);
+        result.socket = socket;
+    } catch (...) {
+        closeSocket(socket);
+        result.error = std::current_exception();
+    }
+}
+
+void fail(Target& target, std::exception_ptr error, ConnectResult& result) {
+    closeAttempts(target);
+    target.done = true;
+    result.error = std::move(error);
+}
+
+// 次のアドレスへのノンブロッキング接続を開始する。
+void startAttempt(Target& target, ConnectResult& result) {
+    const ConnectAttempt attempt = startConnect(target.addresses[target.next++]);
+    if (attempt.socket == kInvalidSocket) {
+        target.last_error = attempt.error;
+        return;
+    }
+    target.attempts.push_back(attempt.socket);
+    if (attempt.connected) {
+        succeed(target, attempt.socket, result);
+    }
+}
+
+// SO_ERROR（取得できない場合は getsockopt のエラー）。
+int socketError(SocketHandle socket) {
+    int error = 0;
+    SocketLength length = sizeof(error);
+    if (::getsockopt(socket, SOL_SOCKET, SO_ERROR,
+#ifdef _WIN32
+                     reinterpret_cast<char*>(&error),
+#else
+                     &error,
+#endif
+                     &length) != 0) {
+        return lastSocketError();
+    }
+    return error;
+}
+
+// 接続中のソケットの結果を確認する（0 は接続済み）。
+int pendingConnectError(SocketHandle socket, short revents) {
+    const int error = socketError(socket);
+    if (error == 0 && (revents & (POLLERR | POLLHUP)) != 0) {
+#ifdef _WIN32
+        return WSAECONNREFUSED;
+#else
+        return ECONNREFUSED;
+#endif
+    }
+    return error;
+}
+
+void failTimedOut(Target& target, ConnectResult& result) {
+    const auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(deriveTimeout(*target.config));
+    fail(target,
+         std::make_exception_ptr(TransportTimeoutError("Connection to " + endpointName(*target.config) +
+                                                       " timed out after " + std::to_string(timeout.count()) +
+                                                       " ms")),
+         result);
+}
+
+// 接続を開始できるアドレスへの試行を始め、終わった接続先の結果を確定する。
+void advance(Target& target, ConnectResult& result, Clock::time_point now) {
+    if (now >= target.deadline) {
+        failTimedOut(target, result);
+        return;
+    }
+    // 接続中の試行がなくなった場合は待たずに次のアドレスへ進む
+    while (!target.done && target.next < target.addresses.size() &&
+           (target.attempts.empty() || now >= target.next_start)) {
+        target.next_start = now + kAttemptDelay;
+        startAttempt(target, result);
+    }
+    if (!target.done && target.attempts.empty()) {
+        std::string message = "Failed to connect to " + endpointName(*target.config);
+        if (target.last_error != 0) {
+            message += ": " + lastSocketErrorMessage(target.last_error);
+        }
+        fail(target, std::make_exception_ptr(TransportError(message)), result);
+    }
+}
+
+} // namespace
+
+#ifdef _WIN32
+bool isConnectInProgress(int code) {
+    return code == WSAEWOULDBLOCK || code == WSAEINPROGRESS;
+}
+#else
+bool isConnectInProgress(int code) {
+    // ノンブロッキングの connect がシグナルで中断された場合も、接続はバックグラウンドで続く
+    return code == EINPROGRESS || code == EINTR;
+}
+#endif
+
+std::string endpointName(const SessionConfig& config) {
+    std::ostringstream oss;
+    oss << config.host << ":" << config.port;
+    return oss.str();
+}
+
+std::vector<SocketAddress> resolveEndpoint(const SessionConfig& config) {
+    ensureWinsock();
+    validateEndpoint(config);
+    return *resolveAddresses(config.host, config.port, false);
+}
+
+ConnectAttempt startConnect(const SocketAddress& address) {
+    ConnectAttempt attempt;
+    SocketHandle socket = ::socket(address.family, address.socktype, address.protocol);
+    if (socket == kInvalidSocket) {
+        attempt.error = lastSocketError();
+        return attempt;
+    }
+    try {
+        setNonBlocking(socket, true);
+    } catch (...) {
+        attempt.error = lastSocketError();
+        closeSocket(socket);
+        return attempt;
+    }
+
+    if (::connect(socket, reinterpret_cast<const sockaddr*>(&address.storage), address.length) == 0) {
+        attempt.socket = socket;
+        attempt.connected = true;
+        return attempt;
+    }
+    const int code = lastSocketError();
+    if (!isConnectInProgress(code)) {
+        attempt.error = code;
+        closeSocket(socket);
+        return attempt;
+    }
+    attempt.socket = socket;
+    return attempt;
+}
+
+int connectError(SocketHandle socket) {
+    if (const int error = socketError(socket); error != 0) {
+        return error;
+    }
+    // 通知が接続の完了より先に届いた場合（利用者のイベントループの誤通知など）は接続中として扱う
+    sockaddr_storage peer{};
+    SocketLength length = sizeof(peer);
+    if (::getpeername(socket, reinterpret_cast<sockaddr*>(&peer), &length) == 0) {
+        return 0;
+    }
+    const int code = lastSocketError();
+#ifdef _WIN32
+    return code == WSAENOTCONN ? WSAEINPROGRESS : code;
+#else
+    return code == ENOTCONN ? EINPROGRESS : code;
+#endif
+}
+
+std::vector<ConnectResult> connectTcpAll(std::span<const SessionConfig> configs) {
+    ensureWinsock();
+
+    std::vector<ConnectResult> results(configs.size());
+    std::vector<Target> targets(configs.size());
+    const auto started = Clock::now();
+    // 数値アドレスはその場で変換し、ホスト名だけをまとめて並行に解決する（同じホスト名は 1 回だけ）
+    const auto resolver = std::make_shared<ResolverState>();
+    std::map<std::pair<std::string, std::uint16_t>, std::size_t> lookups;
+    for (std::size_t i = 0; i < configs.size(); ++i) {
+        Target& target = targets[i];
+        target.config = &configs[i];
+        target.deadline = started + deriveTimeout(configs[i]);
+        try {
+            validateEndpoint(configs[i]);
+            if (auto numeric = resolveAddresses(configs[i].host, configs[i].port, true)) {
+                target.addresses = std::move(*numeric);
+                continue;
+            }
+            const auto [it, inserted] = lookups.try_emplace({configs[i].host, configs[i].port}, lookups.size());
+            if (inserted) {
+                {
+                    std::lock_guard<std::mutex> lock(resolver->mutex);
+                    resolver->resolutions.emplace_back();
+                }
+                startResolution(resolver, it->second, configs[i]);
+            }
+            target.resolution = it->second;
+        } catch (...) {
+            fail(target, std::current_exception(), results[i]);
+        }
+    }
+
+    std::vector<PollDescriptor> fds;
+    std::vector<std::size_t> owners; // fds[k] の接続先
+    for (;;) {
+        {
+            // 解決が終わった接続先はアドレスを受け取り、接続を開始できるようにする
+            std::lock_guard<std::mutex> lock(resolver->mutex);
+            for (std::size_t i = 0; i < targets.size(); ++i) {
+                Target& target = targets[i];
+                if (target.done || !target.resolution || !resolver->resolutions[*target.resolution].done) {
+                    continue;
+                }
+                const Resolution& resolution = resolver->resolutions[*target.resolution];
+                target.resolution.reset();
+                if (resolution.error) {
+                    fail(target, resolution.error, results[i]);
+                } else {
+                    target.addresses = resolution.addresses;
+                }
+            }
+        }
+
+        const auto now = Clock::now();
+        fds.clear();
+        owners.clear();
+        auto wake = Clock::time_point::max();
+        bool resolving = false;
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            Target& target = targets[i];
+            if (target.done) {
+                continue;
+            }
+            if (target.resolution) {
+                // 名前解決もデッドラインに含める（解決の遅いホスト名は接続のタイムアウトとして扱う）
+                if (now >= target.deadline) {
+                    failTimedOut(target, results[i]);
+                } else {
+                    resolving = true;
+                    wake = std::min(wake, target.deadline);
+                }
+                continue;
+            }
+            advance(target, results[i], now);
+            if (target.done) {
+                continue;
+            }
+            for (SocketHandle socket : target.attempts) {
+                PollDescriptor fd{};
+                fd.fd = socket;
+                fd.events = POLLOUT;
+                fds.push_back(fd);
+                owners.push_back(i);
+            }
+            wake = std::min(wake, target.deadline);
+            if (target.next < target.addresses.size()) {
+                wake = std::min(wake, target.next_start);
+            }
+        }
+        if (fds.empty() && resolving) {
+            // 待つのは名前解決だけなので、解決の完了かデッドラインまで眠る
+            std::unique_lock<std::mutex> lock(resolver->mutex);
+            resolver->cv.wait_until(lock, wake, [&] {
+                for (const Target& target : targets) {
+                    if (!target.done && target.resolution && resolver->resolutions[*target.resolution].done) {
+                        return true;
+                    }
+                }
+                return false;
+            });
+            continue;
+        }
+        if (resolving) {
+            wake = std::min(wake, now + kResolvePollInterval);
+        }
+        if (fds.empty()) {
+            break;
+        }
+
+        const auto wait = std::chrono::ceil<std::chrono::milliseconds>(std::max(wake - now, Clock::duration::zero()));
+        const int ready = pollSockets(fds, static_cast<int>(std::min<std::chrono::milliseconds::rep>(
+                                               wait.count(), std::numeric_limits<int>::max())));
+        if (ready < 0) {
+            const int code = lastSocketError();
+            if (isInterrupted(code)) {
+                continue;
+            }
+            // 待機自体が失敗した場合は、残りの接続先をすべて失敗にする
+            const auto error = std::make_exception_ptr(TransportError("poll failed: " + lastSocketErrorMessage(code)));
+            for (std::size_t i = 0; i < targets.size(); ++i) {
+                if (!targets[i].done) {
+                    fail(targets[i], error, results[i]);
+                }
+            }
+            break;
+        }
+
+        for (std::size_t k = 0; k < fds.size(); ++k) {
+            Target& target = targets[owners[k]];
+            if (fds[k].revents == 0 || target.done) {
+                continue;
+            }
+            const SocketHandle socket = fds[k].fd;
+            const int error = pendingConnectError(socket, fds[k].revents);
+            if (error == 0) {
+                succeed(target, socket, results[owners[k]]);
+                continue;
+            }
+            // 失敗した試行を閉じ、次の巡回で次のアドレスを待たずに開始する
+            target.last_error = error;
+            target.attempts.erase(std::remove(target.attempts.begin(), target.attempts.end(), socket),
+                                  target.attempts.end());
+            closeSocket(socket);
+            target.next_start = Clock::now();
+        }
+    }
+    return results;
+}
+
+SocketHandle connectTcp(const SessionConfig& config) {
+    auto results = connectTcpAll(std::span<const SessionConfig>(&config, 1));
+    if (results.front().error) {
+        std::rethrow_exception(results.front().error);
+    }
+    return results.front().socket;
+}
+
+} // namespace cpmcprotocol::detail
@@ -0,0 +1,127 @@
+#pragma once
+
+// ソケット API のプラットフォーム差異を吸収する内部ヘルパ。
+// TcpTransport と AsyncTcpTransport で共有し、公開ヘッダーからは参照しない。
+
+#include "cpmcprotocol/session_config.hpp"
+
+#include <chrono>
+#include <exception>
+#include <span>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef max
+#undef max
+#endif
+#ifdef min
+#undef min
+#endif
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+namespace cpmcprotocol::detail {
+
+#ifdef _WIN32
+using SocketHandle = SOCKET;
+using SocketLength = int;
+constexpr SocketHandle kInvalidSocket = INVALID_SOCKET;
+#else
+using SocketHandle = int;
+using SocketLength = socklen_t;
+constexpr SocketHandle kInvalidSocket = -1;
+#endif
+
+/// 直近のソケットエラーコード（errno / WSAGetLastError）
+int lastSocketError();
+
+/// エラーコードを文字列に変換する（0 の場合は直近のエラーを使用）
+std::string lastSocketErrorMessage(int code);
+
+/// getaddrinfo のエラーコードを文字列に変換する
+std::string addrInfoErrorMessage(int code);
+
+void closeSocket(SocketHandle socket);
+
+/// Windows では WSAStartup を一度だけ実行する（POSIX では何もしない）
+void ensureWinsock();
+
+/// SessionConfig の 250ms 単位タイムアウトをミリ秒に変換する（最小 1 単位）
+std::chrono::milliseconds deriveTimeout(const SessionConfig& config);
+
+bool isTimeoutError(int code);
+bool isInterrupted(int code);
+bool isWouldBlock(int code);
+
+/// ソケットのノンブロッキングモードを切り替える
+void setNonBlocking(SocketHandle socket, bool enabled);
+
+/// KEEPALIVE と TCP_NODELAY を設定する
+void applyLatencyOptions(SocketHandle socket);
+
+/// "host:port" 形式の接続先名（エラーメッセージ用）
+std::string endpointName(const SessionConfig& config);
+
+/// 名前解決したアドレス 1 件
+struct SocketAddress {
+    int family = 0;
+    int socktype = 0;
+    int protocol = 0;
+    sockaddr_storage storage{};
+    SocketLength length = 0;
+};
+
+/// config.host/port を名前解決し、アドレスファミリーが交互になるように並べる（RFC 8305 の順序）
+/// 数値アドレスはその場で変換するが、ホスト名は getaddrinfo() の応答まで呼び出したスレッドで待つ
+/// @throws TransportError host/port が不正な場合、または名前解決に失敗した場合
+std::vector<SocketAddress> resolveEndpoint(const SessionConfig& config);
+
+/// ノンブロッキング接続を開始したソケット
+struct ConnectAttempt {
+    SocketHandle socket = kInvalidSocket; ///< 無効値の場合は error に失敗の理由
+    bool connected = false;               ///< その場で接続できた場合 true（ループバックなどで起こり得る）
+    int error = 0;
+};
+
+/// address へのノンブロッキング接続を開始する（ソケットはノンブロッキングモードのまま返す）
+ConnectAttempt startConnect(const SocketAddress& address);
+
+/// 接続中のソケットの結果（0 は確立、EINPROGRESS 相当は接続中、それ以外は失敗の理由）
+/// 書き込み可能またはエラーの通知を受けた後に呼ぶ
+int connectError(SocketHandle socket);
+
+/// 接続中を表す connect() のエラーコードの場合 true
+bool isConnectInProgress(int code);
+
+/// 接続先 1 件分の接続結果（socket と error のどちらか一方が有効）
+struct ConnectResult {
+    SocketHandle socket = kInvalidSocket;
+    std::exception_ptr error;
+};
+
+/// 複数の接続先へ同時に TCP 接続する（結果は configs と同じ順）
+/// 各接続先は deriveTimeout() のデッドラインまでに接続できなければ TransportTimeoutError になる
+/// 名前解決の結果が複数ある場合は、アドレスファミリーを交互に並べ、前の試行が終わらなくても
+/// 一定時間ごとに次のアドレスへの接続を並行して開始する（最初に確立した接続を使う）
+/// 返すソケットはブロッキングモード
+std::vector<ConnectResult> connectTcpAll(std::span<const SessionConfig> configs);
+
+/// config.host/port へ TCP 接続したソケットを返す（connectTcpAll() の 1 件版）
+/// @throws TransportTimeoutError デッドラインまでに接続できなかった場合
+/// @throws TransportError 名前解決または接続に失敗した場合
+SocketHandle connectTcp(const SessionConfig& config);
+
+} // namespace cpmcprotocol::detail
@@ -0,0 +1,341 @@
+#include "cpmcprotocol/subscription.hpp"
+
+#include "cpmcprotocol/mc_client.hpp"
+#include "cpmcprotocol/read_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace cpmcprotocol {
+
+namespace {
+
+// 同じデバイスを同じフォーマットで読むタグは 1 回だけ読む
+using TagKey = std::tuple<std::uint8_t, std::uint32_t, ValueType, std::size_t>;
+
+TagKey tagKey(const ResolvedReadPlanEntry& entry) {
+    return {entry.address.kind, entry.address.number, entry.format.type, entry.format.parameter};
+}
+
+// 変化検出用のワード列でタグが占めるワード数（ビット配列は 16 点を 1 ワードに詰める）
+std::size_t imageWords(const ValueFormat& format) {
+    if (format.type == ValueType::BitArray) {
+        return (format.parameter + 15) / 16;
+    }
+    return ValueCodec::requiredWords(format);
+}
+
+std::optional<double> numericValue(const DeviceValue& value) {
+    return std::visit(
+        [](const auto& v) -> std::optional<double> {
+            if constexpr (std::is_arithmetic_v<std::decay_t<decltype(v)>>) {
+                return static_cast<double>(v);
+            } else {
+                return std::nullopt;
+            }
+        },
+        value);
+}
+
+} // namespace
+
+struct SubscriptionEngine::Impl {
+    struct Subscription {
+        ResolvedReadPlan tags;
+        Clock::duration period{};
+        Callback callback;
+        Clock::time_point next_due{};
+
+        // changes_only の場合の変化検出の状態
+        SubscriptionOptions options;
+        std::vector<std::size_t> image_offsets;  // タグ k のワード列は image[image_offsets[k], image_offsets[k + 1])
+        std::vector<std::uint16_t> image;        // 前回読み取ったタグのワード列（空なら未読み取り）
+        std::vector<double> last_emitted;        // 不感帯の基準（最後に通知した値）
+    };
+
+    // 同時に周期が来る購読の組ごとに作る読み取り。購読の追加・解除で作り直す。
+    struct Batch {
+        PlcSeries series = PlcSeries::IQ_R;
+        OptimizedReadPlan plan;
+        // positions[s][k]: s 番目の購読の k 番目のタグが plan.entries の何番目か
+        std::vector<std::vector<std::size_t>> positions;
+    };
+
+    explicit Impl(McClient& c) : client(c) {}
+
+    McClient& client;
+    std::map<SubscriptionId, Subscription> subscriptions;
+    std::map<std::vector<SubscriptionId>, Batch> batches;
+    SubscriptionId next_id = 0;
+    // 周期の起点。各購読は epoch + period の倍数の時刻に読み取る。
+    const Clock::time_point epoch = Clock::now();
+
+    // 変化検出用のワード列の作業領域（周期ごとの確保を避ける）
+    std::vector<std::uint16_t> scratch;
+
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool stop_requested = false;
+
+    // now より後で最初の epoch + period の倍数の時刻
+    Clock::time_point nextTick(Clock::duration period, Clock::time_point now) const {
+        if (now < epoch) {
+            return epoch;
+        }
+        return epoch + ((now - epoch) / period + 1) * period;
+    }
+
+    Batch& batchFor(const std::vector<SubscriptionId>& due) {
+        const PlcSeries series = client.series();
+        auto it = batches.find(due);
+        if (it != batches.end() && it->second.series == series) {
+            return it->second;
+        }
+
+        Batch batch;
+        batch.series = series;
+        ResolvedReadPlan combined;
+        std::map<TagKey, std::size_t> index_of;
+        for (const SubscriptionId id : due) {
+            const auto& tags = subscriptions.at(id).tags;
+            auto& positions = batch.positions.emplace_back();
+            positions.reserve(tags.size());
+            for (const auto& entry : tags) {
+                const auto [found, inserted] = index_of.try_emplace(tagKey(entry), combined.size());
+                if (inserted) {
+                    combined.push_back(entry);
+                }
+                positions.push_back(found->second);
+            }
+        }
+        batch.plan = optimizeReadPlan(combined, series);
+        return batches.insert_or_assign(due, std::move(batch)).first->second;
+    }
+
+    // 読み取ったワード列から購読のタグのワード列を組み立て、前回から変化したタグを indices に入れる。
+    void detectChanges(Subscription& subscription,
+                       const OptimizedReadPlan& plan,
+                       const std::vector<std::size_t>& positions,
+                       const std::vector<std::uint16_t>& words,
+                       const std::vector<DeviceValue>& values,
+                       std::vector<std::size_t>& indices) {
+        scratch.assign(subscription.image_offsets.back(), 0);
+        for (std::size_t k = 0; k < positions.size(); ++k) {
+            const std::size_t position = positions[k];
+            const auto& format = plan.entries[position].format;
+            const std::size_t offset = plan.word_offsets[position];
+            auto* out = scratch.data() + subscription.image_offsets[k];
+            if (format.type != ValueType::BitArray) {
+                std::copy_n(words.begin() + static_cast<std::ptrdiff_t>(offset), imageWords(format), out);
+                continue;
+            }
+            // 隣接するデバイスのビットで変化と誤判定しないよう、タグのビットだけを詰め直す
+            for (std::size_t b = 0; b < format.parameter; ++b) {
+                const std::size_t bit = plan.bit_offsets[position] + b;
+                if ((words[offset + bit / 16] >> (bit % 16)) & 0x1) {
+                    out[b / 16] = static_cast<std::uint16_t>(out[b / 16] | (1U << (b % 16)));
+                }
+            }
+        }
+
+        const auto& deadbands = subscription.options.deadbands;
+        auto emit = [&](std::size_t k) {
+            if (!deadbands.empty()) {
+                if (const auto numeric = numericValue(values[positions[k]])) {
+                    subscription.last_emitted[k] = *numeric;
+                }
+            }
+            indices.push_back(k);
+        };
+
+        if (subscription.image.empty()) {
+            for (std::size_t k = 0; k < positions.size(); ++k) {
+                emit(k);
+            }
+        } else if (scratch != subscription.image) {
+            for (std::size_t k = 0; k < positions.size(); ++k) {
+                const auto first = static_cast<std::ptrdiff_t>(subscription.image_offsets[k]);
+                const auto last = static_cast<std::ptrdiff_t>(subscription.image_offsets[k + 1]);
+                if (std::equal(scratch.begin() + first, scratch.begin() + last, subscription.image.begin() + first)) {
+                    continue;
+                }
+                if (!deadbands.empty() && deadbands[k] > 0) {
+                    const auto numeric = numericValue(values[positions[k]]);
+                    if (numeric && std::abs(*numeric - subscription.last_emitted[k]) <= deadbands[k]) {
+                        continue;
+                    }
+                }
+                emit(k);
+            }
+        }
+        subscription.image.swap(scratch);
+    }
+};
+
+SubscriptionEngine::SubscriptionEngine(McClient& client) : impl_(std::make_unique<Impl>(client)) {}
+
+SubscriptionEngine::~SubscriptionEngine() = default;
+
+SubscriptionId SubscriptionEngine::subscribe(const DeviceReadPlan& tags,
+                                             std::chrono::milliseconds period,
+                                             Callback callback,
+                                             SubscriptionOptions options) {
+    return subscribe(resolveReadPlan(tags), period, std::move(callback), std::move(options));
+}
+
+SubscriptionId SubscriptionEngine::subscribe(const ResolvedReadPlan& tags,
+                                             std::chrono::milliseconds period,
+                                             Callback callback,
+                                             SubscriptionOptions options) {
+    if (tags.empty()) {
+        throw std::invalid_argument("Subscription has no tags");
+    }
+    if (period.count() <= 0) {
+        throw std::invalid_argument("Subscription period must be positive");
+    }
+    if (!callback) {
+        throw std::invalid_argument("Subscription callback is empty");
+    }
+    if (!options.deadbands.empty() && (!options.changes_only || options.deadbands.size() != tags.size())) {
+        throw std::invalid_argument("Deadbands require changes_only and one value per tag");
+    }
+    // フォーマットの誤りは読み取り時ではなく登録時に検出する
+    optimizeReadPlan(tags, impl_->client.series());
+
+    Impl::Subscription subscription;
+    subscription.tags = tags;
+    subscription.period = period;
+    subscription.callback = std::move(callback);
+    subscription.next_due = Clock::time_point::min();
+    if (options.changes_only) {
+        subscription.image_offsets.reserve(tags.size() + 1);
+        subscription.image_offsets.push_back(0);
+        for (const auto& entry : tags) {
+            subscription.image_offsets.push_back(subscription.image_offsets.back() + imageWords(entry.format));
+        }
+        subscription.last_emitted.resize(options.deadbands.size());
+    }
+    subscription.options = std::move(options);
+
+    const SubscriptionId id = ++impl_->next_id;
+    impl_->subscriptions.emplace(id, std::move(subscription));
+    impl_->batches.clear();
+    return id;
+}
+
+bool SubscriptionEngine::unsubscribe(SubscriptionId id) {
+    if (impl_->subscriptions.erase(id) == 0) {
+        return false;
+    }
+    impl_->batches.clear();
+    return true;
+}
+
+std::size_t SubscriptionEngine::poll(Clock::time_point now) {
+    std::vector<SubscriptionId> due;
+    for (auto& [id, subscription] : impl_->subscriptions) {
+        if (subscription.next_due <= now) {
+            due.push_back(id);
+            // 読み取りに失敗しても同じ購読で読み取りを繰り返さないよう、先に次の周期へ進める
+            subscription.next_due = impl_->nextTick(subscription.period, now);
+        }
+    }
+    if (due.empty()) {
+        return 0;
+    }
+
+    const auto& batch = impl_->batchFor(due);
+    const auto words = impl_->client.readOptimizedWords(batch.plan);
+    const auto values = decodeOptimizedRead(batch.plan, words);
+    const auto timestamp = Clock::now();
+
+    std::vector<SubscriptionUpdate> updates;
+    updates.reserve(due.size());
+    for (std::size_t s = 0; s < due.size(); ++s) {
+        auto& subscription = impl_->subscriptions.at(due[s]);
+        const auto& positions = batch.positions[s];
+        SubscriptionUpdate update;
+        update.id = due[s];
+        update.timestamp = timestamp;
+        if (subscription.options.changes_only) {
+            impl_->detectChanges(subscription, batch.plan, positions, words, values, update.indices);
+            if (update.indices.empty()) {
+                continue;
+            }
+        } else {
+            update.indices.resize(positions.size());
+            for (std::size_t k = 0; k < positions.size(); ++k) {
+                update.indices[k] = k;
+            }
+        }
+        update.values.reserve(update.indices.size());
+        for (const std::size_t k : update.indices) {
+            update.values.push_back(values[positions[k]]);
+        }
+        updates.push_back(std::move(update));
+    }
+
+    // コールバック内で購読が追加・解除されてもよいよう、呼び出しのたびに購読を引き直す
+    for (const auto& update : updates) {
+        const auto it = impl_->subscriptions.find(update.id);
+        if (it != impl_->subscriptions.end()) {
+            const Callback callback = it->second.callback;
+            callback(update);
+        }
+    }
+    return due.size();
+}
+
+std::optional<SubscriptionEngine::Clock::time_point> SubscriptionEngine::nextDue() const {
+    std::optional<Clock::time_point> earliest;
+    for (const auto& [id, subscription] : impl_->subscriptions) {
+        if (!earliest || subscription.next_due < *earliest) {
+            earliest = subscription.next_due;
+        }
+    }
+    return earliest;
+}
+
+void SubscriptionEngine::run() {
+    // 購読がない間は一定間隔で stop() を確認する
+    constexpr auto kIdleWait = std::chrono::milliseconds(100);
+
+    while (true) {
+        const auto now = Clock::now();
+        const auto due = nextDue();
+        const auto wake = due ? std::min(*due, now + kIdleWait) : now + kIdleWait;
+        {
+            std::unique_lock<std::mutex> lock(impl_->stop_mutex);
+            if (wake > now) {
+                impl_->stop_cv.wait_until(lock, wake, [this] { return impl_->stop_requested; });
+            }
+            if (impl_->stop_requested) {
+                impl_->stop_requested = false;
+                return;
+            }
+        }
+        poll();
+    }
+}
+
+void SubscriptionEngine::stop() {
+    {
+        std::lock_guard<std::mutex> lock(impl_->stop_mutex);
+        impl_->stop_requested = true;
+    }
+    impl_->stop_cv.notify_all();
+}
+
+std::size_t SubscriptionEngine::size() const noexcept {
+    return impl_->subscriptions.size();
+}
+
+} // namespace cpmcprotocol
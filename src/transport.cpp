@@ -2,146 +2,68 @@
 
 // TCP/3E 通信のソケットラッパ。タイムアウトや切断制御を一箇所で扱う。
 
+#include "socket_ops.hpp"
+
 #include <algorithm>
 #include <array>
 #include <chrono>
 #include <cstring>
 #include <limits>
 #include <memory>
-#include <mutex>
-#include <sstream>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 #include <cerrno>
 
-#ifdef _WIN32
-#ifndef NOMINMAX
-#define NOMINMAX
-#endif
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#pragma comment(lib, "Ws2_32.lib")
-#ifdef max
-#undef max
-#endif
-#ifdef min
-#undef min
-#endif
-#else
-#include <arpa/inet.h>
-#include <netdb.h>
-#include <netinet/in.h>
-#include <netinet/tcp.h>
-#include <sys/socket.h>
-#include <sys/types.h>
-#include <unistd.h>
+#ifndef _WIN32
+#include <sys/uio.h>
+
+#include <climits>
 #endif
 
 namespace cpmcprotocol {
 
-namespace {
+using detail::SocketHandle;
+using detail::kInvalidSocket;
+using detail::closeSocket;
+using detail::deriveTimeout;
+using detail::lastSocketErrorMessage;
 
-#ifdef _WIN32
-// Windows ソケット API 周りの薄いラッパ。POSIX と共通の呼び出し口を保つ。
-using SocketHandle = SOCKET;
-constexpr SocketHandle kInvalidSocket = INVALID_SOCKET;
+TransportError::TransportError(const std::string& message)
+    : std::runtime_error(message) {}
 
-std::string lastSocketErrorMessage(int code) {
-    if (code == 0) {
-        code = WSAGetLastError();
-    }
-    LPSTR buffer = nullptr;
-    const DWORD flags = FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM |
-                        FORMAT_MESSAGE_IGNORE_INSERTS;
-    const DWORD lang = MAKELANGID(LANG_NEUTRAL, SUBLANG_DEFAULT);
-    const DWORD result = FormatMessageA(flags, nullptr, static_cast<DWORD>(code), lang,
-                                        reinterpret_cast<LPSTR>(&buffer), 0, nullptr);
-    std::string message;
-    if (result == 0) {
-        message = "Unknown WSA error " + std::to_string(code);
-    } else {
-        message.assign(buffer, buffer + result);
-    }
-    if (buffer) {
-        LocalFree(buffer);
-    }
-    return "WSA error " + std::to_string(code) + ": " + message;
-}
+TransportTimeoutError::TransportTimeoutError(const std::string& message)
+    : TransportError(message) {}
 
-std::string addrInfoErrorMessage(int code) {
-    const char* msg = ::gai_strerrorA(code);
-    if (msg == nullptr) {
-        return std::string("getaddrinfo failed with code ") + std::to_string(code);
-    }
-    return std::string(msg);
-}
+TransportReconnectingError::TransportReconnectingError(const std::string& message)
+    : TransportError(message) {}
 
-void closeSocket(SocketHandle socket) {
-    if (socket != kInvalidSocket) {
-        closesocket(socket);
-    }
-}
+namespace {
 
-void ensureWinsock() {
-    static std::once_flag once;
-    std::call_once(once, []() {
-        WSADATA data{};
-        if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
-            throw TransportError("WSAStartup failed");
-        }
-    });
-}
+// 最大の MC 応答（ASCII 4E で 960 ワード読み出し）が収まる初期受信バッファ長。
+constexpr std::size_t kInitialReceiveBufferSize = 8192;
 
+// 1 回の sendmsg / WSASend に渡すバッファ数の上限。
+#ifdef IOV_MAX
+constexpr std::size_t kMaxGatherBuffers = IOV_MAX;
 #else
-
-using SocketHandle = int;
-constexpr SocketHandle kInvalidSocket = -1;
-
-// POSIX 系の errno を文字列に変換するユーティリティ。
-std::string lastSocketErrorMessage(int code) {
-    if (code == 0) {
-        code = errno;
-    }
-    return std::string(std::strerror(code));
-}
-
-std::string addrInfoErrorMessage(int code) {
-    return gai_strerror(code);
-}
-
-void closeSocket(SocketHandle socket) {
-    if (socket != kInvalidSocket) {
-        ::close(socket);
-    }
-}
-
-void ensureWinsock() {
-    // No-op on POSIX systems.
-}
-
+constexpr std::size_t kMaxGatherBuffers = 1024;
 #endif
 
-std::chrono::milliseconds deriveTimeout(const SessionConfig& config) {
-    constexpr std::uint16_t kMinTicks = 1;
-    auto ticks = std::max(kMinTicks, config.timeout_250ms);
-    return std::chrono::milliseconds(ticks * 250);
-}
-
 } // namespace
 
-TransportError::TransportError(const std::string& message)
-    : std::runtime_error(message) {}
-
-TransportTimeoutError::TransportTimeoutError(const std::string& message)
-    : TransportError(message) {}
-
 // PIMPL に実際のソケットやタイムアウト設定をまとめる。
 struct TcpTransport::Impl {
     SocketHandle socket = kInvalidSocket;
     SessionConfig config{};
     std::chrono::milliseconds send_timeout{std::chrono::milliseconds{0}};
     std::chrono::milliseconds recv_timeout{std::chrono::milliseconds{0}};
+    // 接続ごとの受信バッファ。[rx_begin, rx_end) が未消費の受信済みデータ。
+    std::vector<std::uint8_t> rx_buffer;
+    std::size_t rx_begin = 0;
+    std::size_t rx_end = 0;
 };
 
 TcpTransport::TcpTransport()
@@ -155,59 +77,51 @@ TcpTransport::TcpTransport(TcpTransport&& other) noexcept = default;
 TcpTransport& TcpTransport::operator=(TcpTransport&& other) noexcept = default;
 
 void TcpTransport::connect(const SessionConfig& config) {
-    if (config.host.empty()) {
-        throw TransportError("SessionConfig.host must not be empty");
-    }
-    if (config.port == 0) {
-        throw TransportError("SessionConfig.port must be non-zero");
+    TcpTransport* self = this;
+    const auto errors = connectAll(std::span<TcpTransport* const>(&self, 1), std::span<const SessionConfig>(&config, 1));
+    if (errors.front()) {
+        std::rethrow_exception(errors.front());
     }
+}
 
-    ensureWinsock();
-
-    disconnect();
-
-    impl_->config = config;
-    impl_->send_timeout = deriveTimeout(config);
-    impl_->recv_timeout = deriveTimeout(config);
-
-    addrinfo hints{};
-    hints.ai_family = AF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_protocol = IPPROTO_TCP;
+std::vector<std::exception_ptr> TcpTransport::connectAll(std::span<TcpTransport* const> transports,
+                                                         std::span<const SessionConfig> configs) {
+    if (transports.size() != configs.size()) {
+        throw std::invalid_argument("connectAll requires one SessionConfig per transport");
+    }
+    std::vector<TcpTransport*> sorted(transports.begin(), transports.end());
+    std::sort(sorted.begin(), sorted.end(), std::less<TcpTransport*>());
+    if (!sorted.empty() && sorted.front() == nullptr) {
+        throw std::invalid_argument("connectAll requires non-null transports");
+    }
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+        throw std::invalid_argument("connectAll requires distinct transports");
+    }
 
-    addrinfo* results = nullptr;
-    const std::string port_str = std::to_string(config.port);
-    const int gai_result = ::getaddrinfo(config.host.c_str(), port_str.c_str(), &hints, &results);
-    if (gai_result != 0) {
-        throw TransportError(addrInfoErrorMessage(gai_result));
+    for (std::size_t i = 0; i < transports.size(); ++i) {
+        Impl& impl = *transports[i]->impl_;
+        transports[i]->disconnect();
+        impl.config = configs[i];
+        impl.send_timeout = deriveTimeout(configs[i]);
+        impl.recv_timeout = deriveTimeout(configs[i]);
     }
 
-    SocketHandle socket = kInvalidSocket;
-    for (addrinfo* rp = results; rp != nullptr; rp = rp->ai_next) {
-        socket = ::socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
-        if (socket == kInvalidSocket) {
+    auto results = detail::connectTcpAll(configs);
+    std::vector<std::exception_ptr> errors(transports.size());
+    for (std::size_t i = 0; i < transports.size(); ++i) {
+        if (results[i].error) {
+            errors[i] = std::move(results[i].error);
             continue;
         }
-
-        const int connect_result = ::connect(socket, rp->ai_addr, static_cast<int>(rp->ai_addrlen));
-        if (connect_result == 0) {
-            impl_->socket = socket;
-            break;
+        transports[i]->impl_->socket = results[i].socket;
+        try {
+            transports[i]->applySocketOptions();
+        } catch (...) {
+            transports[i]->markDisconnected();
+            errors[i] = std::current_exception();
         }
-
-        closeSocket(socket);
-        socket = kInvalidSocket;
     }
-
-    ::freeaddrinfo(results);
-
-    if (impl_->socket == kInvalidSocket) {
-        std::ostringstream oss;
-        oss << "Failed to connect to " << config.host << ":" << config.port;
-        throw TransportError(oss.str());
-    }
-
-    applySocketOptions();
+    return errors;
 }
 
 void TcpTransport::disconnect() noexcept {
@@ -277,12 +191,117 @@ void TcpTransport::sendAll(const std::vector<std::uint8_t>& data) {
     sendAll(data.data(), data.size());
 }
 
+void TcpTransport::sendAll(std::span<const std::span<const std::uint8_t>> buffers) {
+    ensureConnected();
+
+#ifdef _WIN32
+    std::vector<WSABUF> pieces;
+    pieces.reserve(buffers.size());
+    for (const auto& buffer : buffers) {
+        // WSABUF の長さは ULONG のため、それを超えるバッファは分けて渡す
+        for (std::size_t offset = 0; offset < buffer.size();) {
+            const std::size_t length =
+                std::min<std::size_t>(buffer.size() - offset, std::numeric_limits<ULONG>::max());
+            pieces.push_back(WSABUF{static_cast<ULONG>(length),
+                                    reinterpret_cast<char*>(const_cast<std::uint8_t*>(buffer.data() + offset))});
+            offset += length;
+        }
+    }
+    auto advance = [](WSABUF& piece, std::size_t count) {
+        piece.buf += count;
+        piece.len -= static_cast<ULONG>(count);
+    };
+    auto lengthOf = [](const WSABUF& piece) { return static_cast<std::size_t>(piece.len); };
+#else
+    std::vector<iovec> pieces;
+    pieces.reserve(buffers.size());
+    for (const auto& buffer : buffers) {
+        if (!buffer.empty()) {
+            pieces.push_back(iovec{const_cast<std::uint8_t*>(buffer.data()), buffer.size()});
+        }
+    }
+    auto advance = [](iovec& piece, std::size_t count) {
+        piece.iov_base = static_cast<std::uint8_t*>(piece.iov_base) + count;
+        piece.iov_len -= count;
+    };
+    auto lengthOf = [](const iovec& piece) { return piece.iov_len; };
+#endif
+
+    std::size_t index = 0;
+    while (index < pieces.size()) {
+        const std::size_t count = std::min(pieces.size() - index, kMaxGatherBuffers);
+#ifdef _WIN32
+        DWORD sent_bytes = 0;
+        if (::WSASend(impl_->socket, pieces.data() + index, static_cast<DWORD>(count), &sent_bytes, 0, nullptr,
+                      nullptr) == SOCKET_ERROR) {
+            const int err = WSAGetLastError();
+            if (isTimeoutError(err)) {
+                throw TransportTimeoutError(lastSocketErrorMessage(err));
+            }
+            markDisconnected();
+            throw TransportError(lastSocketErrorMessage(err));
+        }
+        std::size_t sent = sent_bytes;
+#else
+        msghdr message{};
+        message.msg_iov = pieces.data() + index;
+        message.msg_iovlen = count;
+        int flags = 0;
+#ifdef MSG_MORE
+        // 上限で分割した場合、最後の呼び出しまで TCP_NODELAY による小さなセグメントの送出を止める
+        if (index + count < pieces.size()) {
+            flags |= MSG_MORE;
+        }
+#endif
+        const auto result = ::sendmsg(impl_->socket, &message, flags);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (isTimeoutError(errno)) {
+                throw TransportTimeoutError(lastSocketErrorMessage(errno));
+            }
+            markDisconnected();
+            throw TransportError(lastSocketErrorMessage(errno));
+        }
+        std::size_t sent = static_cast<std::size_t>(result);
+#endif
+        if (sent == 0) {
+            markDisconnected();
+            throw TransportError("Socket closed while sending");
+        }
+        // 送信できた分だけ先頭から読み進める（途中まで送ったバッファは残りから再開する）
+        while (sent > 0) {
+            const std::size_t length = lengthOf(pieces[index]);
+            if (sent < length) {
+                advance(pieces[index], sent);
+                break;
+            }
+            sent -= length;
+            ++index;
+        }
+    }
+}
+
 std::size_t TcpTransport::receiveSome(std::uint8_t* buffer, std::size_t capacity) {
     ensureConnected();
     if (capacity == 0) {
         return 0;
     }
 
+    // receiveFrameView が先読みしたデータを先に返す。
+    const std::size_t buffered = impl_->rx_end - impl_->rx_begin;
+    if (buffered > 0) {
+        const std::size_t count = std::min(buffered, capacity);
+        std::memcpy(buffer, impl_->rx_buffer.data() + impl_->rx_begin, count);
+        impl_->rx_begin += count;
+        return count;
+    }
+    return receiveFromSocket(buffer, capacity);
+}
+
+std::size_t TcpTransport::receiveFromSocket(std::uint8_t* buffer, std::size_t capacity) {
+
     const std::size_t chunk_size =
         std::min<std::size_t>(capacity,
                               static_cast<std::size_t>(std::numeric_limits<int>::max()));
@@ -296,7 +315,7 @@ std::size_t TcpTransport::receiveSome(std::uint8_t* buffer, std::size_t capacity
     if (received == SOCKET_ERROR) {
         const int code = WSAGetLastError();
         if (code == WSAEINTR) {
-            return receiveSome(buffer, capacity);
+            return receiveFromSocket(buffer, capacity);
         }
         if (isTimeoutError(code)) {
             throw TransportTimeoutError(lastSocketErrorMessage(code));
@@ -348,45 +367,65 @@ std::vector<std::uint8_t> TcpTransport::receiveAll(std::size_t expected) {
 
 std::vector<std::uint8_t> TcpTransport::receiveFrame(std::size_t header_size,
                                                      const std::function<std::size_t(const std::uint8_t*, std::size_t)>& length_extractor) {
+    const auto frame = receiveFrameView(header_size, length_extractor);
+    return std::vector<std::uint8_t>(frame.begin(), frame.end());
+}
+
+std::span<const std::uint8_t> TcpTransport::receiveFrameView(
+    std::size_t header_size,
+    const std::function<std::size_t(const std::uint8_t*, std::size_t)>& length_extractor) {
+    ensureConnected();
     if (header_size == 0) {
         throw TransportError("Header size must be greater than zero");
     }
-    std::vector<std::uint8_t> header(header_size);
-    try {
-        receiveAll(header.data(), header_size);
-    } catch (...) {
-        markDisconnected();
-        throw;
-    }
 
-    std::size_t body_size = 0;
+    std::size_t frame_size = 0;
+    // 途中で例外が出た場合も呼び出し側で再接続できるように切断しておく。
     try {
-        body_size = length_extractor(header.data(), header.size());
+        fillReceiveBuffer(header_size);
+        const std::size_t body_size =
+            length_extractor(impl_->rx_buffer.data() + impl_->rx_begin, header_size);
+        if (body_size == 0) {
+            throw TransportError("Frame body length reported as zero");
+        }
+        frame_size = header_size + body_size;
+        fillReceiveBuffer(frame_size);
     } catch (...) {
         markDisconnected();
         throw;
     }
 
-    if (body_size == 0) {
-        markDisconnected();
-        throw TransportError("Frame body length reported as zero");
+    const std::span<const std::uint8_t> frame(impl_->rx_buffer.data() + impl_->rx_begin, frame_size);
+    impl_->rx_begin += frame_size;
+    return frame;
+}
+
+void TcpTransport::fillReceiveBuffer(std::size_t needed) {
+    auto& rx = impl_->rx_buffer;
+    if (impl_->rx_begin == impl_->rx_end) {
+        impl_->rx_begin = 0;
+        impl_->rx_end = 0;
+    }
+    if (impl_->rx_end - impl_->rx_begin >= needed) {
+        return;
     }
 
-    std::vector<std::uint8_t> frame;
-    frame.reserve(header_size + body_size);
-    frame.insert(frame.end(), header.begin(), header.end());
-    if (body_size > 0) {
-        std::vector<std::uint8_t> body;
-        // 本体部分の受信中に例外が出た場合も呼び出し側で再接続できるように切断しておく。
-        try {
-            body = receiveAll(body_size);
-        } catch (...) {
-            markDisconnected();
-            throw;
+    // 未消費データを先頭に詰め、不足する場合のみバッファを拡張する。
+    if (impl_->rx_begin + needed > rx.size()) {
+        const std::size_t buffered = impl_->rx_end - impl_->rx_begin;
+        if (buffered > 0 && impl_->rx_begin > 0) {
+            std::memmove(rx.data(), rx.data() + impl_->rx_begin, buffered);
+        }
+        impl_->rx_begin = 0;
+        impl_->rx_end = buffered;
+        if (needed > rx.size()) {
+            rx.resize(std::max(needed, kInitialReceiveBufferSize));
         }
-        frame.insert(frame.end(), body.begin(), body.end());
     }
-    return frame;
+
+    while (impl_->rx_end - impl_->rx_begin < needed) {
+        impl_->rx_end += receiveFromSocket(rx.data() + impl_->rx_end, rx.size() - impl_->rx_end);
+    }
 }
 
 void TcpTransport::ensureConnected() const {
@@ -400,24 +439,7 @@ void TcpTransport::applySocketOptions() {
 
     SocketHandle socket = impl_->socket;
 
-    // Enable keepalive by default.
-    const int enable = 1;
-    ::setsockopt(socket, SOL_SOCKET, SO_KEEPALIVE,
-#ifdef _WIN32
-                 reinterpret_cast<const char*>(&enable),
-#else
-                 &enable,
-#endif
-                 sizeof(enable));
-
-    // Disable Nagle to reduce latency.
-    ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY,
-#ifdef _WIN32
-                 reinterpret_cast<const char*>(&enable),
-#else
-                 &enable,
-#endif
-                 sizeof(enable));
+    detail::applyLatencyOptions(socket);
 
     // Apply send timeout.
     if (impl_->send_timeout.count() > 0) {
@@ -451,11 +473,7 @@ void TcpTransport::applySocketOptions() {
 }
 
 bool TcpTransport::isTimeoutError(int error_code) const {
-#ifdef _WIN32
-    return error_code == WSAEWOULDBLOCK || error_code == WSAETIMEDOUT;
-#else
-    return error_code == EWOULDBLOCK || error_code == EAGAIN || error_code == ETIMEDOUT;
-#endif
+    return detail::isTimeoutError(error_code);
 }
 
 void TcpTransport::markDisconnected() noexcept {
@@ -467,6 +485,8 @@ void TcpTransport::markDisconnected() noexcept {
         closeSocket(impl_->socket);
         impl_->socket = kInvalidSocket;
     }
+    impl_->rx_begin = 0;
+    impl_->rx_end = 0;
 }
 
 } // namespace cpmcprotocol
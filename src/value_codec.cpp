@@ -52,15 +52,15 @@ std::string toHexPadded(std::uint32_t value, std::size_t width) {
     return oss.str();
 }
 
-} // namespace
-
-std::vector<DeviceValue> ValueCodec::decode(const DeviceReadPlan& plan, const std::vector<std::uint16_t>& words) const {
+// 読み取りプランのフォーマット列に従ってワード列をデコードする（DeviceReadPlan / ResolvedReadPlan 共通）。
+template <typename Plan>
+std::vector<DeviceValue> decodePlan(const Plan& plan, const std::vector<std::uint16_t>& words) {
     std::vector<DeviceValue> result;
     result.reserve(plan.size());
 
     std::size_t offset = 0;
     for (const auto& entry : plan) {
-        const std::size_t required = requiredWords(entry.format);
+        const std::size_t required = ValueCodec::requiredWords(entry.format);
         if (offset + required > words.size()) {
             throw std::invalid_argument("Insufficient word data for decode");
         }
@@ -191,6 +191,25 @@ std::vector<DeviceValue> ValueCodec::decode(const DeviceReadPlan& plan, const st
     return result;
 }
 
+} // namespace
+
+ResolvedReadPlan resolveReadPlan(const DeviceReadPlan& plan) {
+    ResolvedReadPlan resolved;
+    resolved.reserve(plan.size());
+    for (const auto& entry : plan) {
+        resolved.push_back(ResolvedReadPlanEntry{resolveDevice(entry.address), entry.format});
+    }
+    return resolved;
+}
+
+std::vector<DeviceValue> ValueCodec::decode(const DeviceReadPlan& plan, const std::vector<std::uint16_t>& words) const {
+    return decodePlan(plan, words);
+}
+
+std::vector<DeviceValue> ValueCodec::decode(const ResolvedReadPlan& plan, const std::vector<std::uint16_t>& words) const {
+    return decodePlan(plan, words);
+}
+
 static const std::uint16_t* expectWordValue(const DeviceValue& value, std::uint16_t& storage) {
     if (auto ptr = std::get_if<std::uint16_t>(&value)) {
         return ptr;
@@ -340,7 +359,7 @@ std::vector<std::uint16_t> ValueCodec::encode(const DeviceWritePlan& plan) const
     return words;
 }
 
-std::vector<std::uint16_t> ValueCodec::fromBinaryBytes(const std::vector<std::uint8_t>& bytes) {
+std::vector<std::uint16_t> ValueCodec::fromBinaryBytes(std::span<const std::uint8_t> bytes) {
     if (bytes.size() % 2 != 0) {
         throw std::invalid_argument("Binary byte stream length must be even");
     }
@@ -352,15 +371,27 @@ std::vector<std::uint16_t> ValueCodec::fromBinaryBytes(const std::vector<std::ui
     return words;
 }
 
-std::vector<std::uint16_t> ValueCodec::fromAsciiWords(const std::vector<std::uint8_t>& ascii) {
+std::vector<std::uint16_t> ValueCodec::fromAsciiWords(std::span<const std::uint8_t> ascii) {
     if (ascii.size() % 4 != 0) {
         throw std::invalid_argument("ASCII word stream must be a multiple of 4 characters");
     }
     std::vector<std::uint16_t> words(ascii.size() / 4);
     for (std::size_t i = 0; i < words.size(); ++i) {
-        std::string hex(reinterpret_cast<const char*>(ascii.data() + 4 * i), 4);
-        std::uint32_t value = static_cast<std::uint32_t>(std::stoul(hex, nullptr, 16));
-        words[i] = static_cast<std::uint16_t>(value & 0xFFFF);
+        std::uint16_t value = 0;
+        for (std::size_t j = 0; j < 4; ++j) {
+            const char c = static_cast<char>(ascii[4 * i + j]);
+            value = static_cast<std::uint16_t>(value << 4);
+            if (c >= '0' && c <= '9') {
+                value |= static_cast<std::uint16_t>(c - '0');
+            } else if (c >= 'A' && c <= 'F') {
+                value |= static_cast<std::uint16_t>(c - 'A' + 10);
+            } else if (c >= 'a' && c <= 'f') {
+                value |= static_cast<std::uint16_t>(c - 'a' + 10);
+            } else {
+                throw std::invalid_argument("Invalid hex digit in ASCII word stream");
+            }
+        }
+        words[i] = value;
     }
     return words;
 }
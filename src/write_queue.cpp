@@ -0,0 +1,334 @@
+#include "cpmcprotocol/write_queue.hpp"
+
+#include "cpmcprotocol/mc_client.hpp"
+#include "cpmcprotocol/codec/frame_encoder.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <variant>
+
+namespace cpmcprotocol {
+
+namespace {
+
+// 書き込む 1 点（device.number がその点の番号）。ビットデバイスの値は 0/1。
+struct PointWrite {
+    ResolvedDevice device;
+    std::uint16_t value = 0;
+};
+
+// 書き込み範囲の先頭デバイスと点数を確認する。
+void checkRange(const ResolvedDevice& head, std::size_t count) {
+    if (head.type == DeviceType::DoubleWord) {
+        throw std::invalid_argument("WriteQueue does not support double-word devices");
+    }
+    if (count == 0) {
+        throw std::invalid_argument("DeviceRange.length must be greater than zero");
+    }
+    if (count - 1 > std::numeric_limits<std::uint32_t>::max() - head.number) {
+        throw std::invalid_argument("Device range exceeds the device number space");
+    }
+}
+
+void appendPoint(std::vector<PointWrite>& points, const ResolvedDevice& head, std::size_t offset, std::uint16_t value) {
+    PointWrite point{head, value};
+    point.device.number += static_cast<std::uint32_t>(offset);
+    if (head.type == DeviceType::Bit) {
+        point.value = value != 0 ? 1 : 0;
+    }
+    points.push_back(point);
+}
+
+} // namespace
+
+struct WriteQueue::Impl {
+    using Clock = std::chrono::steady_clock;
+    // 送信待ちの値。キーは (デバイス種別 << 32) | 番号で、同じ種別の番号順に並ぶ。
+    using Image = std::map<std::uint64_t, std::uint16_t>;
+
+    Impl(McClient& c, WriteQueueOptions o) : client(c), options(o) {}
+
+    McClient& client;
+    const WriteQueueOptions options;
+    ValueCodec value_codec;
+
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    Image pending;
+    // 種別ごとのデバイスコードと型（キーから ResolvedDevice を組み立てる）
+    std::map<std::uint8_t, ResolvedDevice> devices;
+    Clock::time_point first_pending{};
+
+    // 書き込みを積んだ回数と、送信が完了した・失敗した時点の回数（fence() の待ち合わせに使う）
+    std::uint64_t enqueued = 0;
+    std::uint64_t sent = 0;
+    std::uint64_t failed = 0;
+    std::exception_ptr error;
+    std::uint64_t fence_target = 0;
+    bool running = false;
+    bool stop_requested = false;
+
+    static std::uint64_t keyOf(const ResolvedDevice& device) {
+        return (static_cast<std::uint64_t>(device.kind) << 32) | device.number;
+    }
+
+    void enqueue(const std::vector<PointWrite>& points) {
+        if (points.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (pending.empty()) {
+                first_pending = Clock::now();
+            }
+            for (const auto& point : points) {
+                devices.try_emplace(point.device.kind, point.device);
+                pending[keyOf(point.device)] = point.value;
+            }
+            ++enqueued;
+        }
+        cv.notify_all();
+    }
+
+    // 連続する点を 1 つの区間として、長ければ一括書き込み、短ければランダム書き込みに加える。
+    // 短いワードの区間は 2 ワードずつダブルワードにまとめる（点数の重みが 12×2 から 14 に下がる）。
+    void appendRun(WriteBatch& batch, const ResolvedDevice& head, const std::vector<std::uint16_t>& values) const {
+        if (values.size() >= options.batch_threshold) {
+            batch.ranges.push_back(ResolvedRange{head, static_cast<std::uint16_t>(values.size())});
+            batch.range_values.push_back(values);
+            return;
+        }
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            ResolvedDevice device = head;
+            device.number += static_cast<std::uint32_t>(i);
+            if (head.type == DeviceType::Bit) {
+                batch.random.bit_devices.push_back(device);
+                batch.bit_values.push_back(values[i] != 0);
+            } else if (i + 1 < values.size()) {
+                batch.random.dword_devices.push_back(device);
+                batch.dword_values.push_back(static_cast<std::uint32_t>(values[i]) |
+                                             (static_cast<std::uint32_t>(values[i + 1]) << 16));
+                ++i;
+            } else {
+                batch.random.word_devices.push_back(device);
+                batch.word_values.push_back(values[i]);
+            }
+        }
+    }
+
+    WriteBatch buildBatch(const Image& image, const std::map<std::uint8_t, ResolvedDevice>& kinds) const {
+        WriteBatch batch;
+        std::vector<std::uint16_t> values;
+        auto it = image.begin();
+        while (it != image.end()) {
+            ResolvedDevice head = kinds.at(static_cast<std::uint8_t>(it->first >> 32));
+            head.number = static_cast<std::uint32_t>(it->first);
+            const std::size_t limit = codec::FrameEncoder::maxBatchWritePoints(head.type);
+
+            values.assign(1, it->second);
+            auto last = it++;
+            while (it != image.end() && it->first == last->first + 1 && (it->first >> 32) == (last->first >> 32) &&
+                   values.size() < limit) {
+                values.push_back(it->second);
+                last = it++;
+            }
+            appendRun(batch, head, values);
+        }
+        return batch;
+    }
+};
+
+WriteQueue::WriteQueue(McClient& client, WriteQueueOptions options)
+    : impl_(std::make_unique<Impl>(client, options)) {
+    if (options.batch_threshold == 0) {
+        throw std::invalid_argument("WriteQueue batch_threshold must be positive");
+    }
+}
+
+WriteQueue::~WriteQueue() = default;
+
+void WriteQueue::writeWords(const DeviceRange& range, const std::vector<std::uint16_t>& values) {
+    if (values.size() < range.length) {
+        throw std::invalid_argument("Insufficient word data for write");
+    }
+    const ResolvedDevice head = resolveDevice(range.head);
+    checkRange(head, range.length);
+    std::vector<PointWrite> points;
+    points.reserve(range.length);
+    for (std::size_t i = 0; i < range.length; ++i) {
+        appendPoint(points, head, i, values[i]);
+    }
+    impl_->enqueue(points);
+}
+
+void WriteQueue::writeBits(const DeviceRange& range, const std::vector<bool>& values) {
+    if (values.size() < range.length) {
+        throw std::invalid_argument("Insufficient bit data for write");
+    }
+    const ResolvedDevice head = resolveDevice(range.head);
+    checkRange(head, range.length);
+    std::vector<PointWrite> points;
+    points.reserve(range.length);
+    for (std::size_t i = 0; i < range.length; ++i) {
+        appendPoint(points, head, i, values[i] ? 1 : 0);
+    }
+    impl_->enqueue(points);
+}
+
+void WriteQueue::randomWrite(const DeviceWritePlan& plan) {
+    // プラン全体を検証・展開してから積む（途中のエントリが不正でも一部だけを積まない）
+    std::vector<PointWrite> points;
+    for (const auto& entry : plan) {
+        const ResolvedDevice head = resolveDevice(entry.address);
+        if (entry.format.type == ValueType::BitArray) {
+            const auto* bits = std::get_if<std::vector<bool>>(&entry.value);
+            if (bits == nullptr) {
+                throw std::invalid_argument("BitArray format requires vector<bool> value");
+            }
+            checkRange(head, bits->size());
+            if (head.type != DeviceType::Bit) {
+                throw std::invalid_argument("BitArray format requires a bit device");
+            }
+            for (std::size_t i = 0; i < bits->size(); ++i) {
+                appendPoint(points, head, i, (*bits)[i] ? 1 : 0);
+            }
+            continue;
+        }
+
+        const auto words = impl_->value_codec.encode(DeviceWritePlan{entry});
+        // ビットデバイスへのワード値は、下位ビットから順に 16 点ずつ書き込む
+        const std::size_t per_word = (head.type == DeviceType::Bit) ? 16 : 1;
+        checkRange(head, words.size() * per_word);
+        for (std::size_t w = 0; w < words.size(); ++w) {
+            if (per_word == 1) {
+                appendPoint(points, head, w, words[w]);
+                continue;
+            }
+            for (std::size_t b = 0; b < per_word; ++b) {
+                appendPoint(points, head, w * per_word + b, static_cast<std::uint16_t>((words[w] >> b) & 0x1));
+            }
+        }
+    }
+    impl_->enqueue(points);
+}
+
+std::size_t WriteQueue::flush() {
+    Impl::Image taken;
+    std::map<std::uint8_t, ResolvedDevice> kinds;
+    std::uint64_t sequence = 0;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        if (impl_->pending.empty()) {
+            return 0;
+        }
+        taken.swap(impl_->pending);
+        kinds = impl_->devices;
+        sequence = impl_->enqueued;
+    }
+
+    try {
+        impl_->client.writeBatch(impl_->buildBatch(taken, kinds));
+    } catch (...) {
+        {
+            // 送信中に積まれた値の方が新しいため、同じデバイスは上書きしない
+            std::lock_guard<std::mutex> lock(impl_->mutex);
+            if (impl_->pending.empty()) {
+                impl_->first_pending = Impl::Clock::now();
+            }
+            impl_->pending.insert(taken.begin(), taken.end());
+            impl_->failed = sequence;
+            impl_->error = std::current_exception();
+        }
+        impl_->cv.notify_all();
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->sent = sequence;
+    }
+    impl_->cv.notify_all();
+    return taken.size();
+}
+
+void WriteQueue::fence() {
+    std::unique_lock<std::mutex> lock(impl_->mutex);
+    const std::uint64_t target = impl_->enqueued;
+    if (impl_->sent >= target) {
+        return;
+    }
+    if (!impl_->running) {
+        throw std::runtime_error("WriteQueue is not running");
+    }
+    impl_->fence_target = std::max(impl_->fence_target, target);
+    impl_->cv.notify_all();
+    impl_->cv.wait(lock, [&] {
+        return impl_->sent >= target || (impl_->error && impl_->failed >= target) || !impl_->running;
+    });
+    if (impl_->sent >= target) {
+        return;
+    }
+    if (impl_->error && impl_->failed >= target) {
+        std::rethrow_exception(impl_->error);
+    }
+    throw std::runtime_error("WriteQueue stopped before the writes were sent");
+}
+
+void WriteQueue::run() {
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->running = true;
+        impl_->error = nullptr;
+    }
+    auto finish = [this] {
+        {
+            std::lock_guard<std::mutex> lock(impl_->mutex);
+            impl_->running = false;
+            impl_->stop_requested = false;
+        }
+        impl_->cv.notify_all();
+    };
+
+    try {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(impl_->mutex);
+                impl_->cv.wait(lock, [this] { return impl_->stop_requested || !impl_->pending.empty(); });
+                if (impl_->pending.empty()) {
+                    break;
+                }
+                // 最初の書き込みから max_delay の間に積まれた書き込みをまとめる（fence() と stop() は待たない）
+                if (!impl_->stop_requested) {
+                    impl_->cv.wait_until(lock, impl_->first_pending + impl_->options.max_delay, [this] {
+                        return impl_->stop_requested || impl_->fence_target > impl_->sent;
+                    });
+                }
+            }
+            flush();
+        }
+    } catch (...) {
+        finish();
+        throw;
+    }
+    finish();
+}
+
+void WriteQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->stop_requested = true;
+    }
+    impl_->cv.notify_all();
+}
+
+std::size_t WriteQueue::pendingPoints() const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->pending.size();
+}
+
+} // namespace cpmcprotocol
@@ -0,0 +1,216 @@
+#include "cpmcprotocol/async_client.hpp"
+#include "cpmcprotocol/session_config.hpp"
+#include "cpmcprotocol/task.hpp"
+#include "util/mock_plc.hpp"
+#include "util/mock_slmp_server.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace cpmcprotocol;
+using cpmcprotocol::testutil::MockPlc;
+using cpmcprotocol::testutil::MockSlmpServer;
+
+namespace {
+
+// 未書き込みの D は番号の下位 16bit、M は 0（D9999 を含む読み出しは PLC エラーにする）
+std::uint16_t initialValue(std::uint16_t code, std::uint32_t number) {
+    return code == MockPlc::kCodeD ? static_cast<std::uint16_t>(number) : 0;
+}
+
+SessionConfig makeConfig(std::uint16_t port, FrameType frame_type) {
+    SessionConfig config{};
+    config.host = "127.0.0.1";
+    config.port = port;
+    config.frame_type = frame_type;
+    config.series = PlcSeries::IQ_R;
+    config.max_in_flight = 4;
+    return config;
+}
+
+template <typename Done>
+void runUntil(EventLoop& loop, Done done) {
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+    while (!done() && std::chrono::steady_clock::now() < deadline) {
+        loop.runOnce(100ms);
+    }
+    assert(done());
+}
+
+// 書き込んだ値を読み直し、一致しなければ失敗を数える
+Task<> writeAndReadBack(McAsyncClient& client, std::uint32_t number, int& failures, int& finished) {
+    const auto range = makeDeviceRange("D" + std::to_string(number), 2);
+    const auto value = static_cast<std::uint16_t>(number * 3);
+    // 初期化子リストの一時配列を co_await をまたいで使うと GCC 12 がコンパイルできないため、先に作る
+    const std::vector<std::uint16_t> values{value, static_cast<std::uint16_t>(value + 1)};
+    co_await client.writeWords(range, values);
+    const auto words = co_await client.readWords(range);
+    if (words != values) {
+        ++failures;
+    }
+    ++finished;
+}
+
+Task<std::vector<std::uint16_t>> readArea(McAsyncClient& client, std::size_t count) {
+    co_return co_await client.readWordArea(makeDeviceAddress("D20000"), count);
+}
+
+void testOperations(FrameType frame_type, std::uint16_t port) {
+    MockPlc plc(initialValue);
+    plc.setFaultDevice(MockPlc::kCodeD, 9999);
+    MockSlmpServer server;
+    server.start(port, plc.handler());
+
+    EventLoop loop;
+    McAsyncClient client(loop);
+    client.connect(makeConfig(port, frame_type));
+    assert(client.isConnected());
+
+    // 1 スレッドで多数の操作を同時に待つ（送信数の上限を超える分は順に送信される）
+    constexpr int kTasks = 200;
+    int failures = 0;
+    int finished = 0;
+    for (int i = 0; i < kTasks; ++i) {
+        spawn(writeAndReadBack(client, static_cast<std::uint32_t>(1000 + i * 2), failures, finished));
+    }
+    assert(client.pendingCount() > 0);
+    runUntil(loop, [&] { return finished == kTasks; });
+    assert(failures == 0 && client.pendingCount() == 0);
+
+    // 分割読み出しと、タスクの入れ子
+    bool done = false;
+    spawn([](McAsyncClient& client, bool& done) -> Task<> {
+        const auto words = co_await readArea(client, 3000);
+        assert(words.size() == 3000);
+        for (std::uint32_t i = 0; i < words.size(); ++i) {
+            assert(words[i] == static_cast<std::uint16_t>(20000 + i));
+        }
+
+        const std::vector<bool> pattern{true, false, true};
+        co_await client.writeBits(makeDeviceRange("M10", 3), pattern);
+        const auto bits = co_await client.readBits(makeDeviceRange("M9", 5));
+        assert((bits == std::vector<bool>{false, true, false, true, false}));
+
+        DeviceReadPlan plan;
+        plan.push_back({makeDeviceAddress("D5"), ValueFormat::UInt16()});
+        plan.push_back({makeDeviceAddress("D1000"), ValueFormat::UInt32()});
+        plan.push_back({makeDeviceAddress("D7"), ValueFormat::Int16()});
+        const auto values = co_await client.randomRead(plan);
+        assert(std::get<std::uint16_t>(values[0]) == 5);
+        assert(std::get<std::uint32_t>(values[1]) == (3000u | (3001u << 16)));
+        assert(std::get<std::int16_t>(values[2]) == 7);
+        done = true;
+    }(client, done));
+    runUntil(loop, [&] { return done; });
+
+    // PLC エラーと引数の不正は co_await した箇所で送出され、他の操作には影響しない
+    done = false;
+    spawn([](McAsyncClient& client, bool& done) -> Task<> {
+        bool threw = false;
+        try {
+            co_await client.readWordArea(makeDeviceAddress("D9000"), 2000);
+        } catch (const TransportError&) {
+            assert(false);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+
+        threw = false;
+        try {
+            const std::vector<std::uint16_t> short_values(1, 1);
+            co_await client.writeWords(makeDeviceRange("D0", 2), short_values);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+
+        const auto words = co_await client.readWords(makeDeviceRange("D42", 1));
+        assert(words[0] == 42);
+        done = true;
+    }(client, done));
+    runUntil(loop, [&] { return done; });
+
+    // 切断すると待っている操作は TransportError で完了し、以降の操作も失敗する
+    int disconnected = 0;
+    auto expectDisconnected = [](McAsyncClient& client, int& disconnected) -> Task<> {
+        try {
+            co_await client.readWordArea(makeDeviceAddress("D0"), 5000);
+        } catch (const TransportError&) {
+            ++disconnected;
+        }
+    };
+    spawn(expectDisconnected(client, disconnected));
+    spawn(expectDisconnected(client, disconnected));
+    client.disconnect();
+    assert(disconnected == 2 && client.pendingCount() == 0);
+    spawn(expectDisconnected(client, disconnected));
+    assert(disconnected == 3);
+
+    server.stop();
+}
+
+void testTimeout() {
+    MockSlmpServer server;
+    server.start(56031, [](const std::vector<std::uint8_t>&) { return std::vector<std::uint8_t>{}; });
+
+    EventLoop loop;
+    McAsyncClient client(loop);
+    auto config = makeConfig(56031, FrameType::Frame4E);
+    config.timeout_250ms = 1;
+    client.connect(config);
+
+    bool timed_out = false;
+    std::exception_ptr unexpected;
+    spawn(
+        [](McAsyncClient& client, bool& timed_out) -> Task<> {
+            try {
+                co_await client.readWords(makeDeviceRange("D0", 1));
+            } catch (const TransportTimeoutError&) {
+                timed_out = true;
+            }
+        }(client, timed_out),
+        [&unexpected](std::exception_ptr error) { unexpected = error; });
+    runUntil(loop, [&] { return timed_out; });
+    assert(!unexpected);
+    // 4E フレームではタイムアウトした要求だけが失敗し、接続は維持する
+    assert(client.isConnected());
+
+    // spawn() したタスクの例外は on_error に渡る
+    spawn([]() -> Task<> { throw std::logic_error("failed"); co_return; }(),
+          [&unexpected](std::exception_ptr error) { unexpected = error; });
+    assert(unexpected);
+
+    // ムーブ元の Task を co_await すると logic_error を送出する
+    bool rejected = false;
+    spawn([](bool& rejected) -> Task<> {
+        auto task = []() -> Task<int> { co_return 1; }();
+        auto moved = std::move(task);
+        try {
+            co_await std::move(task);
+        } catch (const std::logic_error&) {
+            rejected = true;
+        }
+        assert(co_await std::move(moved) == 1);
+    }(rejected));
+    assert(rejected);
+
+    client.disconnect();
+    server.stop();
+}
+
+} // namespace
+
+int main() {
+    testOperations(FrameType::Frame4E, 56029);
+    testOperations(FrameType::Frame3E, 56030);
+    testTimeout();
+    return 0;
+}
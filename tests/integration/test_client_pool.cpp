@@ -0,0 +1,220 @@
+#include "cpmcprotocol/client_pool.hpp"
+#include "cpmcprotocol/session_config.hpp"
+#include "cpmcprotocol/transport.hpp"
+#include "util/mock_slmp_server.hpp"
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace cpmcprotocol;
+using cpmcprotocol::testutil::make4EBinaryResponse;
+using cpmcprotocol::testutil::MockSlmpServer;
+
+namespace {
+
+constexpr std::array<std::uint16_t, 3> kPorts{56025, 56026, 56027};
+constexpr std::uint16_t kUnusedPort = 56028;
+
+// 読み出しの値はデバイス番号から決まる（ワードは番号の下位 16 ビット、ビットは 3 の倍数の番号が ON）。
+// D60000 以降への要求は PLC エラーを返す。
+std::uint16_t wordAt(std::uint32_t number) {
+    return static_cast<std::uint16_t>(number & 0xFFFF);
+}
+
+bool bitAt(std::uint32_t number) {
+    return number % 3 == 0;
+}
+
+std::vector<std::uint8_t> serveBatch(const std::vector<std::uint8_t>& request, std::atomic<int>& frames) {
+    if (request.size() < 27 || request[0] != 0x54) {
+        return {};
+    }
+    auto read_u16 = [&](std::size_t offset) {
+        return static_cast<std::uint16_t>(request[offset] | (request[offset + 1] << 8));
+    };
+    const std::uint32_t head = static_cast<std::uint32_t>(request[19] | (request[20] << 8) | (request[21] << 16) |
+                                                          (request[22] << 24));
+    const std::uint16_t points = read_u16(25);
+    ++frames;
+
+    std::vector<std::uint8_t> payload;
+    switch (read_u16(15)) {
+    case 0x0401:
+        if (head + points > 60000) {
+            return make4EBinaryResponse(request, {}, 0xC051);
+        }
+        if (read_u16(17) == 0x0003) {
+            // 1 バイトに 2 点（上位ニブルが先）
+            for (std::uint32_t i = 0; i < points; i += 2) {
+                payload.push_back(static_cast<std::uint8_t>((bitAt(head + i) ? 0x10 : 0x00) |
+                                                            (bitAt(head + i + 1) ? 0x01 : 0x00)));
+            }
+        } else {
+            for (std::uint32_t i = 0; i < points; ++i) {
+                payload.push_back(static_cast<std::uint8_t>(wordAt(head + i) & 0xFF));
+                payload.push_back(static_cast<std::uint8_t>(wordAt(head + i) >> 8));
+            }
+        }
+        return make4EBinaryResponse(request, payload);
+    case 0x1401:
+        return make4EBinaryResponse(request, {});
+    default:
+        return {};
+    }
+}
+
+SessionConfig makeConfig() {
+    SessionConfig config{};
+    config.host = "127.0.0.1";
+    config.frame_type = FrameType::Frame4E;
+    config.series = PlcSeries::IQ_R;
+    return config;
+}
+
+} // namespace
+
+int main() {
+    std::array<MockSlmpServer, kPorts.size()> servers;
+    std::array<std::atomic<int>, kPorts.size()> frames{};
+    for (std::size_t i = 0; i < servers.size(); ++i) {
+        servers[i].start(kPorts[i], [&frames, i](const std::vector<std::uint8_t>& request) {
+            return serveBatch(request, frames[i]);
+        });
+    }
+    auto resetFrames = [&frames] {
+        for (auto& count : frames) {
+            count = 0;
+        }
+    };
+
+    McClientPool pool;
+
+    // 接続前は要求できない
+    bool threw = false;
+    try {
+        pool.readWords(makeDeviceRange("D0", 1));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw && !pool.isConnected());
+
+    threw = false;
+    try {
+        pool.connect(makeConfig(), {});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // 1 つでも接続できなければ全体を失敗させ、接続済みの分も切断する
+    threw = false;
+    try {
+        pool.connect(makeConfig(), {kPorts[0], kUnusedPort});
+    } catch (const TransportError&) {
+        threw = true;
+    }
+    assert(threw && !pool.isConnected() && pool.size() == 0);
+
+    pool.connect(makeConfig(), {kPorts.begin(), kPorts.end()});
+    assert(pool.isConnected() && pool.size() == kPorts.size());
+
+    // 大容量の読み取りは 960 点単位の要求を接続数で分け、並行して読み取る（6 要求 → 2 要求ずつ）
+    {
+        const auto words = pool.readWordArea(makeDeviceAddress("D1000"), 5000);
+        assert(words.size() == 5000);
+        for (std::uint32_t i = 0; i < words.size(); ++i) {
+            assert(words[i] == wordAt(1000 + i));
+        }
+        for (const auto& count : frames) {
+            assert(count == 2);
+        }
+    }
+
+    // 要求数が接続数に満たなければ、その数の接続だけを使う（7168 点単位で 3 要求 → 1 要求ずつ）
+    resetFrames();
+    {
+        const auto bits = pool.readBitArea(makeDeviceAddress("M10"), 20000);
+        assert(bits.size() == 20000);
+        for (std::uint32_t i = 0; i < bits.size(); ++i) {
+            assert(bits[i] == bitAt(10 + i));
+        }
+        for (const auto& count : frames) {
+            assert(count == 1);
+        }
+
+        resetFrames();
+        const auto small = pool.readWordArea(makeDeviceAddress("D50"), 100);
+        assert(small.size() == 100 && small[99] == wordAt(149));
+        assert(frames[0] + frames[1] + frames[2] == 1);
+    }
+
+    // 要求は実行中の要求が最も少ない接続に振り分ける
+    {
+        auto first = pool.acquire();
+        auto second = pool.acquire();
+        assert(first.index() != second.index());
+        auto third = pool.acquire();
+        assert(third.index() != first.index() && third.index() != second.index());
+
+        // 全接続が貸し出し中でも分割読み取りはできる（各接続で多重化される）
+        const auto words = pool.readWordArea(makeDeviceAddress("D0"), 2000);
+        assert(words[1999] == wordAt(1999));
+
+        // 返却した接続が次に選ばれる
+        const std::size_t released = second.index();
+        { auto done = std::move(second); }
+        auto next = pool.acquire();
+        assert(next.index() == released);
+        assert(next->readWords(makeDeviceRange("D7", 1))[0] == wordAt(7));
+    }
+
+    // 貸し出していなければ、順に別の接続を使う
+    resetFrames();
+    for (int i = 0; i < 6; ++i) {
+        pool.writeWords(makeDeviceRange("D0", 1), {1});
+    }
+    for (const auto& count : frames) {
+        assert(count == 2);
+    }
+
+    // 区間の 1 つが失敗しても、他の区間の完了を待ってから例外を送出する
+    threw = false;
+    try {
+        pool.readWordArea(makeDeviceAddress("D58000"), 3000);
+    } catch (const TransportError&) {
+        assert(false);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw && pool.isConnected());
+    assert(pool.readWordArea(makeDeviceAddress("D100"), 3000)[2999] == wordAt(3099));
+
+    // disconnect() は貸し出し中の Lease の返却を待ち、待つ間も Lease を保持したスレッドはプールの要求を呼べる
+    {
+        auto lease = pool.acquire();
+        std::atomic<bool> disconnected{false};
+        std::thread closer([&] {
+            pool.disconnect();
+            disconnected = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        assert(!disconnected && pool.size() == kPorts.size());
+        assert(pool.readWords(makeDeviceRange("D8", 1))[0] == wordAt(8));
+        assert(pool.readWordArea(makeDeviceAddress("D0"), 2000)[1999] == wordAt(1999));
+        assert(!disconnected);
+        { auto done = std::move(lease); }
+        closer.join();
+        assert(disconnected);
+    }
+    assert(!pool.isConnected() && pool.size() == 0);
+    for (auto& server : servers) {
+        server.stop();
+    }
+    return 0;
+}
@@ -0,0 +1,276 @@
+#include "cpmcprotocol/event_transport.hpp"
+#include "cpmcprotocol/mc_client.hpp"
+#include "cpmcprotocol/session_config.hpp"
+#include "cpmcprotocol/transport.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace cpmcprotocol;
+using namespace std::chrono_literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::uint16_t kOpenPort = 56035;      // 受け付け待ちに入るだけで accept しない（接続は確立する）
+constexpr std::uint16_t kRefusedPort = 56036;   // 待ち受けなし（RST で即座に拒否される）
+constexpr std::uint16_t kBlackholePort = 56037; // 受け付け待ちが満杯で SYN が捨てられる（電源断の PLC 相当）
+
+// ループバックで待ち受けるだけのソケット。accept しないため、backlog を超えた SYN はカーネルが捨てる。
+class Listener {
+public:
+    Listener(std::uint16_t port, int backlog) : port_(port) {
+        socket_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        assert(socket_ >= 0);
+        const int reuse = 1;
+        ::setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        const int bound = ::bind(socket_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+        assert(bound == 0);
+        const int listening = ::listen(socket_, backlog);
+        assert(listening == 0);
+        (void)bound;
+        (void)listening;
+    }
+
+    ~Listener() {
+        for (int filler : fillers_) {
+            ::close(filler);
+        }
+        ::close(socket_);
+    }
+
+    Listener(const Listener&) = delete;
+    Listener& operator=(const Listener&) = delete;
+
+    // 受け付け待ちを埋める接続をノンブロッキングで開始する
+    void fill(int count) {
+        for (int i = 0; i < count; ++i) {
+            const int filler = ::socket(AF_INET, SOCK_STREAM, 0);
+            ::fcntl(filler, F_SETFL, ::fcntl(filler, F_GETFL, 0) | O_NONBLOCK);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(port_);
+            ::connect(filler, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+            fillers_.push_back(filler);
+        }
+        std::this_thread::sleep_for(50ms);
+    }
+
+private:
+    std::uint16_t port_;
+    int socket_ = -1;
+    std::vector<int> fillers_;
+};
+
+SessionConfig makeConfig(std::uint16_t port) {
+    SessionConfig config;
+    config.host = "127.0.0.1";
+    config.port = port;
+    config.timeout_250ms = 2; // 500ms
+    return config;
+}
+
+template <typename Error>
+bool holds(const std::exception_ptr& error) {
+    try {
+        std::rethrow_exception(error);
+    } catch (const Error&) {
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+} // namespace
+
+int main() {
+    Listener open_listener(kOpenPort, 128);
+    Listener blackhole(kBlackholePort, 0);
+    blackhole.fill(2);
+
+    // 単独の接続
+    {
+        TcpTransport transport;
+        transport.connect(makeConfig(kOpenPort));
+        assert(transport.isConnected());
+    }
+
+    // ホスト名は数値アドレスの接続と並行して解決する
+    {
+        std::vector<TcpTransport> transports(2);
+        std::vector<TcpTransport*> targets{&transports[0], &transports[1]};
+        std::vector<SessionConfig> configs{makeConfig(kOpenPort), makeConfig(kOpenPort)};
+        configs[0].host = "localhost";
+        const auto errors = TcpTransport::connectAll(targets, configs);
+        assert(!errors[0] && !errors[1]);
+        assert(transports[0].isConnected() && transports[1].isConnected());
+    }
+
+    // 拒否された接続はタイムアウトを待たずに失敗する
+    {
+        TcpTransport transport;
+        const auto started = Clock::now();
+        bool refused = false;
+        try {
+            transport.connect(makeConfig(kRefusedPort));
+        } catch (const TransportTimeoutError&) {
+            assert(false);
+        } catch (const TransportError&) {
+            refused = true;
+        }
+        assert(refused);
+        assert(!transport.isConnected());
+        assert(Clock::now() - started < 400ms);
+    }
+
+    // 応答しない接続先はカーネルの SYN 再送（約 2 分）ではなく timeout_250ms で打ち切る
+    {
+        TcpTransport transport;
+        const auto started = Clock::now();
+        bool timed_out = false;
+        try {
+            transport.connect(makeConfig(kBlackholePort));
+        } catch (const TransportTimeoutError&) {
+            timed_out = true;
+        }
+        const auto elapsed = Clock::now() - started;
+        assert(timed_out);
+        assert(!transport.isConnected());
+        assert(elapsed >= 450ms && elapsed < 1500ms);
+    }
+
+    // 一括接続: 応答しない接続先が複数あっても、待つのはデッドライン 1 回分
+    {
+        std::vector<TcpTransport> transports(6);
+        std::vector<TcpTransport*> targets;
+        for (auto& transport : transports) {
+            targets.push_back(&transport);
+        }
+        const std::vector<SessionConfig> configs{makeConfig(kBlackholePort), makeConfig(kOpenPort),
+                                                 makeConfig(kBlackholePort), makeConfig(kRefusedPort),
+                                                 makeConfig(kBlackholePort), makeConfig(kOpenPort)};
+        const auto started = Clock::now();
+        const auto errors = TcpTransport::connectAll(targets, configs);
+        const auto elapsed = Clock::now() - started;
+        assert(elapsed < 1200ms); // 順に待てば 1.5 秒
+        assert(errors.size() == configs.size());
+        for (std::size_t i = 0; i < configs.size(); ++i) {
+            const bool expect_open = configs[i].port == kOpenPort;
+            assert((errors[i] == nullptr) == expect_open);
+            assert(transports[i].isConnected() == expect_open);
+            if (configs[i].port == kBlackholePort) {
+                assert(holds<TransportTimeoutError>(errors[i]));
+            } else if (configs[i].port == kRefusedPort) {
+                assert(holds<TransportError>(errors[i]) && !holds<TransportTimeoutError>(errors[i]));
+            }
+        }
+
+        // 要素数の不一致・重複は接続を始めずに拒否する
+        bool rejected = false;
+        try {
+            TcpTransport::connectAll(targets, std::span<const SessionConfig>(configs).first(2));
+        } catch (const std::invalid_argument&) {
+            rejected = true;
+        }
+        assert(rejected);
+        assert(transports[1].isConnected());
+    }
+
+    // イベント駆動の接続は確立を待たずに戻り、確立・失敗はループの通知で確認する
+    {
+        EventLoop loop;
+        AsyncTcpTransport opened(loop);
+        AsyncTcpTransport refused(loop);
+        AsyncTcpTransport silent(loop);
+        const auto started = Clock::now();
+        opened.connect(makeConfig(kOpenPort));
+        silent.connect(makeConfig(kBlackholePort));
+        assert(Clock::now() - started < 100ms);
+        assert(silent.isConnected() && silent.isConnecting() && silent.wantsWrite());
+
+        // 拒否はその場で送出されるか、ループで確認した時点で確立前に積んだ要求を失敗させる
+        std::exception_ptr refused_error;
+        try {
+            refused.connect(makeConfig(kRefusedPort));
+            refused.submit({0x50, 0x00}, std::nullopt, Clock::now() + 5s,
+                           [&](std::exception_ptr error, std::vector<std::uint8_t>) { refused_error = error; });
+        } catch (const TransportError&) {
+            refused_error = std::current_exception();
+        }
+
+        // 確立しない接続に積んだ要求は、要求の期限より先に接続のデッドラインで失敗する
+        std::exception_ptr silent_error;
+        silent.submit({0x50, 0x00}, std::nullopt, Clock::now() + 5s,
+                      [&](std::exception_ptr error, std::vector<std::uint8_t>) { silent_error = error; });
+        while (!silent_error && Clock::now() - started < 2s) {
+            loop.runOnce(100ms);
+        }
+        const auto elapsed = Clock::now() - started;
+        assert(holds<TransportTimeoutError>(silent_error));
+        assert(elapsed >= 450ms && elapsed < 1500ms);
+        assert(!silent.isConnected() && !silent.isConnecting());
+        assert(holds<TransportError>(refused_error) && !holds<TransportTimeoutError>(refused_error));
+        assert(!refused.isConnected());
+        assert(opened.isConnected() && !opened.isConnecting() && !opened.wantsWrite());
+    }
+
+    // McClient の一括接続（多数のセッションを並行して立ち上げる）
+    {
+        constexpr std::size_t kClients = 64;
+        std::vector<McClient> clients(kClients);
+        std::vector<McClient*> targets;
+        std::vector<SessionConfig> configs;
+        for (std::size_t i = 0; i < kClients; ++i) {
+            targets.push_back(&clients[i]);
+            configs.push_back(makeConfig(i % 16 == 15 ? kBlackholePort : kOpenPort));
+        }
+        const auto started = Clock::now();
+        const auto errors = McClient::connectAll(targets, configs);
+        assert(Clock::now() - started < 1200ms);
+        for (std::size_t i = 0; i < kClients; ++i) {
+            const bool expect_open = configs[i].port == kOpenPort;
+            assert((errors[i] == nullptr) == expect_open);
+            assert(clients[i].isConnected() == expect_open);
+        }
+
+        // 接続を待つ間もクライアントのロックは保持しない（状態の確認はデッドラインを待たずに返る）
+        std::thread reconnecting([&] { McClient::connectAll(targets, configs); });
+        std::this_thread::sleep_for(100ms);
+        const auto queried = Clock::now();
+        (void)clients[0].isConnected();
+        assert(Clock::now() - queried < 100ms);
+        reconnecting.join();
+        assert(clients[0].isConnected() && !clients[15].isConnected());
+
+        std::vector<McClient*> duplicated{&clients[0], &clients[0]};
+        const std::vector<SessionConfig> pair{configs[0], configs[0]};
+        bool rejected = false;
+        try {
+            McClient::connectAll(duplicated, pair);
+        } catch (const std::invalid_argument&) {
+            rejected = true;
+        }
+        assert(rejected);
+        assert(clients[0].isConnected());
+    }
+
+    return 0;
+}
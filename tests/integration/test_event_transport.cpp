@@ -0,0 +1,296 @@
+#include "cpmcprotocol/codec/frame_decoder.hpp"
+#include "cpmcprotocol/codec/frame_encoder.hpp"
+#include "cpmcprotocol/device.hpp"
+#include "cpmcprotocol/event_transport.hpp"
+#include "cpmcprotocol/session_config.hpp"
+#include "cpmcprotocol/value_codec.hpp"
+#include "util/mock_slmp_server.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace cpmcprotocol;
+using cpmcprotocol::testutil::MockSlmpServer;
+
+namespace {
+
+// 3E/4E の要求ヘッダーを折り返し、先頭デバイス番号を 1 ワードの値として返す。
+std::vector<std::uint8_t> echoHeadNumber(const std::vector<std::uint8_t>& request) {
+    const bool is4e = request[0] == 0x54;
+    const std::size_t route_end = is4e ? 11 : 7;
+    const std::size_t number_offset = is4e ? 19 : 15;
+
+    std::vector<std::uint8_t> response{static_cast<std::uint8_t>(is4e ? 0xD4 : 0xD0), 0x00};
+    response.insert(response.end(), request.begin() + 2, request.begin() + route_end);
+    response.push_back(0x04);
+    response.push_back(0x00);
+    response.push_back(0x00);
+    response.push_back(0x00);
+    response.push_back(request[number_offset]);
+    response.push_back(request[number_offset + 1]);
+    return response;
+}
+
+std::uint16_t decodeSingleWord(const std::vector<std::uint8_t>& frame) {
+    codec::FrameDecoder decoder;
+    auto parsed = decoder.parseBatchReadResponse(frame);
+    assert(parsed.completion_code == 0);
+    auto words = ValueCodec::fromBinaryBytes(parsed.device_data);
+    assert(words.size() == 1);
+    return words[0];
+}
+
+SessionConfig makeConfig(std::uint16_t port) {
+    SessionConfig config{};
+    config.host = "127.0.0.1";
+    config.port = port;
+    config.series = PlcSeries::IQ_R;
+    return config;
+}
+
+} // namespace
+
+int main() {
+    codec::FrameEncoder encoder;
+
+    // 1 スレッドのイベントループで複数接続を多重化する
+    constexpr std::size_t kConnections = 3;
+    constexpr std::uint16_t kBasePort = 56010;
+    constexpr std::size_t kRequestsPerConnection = 20;
+
+    std::vector<std::unique_ptr<MockSlmpServer>> servers;
+    for (std::size_t i = 0; i < kConnections; ++i) {
+        servers.push_back(std::make_unique<MockSlmpServer>());
+        servers.back()->start(static_cast<std::uint16_t>(kBasePort + i), echoHeadNumber);
+    }
+
+    {
+        EventLoop loop;
+#ifdef __linux__
+        // io_uring でビルドしてもカーネルが対応していなければ epoll になる（どちらでも以降の動作は同じ）
+        assert(loop.backend() == EventLoopBackend::Epoll || loop.backend() == EventLoopBackend::IoUring);
+#endif
+        std::vector<std::unique_ptr<AsyncTcpTransport>> transports;
+        for (std::size_t i = 0; i < kConnections; ++i) {
+            auto config = makeConfig(static_cast<std::uint16_t>(kBasePort + i));
+            if (i == kConnections - 1) {
+                config.frame_type = FrameType::Frame4E;
+            }
+            transports.push_back(std::make_unique<AsyncTcpTransport>(loop));
+            transports.back()->connect(config);
+        }
+        assert(loop.size() == kConnections);
+
+        std::size_t completed = 0;
+        bool all_ok = true;
+        const auto deadline = std::chrono::steady_clock::now() + 2s;
+        for (std::size_t c = 0; c < kConnections; ++c) {
+            auto config = makeConfig(static_cast<std::uint16_t>(kBasePort + c));
+            const bool is4e = (c == kConnections - 1);
+            if (is4e) {
+                config.frame_type = FrameType::Frame4E;
+            }
+            for (std::size_t r = 0; r < kRequestsPerConnection; ++r) {
+                const auto expected = static_cast<std::uint16_t>(c * 1000 + r);
+                auto request = encoder.makeBatchReadRequest(
+                    config, makeDeviceRange("D" + std::to_string(expected), 1));
+                std::optional<std::uint16_t> key;
+                if (is4e) {
+                    key = static_cast<std::uint16_t>(r);
+                    codec::FrameEncoder::setSerialNumber(request, *key);
+                }
+                transports[c]->submit(std::move(request), key, deadline,
+                                      [&, expected](std::exception_ptr error, std::vector<std::uint8_t> frame) {
+                                          ++completed;
+                                          if (error || decodeSingleWord(frame) != expected) {
+                                              all_ok = false;
+                                          }
+                                      });
+            }
+        }
+
+        while (completed < kConnections * kRequestsPerConnection && std::chrono::steady_clock::now() < deadline) {
+            loop.runOnce(100ms);
+        }
+        assert(completed == kConnections * kRequestsPerConnection);
+        assert(all_ok);
+        for (const auto& transport : transports) {
+            assert(transport->pendingCount() == 0);
+            assert(transport->isConnected());
+        }
+    }
+
+    for (auto& server : servers) {
+        server->stop();
+    }
+
+    // 要求ごとのデッドライン: 応答しないサーバーに対して期限で完了する
+    MockSlmpServer silent_server;
+    silent_server.start(56013, [](const std::vector<std::uint8_t>&) { return std::vector<std::uint8_t>{}; });
+    {
+        EventLoop loop;
+        AsyncTcpTransport transport(loop);
+        auto config = makeConfig(56013);
+        transport.connect(config);
+
+        bool timed_out = false;
+        const auto start = std::chrono::steady_clock::now();
+        transport.submit(encoder.makeBatchReadRequest(config, makeDeviceRange("D0", 1)), std::nullopt,
+                         start + 200ms, [&](std::exception_ptr error, std::vector<std::uint8_t>) {
+                             try {
+                                 if (error) {
+                                     std::rethrow_exception(error);
+                                 }
+                             } catch (const TransportTimeoutError&) {
+                                 timed_out = true;
+                             }
+                         });
+        while (!timed_out && std::chrono::steady_clock::now() - start < 2s) {
+            loop.runOnce(1s);
+        }
+        assert(timed_out);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        assert(elapsed >= 200ms && elapsed < 1s);
+        // FIFO 照合では応答順序が崩れるため接続を破棄する
+        assert(!transport.isConnected());
+    }
+    {
+        // 完了コールバックが例外を送出しても、まとめて失敗させる残りの要求のコールバックは呼ばれる
+        EventLoop loop;
+        AsyncTcpTransport transport(loop);
+        auto config = makeConfig(56013);
+        config.frame_type = FrameType::Frame4E;
+        transport.connect(config);
+
+        int timeouts = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (std::uint16_t serial = 0; serial < 3; ++serial) {
+            auto request = encoder.makeBatchReadRequest(config, makeDeviceRange("D0", 1));
+            codec::FrameEncoder::setSerialNumber(request, serial);
+            transport.submit(std::move(request), serial, start + 50ms,
+                             [&](std::exception_ptr error, std::vector<std::uint8_t>) {
+                                 assert(error);
+                                 ++timeouts;
+                                 throw std::runtime_error("callback failed");
+                             });
+        }
+        bool rethrown = false;
+        while (timeouts == 0 && std::chrono::steady_clock::now() - start < 2s) {
+            try {
+                loop.runOnce(100ms);
+            } catch (const std::runtime_error&) {
+                rethrown = true;
+            }
+        }
+        assert(rethrown && timeouts == 3 && transport.pendingCount() == 0);
+
+        // 切断で失敗した要求のコールバックが閉じたトランスポートに submit() して例外になっても同様
+        int failures = 0;
+        for (std::uint16_t serial = 3; serial < 6; ++serial) {
+            auto request = encoder.makeBatchReadRequest(config, makeDeviceRange("D0", 1));
+            codec::FrameEncoder::setSerialNumber(request, serial);
+            transport.submit(std::move(request), serial, std::chrono::steady_clock::now() + 1s,
+                             [&](std::exception_ptr error, std::vector<std::uint8_t>) {
+                                 assert(error);
+                                 ++failures;
+                                 transport.submit(encoder.makeBatchReadRequest(config, makeDeviceRange("D0", 1)), 0,
+                                                  std::chrono::steady_clock::now() + 1s,
+                                                  [](std::exception_ptr, std::vector<std::uint8_t>) {});
+                             });
+        }
+        transport.disconnect();
+        assert(failures == 3 && transport.pendingCount() == 0);
+    }
+    {
+        // 接続ごとのデッドラインは期限の早い順に処理し、期限前の要求は残す
+        MockSlmpServer second_silent_server;
+        second_silent_server.start(56039, [](const std::vector<std::uint8_t>&) { return std::vector<std::uint8_t>{}; });
+        EventLoop loop;
+        auto config = makeConfig(56013);
+        config.frame_type = FrameType::Frame4E;
+        auto late_config = config;
+        late_config.port = 56039;
+        AsyncTcpTransport early(loop);
+        AsyncTcpTransport late(loop);
+        early.connect(config);
+        late.connect(late_config);
+
+        int early_timeouts = 0;
+        int late_timeouts = 0;
+        const auto start = std::chrono::steady_clock::now();
+        auto submit = [&](AsyncTcpTransport& transport, std::uint16_t serial, std::chrono::milliseconds after,
+                          int& timeouts) {
+            auto request = encoder.makeBatchReadRequest(config, makeDeviceRange("D0", 1));
+            codec::FrameEncoder::setSerialNumber(request, serial);
+            transport.submit(std::move(request), serial, start + after,
+                             [&timeouts](std::exception_ptr error, std::vector<std::uint8_t>) {
+                                 assert(error);
+                                 ++timeouts;
+                             });
+        };
+        submit(late, 0, 400ms, late_timeouts);
+        submit(early, 0, 50ms, early_timeouts);
+        submit(early, 1, 100ms, early_timeouts);
+        assert(early.nextDeadline() == start + 50ms && late.nextDeadline() == start + 400ms);
+
+        while (early_timeouts < 2 && std::chrono::steady_clock::now() - start < 2s) {
+            loop.runOnce(1s);
+        }
+        assert(early_timeouts == 2 && early.pendingCount() == 0 && !early.nextDeadline());
+        assert(late_timeouts == 0 && late.pendingCount() == 1);
+        while (late_timeouts == 0 && std::chrono::steady_clock::now() - start < 2s) {
+            loop.runOnce(1s);
+        }
+        assert(late_timeouts == 1 && std::chrono::steady_clock::now() - start >= 400ms);
+        assert(early.isConnected() && late.isConnected());
+        late.disconnect();
+        second_silent_server.stop();
+    }
+    silent_server.stop();
+
+    // 別スレッドで run() し、post()/stop() で制御する
+    MockSlmpServer threaded_server;
+    threaded_server.start(56014, echoHeadNumber);
+    {
+        EventLoop loop;
+        AsyncTcpTransport transport(loop);
+        auto config = makeConfig(56014);
+        transport.connect(config);
+
+        std::thread runner([&loop]() { loop.run(); });
+
+        std::atomic<bool> done{false};
+        std::uint16_t value = 0;
+        loop.post([&]() {
+            transport.submit(encoder.makeBatchReadRequest(config, makeDeviceRange("D77", 1)), std::nullopt,
+                             std::chrono::steady_clock::now() + 1s,
+                             [&](std::exception_ptr error, std::vector<std::uint8_t> frame) {
+                                 assert(!error);
+                                 value = decodeSingleWord(frame);
+                                 done = true;
+                             });
+        });
+
+        const auto start = std::chrono::steady_clock::now();
+        while (!done && std::chrono::steady_clock::now() - start < 2s) {
+            std::this_thread::sleep_for(1ms);
+        }
+        loop.stop();
+        runner.join();
+        assert(done);
+        assert(value == 77);
+    }
+    threaded_server.stop();
+
+    return 0;
+}
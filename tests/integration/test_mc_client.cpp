@@ -1,15 +1,26 @@
 #include "cpmcprotocol/access_option.hpp"
+#include "cpmcprotocol/codec/frame_encoder.hpp"
 #include "cpmcprotocol/mc_client.hpp"
 #include "cpmcprotocol/runtime_control.hpp"
 #include "cpmcprotocol/session_config.hpp"
 #include "cpmcprotocol/value_codec.hpp"
 #include "util/mock_slmp_server.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 using namespace cpmcprotocol;
+using cpmcprotocol::testutil::make4EBinaryResponse;
 
 namespace {
 
@@ -34,6 +45,943 @@ std::vector<std::uint8_t> makeBinaryResponse(const std::vector<std::uint8_t>& re
     return response;
 }
 
+// 4E フレームのパイプライン読み出しを検証する。
+// 応答順序の入れ替えに対してもシリアル番号で正しく対応付けられることを確認する。
+void testPipelined4E() {
+    using cpmcprotocol::testutil::MockSlmpServer;
+
+    std::vector<std::uint8_t> held;
+    MockSlmpServer server;
+    server.start(56003, [&held](const std::vector<std::uint8_t>& request) {
+        if (request.size() < 27 || request[0] != 0x54) {
+            return std::vector<std::uint8_t>{};
+        }
+        const std::uint16_t command = static_cast<std::uint16_t>(request[15] | (request[16] << 8));
+        if (command != 0x0401) {
+            return std::vector<std::uint8_t>{};
+        }
+        // 各ワード値 = 先頭デバイス番号 + オフセット
+        const std::uint32_t head = static_cast<std::uint32_t>(request[19] | (request[20] << 8) |
+                                                              (request[21] << 16) | (request[22] << 24));
+        const std::uint16_t points = static_cast<std::uint16_t>(request[25] | (request[26] << 8));
+        std::vector<std::uint8_t> payload;
+        for (std::uint16_t i = 0; i < points; ++i) {
+            const std::uint16_t value = static_cast<std::uint16_t>(head + i);
+            payload.push_back(static_cast<std::uint8_t>(value & 0xFF));
+            payload.push_back(static_cast<std::uint8_t>((value >> 8) & 0xFF));
+        }
+        auto response = make4EBinaryResponse(request, payload);
+
+        // パイプライン区間（シリアル 0-9）では偶数シリアルの応答を保留し、
+        // 次の応答の後ろに付けて返す（順序入れ替え）
+        const std::uint16_t serial = static_cast<std::uint16_t>(request[2] | (request[3] << 8));
+        if (serial < 10 && serial % 2 == 0) {
+            held = std::move(response);
+            return std::vector<std::uint8_t>{};
+        }
+        response.insert(response.end(), held.begin(), held.end());
+        held.clear();
+        return response;
+    });
+
+    SessionConfig config{};
+    config.host = "127.0.0.1";
+    config.port = 56003;
+    config.frame_type = FrameType::Frame4E;
+    config.max_in_flight = 4;
+    config.series = PlcSeries::IQ_R;
+
+    McClient client;
+    client.connect(config);
+
+    std::vector<DeviceRange> ranges;
+    for (std::uint16_t i = 0; i < 10; ++i) {
+        ranges.push_back(makeDeviceRange("D" + std::to_string(i * 100), static_cast<std::uint16_t>(i + 1)));
+    }
+    auto results = client.readWordsPipelined(ranges);
+    assert(results.size() == ranges.size());
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        assert(results[i].size() == i + 1);
+        assert(results[i][0] == i * 100);
+        assert(results[i].back() == i * 100 + i);
+    }
+
+    // 単発要求も 4E で往復できる
+    auto single = client.readWords(makeDeviceRange("D600", 2));
+    assert(single.size() == 2 && single[0] == 600 && single[1] == 601);
+
+    auto prepared = client.prepareReadWords(makeDeviceRange("D700", 1));
+    assert(client.readWords(prepared)[0] == 700);
+    assert(client.readWords(prepared)[0] == 700);
+
+    client.disconnect();
+    server.stop();
+}
+
+// 1 要求の上限を超える一括読み出しが分割・パイプライン送信され、順序通りに結合されることを検証する。
+void testLargeRead() {
+    using cpmcprotocol::testutil::MockSlmpServer;
+
+    std::size_t max_points = 0;
+    std::size_t requests = 0;
+    MockSlmpServer server;
+    server.start(56015, [&](const std::vector<std::uint8_t>& request) {
+        if (request.size() < 27 || request[0] != 0x54) {
+            return std::vector<std::uint8_t>{};
+        }
+        const std::uint16_t command = static_cast<std::uint16_t>(request[15] | (request[16] << 8));
+        const std::uint16_t subcommand = static_cast<std::uint16_t>(request[17] | (request[18] << 8));
+        if (command != 0x0401) {
+            return std::vector<std::uint8_t>{};
+        }
+        const std::uint32_t head = static_cast<std::uint32_t>(request[19] | (request[20] << 8) |
+                                                              (request[21] << 16) | (request[22] << 24));
+        const std::uint16_t points = static_cast<std::uint16_t>(request[25] | (request[26] << 8));
+        max_points = std::max<std::size_t>(max_points, points);
+        ++requests;
+
+        std::vector<std::uint8_t> payload;
+        if (subcommand == 0x0003) {
+            // ビット単位: デバイス番号が 3 の倍数の点を ON にする（1 バイト 2 点）
+            for (std::uint32_t i = 0; i < points; i += 2) {
+                std::uint8_t byte = ((head + i) % 3 == 0) ? 0x10 : 0x00;
+                if (i + 1 < points && (head + i + 1) % 3 == 0) {
+                    byte |= 0x01;
+                }
+                payload.push_back(byte);
+            }
+        } else {
+            for (std::uint32_t i = 0; i < points; ++i) {
+                const std::uint16_t value = static_cast<std::uint16_t>(head + i);
+                payload.push_back(static_cast<std::uint8_t>(value & 0xFF));
+                payload.push_back(static_cast<std::uint8_t>((value >> 8) & 0xFF));
+            }
+        }
+        return make4EBinaryResponse(request, payload);
+    });
+
+    SessionConfig config{};
+    config.host = "127.0.0.1";
+    config.port = 56015;
+    config.frame_type = FrameType::Frame4E;
+    config.max_in_flight = 4;
+    config.series = PlcSeries::IQ_R;
+
+    McClient client;
+    client.connect(config);
+
+    // 32k ワードの ZR 領域を 1 呼び出しで読み取る（960 点ずつ 34 要求）
+    auto area = client.readWordArea(makeDeviceAddress("ZR100"), 32000);
+    assert(area.size() == 32000);
+    for (std::size_t i = 0; i < area.size(); ++i) {
+        assert(area[i] == static_cast<std::uint16_t>(0x100 + i));
+    }
+    assert(max_points == 960);
+    assert(requests == 34);
+
+    // DeviceRange による読み取りも上限を超えれば自動で分割する
+    auto words = client.readWords(makeDeviceRange("D10", 2000));
+    assert(words.size() == 2000 && words.front() == 10 && words.back() == 2009);
+
+    auto bits = client.readBits(makeDeviceRange("M1", 10000));
+    assert(bits.size() == 10000);
+    for (std::size_t i = 0; i < bits.size(); ++i) {
+        assert(bits[i] == ((1 + i) % 3 == 0));
+    }
+    assert(max_points == 7168);
+
+    bool threw = false;
+    try {
+        client.readWordArea(makeDeviceAddress("D0"), 0);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    client.disconnect();
+    server.stop();
+}
+
+// 1 要求の点数上限を超えるランダム読み書きが分割され、読み取り結果がプランの順に戻ることを検証する。
+void testLargeRandomAccess() {
+    using cpmcprotocol::testutil::MockSlmpServer;
+
+    const auto limits = codec::FrameEncoder::randomAccessLimits(PlcSeries::IQ_R);
+    std::atomic<std::size_t> read_frames{0};
+    std::atomic<std::size_t> written_points{0};
+    std::atomic<bool> over_limit{false};
+    MockSlmpServer server;
+    server.start(56016, [&](const std::vector<std::uint8_t>& request) {
+        if (request.size() < 23 || request[0] != 0x54) {
+            return std::vector<std::uint8_t>{};
+        }
+        const std::uint16_t command = static_cast<std::uint16_t>(request[15] | (request[16] << 8));
+        const std::size_t words = request[19];
+        const std::size_t dwords = request[20];
+        const std::size_t lwords = request[21];
+        const std::size_t bits = request[22];
+        if (command == 0x1402) {
+            if (words * 12 + dwords * 14 + lwords * 28 > limits.write_cost || bits > limits.write_bits) {
+                over_limit = true;
+            }
+            written_points += words + dwords + lwords + bits;
+            return make4EBinaryResponse(request, {});
+        }
+        if (command != 0x0403) {
+            return std::vector<std::uint8_t>{};
+        }
+        if (words + dwords + 2 * lwords + bits > limits.read_points) {
+            over_limit = true;
+        }
+        ++read_frames;
+
+        // デバイス番号をそのまま値として返す（iQ-R: 番号 4 バイト + コード 2 バイト）
+        std::vector<std::uint8_t> payload;
+        std::size_t offset = 23;
+        auto next_number = [&]() {
+            const std::uint32_t number = static_cast<std::uint32_t>(request[offset] | (request[offset + 1] << 8) |
+                                                                    (request[offset + 2] << 16));
+            offset += 6;
+            return number;
+        };
+        auto append = [&](std::uint64_t value, std::size_t bytes) {
+            for (std::size_t i = 0; i < bytes; ++i) {
+                payload.push_back(static_cast<std::uint8_t>((value >> (8 * i)) & 0xFF));
+            }
+        };
+        for (std::size_t i = 0; i < words; ++i) {
+            append(next_number(), 2);
+        }
+        for (std::size_t i = 0; i < dwords; ++i) {
+            append(0x10000U + next_number(), 4);
+        }
+        for (std::size_t i = 0; i < lwords; ++i) {
+            append(0x100000000ULL + next_number(), 8);
+        }
+        for (std::size_t i = 0; i < bits; ++i) {
+            append(next_number() % 2, 2);
+        }
+        return make4EBinaryResponse(request, payload);
+    });
+
+    SessionConfig config{};
+    config.host = "127.0.0.1";
+    config.port = 56016;
+    config.frame_type = FrameType::Frame4E;
+    config.series = PlcSeries::IQ_R;
+
+    McClient client;
+    client.connect(config);
+
+    // 種別が混在した 300 点のプラン（iQ-R の上限は 96 点/要求）
+    DeviceReadPlan read_plan;
+    DeviceWritePlan write_plan;
+    for (std::size_t i = 0; i < 300; ++i) {
+        if (i % 7 == 0) {
+            read_plan.push_back({makeDeviceAddress("D" + std::to_string(i)), ValueFormat::UInt64()});
+            write_plan.push_back({read_plan.back().address, ValueFormat::UInt64(), static_cast<std::uint64_t>(i)});
+        } else if (i % 5 == 0) {
+            read_plan.push_back({makeDeviceAddress("M" + std::to_string(i)), ValueFormat::BitArray(1)});
+            write_plan.push_back({read_plan.back().address, ValueFormat::BitArray(1), std::vector<bool>{true}});
+        } else if (i % 3 == 0) {
+            read_plan.push_back({makeDeviceAddress("D" + std::to_string(i)), ValueFormat::UInt32()});
+            write_plan.push_back({read_plan.back().address, ValueFormat::UInt32(), static_cast<std::uint32_t>(i)});
+        } else {
+            read_plan.push_back({makeDeviceAddress("D" + std::to_string(i)), ValueFormat::UInt16()});
+            write_plan.push_back({read_plan.back().address, ValueFormat::UInt16(), static_cast<std::uint16_t>(i)});
+        }
+    }
+
+    for (const auto& values : {client.randomRead(read_plan), client.randomRead(resolveReadPlan(read_plan))}) {
+        assert(values.size() == read_plan.size());
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            if (i % 7 == 0) {
+                assert(std::get<std::uint64_t>(values[i]) == 0x100000000ULL + i);
+            } else if (i % 5 == 0) {
+                assert(std::get<std::vector<bool>>(values[i])[0] == (i % 2 == 1));
+            } else if (i % 3 == 0) {
+                assert(std::get<std::uint32_t>(values[i]) == 0x10000U + i);
+            } else {
+                assert(std::get<std::uint16_t>(values[i]) == i);
+            }
+        }
+    }
+    assert(read_frames > 2);
+
+    client.randomWrite(write_plan);
+    assert(written_points == write_plan.size());
+    assert(!over_limit);
+
+    client.disconnect();
+    server.stop();
+}
+
+// 複数ブロック一括読み書きを検証する。上限を超える要求は分割され、ブロックごとに結合される。
+void testMultipleBlocks() {
+    using cpmcprotocol::testutil::MockSlmpServer;
+
+    // 書き込まれたワードを (デバイスコード, 番号) ごとに保持し、未書き込みの位置は番号の下位 16bit を返す
+    std::map<std::pair<std::uint16_t, std::uint32_t>, std::uint16_t> memory;
+    std::atomic<std::size_t> read_frames{0};
+    MockSlmpServer server;
+    server.start(56017, [&](const std::vector<std::uint8_t>& request) {
+        if (request.size() < 21 || request[0] != 0x54) {
+            return std::vector<std::uint8_t>{};
+        }
+        const std::uint16_t command = static_cast<std::uint16_t>(request[15] | (request[16] << 8));
+        if (command != 0x0406 && command != 0x1406) {
+            return std::vector<std::uint8_t>{};
+        }
+        const std::size_t blocks = static_cast<std::size_t>(request[19]) + request[20];
+        const std::size_t word_blocks = request[19];
+        std::vector<std::uint8_t> payload;
+        std::size_t offset = 21;
+        for (std::size_t b = 0; b < blocks; ++b) {
+            const std::uint32_t head = static_cast<std::uint32_t>(request[offset] | (request[offset + 1] << 8) |
+                                                                  (request[offset + 2] << 16));
+            const std::uint16_t code = static_cast<std::uint16_t>(request[offset + 4] | (request[offset + 5] << 8));
+            const std::uint16_t points = static_cast<std::uint16_t>(request[offset + 6] | (request[offset + 7] << 8));
+            offset += 8;
+            const std::uint32_t stride = (b < word_blocks) ? 1 : 16;
+            for (std::uint16_t i = 0; i < points; ++i) {
+                const auto key = std::make_pair(code, head + i * stride);
+                if (command == 0x1406) {
+                    memory[key] = static_cast<std::uint16_t>(request[offset] | (request[offset + 1] << 8));
+                    offset += 2;
+                } else {
+                    const auto it = memory.find(key);
+                    const std::uint16_t value = (it != memory.end()) ? it->second : static_cast<std::uint16_t>(key.second);
+                    payload.push_back(static_cast<std::uint8_t>(value & 0xFF));
+                    payload.push_back(static_cast<std::uint8_t>((value >> 8) & 0xFF));
+                }
+            }
+        }
+        if (command == 0x0406) {
+            ++read_frames;
+        }
+        return make4EBinaryResponse(request, payload);
+    });
+
+    SessionConfig config{};
+    config.host = "127.0.0.1";
+    config.port = 56017;
+    config.frame_type = FrameType::Frame4E;
+    config.series = PlcSeries::IQ_R;
+
+    McClient client;
+    client.connect(config);
+
+    // D100-D199、W0-W3F、M0-M255 を 1 往復で読み取る
+    MultiBlockRequest request{};
+    request.word_blocks = {makeDeviceRange("D100", 100), makeDeviceRange("W0", 0x40)};
+    request.bit_blocks = {makeDeviceRange("M0", 16)};
+    auto data = client.readMultipleBlocks(request);
+    assert(read_frames == 1);
+    assert(data.word_blocks.size() == 2 && data.bit_blocks.size() == 1);
+    assert(data.word_blocks[0].size() == 100 && data.word_blocks[0][0] == 100 && data.word_blocks[0][99] == 199);
+    assert(data.word_blocks[1].size() == 0x40 && data.word_blocks[1][0x3F] == 0x3F);
+    assert(data.bit_blocks[0].size() == 16 && data.bit_blocks[0][1] == 16 && data.bit_blocks[0][15] == 240);
+
+    // 合計 960 ワードを超える要求は分割される（ブロックの途中でも分割し、先頭番号をずらす）
+    MultiBlockRequest large{};
+    large.word_blocks = {makeDeviceRange("D0", 700), makeDeviceRange("D1000", 700)};
+    large.bit_blocks = {makeDeviceRange("B0", 100)};
+    read_frames = 0;
+    auto large_data = client.readMultipleBlocks(large);
+    assert(read_frames == 2);
+    for (std::size_t i = 0; i < 700; ++i) {
+        assert(large_data.word_blocks[0][i] == i);
+        assert(large_data.word_blocks[1][i] == 1000 + i);
+    }
+    for (std::size_t i = 0; i < 100; ++i) {
+        assert(large_data.bit_blocks[0][i] == static_cast<std::uint16_t>(i * 16));
+    }
+
+    // 書き込んだ値を読み戻す（書き込みはブロックごとに 4 点分を加算した上限で分割される）
+    MultiBlockData values{};
+    values.word_blocks = {std::vector<std::uint16_t>(700), std::vector<std::uint16_t>(700)};
+    values.bit_blocks = {std::vector<std::uint16_t>(100)};
+    for (std::size_t i = 0; i < 700; ++i) {
+        values.word_blocks[0][i] = static_cast<std::uint16_t>(0x8000 + i);
+        values.word_blocks[1][i] = static_cast<std::uint16_t>(0x4000 + i);
+    }
+    for (std::size_t i = 0; i < 100; ++i) {
+        values.bit_blocks[0][i] = static_cast<std::uint16_t>(0xA5A5 ^ i);
+    }
+    client.writeMultipleBlocks(large, values);
+    auto written = client.readMultipleBlocks(large);
+    assert(written.word_blocks == values.word_blocks);
+    assert(written.bit_blocks == values.bit_blocks);
+
+    bool threw = false;
+    try {
+        values.bit_blocks.clear();
+        client.writeMultipleBlocks(large, values);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    client.disconnect();
+    server.stop();
+}
+
+void testReadOptimized() {
+    using cpmcprotocol::testutil::MockSlmpServer;
+
+    // D は番号の下位 16bit、M は 3 の倍数の番号だけ ON を返す（ワード単位では 16 点を詰めた値）
+    auto word_at = [](std::uint16_t code, std::uint32_t number) {
+        if (code != 0x90) {
+            return static_cast<std::uint16_t>(number);
+        }
+        std::uint16_t word = 0;
+        for (std::uint32_t bit = 0; bit < 16; ++bit) {
+            if ((number + bit) % 3 == 0) {
+                word = static_cast<std::uint16_t>(word | (1U << bit));
+            }
+        }
+        return word;
+    };
+    auto read_device = [](const std::vector<std::uint8_t>& request, std::size_t offset) {
+        const std::uint32_t number = static_cast<std::uint32_t>(request[offset] | (request[offset + 1] << 8) |
+                                                                (request[offset + 2] << 16));
+        const std::uint16_t code = static_cast<std::uint16_t>(request[offset + 4] | (request[offset + 5] << 8));
+        return std::make_pair(code, number);
+    };
+
+    std::map<std::uint16_t, std::size_t> frames_by_command;
+    MockSlmpServer server;
+    server.start(56018, [&](const std::vector<std::uint8_t>& request) {
+        if (request.size() < 21 || request[0] != 0x54) {
+            return std::vector<std::uint8_t>{};
+        }
+        const std::uint16_t command = static_cast<std::uint16_t>(request[15] | (request[16] << 8));
+        ++frames_by_command[command];
+
+        std::vector<std::uint8_t> payload;
+        auto append = [&](std::uint16_t word) {
+            payload.push_back(static_cast<std::uint8_t>(word & 0xFF));
+            payload.push_back(static_cast<std::uint8_t>((word >> 8) & 0xFF));
+        };
+        if (command == 0x0401) {
+            // ワード単位の一括読み出し（ビットデバイスは 16 点ずつ）
+            const auto [code, head] = read_device(request, 19);
+            const std::uint16_t points = static_cast<std::uint16_t>(request[25] | (request[26] << 8));
+            const std::uint32_t stride = (code == 0x90) ? 16 : 1;
+            for (std::uint16_t i = 0; i < points; ++i) {
+                append(word_at(code, head + i * stride));
+            }
+        } else if (command == 0x0406) {
+            const std::size_t word_blocks = request[19];
+            const std::size_t blocks = word_blocks + request[20];
+            for (std::size_t b = 0, offset = 21; b < blocks; ++b, offset += 8) {
+                const auto [code, head] = read_device(request, offset);
+                const std::uint16_t points = static_cast<std::uint16_t>(request[offset + 6] | (request[offset + 7] << 8));
+                const std::uint32_t stride = (b < word_blocks) ? 1 : 16;
+                for (std::uint16_t i = 0; i < points; ++i) {
+                    append(word_at(code, head + i * stride));
+                }
+            }
+        } else if (command == 0x0403) {
+            std::size_t offset = 23;
+            for (std::size_t i = 0; i < request[19]; ++i, offset += 6) {
+                const auto [code, number] = read_device(request, offset);
+                append(word_at(code, number));
+            }
+            for (std::size_t i = 0; i < request[20]; ++i, offset += 6) {
+                const auto [code, number] = read_device(request, offset);
+                append(word_at(code, number));
+                append(word_at(code, number + 1));
+            }
+            for (std::size_t i = 0; i < request[22]; ++i, offset += 6) {
+                const auto [code, number] = read_device(request, offset);
+                append(static_cast<std::uint16_t>(number % 3 == 0 ? 1 : 0));
+            }
+        } else {
+            return std::vector<std::uint8_t>{};
+        }
+        return make4EBinaryResponse(request, payload);
+    });
+
+    SessionConfig config{};
+    config.host = "127.0.0.1";
+    config.port = 56018;
+    config.frame_type = FrameType::Frame4E;
+    config.series = PlcSeries::IQ_R;
+
+    McClient client;
+    client.connect(config);
+
+    // 近接したアドレスをまとめた 5 ブロックを複数ブロック読み出し 1 往復で読む
+    DeviceReadPlan plan{
+        {makeDeviceAddress("D103"), ValueFormat::UInt16()},
+        {makeDeviceAddress("M32"), ValueFormat::BitArray(1)},
+        {makeDeviceAddress("D9000"), ValueFormat::UInt32()},
+        {makeDeviceAddress("D500"), ValueFormat::RawWords(4)},
+        {makeDeviceAddress("M1000"), ValueFormat::BitArray(1)},
+        {makeDeviceAddress("M0"), ValueFormat::BitArray(20)},
+        {makeDeviceAddress("D100"), ValueFormat::Int16()},
+    };
+    auto values = client.readOptimized(plan);
+    assert(frames_by_command[0x0406] == 1);
+    assert(frames_by_command.size() == 1);
+    assert(std::get<std::uint16_t>(values[0]) == 103);
+    assert(std::get<std::vector<bool>>(values[1]) == std::vector<bool>{false});
+    assert(std::get<std::uint32_t>(values[2]) == ((9001U << 16) | 9000U));
+    assert((std::get<std::vector<std::uint16_t>>(values[3]) == std::vector<std::uint16_t>{500, 501, 502, 503}));
+    assert(std::get<std::vector<bool>>(values[4]) == std::vector<bool>{false});
+    const auto m0 = std::get<std::vector<bool>>(values[5]);
+    for (std::size_t i = 0; i < m0.size(); ++i) {
+        assert(m0[i] == (i % 3 == 0));
+    }
+    assert(std::get<std::int16_t>(values[6]) == 100);
+
+    // 単独の値だけならランダム読み出しの方が短い
+    frames_by_command.clear();
+    DeviceReadPlan sparse{
+        {makeDeviceAddress("M999"), ValueFormat::BitArray(1)},
+        {makeDeviceAddress("D9000"), ValueFormat::UInt32()},
+        {makeDeviceAddress("D100"), ValueFormat::UInt16()},
+    };
+    const auto optimized = optimizeReadPlan(sparse, PlcSeries::IQ_R);
+    values = client.readOptimized(optimized);
+    assert(frames_by_command[0x0403] == 1 && frames_by_command.size() == 1);
+    assert(std::get<std::vector<bool>>(values[0]) == std::vector<bool>{true});
+    assert(std::get<std::uint32_t>(values[1]) == ((9001U << 16) | 9000U));
+    assert(std::get<std::uint16_t>(values[2]) == 100);
+
+    // 1 要求の上限を超える範囲は一括読み出しに分割してパイプラインで送信する
+    frames_by_command.clear();
+    values = client.readOptimized(DeviceReadPlan{{makeDeviceAddress("D0"), ValueFormat::RawWords(1200)}});
+    assert(frames_by_command[0x0401] == 2 && frames_by_command.size() == 1);
+    const auto& area = std::get<std::vector<std::uint16_t>>(values[0]);
+    for (std::size_t i = 0; i < area.size(); ++i) {
+        assert(area[i] == i);
+    }
+
+    // 別シリーズ向けに最適化したプランは拒否する
+    bool threw = false;
+    try {
+        client.readOptimized(optimizeReadPlan(sparse, PlcSeries::Q));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    client.disconnect();
+    server.stop();
+}
+
+void testMonitor() {
+    using cpmcprotocol::testutil::MockSlmpServer;
+
+    // モニタ登録されたデバイスを保持し、D は番号の下位 16bit を返す（ダブルワードは連続 2 ワード）
+    std::vector<std::uint32_t> registered_words;
+    std::vector<std::uint32_t> registered_dwords;
+    std::map<std::uint16_t, std::size_t> frames_by_command;
+    std::atomic<bool> unregistered_monitor{false};
+    MockSlmpServer server;
+    server.start(56019, [&](const std::vector<std::uint8_t>& request) {
+        if (request.size() < 19 || request[0] != 0x54) {
+            return std::vector<std::uint8_t>{};
+        }
+        const std::uint16_t command = static_cast<std::uint16_t>(request[15] | (request[16] << 8));
+        ++frames_by_command[command];
+
+        std::vector<std::uint32_t> words;
+        std::vector<std::uint32_t> dwords;
+        if (command == 0x0801 || command == 0x0403) {
+            std::size_t offset = 23;
+            auto next_number = [&]() {
+                const std::uint32_t number = static_cast<std::uint32_t>(request[offset] | (request[offset + 1] << 8) |
+                                                                        (request[offset + 2] << 16));
+                offset += 6;
+                return number;
+            };
+            for (std::size_t i = 0; i < request[19]; ++i) {
+                words.push_back(next_number());
+            }
+            for (std::size_t i = 0; i < request[20]; ++i) {
+                dwords.push_back(next_number());
+            }
+            if (command == 0x0801) {
+                registered_words = std::move(words);
+                registered_dwords = std::move(dwords);
+                return make4EBinaryResponse(request, {});
+            }
+        } else if (command == 0x0802) {
+            if (registered_words.empty() && registered_dwords.empty()) {
+                unregistered_monitor = true;
+            }
+            words = registered_words;
+            dwords = registered_dwords;
+        } else {
+            return std::vector<std::uint8_t>{};
+        }
+
+        std::vector<std::uint8_t> payload;
+        auto append = [&](std::uint32_t number) {
+            payload.push_back(static_cast<std::uint8_t>(number & 0xFF));
+            payload.push_back(static_cast<std::uint8_t>((number >> 8) & 0xFF));
+        };
+        for (const auto number : words) {
+            append(number);
+        }
+        for (const auto number : dwords) {
+            append(number);
+            append(number + 1);
+        }
+        return make4EBinaryResponse(request, payload);
+    });
+
+    SessionConfig config{};
+    config.host = "127.0.0.1";
+    config.port = 56019;
+    config.frame_type = FrameType::Frame4E;
+    config.series = PlcSeries::IQ_R;
+
+    McClient client;
+    client.connect(config);
+
+    // 152 点のうち先頭 96 点をモニタ登録し、残りはランダム読み出しで読む
+    DeviceReadPlan plan;
+    for (std::size_t i = 0; i < 150; ++i) {
+        plan.push_back({makeDeviceAddress("D" + std::to_string(i * 3)), ValueFormat::UInt16()});
+    }
+    plan.push_back({makeDeviceAddress("D1000"), ValueFormat::UInt32()});
+    plan.push_back({makeDeviceAddress("D2000"), ValueFormat::UInt32()});
+
+    auto check = [&](const std::vector<DeviceValue>& values) {
+        assert(values.size() == plan.size());
+        for (std::size_t i = 0; i < 150; ++i) {
+            assert(std::get<std::uint16_t>(values[i]) == i * 3);
+        }
+        assert(std::get<std::uint32_t>(values[150]) == ((1001U << 16) | 1000U));
+        assert(std::get<std::uint32_t>(values[151]) == ((2001U << 16) | 2000U));
+    };
+
+    auto monitor = client.registerMonitor(plan);
+    assert(monitor.monitoredCount() == 96);
+    assert(frames_by_command[0x0801] == 1);
+    for (int cycle = 0; cycle < 3; ++cycle) {
+        check(client.readMonitor(monitor));
+    }
+    assert(frames_by_command[0x0801] == 1);
+    assert(frames_by_command[0x0802] == 3);
+    assert(frames_by_command[0x0403] == 3);
+
+    // 再接続後は PLC 側の登録が失われるため、次回読み取り時に再登録する
+    client.disconnect();
+    registered_words.clear();
+    registered_dwords.clear();
+    client.connect(config);
+    check(client.readMonitor(monitor));
+    assert(frames_by_command[0x0801] == 2);
+
+    // 別のセットを登録すると、元のセットは次回読み取り時に再登録される
+    auto other = client.registerMonitor(DeviceReadPlan{{makeDeviceAddress("D5"), ValueFormat::UInt16()}});
+    assert(std::get<std::uint16_t>(client.readMonitor(other)[0]) == 5);
+    assert(frames_by_command[0x0801] == 3);
+    check(client.readMonitor(monitor));
+    assert(frames_by_command[0x0801] == 4);
+    assert(!unregistered_monitor);
+
+    bool threw = false;
+    try {
+        MonitorSet empty;
+        client.readMonitor(empty);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    client.disconnect();
+    server.stop();
+}
+
+void testShadowCache() {
+    using cpmcprotocol::testutil::MockSlmpServer;
+
+    // D は memory に値があればその値、なければ番号の下位 16bit を返し、M は 3 の倍数の番号だけ ON を返す
+    std::map<std::uint32_t, std::uint16_t> memory;
+    auto word_at = [&](std::uint32_t number) {
+        const auto it = memory.find(number);
+        return it != memory.end() ? it->second : static_cast<std::uint16_t>(number);
+    };
+    auto read_number = [](const std::vector<std::uint8_t>& request, std::size_t offset) {
+        return static_cast<std::uint32_t>(request[offset] | (request[offset + 1] << 8) | (request[offset + 2] << 16));
+    };
+
+    std::size_t frames = 0;
+    MockSlmpServer server;
+    server.start(56021, [&](const std::vector<std::uint8_t>& request) {
+        if (request.size() < 21 || request[0] != 0x54) {
+            return std::vector<std::uint8_t>{};
+        }
+        const std::uint16_t command = static_cast<std::uint16_t>(request[15] | (request[16] << 8));
+        ++frames;
+
+        std::vector<std::uint8_t> payload;
+        auto append = [&](std::uint16_t word) {
+            payload.push_back(static_cast<std::uint8_t>(word & 0xFF));
+            payload.push_back(static_cast<std::uint8_t>((word >> 8) & 0xFF));
+        };
+        if (command == 0x0401) {
+            const std::uint32_t head = read_number(request, 19);
+            const std::uint16_t points = static_cast<std::uint16_t>(request[25] | (request[26] << 8));
+            for (std::uint16_t i = 0; i < points; ++i) {
+                append(word_at(head + i));
+            }
+        } else if (command == 0x0406) {
+            const std::size_t word_blocks = request[19];
+            const std::size_t blocks = word_blocks + request[20];
+            for (std::size_t b = 0, offset = 21; b < blocks; ++b, offset += 8) {
+                const std::uint32_t head = read_number(request, offset);
+                const std::uint16_t points = static_cast<std::uint16_t>(request[offset + 6] | (request[offset + 7] << 8));
+                for (std::uint16_t i = 0; i < points; ++i) {
+                    if (b < word_blocks) {
+                        append(word_at(head + i));
+                        continue;
+                    }
+                    std::uint16_t word = 0;
+                    for (std::uint32_t bit = 0; bit < 16; ++bit) {
+                        if ((head + i * 16 + bit) % 3 == 0) {
+                            word = static_cast<std::uint16_t>(word | (1U << bit));
+                        }
+                    }
+                    append(word);
+                }
+            }
+        } else if (command == 0x0403) {
+            std::size_t offset = 23;
+            for (std::size_t i = 0; i < request[19]; ++i, offset += 6) {
+                append(word_at(read_number(request, offset)));
+            }
+            for (std::size_t i = 0; i < request[20]; ++i, offset += 6) {
+                const std::uint32_t number = read_number(request, offset);
+                append(word_at(number));
+                append(word_at(number + 1));
+            }
+            for (std::size_t i = 0; i < request[22]; ++i, offset += 6) {
+                append(static_cast<std::uint16_t>(read_number(request, offset) % 3 == 0 ? 1 : 0));
+            }
+        } else if (command == 0x1401) {
+            const std::uint32_t head = read_number(request, 19);
+            const std::uint16_t points = static_cast<std::uint16_t>(request[25] | (request[26] << 8));
+            for (std::uint16_t i = 0; i < points; ++i) {
+                memory[head + i] = static_cast<std::uint16_t>(request[27 + i * 2] | (request[28 + i * 2] << 8));
+            }
+        } else if (command != 0x1402) {
+            // ランダム書き込みは値を反映せず完了だけを返す（キャッシュの無効化を確認するため）
+            return std::vector<std::uint8_t>{};
+        }
+        return make4EBinaryResponse(request, payload);
+    });
+
+    SessionConfig config{};
+    config.host = "127.0.0.1";
+    config.port = 56021;
+    config.frame_type = FrameType::Frame4E;
+    config.series = PlcSeries::IQ_R;
+
+    McClient client;
+    client.connect(config);
+    assert(!client.isCacheEnabled());
+    client.setCacheEnabled(true);
+
+    // 通常の読み取りはキャッシュに格納し、max_age 以内の読み取りは送信しない
+    const auto range = makeDeviceRange("D100", 10);
+    auto words = client.readWords(range);
+    assert(frames == 1 && words.size() == 10 && words[9] == 109);
+    words = client.readWords(range, std::chrono::hours(1));
+    assert(frames == 1 && words.size() == 10 && words[0] == 100 && words[9] == 109);
+
+    // PLC 側の変化は max_age が切れるまで見えない
+    memory[105] = 555;
+    assert(client.readWords(range, std::chrono::hours(1))[5] == 105);
+    assert(client.readWords(range, std::chrono::milliseconds(0))[5] == 555);
+    assert(frames == 2);
+
+    // 未取得の区間と無効化した区間だけを 1 フレームで読む
+    memory[103] = 777;
+    client.randomWrite(DeviceWritePlan{{makeDeviceAddress("D103"), ValueFormat::UInt16(), std::uint16_t{777}}});
+    assert(frames == 3);
+    words = client.readWords(makeDeviceRange("D100", 20), std::chrono::hours(1));
+    assert(frames == 4);
+    assert(words[3] == 777 && words[5] == 555 && words[19] == 119);
+    client.readWords(makeDeviceRange("D100", 20), std::chrono::hours(1));
+    assert(frames == 4);
+
+    // 書き込んだ値はキャッシュに反映する
+    client.writeWords(makeDeviceRange("D200", 3), {1, 2, 3});
+    assert(frames == 5);
+    words = client.readWords(makeDeviceRange("D200", 3), std::chrono::hours(1));
+    assert(frames == 5 && (words == std::vector<std::uint16_t>{1, 2, 3}));
+
+    // ランダム読み出しはワードデバイスの未取得分とビットデバイスだけを読む
+    DeviceReadPlan plan{
+        {makeDeviceAddress("D101"), ValueFormat::UInt16()},
+        {makeDeviceAddress("M3"), ValueFormat::BitArray(1)},
+        {makeDeviceAddress("D9000"), ValueFormat::UInt32()},
+    };
+    auto values = client.randomRead(plan, std::chrono::hours(1));
+    assert(frames == 6);
+    assert(std::get<std::uint16_t>(values[0]) == 101);
+    assert(std::get<std::vector<bool>>(values[1]) == std::vector<bool>{true});
+    assert(std::get<std::uint32_t>(values[2]) == ((9001U << 16) | 9000U));
+    memory[9000] = 0;
+    values = client.randomRead(plan, std::chrono::hours(1));
+    assert(frames == 7);
+    assert(std::get<std::uint32_t>(values[2]) == ((9001U << 16) | 9000U));
+    values = client.randomRead(DeviceReadPlan{plan[0], plan[2]}, std::chrono::hours(1));
+    assert(frames == 7);
+    assert(std::get<std::uint32_t>(values[1]) == ((9001U << 16) | 9000U));
+
+    // max_age を過ぎた値は読み直す
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    words = client.readWords(range, std::chrono::milliseconds(20));
+    assert(frames == 8 && words[5] == 555);
+
+    // 無効にするとキャッシュを破棄し、毎回読み取る
+    client.setCacheEnabled(false);
+    client.readWords(range, std::chrono::hours(1));
+    client.readWords(range, std::chrono::hours(1));
+    assert(frames == 10);
+
+    client.disconnect();
+    server.stop();
+}
+
+// 複数スレッドから 1 つの McClient を同時に使用し、応答がそれぞれの呼び出し元に正しく返ることを検証する。
+// 4E フレーム（パイプラインで多重化）と 3E フレーム（1 件ずつ往復）の両方で、書き込み・読み取り・
+// 分割読み出し・PLC エラーを混在させる。
+void testConcurrentCallers(FrameType frame_type, std::uint16_t port) {
+    using cpmcprotocol::testutil::MockSlmpServer;
+
+    // D デバイスのメモリ（未書き込みのワードはデバイス番号の下位 16bit）
+    std::map<std::uint32_t, std::uint16_t> memory;
+    MockSlmpServer server;
+    server.start(port, [&memory](const std::vector<std::uint8_t>& request) {
+        const bool is4e = !request.empty() && request[0] == 0x54;
+        const std::size_t off = is4e ? 4 : 0;
+        if (request.size() < 23 + off) {
+            return std::vector<std::uint8_t>{};
+        }
+        auto read_u16 = [&](std::size_t offset) {
+            return static_cast<std::uint16_t>(request[offset] | (request[offset + 1] << 8));
+        };
+        auto respond = [&](const std::vector<std::uint8_t>& payload, std::uint16_t completion) {
+            return is4e ? make4EBinaryResponse(request, payload, completion)
+                        : makeBinaryResponse(request, payload, completion);
+        };
+        const std::uint16_t command = read_u16(11 + off);
+        const std::uint32_t head = static_cast<std::uint32_t>(read_u16(15 + off) | (read_u16(17 + off) << 16));
+        const std::uint16_t points = read_u16(21 + off);
+        if (command == 0x1401) {
+            for (std::uint16_t i = 0; i < points; ++i) {
+                memory[head + i] = read_u16(23 + off + i * 2);
+            }
+            return respond({}, 0x0000);
+        }
+        // D9999 を含む読み取りは PLC エラーを返す
+        std::vector<std::uint8_t> payload;
+        bool rejected = false;
+        auto append = [&](std::uint32_t number) {
+            rejected = rejected || number == 9999;
+            const auto it = memory.find(number);
+            const std::uint16_t value = it != memory.end() ? it->second : static_cast<std::uint16_t>(number);
+            payload.push_back(static_cast<std::uint8_t>(value & 0xFF));
+            payload.push_back(static_cast<std::uint8_t>((value >> 8) & 0xFF));
+        };
+        if (command == 0x0403) {
+            // キャッシュの読み取りは最適化によりランダム読み出しになる場合がある（ワード点、ダブルワード点の順）
+            std::size_t offset = 19 + off;
+            for (std::size_t i = 0; i < request[15 + off]; ++i, offset += 6) {
+                append(static_cast<std::uint32_t>(read_u16(offset) | (read_u16(offset + 2) << 16)));
+            }
+            for (std::size_t i = 0; i < request[16 + off]; ++i, offset += 6) {
+                const auto number = static_cast<std::uint32_t>(read_u16(offset) | (read_u16(offset + 2) << 16));
+                append(number);
+                append(number + 1);
+            }
+            return rejected ? respond({}, 0xC051) : respond(payload, 0x0000);
+        }
+        if (command != 0x0401) {
+            return std::vector<std::uint8_t>{};
+        }
+        for (std::uint16_t i = 0; i < points; ++i) {
+            append(head + i);
+        }
+        return rejected ? respond({}, 0xC051) : respond(payload, 0x0000);
+    });
+
+    SessionConfig config{};
+    config.host = "127.0.0.1";
+    config.port = port;
+    config.frame_type = frame_type;
+    config.max_in_flight = 4;
+    config.series = PlcSeries::IQ_R;
+
+    McClient client;
+    client.connect(config);
+    // 自分の書き込みの直後にキャッシュから読んでも、他のスレッドの読み取りで古い値に戻らない
+    client.setCacheEnabled(frame_type == FrameType::Frame4E);
+
+    constexpr std::uint32_t kThreads = 8;
+    constexpr std::uint32_t kIterations = 60;
+    std::atomic<std::uint32_t> failures{0};
+    std::vector<std::thread> threads;
+    for (std::uint32_t t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&client, &failures, t] {
+            for (std::uint32_t i = 0; i < kIterations; ++i) {
+                // スレッドごとの領域に書き込み、読み直す
+                const auto range = makeDeviceRange("D" + std::to_string(t * 1000 + (i % 10) * 10), 5);
+                const std::uint16_t base = static_cast<std::uint16_t>((t << 12) | (i << 3));
+                client.writeWords(range, {base, static_cast<std::uint16_t>(base + 1), static_cast<std::uint16_t>(base + 2),
+                                          static_cast<std::uint16_t>(base + 3), static_cast<std::uint16_t>(base + 4)});
+                const auto read = client.readWords(range);
+                const auto cached = client.readWords(range, std::chrono::hours(1));
+                for (std::uint16_t k = 0; k < 5; ++k) {
+                    if (read[k] != base + k || cached[k] != base + k) {
+                        ++failures;
+                    }
+                }
+
+                // 分割される大きな読み出しが他のスレッドの要求と並行して結合される
+                if (i % 10 == t % 10) {
+                    const auto area = client.readWordArea(makeDeviceAddress("D20000"), 2000);
+                    for (std::size_t k = 0; k < area.size(); ++k) {
+                        if (area[k] != static_cast<std::uint16_t>(20000 + k)) {
+                            ++failures;
+                        }
+                    }
+                }
+
+                // PLC エラーは要求したスレッドだけに返る
+                if (t == kThreads - 1 && i % 5 == 0) {
+                    bool threw = false;
+                    try {
+                        client.readWords(makeDeviceRange("D9999", 1));
+                    } catch (const std::runtime_error&) {
+                        threw = true;
+                    }
+                    if (!threw) {
+                        ++failures;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    assert(failures == 0);
+    assert(client.isConnected());
+
+    client.disconnect();
+    server.stop();
+}
+
 } // namespace
 
 int main() {
@@ -147,6 +1095,24 @@ int main() {
     assert(word_values[0] == 0x1234);
     assert(word_values[1] == 0x5678);
 
+    // 事前エンコード済み要求: タイマー変更はパッチ、経路変更は再エンコード
+    auto prepared = client.prepareReadWords(word_range);
+    assert(!prepared.empty());
+    for (int i = 0; i < 3; ++i) {
+        auto prepared_values = client.readWords(prepared);
+        assert(prepared_values.size() == 2 && prepared_values[0] == 0x1234);
+    }
+    AccessOption slow_option = option;
+    slow_option.timeout_seconds = 2;
+    client.setAccessOption(slow_option);
+    client.readWords(prepared);
+    assert(prepared.frame()[9] == 8 && prepared.frame()[10] == 0);
+    slow_option.module_station = 0x04;
+    client.setAccessOption(slow_option);
+    client.readWords(prepared);
+    assert(prepared.frame()[6] == 0x04);
+    client.setAccessOption(option);
+
     DeviceRange bit_range{DeviceAddress{"X10", DeviceType::Bit}, 3};
     auto bit_values = client.readBits(bit_range);
     assert(bit_values.size() == 3);
@@ -163,6 +1129,11 @@ int main() {
     assert(std::get<int16_t>(random_values[0]) == static_cast<int16_t>(0x4321));
     assert(std::get<int32_t>(random_values[1]) == static_cast<int32_t>(0xCDEF89AB));
 
+    const auto resolved_plan = resolveReadPlan(read_plan);
+    auto resolved_values = client.randomRead(resolved_plan);
+    assert(std::get<int16_t>(resolved_values[0]) == static_cast<int16_t>(0x4321));
+    assert(std::get<int32_t>(resolved_values[1]) == static_cast<int32_t>(0xCDEF89AB));
+
     DeviceWritePlan write_plan{
         {DeviceAddress{"D200", DeviceType::Word}, ValueFormat::Int16(), static_cast<int16_t>(0x1111)},
         {DeviceAddress{"D300", DeviceType::DoubleWord}, ValueFormat::Int32(), static_cast<int32_t>(0x12345678)}
@@ -242,5 +1213,15 @@ int main() {
     client.disconnect();
     server.stop();
 
+    testPipelined4E();
+    testLargeRead();
+    testLargeRandomAccess();
+    testMultipleBlocks();
+    testReadOptimized();
+    testMonitor();
+    testShadowCache();
+    testConcurrentCallers(FrameType::Frame4E, 56023);
+    testConcurrentCallers(FrameType::Frame3E, 56024);
+
     return 0;
 }
@@ -0,0 +1,193 @@
+#include "cpmcprotocol/reactor_client.hpp"
+#include "cpmcprotocol/session_config.hpp"
+#include "cpmcprotocol/transport.hpp"
+#include "util/mock_plc.hpp"
+#include "util/mock_slmp_server.hpp"
+
+#include <poll.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace cpmcprotocol;
+using cpmcprotocol::testutil::MockPlc;
+using cpmcprotocol::testutil::MockSlmpServer;
+
+namespace {
+
+// 未書き込みの D は番号の下位 16bit、M は 0（D9999 を含む読み出しは PLC エラーにする）
+std::uint16_t initialValue(std::uint16_t code, std::uint32_t number) {
+    return code == MockPlc::kCodeD ? static_cast<std::uint16_t>(number) : 0;
+}
+
+SessionConfig makeConfig(std::uint16_t port, FrameType frame_type) {
+    SessionConfig config{};
+    config.host = "127.0.0.1";
+    config.port = port;
+    config.frame_type = frame_type;
+    config.series = PlcSeries::IQ_R;
+    config.max_in_flight = 4;
+    return config;
+}
+
+// 利用者のリアクターに相当する poll() ループ。完了した操作を識別番号ごとに集める。
+using Completions = std::map<McReactorClient::OperationId, McReactorClient::Completion>;
+
+void drive(McReactorClient& client, Completions& completions) {
+    const auto give_up = std::chrono::steady_clock::now() + 10s;
+    std::vector<McReactorClient::Completion> done;
+    while (client.pendingCount() > 0 && std::chrono::steady_clock::now() < give_up) {
+        assert(client.isConnected());
+        pollfd pfd{client.nativeHandle(), static_cast<short>(POLLIN | (client.wantsWrite() ? POLLOUT : 0)), 0};
+        auto wait = 100ms;
+        if (const auto deadline = client.nextDeadline()) {
+            const auto until = std::chrono::ceil<std::chrono::milliseconds>(*deadline - std::chrono::steady_clock::now());
+            wait = std::clamp(until, 0ms, wait);
+        }
+        if (::poll(&pfd, 1, static_cast<int>(wait.count())) > 0) {
+            if (pfd.revents & POLLOUT) {
+                client.processWritable();
+            }
+            if (pfd.revents & (POLLIN | POLLHUP | POLLERR)) {
+                client.processReadable();
+            }
+        }
+        client.processTimeouts();
+        client.pollCompletions(done);
+    }
+    assert(client.pendingCount() == 0);
+    client.pollCompletions(done);
+    for (auto& completion : done) {
+        const auto id = completion.id;
+        assert(completions.count(id) == 0);
+        completions.emplace(id, std::move(completion));
+    }
+}
+
+template <typename T>
+const T& resultOf(const Completions& completions, McReactorClient::OperationId id) {
+    const auto& completion = completions.at(id);
+    assert(!completion.error);
+    return std::get<T>(completion.result);
+}
+
+template <typename Error>
+bool failedWith(const Completions& completions, McReactorClient::OperationId id) {
+    try {
+        std::rethrow_exception(completions.at(id).error);
+    } catch (const Error&) {
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+void testOperations(FrameType frame_type, std::uint16_t port) {
+    MockPlc plc(initialValue);
+    plc.setFaultDevice(MockPlc::kCodeD, 9999);
+    MockSlmpServer server;
+    server.start(port, plc.handler());
+
+    McReactorClient client;
+    client.connect(makeConfig(port, frame_type));
+    assert(client.isConnected() && client.nativeHandle() >= 0);
+
+    // 送信数の上限を超える操作をまとめて開始し、リアクターから駆動する
+    Completions completions;
+    std::vector<McReactorClient::OperationId> writes;
+    for (std::uint32_t i = 0; i < 100; ++i) {
+        const auto value = static_cast<std::uint16_t>(i * 7);
+        writes.push_back(client.writeWords(makeDeviceRange("D" + std::to_string(1000 + i), 1), {value}));
+    }
+    assert(client.pendingCount() > 0);
+    const auto area = client.readWordArea(makeDeviceAddress("D20000"), 3000);
+    const auto bits_written = client.writeBits(makeDeviceRange("M10", 3), {true, false, true});
+    const auto bits = client.readBits(makeDeviceRange("M9", 5));
+    DeviceReadPlan plan;
+    plan.push_back({makeDeviceAddress("D5"), ValueFormat::UInt16()});
+    plan.push_back({makeDeviceAddress("D1000"), ValueFormat::UInt32()});
+    const auto random = client.randomRead(plan);
+    const auto rejected = client.readWordArea(makeDeviceAddress("D9000"), 2000);
+
+    // 引数の不正はその場で送出し、識別番号を消費しない
+    bool threw = false;
+    try {
+        client.writeWords(makeDeviceRange("D0", 2), {1});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    const auto readback = client.readWords(makeDeviceRange("D1000", 100));
+    assert(readback == rejected + 1);
+
+    drive(client, completions);
+    assert(completions.size() == writes.size() + 6);
+    for (const auto id : writes) {
+        resultOf<std::monostate>(completions, id);
+    }
+    const auto& words = resultOf<std::vector<std::uint16_t>>(completions, area);
+    assert(words.size() == 3000 && words[0] == 20000 && words[2999] == static_cast<std::uint16_t>(22999));
+    resultOf<std::monostate>(completions, bits_written);
+    assert((resultOf<std::vector<bool>>(completions, bits) == std::vector<bool>{false, true, false, true, false}));
+    const auto& values = resultOf<std::vector<DeviceValue>>(completions, random);
+    assert(std::get<std::uint16_t>(values[0]) == 5);
+    assert(std::get<std::uint32_t>(values[1]) == (7u << 16));
+    assert(failedWith<std::runtime_error>(completions, rejected) &&
+           !failedWith<TransportError>(completions, rejected));
+    const auto& written = resultOf<std::vector<std::uint16_t>>(completions, readback);
+    for (std::uint32_t i = 0; i < 100; ++i) {
+        assert(written[i] == static_cast<std::uint16_t>(i * 7));
+    }
+
+    // 切断すると実行中・送信待ちの操作は TransportError で完了キューに積まれ、以降の操作も失敗する
+    const auto interrupted = client.readWordArea(makeDeviceAddress("D0"), 5000);
+    client.disconnect();
+    assert(!client.isConnected() && client.pendingCount() == 0);
+    const auto after = client.readWords(makeDeviceRange("D0", 1));
+    std::vector<McReactorClient::Completion> done;
+    assert(client.completionCount() == 2 && client.pollCompletions(done) == 2);
+    assert(done[0].id == interrupted && done[1].id == after);
+    assert(done[0].error && done[1].error);
+    assert(client.completionCount() == 0);
+
+    server.stop();
+}
+
+void testTimeout() {
+    MockSlmpServer server;
+    server.start(56034, [](const std::vector<std::uint8_t>&) { return std::vector<std::uint8_t>{}; });
+
+    McReactorClient client;
+    auto config = makeConfig(56034, FrameType::Frame4E);
+    config.timeout_250ms = 1;
+    client.connect(config);
+
+    const auto id = client.readWords(makeDeviceRange("D0", 1));
+    assert(client.nextDeadline().has_value());
+    Completions completions;
+    drive(client, completions);
+    assert(failedWith<TransportTimeoutError>(completions, id));
+    // 4E フレームではタイムアウトした要求だけが失敗し、接続は維持する
+    assert(client.isConnected() && !client.nextDeadline());
+
+    client.disconnect();
+    server.stop();
+}
+
+} // namespace
+
+int main() {
+    testOperations(FrameType::Frame4E, 56032);
+    testOperations(FrameType::Frame3E, 56033);
+    testTimeout();
+    return 0;
+}
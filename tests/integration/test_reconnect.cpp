@@ -0,0 +1,244 @@
+#include "cpmcprotocol/device.hpp"
+#include "cpmcprotocol/mc_client.hpp"
+#include "cpmcprotocol/reconnect_policy.hpp"
+#include "cpmcprotocol/session_config.hpp"
+#include "cpmcprotocol/transport.hpp"
+#include "util/mock_slmp_server.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace cpmcprotocol;
+using cpmcprotocol::testutil::MockSlmpServer;
+using namespace std::chrono_literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::uint16_t kPort = 56038;
+constexpr std::uint16_t kWordValue = 0x1234;
+
+// 3E バイナリの一括読み出し（各ワード kWordValue）と一括書き込みに応答する
+std::vector<std::uint8_t> serve(const std::vector<std::uint8_t>& request) {
+    if (request.size() < 15 || request[0] != 0x50) {
+        return {};
+    }
+    const std::uint16_t command = static_cast<std::uint16_t>(request[11] | (request[12] << 8));
+    std::vector<std::uint8_t> payload;
+    if (command == 0x0401) {
+        const std::size_t points = static_cast<std::size_t>(request[request.size() - 2] |
+                                                            (request[request.size() - 1] << 8));
+        for (std::size_t i = 0; i < points; ++i) {
+            payload.push_back(static_cast<std::uint8_t>(kWordValue & 0xFF));
+            payload.push_back(static_cast<std::uint8_t>(kWordValue >> 8));
+        }
+    } else if (command != 0x1401) {
+        return {};
+    }
+
+    std::vector<std::uint8_t> response{0xD0, 0x00, request[2], request[3], request[4], request[5], request[6]};
+    const std::uint16_t data_length = static_cast<std::uint16_t>(2 + payload.size());
+    response.push_back(static_cast<std::uint8_t>(data_length & 0xFF));
+    response.push_back(static_cast<std::uint8_t>(data_length >> 8));
+    response.push_back(0x00);
+    response.push_back(0x00);
+    response.insert(response.end(), payload.begin(), payload.end());
+    return response;
+}
+
+// 監視スレッドから届いた状態の変化を記録する
+class StateLog {
+public:
+    ConnectionStateHandler handler() {
+        return [this](ConnectionState state, std::exception_ptr cause) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            events_.emplace_back(state, cause);
+        };
+    }
+
+    // 最後に届いた状態が expected になるまで待つ
+    bool waitFor(ConnectionState expected, std::chrono::milliseconds timeout = 3000ms) {
+        const auto deadline = Clock::now() + timeout;
+        while (Clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!events_.empty() && events_.back().first == expected) {
+                    return true;
+                }
+            }
+            std::this_thread::sleep_for(5ms);
+        }
+        return false;
+    }
+
+    std::vector<std::pair<ConnectionState, std::exception_ptr>> take() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return std::exchange(events_, {});
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::pair<ConnectionState, std::exception_ptr>> events_;
+};
+
+ReconnectPolicy fastPolicy() {
+    ReconnectPolicy policy;
+    policy.enabled = true;
+    policy.initial_delay = 50ms;
+    policy.max_delay = 200ms;
+    policy.read_retry_timeout = 3000ms;
+    return policy;
+}
+
+void testInvalidPolicy(McClient& client) {
+    auto rejects = [&](ReconnectPolicy policy) {
+        try {
+            client.setReconnectPolicy(policy);
+        } catch (const std::invalid_argument&) {
+            return true;
+        }
+        return false;
+    };
+    ReconnectPolicy policy = fastPolicy();
+    policy.multiplier = 0.5;
+    assert(rejects(policy));
+    policy = fastPolicy();
+    policy.jitter = 1.5;
+    assert(rejects(policy));
+    policy = fastPolicy();
+    policy.max_delay = 10ms;
+    assert(rejects(policy));
+}
+
+} // namespace
+
+int main() {
+    const auto head = makeDeviceRange("D0", 4);
+
+    SessionConfig config;
+    config.host = "127.0.0.1";
+    config.port = kPort;
+    config.timeout_250ms = 2;
+
+    MockSlmpServer server;
+    server.start(kPort, serve);
+
+    McClient client;
+    StateLog log;
+    client.setConnectionStateHandler(log.handler());
+    testInvalidPolicy(client);
+    client.setReconnectPolicy(fastPolicy());
+    assert(client.connectionState() == ConnectionState::Disconnected);
+
+    client.connect(config);
+    assert(client.connectionState() == ConnectionState::Connected);
+    assert(log.waitFor(ConnectionState::Connected));
+    assert(client.readWords(head) == std::vector<std::uint16_t>(4, kWordValue));
+    log.take();
+
+    // 読み取り: 接続が失われても再接続を待って再試行し、呼び出し元には結果だけが返る
+    {
+        server.stop();
+        std::thread restart([&] {
+            std::this_thread::sleep_for(300ms);
+            server.start(kPort, serve);
+        });
+        const auto values = client.readWords(head);
+        restart.join();
+        assert(values == std::vector<std::uint16_t>(4, kWordValue));
+        assert(client.connectionState() == ConnectionState::Connected);
+        assert(log.waitFor(ConnectionState::Connected));
+        const auto events = log.take();
+        assert(events.size() == 2);
+        assert(events[0].first == ConnectionState::Reconnecting && events[0].second);
+        assert(events[1].first == ConnectionState::Connected && !events[1].second);
+    }
+
+    // 書き込み: 送信中に失われた書き込みは再試行せず、再接続中の書き込みは送信せずに即座に失敗する
+    {
+        server.stop();
+        bool lost = false;
+        try {
+            client.writeWords(head, {1, 2, 3, 4});
+        } catch (const TransportReconnectingError&) {
+            assert(false);
+        } catch (const TransportError&) {
+            lost = true;
+        }
+        assert(lost);
+        assert(client.connectionState() == ConnectionState::Reconnecting);
+
+        const auto started = Clock::now();
+        bool rejected = false;
+        try {
+            client.writeWords(head, {1, 2, 3, 4});
+        } catch (const TransportReconnectingError&) {
+            rejected = true;
+        }
+        assert(rejected);
+        assert(Clock::now() - started < 50ms);
+
+        server.start(kPort, serve);
+        assert(log.waitFor(ConnectionState::Connected));
+        client.writeWords(head, {1, 2, 3, 4});
+        log.take();
+    }
+
+    // 試行回数の上限に達したら Disconnected になり、待っていた読み取りは元のエラーで失敗する
+    {
+        ReconnectPolicy policy = fastPolicy();
+        policy.initial_delay = 20ms;
+        policy.max_attempts = 2;
+        client.setReconnectPolicy(policy);
+        server.stop();
+        const auto started = Clock::now();
+        bool failed = false;
+        try {
+            client.readWords(head);
+        } catch (const TransportError&) {
+            failed = true;
+        }
+        assert(failed);
+        assert(Clock::now() - started < 1500ms);
+        assert(client.connectionState() == ConnectionState::Disconnected);
+        assert(!client.isConnected());
+        assert(log.waitFor(ConnectionState::Disconnected));
+        const auto events = log.take();
+        assert(events.back().second); // 最後の再接続の失敗
+
+        server.start(kPort, serve);
+        client.connect(config);
+        assert(client.readWords(head) == std::vector<std::uint16_t>(4, kWordValue));
+        assert(log.waitFor(ConnectionState::Connected));
+        log.take();
+    }
+
+    // 自動再接続が無効なら、接続が失われると Disconnected を通知する
+    {
+        client.setReconnectPolicy(ReconnectPolicy{});
+        server.stop();
+        bool failed = false;
+        try {
+            client.readWords(head);
+        } catch (const TransportReconnectingError&) {
+            assert(false);
+        } catch (const TransportError&) {
+            failed = true;
+        }
+        assert(failed);
+        assert(client.connectionState() == ConnectionState::Disconnected);
+        assert(log.waitFor(ConnectionState::Disconnected));
+    }
+
+    client.disconnect();
+    return 0;
+}
@@ -0,0 +1,268 @@
+#include "cpmcprotocol/mc_client.hpp"
+#include "cpmcprotocol/session_config.hpp"
+#include "cpmcprotocol/subscription.hpp"
+#include "util/mock_slmp_server.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using namespace cpmcprotocol;
+using cpmcprotocol::testutil::make4EBinaryResponse;
+using cpmcprotocol::testutil::MockSlmpServer;
+
+namespace {
+
+// ランダム読み出しに応答する。ワードは g_words に値があればその値、なければデバイス番号の下位 16bit、
+// ビットは g_bits に含まれる番号だけ ON を返す
+std::atomic<std::size_t> g_random_frames{0};
+std::mutex g_memory_mutex;
+std::map<std::uint32_t, std::uint16_t> g_words;
+std::set<std::uint32_t> g_bits;
+
+void setFloat(std::uint32_t number, float value) {
+    std::uint32_t raw = 0;
+    std::memcpy(&raw, &value, sizeof(raw));
+    std::lock_guard<std::mutex> lock(g_memory_mutex);
+    g_words[number] = static_cast<std::uint16_t>(raw & 0xFFFF);
+    g_words[number + 1] = static_cast<std::uint16_t>(raw >> 16);
+}
+
+void setWord(std::uint32_t number, std::uint16_t value) {
+    std::lock_guard<std::mutex> lock(g_memory_mutex);
+    g_words[number] = value;
+}
+
+void setBit(std::uint32_t number) {
+    std::lock_guard<std::mutex> lock(g_memory_mutex);
+    g_bits.insert(number);
+}
+
+std::vector<std::uint8_t> echoRandomRead(const std::vector<std::uint8_t>& request) {
+    if (request.size() < 23 || request[0] != 0x54 || request[15] != 0x03 || request[16] != 0x04) {
+        return {};
+    }
+    ++g_random_frames;
+
+    std::lock_guard<std::mutex> lock(g_memory_mutex);
+    std::vector<std::uint8_t> payload;
+    std::size_t offset = 23;
+    auto next_number = [&]() {
+        const std::uint32_t number = static_cast<std::uint32_t>(request[offset] | (request[offset + 1] << 8) |
+                                                                (request[offset + 2] << 16));
+        offset += 6;
+        return number;
+    };
+    auto append = [&](std::uint32_t number) {
+        const auto it = g_words.find(number);
+        const std::uint16_t value = (it != g_words.end()) ? it->second : static_cast<std::uint16_t>(number);
+        payload.push_back(static_cast<std::uint8_t>(value & 0xFF));
+        payload.push_back(static_cast<std::uint8_t>((value >> 8) & 0xFF));
+    };
+    for (std::size_t i = 0; i < request[19]; ++i) {
+        append(next_number());
+    }
+    for (std::size_t i = 0; i < request[20]; ++i) {
+        const std::uint32_t number = next_number();
+        append(number);
+        append(number + 1);
+    }
+    offset += 6 * request[21];
+    for (std::size_t i = 0; i < request[22]; ++i) {
+        payload.push_back(g_bits.count(next_number()) != 0 ? 1 : 0);
+        payload.push_back(0);
+    }
+    return make4EBinaryResponse(request, payload);
+}
+
+SessionConfig makeConfig(std::uint16_t port) {
+    SessionConfig config{};
+    config.host = "127.0.0.1";
+    config.port = port;
+    config.frame_type = FrameType::Frame4E;
+    config.series = PlcSeries::IQ_R;
+    return config;
+}
+
+} // namespace
+
+int main() {
+    MockSlmpServer server;
+    server.start(56020, echoRandomRead);
+
+    McClient client;
+    client.connect(makeConfig(56020));
+
+    // 周期の異なる購読を手動の時刻で poll() し、同じ時刻に来た購読が 1 フレームにまとまることを確認する
+    {
+        SubscriptionEngine engine(client);
+        const auto start = SubscriptionEngine::Clock::now();
+
+        std::vector<SubscriptionUpdate> fast_updates;
+        std::vector<SubscriptionUpdate> slow_updates;
+        const auto fast = engine.subscribe(
+            DeviceReadPlan{{makeDeviceAddress("D100"), ValueFormat::Int16()},
+                           {makeDeviceAddress("D9000"), ValueFormat::UInt16()}},
+            100ms, [&](const SubscriptionUpdate& update) { fast_updates.push_back(update); });
+        const auto slow = engine.subscribe(
+            DeviceReadPlan{{makeDeviceAddress("D5000"), ValueFormat::UInt16()},
+                           {makeDeviceAddress("D100"), ValueFormat::Int16()}},
+            200ms, [&](const SubscriptionUpdate& update) { slow_updates.push_back(update); });
+        assert(engine.size() == 2);
+
+        // 登録直後は両方が対象で、共通の D100 は 1 回だけ読む
+        assert(engine.poll(start) == 2);
+        assert(g_random_frames == 1);
+        assert(fast_updates.size() == 1 && slow_updates.size() == 1);
+        assert(fast_updates[0].id == fast);
+        assert((fast_updates[0].indices == std::vector<std::size_t>{0, 1}));
+        assert(std::get<std::int16_t>(fast_updates[0].values[0]) == 100);
+        assert(std::get<std::uint16_t>(fast_updates[0].values[1]) == 9000);
+        assert(slow_updates[0].id == slow);
+        assert(std::get<std::uint16_t>(slow_updates[0].values[0]) == 5000);
+        assert(std::get<std::int16_t>(slow_updates[0].values[1]) == 100);
+
+        // 周期前は何もしない
+        assert(engine.poll(start) == 0);
+        assert(engine.nextDue().has_value() && *engine.nextDue() <= start + 100ms);
+
+        // 100ms の時刻は速い購読だけ、200ms の時刻は両方を 1 フレームで読む
+        assert(engine.poll(start + 100ms) == 1);
+        assert(fast_updates.size() == 2 && slow_updates.size() == 1);
+        assert(engine.poll(start + 200ms) == 2);
+        assert(fast_updates.size() == 3 && slow_updates.size() == 2);
+        assert(g_random_frames == 3);
+
+        // コールバック内で自身を解除できる
+        bool unsubscribed = false;
+        SubscriptionId once = 0;
+        once = engine.subscribe(DeviceReadPlan{{makeDeviceAddress("D7"), ValueFormat::UInt16()}}, 1000ms,
+                                [&](const SubscriptionUpdate& update) {
+                                    assert(std::get<std::uint16_t>(update.values[0]) == 7);
+                                    unsubscribed = engine.unsubscribe(once);
+                                });
+        assert(engine.poll(start + 250ms) == 1);
+        assert(unsubscribed && engine.size() == 2);
+        assert(!engine.unsubscribe(once));
+
+        // 不正な購読は登録時に拒否する
+        bool threw = false;
+        try {
+            engine.subscribe(DeviceReadPlan{{makeDeviceAddress("D0"), ValueFormat::BitArray(4)}}, 100ms,
+                             [](const SubscriptionUpdate&) {});
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+        threw = false;
+        try {
+            engine.subscribe(DeviceReadPlan{{makeDeviceAddress("D0"), ValueFormat::UInt16()}}, 0ms,
+                             [](const SubscriptionUpdate&) {});
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // 変化検出: 変化したタグだけを通知し、数値タグは不感帯を超えた場合だけ通知する
+    {
+        SubscriptionEngine engine(client);
+        const auto start = SubscriptionEngine::Clock::now();
+        setWord(10, 10);
+        setFloat(30, 1.0f);
+
+        std::vector<SubscriptionUpdate> updates;
+        SubscriptionOptions options;
+        options.changes_only = true;
+        options.deadbands = {5.0, 0.0, 0.0, 0.5};
+        engine.subscribe(DeviceReadPlan{{makeDeviceAddress("D10"), ValueFormat::Int16()},
+                                        {makeDeviceAddress("D20"), ValueFormat::UInt16()},
+                                        {makeDeviceAddress("M4"), ValueFormat::BitArray(1)},
+                                        {makeDeviceAddress("D30"), ValueFormat::Float32()}},
+                         100ms, [&](const SubscriptionUpdate& update) { updates.push_back(update); }, options);
+
+        // 最初の読み取りは全タグを通知する
+        auto tick = start;
+        assert(engine.poll(tick) == 1);
+        assert(updates.size() == 1);
+        assert((updates[0].indices == std::vector<std::size_t>{0, 1, 2, 3}));
+        assert(std::get<std::int16_t>(updates[0].values[0]) == 10);
+        assert(std::get<float>(updates[0].values[3]) == 1.0f);
+
+        // 変化がなければコールバックを呼ばない
+        tick += 100ms;
+        assert(engine.poll(tick) == 1);
+        assert(updates.size() == 1);
+
+        // 不感帯以内の変化は通知せず、不感帯なしのタグは任意の変化を通知する
+        setWord(10, 13);
+        setFloat(30, 1.25f);
+        setWord(20, 21);
+        tick += 100ms;
+        engine.poll(tick);
+        assert(updates.size() == 2);
+        assert((updates[1].indices == std::vector<std::size_t>{1}));
+        assert(std::get<std::uint16_t>(updates[1].values[0]) == 21);
+
+        // 不感帯は最後に通知した値（10, 1.0）との差で判定する
+        setWord(10, 16);
+        setFloat(30, 1.75f);
+        setBit(4);
+        tick += 100ms;
+        engine.poll(tick);
+        assert(updates.size() == 3);
+        assert((updates[2].indices == std::vector<std::size_t>{0, 2, 3}));
+        assert(std::get<std::int16_t>(updates[2].values[0]) == 16);
+        assert(std::get<std::vector<bool>>(updates[2].values[1]) == std::vector<bool>{true});
+        assert(std::get<float>(updates[2].values[2]) == 1.75f);
+
+        bool threw = false;
+        try {
+            SubscriptionOptions no_filter;
+            no_filter.deadbands = {1.0};
+            engine.subscribe(DeviceReadPlan{{makeDeviceAddress("D0"), ValueFormat::UInt16()}}, 100ms,
+                             [](const SubscriptionUpdate&) {}, no_filter);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw && "deadbands require changes_only");
+        threw = false;
+        try {
+            engine.subscribe(DeviceReadPlan{{makeDeviceAddress("D0"), ValueFormat::UInt16()}}, 100ms,
+                             [](const SubscriptionUpdate&) {}, options);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw && "one deadband per tag");
+    }
+
+    // run() は周期ごとに読み取り、stop() で終了する
+    {
+        SubscriptionEngine engine(client);
+        std::atomic<std::size_t> updates{0};
+        engine.subscribe(DeviceReadPlan{{makeDeviceAddress("D1"), ValueFormat::UInt16()}}, 10ms,
+                         [&](const SubscriptionUpdate&) { ++updates; });
+
+        std::thread runner([&engine]() { engine.run(); });
+        const auto deadline = std::chrono::steady_clock::now() + 2s;
+        while (updates < 5 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(1ms);
+        }
+        engine.stop();
+        runner.join();
+        assert(updates >= 5);
+    }
+
+    client.disconnect();
+    server.stop();
+    return 0;
+}
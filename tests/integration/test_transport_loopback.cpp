@@ -8,6 +8,7 @@
 #include <cassert>
 #include <chrono>
 #include <cstdint>
+#include <span>
 #include <thread>
 #include <vector>
 
@@ -34,6 +35,17 @@ int main() {
 
     MockSlmpServer server;
     server.start(static_cast<std::uint16_t>(config.port), [=](const std::vector<std::uint8_t>& req) {
+        if (!req.empty() && req[0] == 0xBB) {
+            // 2 フレームを 1 回の送信でまとめて返す
+            std::vector<std::uint8_t> frames;
+            for (std::uint8_t i = 0; i < 2; ++i) {
+                const std::vector<std::uint8_t> frame{
+                    0xD0, 0x00, config.network, config.pc, 0x00, 0x12, config.module_station,
+                    0x04, 0x00, 0x00, 0x00, static_cast<std::uint8_t>(0x10 + i), 0x00};
+                frames.insert(frames.end(), frame.begin(), frame.end());
+            }
+            return frames;
+        }
         if (!req.empty() && req[0] == 0xAA) {
             return std::vector<std::uint8_t>{
                 0xD0, 0x00,
@@ -91,6 +103,31 @@ int main() {
     assert(diag_parsed.diagnostic_data.size() == 2);
     assert(diag_parsed.device_data.empty());
 
+    // Coalesced frames: the second frame is served from the receive buffer
+    const auto header_length = [](const std::uint8_t* header, std::size_t) {
+        return static_cast<std::size_t>(header[7] | (header[8] << 8));
+    };
+    transport.sendAll(std::vector<std::uint8_t>{0xBB});
+    auto first = transport.receiveFrameView(9, header_length);
+    assert(first.size() == 13);
+    assert(first[11] == 0x10);
+    auto second = transport.receiveFrameView(9, header_length);
+    assert(second.size() == 13);
+    assert(second[11] == 0x11);
+
+    // Gather send: frames (one split across two buffers) leave in a single call and arrive back-to-back
+    {
+        const std::span<const std::uint8_t> whole(request);
+        const std::vector<std::span<const std::uint8_t>> buffers{
+            whole, whole.first(5), whole.subspan(5), std::span<const std::uint8_t>{}, whole};
+        transport.sendAll(buffers);
+        for (int i = 0; i < 3; ++i) {
+            auto gathered = decoder.parseBatchReadResponse(transport.receiveAll(9 + 2 + 8));
+            assert(gathered.completion_code == 0x0000);
+            assert(gathered.device_data[0] == 0x10);
+        }
+    }
+
     transport.disconnect();
     server.stop();
 
@@ -0,0 +1,250 @@
+#include "cpmcprotocol/mc_client.hpp"
+#include "cpmcprotocol/session_config.hpp"
+#include "cpmcprotocol/write_queue.hpp"
+#include "util/mock_slmp_server.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace cpmcprotocol;
+using cpmcprotocol::testutil::make4EBinaryResponse;
+using cpmcprotocol::testutil::MockSlmpServer;
+
+namespace {
+
+// 一括書き込みとランダム書き込みを (デバイスコード, 番号) ごとのメモリに反映する。
+// ビットデバイスは 1 点 1 要素で 0/1 を格納する。
+std::mutex g_mutex;
+std::map<std::pair<std::uint16_t, std::uint32_t>, std::uint16_t> g_memory;
+std::map<std::uint16_t, std::size_t> g_frames;
+std::atomic<bool> g_reject{false};
+
+constexpr std::uint16_t kCodeD = 0xA8;
+constexpr std::uint16_t kCodeM = 0x90;
+
+std::uint16_t memoryAt(std::uint16_t code, std::uint32_t number) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    const auto it = g_memory.find({code, number});
+    return it != g_memory.end() ? it->second : 0;
+}
+
+std::size_t framesOf(std::uint16_t command) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_frames[command];
+}
+
+void resetFrames() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_frames.clear();
+}
+
+std::vector<std::uint8_t> applyWrite(const std::vector<std::uint8_t>& request) {
+    if (request.size() < 23 || request[0] != 0x54) {
+        return {};
+    }
+    auto read_u16 = [&](std::size_t offset) {
+        return static_cast<std::uint16_t>(request[offset] | (request[offset + 1] << 8));
+    };
+    auto read_number = [&](std::size_t offset) {
+        return static_cast<std::uint32_t>(request[offset] | (request[offset + 1] << 8) | (request[offset + 2] << 16) |
+                                          (request[offset + 3] << 24));
+    };
+
+    const std::uint16_t command = read_u16(15);
+    std::lock_guard<std::mutex> lock(g_mutex);
+    ++g_frames[command];
+    if (g_reject) {
+        return make4EBinaryResponse(request, {}, 0xC051);
+    }
+    if (command == 0x1401) {
+        // iQ-R の一括書き込みはビットデバイスも 1 点 1 ワード
+        const std::uint32_t head = read_number(19);
+        const std::uint16_t code = read_u16(23);
+        const std::uint16_t points = read_u16(25);
+        for (std::uint16_t i = 0; i < points; ++i) {
+            g_memory[{code, head + i}] = read_u16(27 + i * 2);
+        }
+    } else if (command == 0x1402) {
+        std::size_t offset = 23;
+        for (std::size_t i = 0; i < request[19]; ++i, offset += 8) {
+            g_memory[{read_u16(offset + 4), read_number(offset)}] = read_u16(offset + 6);
+        }
+        for (std::size_t i = 0; i < request[20]; ++i, offset += 10) {
+            const std::uint32_t number = read_number(offset);
+            g_memory[{read_u16(offset + 4), number}] = read_u16(offset + 6);
+            g_memory[{read_u16(offset + 4), number + 1}] = read_u16(offset + 8);
+        }
+        offset += 14 * request[21];
+        for (std::size_t i = 0; i < request[22]; ++i, offset += 8) {
+            g_memory[{read_u16(offset + 4), read_number(offset)}] = read_u16(offset + 6);
+        }
+    } else {
+        return {};
+    }
+    return make4EBinaryResponse(request, {});
+}
+
+SessionConfig makeConfig(std::uint16_t port) {
+    SessionConfig config{};
+    config.host = "127.0.0.1";
+    config.port = port;
+    config.frame_type = FrameType::Frame4E;
+    config.series = PlcSeries::IQ_R;
+    return config;
+}
+
+} // namespace
+
+int main() {
+    MockSlmpServer server;
+    server.start(56022, applyWrite);
+
+    McClient client;
+    client.connect(makeConfig(56022));
+
+    // 連続する区間は一括書き込み、離れた点はランダム書き込み 1 フレームにまとめる
+    {
+        WriteQueue queue(client);
+        for (std::uint32_t i = 0; i < 10; ++i) {
+            queue.writeWords(makeDeviceRange("D" + std::to_string(100 + i), 1), {static_cast<std::uint16_t>(i + 1)});
+        }
+        queue.writeWords(makeDeviceRange("D100", 1), {99});  // 同じデバイスは最後の値を書き込む
+        for (std::uint32_t i = 0; i < 16; ++i) {
+            queue.writeBits(makeDeviceRange("M" + std::to_string(i), 1), {i == 5});
+        }
+        queue.writeWords(makeDeviceRange("D500", 1), {5});
+        queue.writeWords(makeDeviceRange("D502", 2), {7, 8});
+        queue.randomWrite(DeviceWritePlan{{makeDeviceAddress("D800"), ValueFormat::Float32(), 1.5f},
+                                          {makeDeviceAddress("M100"), ValueFormat::BitArray(1), std::vector<bool>{true}}});
+        assert(queue.pendingPoints() == 10 + 16 + 1 + 2 + 2 + 1);
+
+        assert(queue.flush() == 32);
+        assert(queue.pendingPoints() == 0);
+        assert(framesOf(0x1401) == 2 && framesOf(0x1402) == 1);
+        assert(memoryAt(kCodeD, 100) == 99);
+        assert(memoryAt(kCodeD, 109) == 10);
+        assert(memoryAt(kCodeM, 5) == 1 && memoryAt(kCodeM, 4) == 0);
+        assert(memoryAt(kCodeD, 500) == 5);
+        assert(memoryAt(kCodeD, 502) == 7 && memoryAt(kCodeD, 503) == 8);
+        std::uint32_t raw = static_cast<std::uint32_t>(memoryAt(kCodeD, 800)) |
+                            (static_cast<std::uint32_t>(memoryAt(kCodeD, 801)) << 16);
+        float value = 0.0f;
+        std::memcpy(&value, &raw, sizeof(value));
+        assert(value == 1.5f);
+        assert(memoryAt(kCodeM, 100) == 1);
+
+        // 送信するものがなければ何もしない
+        resetFrames();
+        assert(queue.flush() == 0);
+        assert(framesOf(0x1401) == 0 && framesOf(0x1402) == 0);
+
+        // 1 要求の上限を超える分は分割する（iQ-R のランダム書き込みは 1 要求 80 ワード、一括書き込みは 960 ワード）
+        for (std::uint32_t i = 0; i < 100; ++i) {
+            queue.writeWords(makeDeviceRange("D" + std::to_string(1000 + i * 2), 1), {static_cast<std::uint16_t>(i)});
+        }
+        queue.writeWords(makeDeviceRange("D2000", 1000), std::vector<std::uint16_t>(1000, 0x1234));
+        assert(queue.flush() == 1100);
+        assert(framesOf(0x1402) == 2 && framesOf(0x1401) == 2);
+        assert(memoryAt(kCodeD, 1198) == 99);
+        assert(memoryAt(kCodeD, 2000) == 0x1234 && memoryAt(kCodeD, 2999) == 0x1234);
+
+        // ビットデバイスへのワード値は 16 点として書き込む
+        queue.randomWrite(DeviceWritePlan{{makeDeviceAddress("M32"), ValueFormat::UInt16(), std::uint16_t{0x8001}}});
+        assert(queue.pendingPoints() == 16);
+        queue.flush();
+        assert(memoryAt(kCodeM, 32) == 1 && memoryAt(kCodeM, 33) == 0 && memoryAt(kCodeM, 47) == 1);
+
+        // 不正な書き込みは積まない（プランの一部だけを積むこともない）
+        bool threw = false;
+        try {
+            queue.writeWords(makeDeviceRange("D0", 2), {1});
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+        threw = false;
+        try {
+            queue.randomWrite(DeviceWritePlan{{makeDeviceAddress("D10"), ValueFormat::UInt16(), std::uint16_t{1}},
+                                              {makeDeviceAddress("D20"), ValueFormat::BitArray(1), std::vector<bool>{true}}});
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw && queue.pendingPoints() == 0);
+
+        // 送信に失敗した書き込みはキューに戻り、次の flush() で送信する
+        g_reject = true;
+        queue.writeWords(makeDeviceRange("D9999", 1), {1});
+        threw = false;
+        try {
+            queue.flush();
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw && queue.pendingPoints() == 1);
+        g_reject = false;
+        assert(queue.flush() == 1);
+        assert(memoryAt(kCodeD, 9999) == 1);
+
+        // run() していない間の fence() は待たずに失敗する
+        queue.writeWords(makeDeviceRange("D0", 1), {1});
+        threw = false;
+        try {
+            queue.fence();
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+        queue.flush();
+    }
+
+    // run() 中は複数のスレッドから積み、fence() は待ち時間を待たずに送信させる
+    {
+        WriteQueueOptions options;
+        options.max_delay = std::chrono::hours(1);
+        WriteQueue queue(client, options);
+        std::thread runner([&queue] { queue.run(); });
+
+        std::vector<std::thread> producers;
+        for (std::uint32_t t = 0; t < 2; ++t) {
+            producers.emplace_back([&queue, t] {
+                for (std::uint32_t i = 0; i < 50; ++i) {
+                    const std::uint32_t number = 3000 + t * 100 + i * 2;
+                    queue.writeWords(makeDeviceRange("D" + std::to_string(number), 1),
+                                     {static_cast<std::uint16_t>(number)});
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        queue.fence();
+        assert(queue.pendingPoints() == 0);
+        for (std::uint32_t t = 0; t < 2; ++t) {
+            for (std::uint32_t i = 0; i < 50; ++i) {
+                const std::uint32_t number = 3000 + t * 100 + i * 2;
+                assert(memoryAt(kCodeD, number) == number);
+            }
+        }
+
+        // stop() は残りの書き込みを送信してから終了する
+        queue.writeWords(makeDeviceRange("D4000", 1), {4000});
+        queue.stop();
+        runner.join();
+        assert(memoryAt(kCodeD, 4000) == 4000);
+        assert(queue.pendingPoints() == 0);
+    }
+
+    client.disconnect();
+    server.stop();
+    return 0;
+}
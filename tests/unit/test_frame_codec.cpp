@@ -2,12 +2,17 @@
 #include "cpmcprotocol/codec/frame_decoder.hpp"
 #include "cpmcprotocol/codec/frame_encoder.hpp"
 #include "cpmcprotocol/device.hpp"
+#include "cpmcprotocol/device_table.hpp"
 #include "cpmcprotocol/session_config.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 int main() {
@@ -149,6 +154,246 @@ int main() {
     std::string diagAscii(asciiParsedError.diagnostic_data.begin(), asciiParsedError.diagnostic_data.end());
     assert(diagAscii == "BEEF");
 
+    // Zero-copy view: spans point into the original frame
+    auto view = decoder.parseResponse(response);
+    assert(view.completion_code == 0x0000);
+    assert(view.diagnostic_data.empty());
+    assert(view.device_data.size() == device_data.size());
+    assert(view.device_data.data() == response.data() + 11);
+    auto errorView = decoder.parseResponse(std::span<const std::uint8_t>(error_response));
+    assert(errorView.completion_code == 0x1234);
+    assert(errorView.device_data.empty());
+    assert(errorView.diagnostic_data.data() == error_response.data() + 11);
+    assert(errorView.diagnostic_data.size() == 2);
+
+    // 4E frame: serial number field and response parsing
+    SessionConfig config4e = config;
+    config4e.frame_type = FrameType::Frame4E;
+    auto frame4e = encoder.makeBatchReadRequest(config4e, range);
+    assert(frame4e.size() == frame.size() + 4);
+    assert(frame4e[0] == 0x54 && frame4e[1] == 0x00);
+    assert(frame4e[6] == config.network);
+    assert(frame4e[11] == 14 && frame4e[12] == 0x00);
+    codec::FrameEncoder::setSerialNumber(frame4e, 0xBEEF);
+    assert(frame4e[2] == 0xEF && frame4e[3] == 0xBE);
+    assert(frame4e[4] == 0x00 && frame4e[5] == 0x00);
+
+    std::vector<std::uint8_t> response4e{0xD4, 0x00, 0xEF, 0xBE, 0x00, 0x00};
+    response4e.insert(response4e.end(), response.begin() + 2, response.end());
+    assert(codec::FrameDecoder::headerSize(CommunicationMode::Binary, FrameType::Frame4E) == 13);
+    assert(codec::FrameDecoder::bodyLength(response4e.data(), CommunicationMode::Binary, FrameType::Frame4E) == 6);
+    assert(decoder.parseSerialNumber(response4e) == std::optional<std::uint16_t>(0xBEEF));
+    assert(!decoder.parseSerialNumber(response).has_value());
+    auto parsed4e = decoder.parseBatchReadResponse(response4e);
+    assert(parsed4e.completion_code == 0x0000);
+    assert(parsed4e.device_data == device_data);
+
+    SessionConfig asciiConfig4e = asciiConfig;
+    asciiConfig4e.frame_type = FrameType::Frame4E;
+    auto asciiFrame4e = encoder.makeBatchReadRequest(asciiConfig4e, range);
+    codec::FrameEncoder::setSerialNumber(asciiFrame4e, 0x12AB);
+    std::string asciiFrame4eStr(asciiFrame4e.begin(), asciiFrame4e.end());
+    assert(asciiFrame4eStr.substr(0, 12) == "540012AB0000");
+    assert(asciiFrame4eStr.substr(12) == asciiFrameStr.substr(4));
+
+    std::string asciiResponse4e = "D40012AB0000" + asciiResponse.substr(4);
+    std::vector<std::uint8_t> asciiResponse4eBuf(asciiResponse4e.begin(), asciiResponse4e.end());
+    assert(codec::FrameDecoder::bodyLength(asciiResponse4eBuf.data(), CommunicationMode::Ascii, FrameType::Frame4E) == 12);
+    assert(decoder.parseSerialNumber(asciiResponse4eBuf) == std::optional<std::uint16_t>(0x12AB));
+    assert(decoder.parseBatchReadResponse(asciiResponse4eBuf).device_data == expectedAsciiData);
+
+    bool rejected3e = false;
+    try {
+        codec::FrameEncoder::setSerialNumber(frame, 1);
+    } catch (const std::invalid_argument&) {
+        rejected3e = true;
+    }
+    assert(rejected3e);
+
+    // Monitoring timer patching for 3E/4E binary and ASCII request frames
+    auto timer_frame = encoder.makeBatchReadRequest(config, range);
+    codec::FrameEncoder::setMonitoringTimer(timer_frame, 0x0102);
+    assert(timer_frame[9] == 0x02 && timer_frame[10] == 0x01);
+    codec::FrameEncoder::setMonitoringTimer(frame4e, 0x0304);
+    assert(frame4e[13] == 0x04 && frame4e[14] == 0x03);
+    auto ascii_timer_frame = encoder.makeBatchReadRequest(asciiConfig4e, range);
+    codec::FrameEncoder::setMonitoringTimer(ascii_timer_frame, 0xABCD);
+    assert(std::string(ascii_timer_frame.begin() + 26, ascii_timer_frame.begin() + 30) == "ABCD");
+
+    // Encode into a caller-provided buffer: identical bytes, capacity is reused
+    std::vector<std::uint8_t> reused;
+    encoder.makeBatchWriteRequest(reused, config, write_range, write_values);
+    assert(reused == write_frame);
+    const auto* reused_data = reused.data();
+    encoder.makeBatchReadRequest(reused, config, range);
+    assert(reused == frame);
+    assert(reused.data() == reused_data);
+    assert(reused.size() == codec::FrameEncoder::batchReadRequestSize(config));
+    encoder.makeBatchReadRequest(reused, asciiConfig4e, range);
+    assert(reused.size() == codec::FrameEncoder::batchReadRequestSize(asciiConfig4e));
+
+    // Pre-resolved devices encode to the same bytes as named devices
+    static_assert(sizeof(ResolvedDevice) == 8);
+    static_assert(std::is_trivially_copyable_v<ResolvedDevice>);
+    const auto resolved_range = resolveRange(range);
+    assert(resolved_range.head.number == 123 && resolved_range.head.code == 0xA8);
+    encoder.makeBatchReadRequest(reused, config, resolved_range);
+    assert(reused == frame);
+    encoder.makeBatchReadRequest(reused, asciiConfig, resolved_range);
+    assert(reused == asciiFrame);
+    std::vector<std::uint8_t> resolved_random;
+    encoder.makeRandomReadRequest(resolved_random, config, resolveRandomRequest(random_request));
+    assert(resolved_random == random_read_frame);
+    assert(resolveDevice("x1f").number == 0x1F);
+    assert(formatDevice(resolveDevice("X1F")) == "X1F");
+    assert(formatDevice(resolveDevice("ZR1234")) == "ZR1234");
+
+    // Compile-time literals resolve to the same packed address as the runtime path
+    {
+        using namespace cpmcprotocol::literals;
+        constexpr ResolvedDevice d1000 = "D1000"_dev;
+        static_assert(d1000.number == 1000 && d1000.code == 0xA8 && d1000.type == DeviceType::Word);
+        static_assert("X1F"_dev.number == 0x1F && "X1F"_dev.type == DeviceType::Bit);
+        static_assert("W0x1A"_dev.number == 0x1A);
+        static_assert("ZR10"_dev.code == 0xB0 && "RD5"_dev.code == 0x2C);
+        static_assert(parseDeviceName("D1A").error == DeviceParseError::InvalidNumber);
+        static_assert(parseDeviceName("Q10").error == DeviceParseError::UnknownPrefix);
+        static_assert(parseDeviceName("D").error == DeviceParseError::MissingNumber);
+        static_assert(parseDeviceName("X100000000").error == DeviceParseError::InvalidNumber);
+        assert(d1000 == resolveDevice("D1000"));
+        assert("X1F"_dev == resolveDevice("X1F"));
+        assert("ZR1234"_dev == resolveDevice("ZR1234"));
+        assert(!isValidDeviceName("D12Z"));
+    }
+    bool unresolved_threw = false;
+    try {
+        encoder.makeBatchReadRequest(reused, config, ResolvedRange{ResolvedDevice{}, 1});
+    } catch (const std::invalid_argument&) {
+        unresolved_threw = true;
+    }
+    assert(unresolved_threw);
+
+    // Batch reads beyond the per-request point limit are rejected before reaching the PLC
+    static_assert(codec::FrameEncoder::maxBatchReadPoints(DeviceType::Word) == 960);
+    static_assert(codec::FrameEncoder::maxBatchReadPoints(DeviceType::Bit) == 7168);
+    encoder.makeBatchReadRequest(reused, config, makeDeviceRange("D0", 960));
+    encoder.makeBatchReadRequest(reused, config, makeDeviceRange("M0", 7168));
+    bool over_limit_threw = false;
+    try {
+        encoder.makeBatchReadRequest(reused, config, makeDeviceRange("D0", 961));
+    } catch (const std::invalid_argument&) {
+        over_limit_threw = true;
+    }
+    assert(over_limit_threw);
+
+    // Batch writes have their own limit
+    static_assert(codec::FrameEncoder::maxBatchWritePoints(DeviceType::Word) == 960);
+    static_assert(codec::FrameEncoder::maxBatchWritePoints(DeviceType::Bit) == 7168);
+    encoder.makeBatchWriteRequest(reused, config, makeDeviceRange("D0", 960), std::vector<std::uint16_t>(960));
+    over_limit_threw = false;
+    try {
+        encoder.makeBatchWriteRequest(reused, config, makeDeviceRange("D0", 961), std::vector<std::uint16_t>(961));
+    } catch (const std::invalid_argument&) {
+        over_limit_threw = true;
+    }
+    assert(over_limit_threw);
+
+    // Multiple-block batch read/write (0x0406 / 0x1406)
+    {
+        SessionConfig qConfig = config;
+        qConfig.series = PlcSeries::Q;
+        MultiBlockRequest blocks{};
+        blocks.word_blocks = {makeDeviceRange("D100", 2)};
+        blocks.bit_blocks = {makeDeviceRange("M16", 1)};
+        auto block_frame = encoder.makeMultiBlockReadRequest(qConfig, blocks);
+        const std::size_t body = codec::FrameEncoder::headerSize(qConfig);
+        const std::vector<std::uint8_t> block_body{0x06, 0x04, 0x00, 0x00, 0x01, 0x01,
+                                                   0x64, 0x00, 0x00, 0xA8, 0x02, 0x00,
+                                                   0x10, 0x00, 0x00, 0x90, 0x01, 0x00};
+        assert(std::equal(block_body.begin(), block_body.end(), block_frame.begin() + static_cast<std::ptrdiff_t>(body)));
+        assert(block_frame.size() == body + block_body.size());
+        std::vector<std::uint8_t> resolved_block_frame;
+        encoder.makeMultiBlockReadRequest(resolved_block_frame, qConfig, resolveMultiBlockRequest(blocks));
+        assert(resolved_block_frame == block_frame);
+
+        auto block_write = encoder.makeMultiBlockWriteRequest(qConfig, blocks, {0x1111, 0x2222, 0x8001});
+        const std::vector<std::uint8_t> block_write_tail{0x64, 0x00, 0x00, 0xA8, 0x02, 0x00, 0x11, 0x11, 0x22, 0x22,
+                                                         0x10, 0x00, 0x00, 0x90, 0x01, 0x00, 0x01, 0x80};
+        assert(std::equal(block_write_tail.rbegin(), block_write_tail.rend(), block_write.rbegin()));
+        assert(block_write[body] == 0x06 && block_write[body + 1] == 0x14);
+
+        const std::vector<std::uint8_t> block_response{0xD0, 0x00, 0x00, 0xFF, 0xFF, 0x03, 0x00, 0x08, 0x00,
+                                                       0x00, 0x00, 0x34, 0x12, 0x78, 0x56, 0x01, 0x80};
+        const std::vector<std::uint16_t> block_lengths{2, 1};
+        const auto parsed_blocks = decoder.parseMultiBlockReadResponse(block_response, block_lengths);
+        assert(parsed_blocks.completion_code == 0);
+        assert(parsed_blocks.blocks.size() == 2);
+        assert(parsed_blocks.blocks[0] == (std::vector<std::uint16_t>{0x1234, 0x5678}));
+        assert(parsed_blocks.blocks[1] == (std::vector<std::uint16_t>{0x8001}));
+
+        bool block_threw = false;
+        try {
+            blocks.word_blocks = {makeDeviceRange("D0", 961)};
+            encoder.makeMultiBlockReadRequest(qConfig, blocks);
+        } catch (const std::invalid_argument&) {
+            block_threw = true;
+        }
+        assert(block_threw);
+    }
+
+    // Random requests are limited per series instead of truncating the 8-bit device counts
+    {
+        SessionConfig qConfig = config;
+        qConfig.series = PlcSeries::Q;
+        RandomDeviceRequest many{};
+        many.word_devices.assign(192, DeviceAddress{"D0", DeviceType::Word});
+        encoder.makeRandomReadRequest(reused, qConfig, many);
+        bool random_threw = false;
+        try {
+            encoder.makeRandomReadRequest(reused, config, many);
+        } catch (const std::invalid_argument&) {
+            random_threw = true;
+        }
+        assert(random_threw && "iQ-R allows 96 random read points");
+        many.word_devices.resize(161);
+        random_threw = false;
+        try {
+            encoder.makeRandomWriteRequest(reused, qConfig, many, std::vector<std::uint16_t>(161), {}, {}, {});
+        } catch (const std::invalid_argument&) {
+            random_threw = true;
+        }
+        assert(random_threw && "161 words cost 1932 > 1920");
+    }
+
+    // Monitor registration (0x0801) reuses the random read body; monitor (0x0802) has no data
+    {
+        RandomDeviceRequest monitored{};
+        monitored.word_devices = {DeviceAddress{"D100", DeviceType::Word}};
+        monitored.dword_devices = {DeviceAddress{"D200", DeviceType::DoubleWord}};
+        std::vector<std::uint8_t> random_frame;
+        encoder.makeRandomReadRequest(random_frame, config, monitored);
+        std::vector<std::uint8_t> register_frame;
+        encoder.makeMonitorRegisterRequest(register_frame, config, resolveRandomRequest(monitored));
+        const std::size_t body = codec::FrameEncoder::headerSize(config);
+        assert(register_frame.size() == random_frame.size());
+        assert(register_frame[body] == 0x01 && register_frame[body + 1] == 0x08);
+        assert(std::equal(register_frame.begin() + static_cast<std::ptrdiff_t>(body + 2), register_frame.end(),
+                          random_frame.begin() + static_cast<std::ptrdiff_t>(body + 2)));
+
+        std::vector<std::uint8_t> monitor_frame;
+        encoder.makeMonitorRequest(monitor_frame, config);
+        const std::vector<std::uint8_t> monitor_body{0x02, 0x08, 0x00, 0x00};
+        assert(monitor_frame.size() == body + monitor_body.size());
+        assert(std::equal(monitor_body.begin(), monitor_body.end(), monitor_frame.begin() + static_cast<std::ptrdiff_t>(body)));
+    }
+
+    // 64-bit random write values keep their upper 32 bits
+    RandomDeviceRequest lword_request{};
+    lword_request.lword_devices = {DeviceAddress{"D800", DeviceType::Word}};
+    auto lword_frame = encoder.makeRandomWriteRequest(config, lword_request, {}, {}, {0x1122334455667788ULL}, {});
+    const std::vector<std::uint8_t> lword_bytes{0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11};
+    assert(std::equal(lword_bytes.begin(), lword_bytes.end(), lword_frame.end() - 8));
+
     bool threw = false;
     try {
         SessionConfig qConfig = config;
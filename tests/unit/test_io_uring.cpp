@@ -0,0 +1,41 @@
+#include "io_uring.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+using cpmcprotocol::detail::IoUring;
+
+int main() {
+    // 4 エントリのリングに、完了を刈り取らないまま送信キューの何倍もの NOP を積む
+    auto ring = IoUring::create(4);
+    if (!ring) {
+        return 0; // カーネルが io_uring に対応していない（または禁止されている）
+    }
+
+    constexpr std::uint64_t kOperations = 64;
+    for (std::uint64_t i = 0; i < kOperations; ++i) {
+        io_uring_sqe& sqe = ring->prepare();
+        sqe.opcode = IORING_OP_NOP;
+        sqe.user_data = i;
+    }
+
+    // 満杯の送信キューを上書きしていなければ、すべての操作がちょうど 1 回ずつ完了する
+    std::vector<bool> seen(kOperations, false);
+    std::uint64_t completed = 0;
+    std::vector<IoUring::Completion> completions;
+    for (int round = 0; round < 100 && completed < kOperations; ++round) {
+        completions.clear();
+        ring->submitAndWait(std::chrono::milliseconds(10), completions);
+        for (const auto& completion : completions) {
+            assert(completion.user_data < kOperations && !seen[completion.user_data]);
+            assert(completion.result == 0);
+            seen[completion.user_data] = true;
+            ++completed;
+        }
+    }
+    assert(completed == kOperations);
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "cpmcprotocol/read_optimizer.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace cpmcprotocol;
+using Kind = OptimizedReadFrame::Kind;
+
+namespace {
+
+// 連結したワード列を位置そのものの値で埋める
+std::vector<std::uint16_t> indexWords(std::size_t count) {
+    std::vector<std::uint16_t> words(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        words[i] = static_cast<std::uint16_t>(i);
+    }
+    return words;
+}
+
+bool throwsInvalidArgument(const DeviceReadPlan& plan, PlcSeries series) {
+    try {
+        optimizeReadPlan(plan, series);
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int main() {
+    // 近接したアドレスは 1 範囲にまとまり、一括読み出し 1 フレームになる（順序は元のプランのまま）
+    {
+        DeviceReadPlan plan{
+            {DeviceAddress{"D102", DeviceType::Word}, ValueFormat::UInt16()},
+            {DeviceAddress{"D100", DeviceType::Word}, ValueFormat::UInt16()},
+            {DeviceAddress{"D105", DeviceType::Word}, ValueFormat::UInt16()},
+        };
+        auto optimized = optimizeReadPlan(plan, PlcSeries::IQ_R);
+        assert(optimized.frames.size() == 1);
+        assert(optimized.frames[0].kind == Kind::Batch);
+        assert(optimized.frames[0].blocks.word_blocks.size() == 1);
+        assert(optimized.frames[0].blocks.word_blocks[0].head.number == 100);
+        assert(optimized.frames[0].blocks.word_blocks[0].length == 6);
+        assert(optimized.total_words == 6);
+
+        auto values = decodeOptimizedRead(optimized, indexWords(6));
+        assert(std::get<std::uint16_t>(values[0]) == 2);
+        assert(std::get<std::uint16_t>(values[1]) == 0);
+        assert(std::get<std::uint16_t>(values[2]) == 5);
+    }
+
+    // 隙間がデバイス指定より大きい単独値はランダム読み出しの方が短い
+    {
+        DeviceReadPlan plan{
+            {DeviceAddress{"D100", DeviceType::Word}, ValueFormat::Int16()},
+            {DeviceAddress{"D200", DeviceType::DoubleWord}, ValueFormat::Int32()},
+            {DeviceAddress{"M16", DeviceType::Bit}, ValueFormat::UInt16()},
+            {DeviceAddress{"M203", DeviceType::Bit}, ValueFormat::BitArray(1)},
+        };
+        auto optimized = optimizeReadPlan(plan, PlcSeries::IQ_R);
+        assert(optimized.frames.size() == 1);
+        const auto& frame = optimized.frames[0];
+        assert(frame.kind == Kind::Random);
+        assert(frame.random.word_devices.size() == 2);
+        assert(frame.random.dword_devices.size() == 1);
+        assert(frame.random.bit_devices.size() == 1);
+        assert(frame.word_count == 5);
+
+        // 応答はワード（D100, M16）、ダブルワード（D200）、ビット（M203）の順
+        std::vector<std::uint16_t> words{0xFFFF, 0x1234, 0x5678, 0x0001, 0x0001};
+        auto values = decodeOptimizedRead(optimized, words);
+        assert(std::get<std::int16_t>(values[0]) == -1);
+        assert(std::get<std::int32_t>(values[1]) == 0x00015678);
+        assert(std::get<std::uint16_t>(values[2]) == 0x1234);
+        assert(std::get<std::vector<bool>>(values[3]) == std::vector<bool>{true});
+    }
+
+    // 離れた複数の範囲は複数ブロック読み出し 1 フレームにまとまる（ワードブロックの後にビットブロック）
+    {
+        DeviceReadPlan plan{
+            {DeviceAddress{"M35", DeviceType::Bit}, ValueFormat::BitArray(2)},
+            {DeviceAddress{"D500", DeviceType::Word}, ValueFormat::RawWords(10)},
+            {DeviceAddress{"M0", DeviceType::Bit}, ValueFormat::BitArray(20)},
+            {DeviceAddress{"D0", DeviceType::Word}, ValueFormat::RawWords(10)},
+        };
+        auto optimized = optimizeReadPlan(plan, PlcSeries::IQ_R);
+        assert(optimized.frames.size() == 1);
+        const auto& frame = optimized.frames[0];
+        assert(frame.kind == Kind::MultiBlock);
+        assert(frame.blocks.word_blocks.size() == 2);
+        assert(frame.blocks.word_blocks[0].head.number == 0);
+        assert(frame.blocks.word_blocks[1].head.number == 500);
+        assert(frame.blocks.bit_blocks.size() == 1);
+        assert(frame.blocks.bit_blocks[0].head.number == 0);
+        assert(frame.blocks.bit_blocks[0].length == 3);
+        assert(optimized.total_words == 23);
+
+        std::vector<std::uint16_t> words = indexWords(23);
+        words[20] = 0x0005;  // M0, M2
+        words[22] = 0x0018;  // M35, M36
+        auto values = decodeOptimizedRead(optimized, words);
+        const std::vector<bool> m35{true, true};
+        assert(std::get<std::vector<bool>>(values[0]) == m35);
+        assert(std::get<std::vector<std::uint16_t>>(values[1]).front() == 10);
+        auto m0 = std::get<std::vector<bool>>(values[2]);
+        assert(m0.size() == 20 && m0[0] && !m0[1] && m0[2] && !m0[3]);
+        assert(std::get<std::vector<std::uint16_t>>(values[3]).back() == 9);
+    }
+
+    // 上限を超えるプランは分割される。フレーム数の少ない方式が選ばれる
+    {
+        DeviceReadPlan plan;
+        for (int i = 0; i < 200; ++i) {
+            plan.push_back({DeviceAddress{"D" + std::to_string(i * 10), DeviceType::Word}, ValueFormat::UInt16()});
+        }
+
+        // iQ-R: ランダムは 96 点（3 フレーム）、複数ブロックは 120 ブロック（2 フレーム）
+        auto iqr = optimizeReadPlan(plan, PlcSeries::IQ_R);
+        assert(iqr.frames.size() == 2);
+        assert(iqr.frames[0].kind == Kind::MultiBlock && iqr.frames[0].blocks.word_blocks.size() == 120);
+        assert(iqr.frames[1].kind == Kind::MultiBlock && iqr.frames[1].blocks.word_blocks.size() == 80);
+        assert(iqr.frames[1].word_offset == 120);
+
+        // Q: ランダムは 192 点（2 フレーム）で、デバイス指定が短い分ランダムを選ぶ
+        auto q = optimizeReadPlan(plan, PlcSeries::Q);
+        assert(q.frames.size() == 2);
+        assert(q.frames[0].kind == Kind::Random && q.frames[0].random.word_devices.size() == 192);
+        assert(q.frames[1].kind == Kind::Random && q.frames[1].random.word_devices.size() == 8);
+
+        auto values = decodeOptimizedRead(iqr, indexWords(200));
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            assert(std::get<std::uint16_t>(values[i]) == i);
+        }
+    }
+
+    // 1 要求の点数を超える範囲はフレーム境界で分割される
+    {
+        DeviceReadPlan plan{{DeviceAddress{"D0", DeviceType::Word}, ValueFormat::RawWords(1000)}};
+        auto optimized = optimizeReadPlan(plan, PlcSeries::IQ_R);
+        assert(optimized.frames.size() == 2);
+        assert(optimized.frames[0].kind == Kind::Batch && optimized.frames[0].word_count == 960);
+        assert(optimized.frames[1].kind == Kind::Batch);
+        assert(optimized.frames[1].blocks.word_blocks[0].head.number == 960);
+        assert(optimized.frames[1].word_offset == 960);
+        auto values = decodeOptimizedRead(optimized, indexWords(1000));
+        assert(std::get<std::vector<std::uint16_t>>(values[0])[999] == 999);
+
+        bool threw = false;
+        try {
+            decodeOptimizedRead(optimized, indexWords(999));
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // 不正なプラン
+    assert(throwsInvalidArgument({{DeviceAddress{"D0", DeviceType::Word}, ValueFormat::BitArray(4)}}, PlcSeries::IQ_R));
+    assert(throwsInvalidArgument({{DeviceAddress{"M3", DeviceType::Bit}, ValueFormat::AsciiString(4)}}, PlcSeries::IQ_R));
+    assert(throwsInvalidArgument({{DeviceAddress{"RD0", DeviceType::Word}, ValueFormat::UInt16()}}, PlcSeries::Q));
+    assert(!throwsInvalidArgument({{DeviceAddress{"M3", DeviceType::Bit}, ValueFormat::Int32()}}, PlcSeries::IQ_R));
+
+    return 0;
+}
@@ -143,5 +143,18 @@ int main() {
         assert(combined_error.find(";") != std::string::npos);  // Multiple errors joined
     }
 
+    // Test 10: Zero pipeline depth
+    {
+        SessionConfig config{};
+        config.host = "localhost";
+        config.port = 5000;
+        config.frame_type = FrameType::Frame4E;
+        config.max_in_flight = 0;
+
+        std::string error;
+        assert(!config.isValid(&error));
+        assert(error.find("max_in_flight") != std::string::npos);
+    }
+
     return 0;
 }
@@ -0,0 +1,152 @@
+#include "util/mock_plc.hpp"
+
+#include <utility>
+
+namespace cpmcprotocol::testutil {
+
+std::vector<std::uint8_t> makeBinaryResponse(const std::vector<std::uint8_t>& request,
+                                             const std::vector<std::uint8_t>& payload,
+                                             std::uint16_t completion) {
+    if (request[0] == 0x54) {
+        return make4EBinaryResponse(request, payload, completion);
+    }
+    std::vector<std::uint8_t> response{0xD0, 0x00};
+    response.insert(response.end(), request.begin() + 2, request.begin() + 7);
+    const std::uint16_t data_length = static_cast<std::uint16_t>(2 + payload.size());
+    response.push_back(static_cast<std::uint8_t>(data_length & 0xFF));
+    response.push_back(static_cast<std::uint8_t>((data_length >> 8) & 0xFF));
+    response.push_back(static_cast<std::uint8_t>(completion & 0xFF));
+    response.push_back(static_cast<std::uint8_t>((completion >> 8) & 0xFF));
+    response.insert(response.end(), payload.begin(), payload.end());
+    return response;
+}
+
+MockPlc::MockPlc(InitialValue initial) : initial_(std::move(initial)) {}
+
+MockSlmpServer::Handler MockPlc::handler() {
+    return [this](const std::vector<std::uint8_t>& request) { return serve(request); };
+}
+
+std::uint16_t MockPlc::valueAt(std::uint16_t code, std::uint32_t number) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return valueAtLocked(code, number);
+}
+
+std::uint16_t MockPlc::valueAtLocked(std::uint16_t code, std::uint32_t number) const {
+    const auto it = memory_.find({code, number});
+    if (it != memory_.end()) {
+        return it->second;
+    }
+    return initial_ ? initial_(code, number) : 0;
+}
+
+std::size_t MockPlc::framesOf(std::uint16_t command) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = frames_.find(command);
+    return it != frames_.end() ? it->second : 0;
+}
+
+void MockPlc::resetFrames() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frames_.clear();
+}
+
+void MockPlc::setFaultDevice(std::uint16_t code, std::uint32_t number) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fault_ = std::make_pair(code, number);
+}
+
+void MockPlc::setRejectAll(bool reject) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reject_all_ = reject;
+}
+
+std::vector<std::uint8_t> MockPlc::serve(const std::vector<std::uint8_t>& request) {
+    // The 4E header is 4 bytes longer (serial number and reserved word).
+    const bool is4e = !request.empty() && request[0] == 0x54;
+    const std::size_t off = is4e ? 4 : 0;
+    if (request.size() < 23 + off) {
+        return {};
+    }
+    auto read_u16 = [&](std::size_t offset) {
+        return static_cast<std::uint16_t>(request[offset] | (request[offset + 1] << 8));
+    };
+    auto read_number = [&](std::size_t offset) {
+        return static_cast<std::uint32_t>(read_u16(offset) | (read_u16(offset + 2) << 16));
+    };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::uint16_t command = read_u16(11 + off);
+    ++frames_[command];
+    if (reject_all_) {
+        return makeBinaryResponse(request, {}, 0xC051);
+    }
+
+    const bool bit_unit = read_u16(13 + off) == 0x0003;
+    const std::uint32_t head = read_number(15 + off);
+    const std::uint16_t code = read_u16(19 + off);
+    const std::uint16_t points = read_u16(21 + off);
+    std::vector<std::uint8_t> payload;
+    bool rejected = false;
+    auto append = [&](std::uint16_t device_code, std::uint32_t number) {
+        rejected = rejected || fault_ == std::make_pair(device_code, number);
+        const std::uint16_t value = valueAtLocked(device_code, number);
+        payload.push_back(static_cast<std::uint8_t>(value & 0xFF));
+        payload.push_back(static_cast<std::uint8_t>(value >> 8));
+    };
+
+    switch (command) {
+    case 0x1401:
+        for (std::uint16_t i = 0; i < points; ++i) {
+            memory_[{code, head + i}] = read_u16(23 + off + i * 2);
+        }
+        break;
+    case 0x1402: {
+        // Word points, double-word points, then (skipped) long-word blocks and bit points.
+        std::size_t offset = 19 + off;
+        for (std::size_t i = 0; i < request[15 + off]; ++i, offset += 8) {
+            memory_[{read_u16(offset + 4), read_number(offset)}] = read_u16(offset + 6);
+        }
+        for (std::size_t i = 0; i < request[16 + off]; ++i, offset += 10) {
+            const std::uint32_t number = read_number(offset);
+            memory_[{read_u16(offset + 4), number}] = read_u16(offset + 6);
+            memory_[{read_u16(offset + 4), number + 1}] = read_u16(offset + 8);
+        }
+        offset += 14 * request[17 + off];
+        for (std::size_t i = 0; i < request[18 + off]; ++i, offset += 8) {
+            memory_[{read_u16(offset + 4), read_number(offset)}] = read_u16(offset + 6);
+        }
+        break;
+    }
+    case 0x0401:
+        if (bit_unit) {
+            // Two points per byte, upper nibble first.
+            for (std::uint16_t i = 0; i < points; i += 2) {
+                payload.push_back(static_cast<std::uint8_t>((valueAtLocked(code, head + i) != 0 ? 0x10 : 0x00) |
+                                                            (valueAtLocked(code, head + i + 1) != 0 ? 0x01 : 0x00)));
+            }
+        } else {
+            for (std::uint16_t i = 0; i < points; ++i) {
+                append(code, head + i);
+            }
+        }
+        break;
+    case 0x0403: {
+        // Word points, then double-word points.
+        std::size_t offset = 19 + off;
+        for (std::size_t i = 0; i < request[15 + off]; ++i, offset += 6) {
+            append(read_u16(offset + 4), read_number(offset));
+        }
+        for (std::size_t i = 0; i < request[16 + off]; ++i, offset += 6) {
+            append(read_u16(offset + 4), read_number(offset));
+            append(read_u16(offset + 4), read_number(offset) + 1);
+        }
+        break;
+    }
+    default:
+        return {};
+    }
+    return rejected ? makeBinaryResponse(request, {}, 0xC051) : makeBinaryResponse(request, payload);
+}
+
+} // namespace cpmcprotocol::testutil
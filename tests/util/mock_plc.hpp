@@ -0,0 +1,63 @@
+#pragma once
+
+#include "util/mock_slmp_server.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace cpmcprotocol::testutil {
+
+// Binary 3E or 4E response to request (chosen by the request subheader), see make4EBinaryResponse().
+std::vector<std::uint8_t> makeBinaryResponse(const std::vector<std::uint8_t>& request,
+                                             const std::vector<std::uint8_t>& payload,
+                                             std::uint16_t completion = 0x0000);
+
+// Device memory behind a MockSlmpServer. Answers binary 3E/4E batch read/write (0x0401/0x1401) and
+// random read/write (0x0403/0x1402) with iQ-R addressing (4-byte device number, 2-byte device code).
+// Batch writes store one word per point, bit devices included.
+class MockPlc {
+public:
+    static constexpr std::uint16_t kCodeD = 0xA8;
+    static constexpr std::uint16_t kCodeM = 0x90;
+
+    // Value of a device that has never been written.
+    using InitialValue = std::function<std::uint16_t(std::uint16_t code, std::uint32_t number)>;
+
+    explicit MockPlc(InitialValue initial = {});
+
+    MockPlc(const MockPlc&) = delete;
+    MockPlc& operator=(const MockPlc&) = delete;
+
+    // Handler for MockSlmpServer::start(). The MockPlc must outlive the server.
+    MockSlmpServer::Handler handler();
+    std::vector<std::uint8_t> serve(const std::vector<std::uint8_t>& request);
+
+    std::uint16_t valueAt(std::uint16_t code, std::uint32_t number) const;
+
+    // Frames received per command since the last resetFrames().
+    std::size_t framesOf(std::uint16_t command) const;
+    void resetFrames();
+
+    // Reads that include this device fail with completion code 0xC051.
+    void setFaultDevice(std::uint16_t code, std::uint32_t number);
+    // While set, every request fails with completion code 0xC051 and leaves memory untouched.
+    void setRejectAll(bool reject);
+
+private:
+    std::uint16_t valueAtLocked(std::uint16_t code, std::uint32_t number) const;
+
+    InitialValue initial_;
+    mutable std::mutex mutex_;
+    std::map<std::pair<std::uint16_t, std::uint32_t>, std::uint16_t> memory_;
+    std::map<std::uint16_t, std::size_t> frames_;
+    std::optional<std::pair<std::uint16_t, std::uint32_t>> fault_;
+    bool reject_all_ = false;
+};
+
+} // namespace cpmcprotocol::testutil
@@ -46,6 +46,20 @@ void closeSocket(SocketHandle s) {
 
 } // namespace
 
+std::vector<std::uint8_t> make4EBinaryResponse(const std::vector<std::uint8_t>& request,
+                                               const std::vector<std::uint8_t>& payload,
+                                               std::uint16_t completion) {
+    std::vector<std::uint8_t> response{0xD4, 0x00};
+    response.insert(response.end(), request.begin() + 2, request.begin() + 11);
+    const std::uint16_t data_length = static_cast<std::uint16_t>(2 + payload.size());
+    response.push_back(static_cast<std::uint8_t>(data_length & 0xFF));
+    response.push_back(static_cast<std::uint8_t>((data_length >> 8) & 0xFF));
+    response.push_back(static_cast<std::uint8_t>(completion & 0xFF));
+    response.push_back(static_cast<std::uint8_t>((completion >> 8) & 0xFF));
+    response.insert(response.end(), payload.begin(), payload.end());
+    return response;
+}
+
 MockSlmpServer::MockSlmpServer() = default;
 MockSlmpServer::~MockSlmpServer() { stop(); }
 
@@ -54,7 +68,74 @@ void MockSlmpServer::start(std::uint16_t port, Handler handler) {
         throw std::runtime_error("MockSlmpServer already running");
     }
     port_.store(port, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+        ready_ = false;
+    }
     thread_ = std::thread(&MockSlmpServer::run, this, port, std::move(handler));
+
+    // リッスン開始（または失敗）まで待ち、接続テストが競合しないようにする。
+    std::unique_lock<std::mutex> lock(ready_mutex_);
+    ready_cv_.wait(lock, [this]() { return ready_; });
+}
+
+void MockSlmpServer::notifyReady() {
+    {
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+        ready_ = true;
+    }
+    ready_cv_.notify_all();
+}
+
+std::size_t MockSlmpServer::completeFrameLength(const std::vector<std::uint8_t>& buffer) {
+    auto hexValue = [&](std::size_t offset) {
+        std::size_t value = 0;
+        for (std::size_t i = 0; i < 4; ++i) {
+            const char c = static_cast<char>(buffer[offset + i]);
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= static_cast<std::size_t>(c - '0');
+            } else if (c >= 'A' && c <= 'F') {
+                value |= static_cast<std::size_t>(c - 'A' + 10);
+            }
+        }
+        return value;
+    };
+
+    if (buffer.empty()) {
+        return 0;
+    }
+
+    std::size_t header_size = 0;
+    bool ascii = false;
+    if (buffer[0] == 0x50 || buffer[0] == 0x54) {
+        if (buffer.size() < 2) {
+            return 0;
+        }
+        if (buffer[1] != 0x00) {
+            return buffer.size();
+        }
+        header_size = (buffer[0] == 0x54) ? 13 : 9;
+    } else if (buffer[0] == '5') {
+        if (buffer.size() < 4) {
+            return 0;
+        }
+        if ((buffer[1] != '0' && buffer[1] != '4') || buffer[2] != '0' || buffer[3] != '0') {
+            return buffer.size();
+        }
+        header_size = (buffer[1] == '4') ? 26 : 18;
+        ascii = true;
+    } else {
+        return buffer.size();
+    }
+
+    if (buffer.size() < header_size) {
+        return 0;
+    }
+    const std::size_t body = ascii ? hexValue(header_size - 4)
+                                   : static_cast<std::size_t>(buffer[header_size - 2] | (buffer[header_size - 1] << 8));
+    const std::size_t total = header_size + body;
+    return buffer.size() >= total ? total : 0;
 }
 
 void MockSlmpServer::stop() {
@@ -62,6 +143,17 @@ void MockSlmpServer::stop() {
         return;
     }
     wakeListener();
+    {
+        // Wake a recv() blocked on an idle client so the server thread can exit.
+        std::lock_guard<std::mutex> lock(client_mutex_);
+        if (client_ != -1) {
+#ifdef _WIN32
+            ::shutdown(static_cast<SocketHandle>(client_), SD_BOTH);
+#else
+            ::shutdown(static_cast<SocketHandle>(client_), SHUT_RDWR);
+#endif
+        }
+    }
     if (thread_.joinable()) {
         thread_.join();
     }
@@ -79,6 +171,7 @@ void MockSlmpServer::run(std::uint16_t port, Handler handler) {
     SocketHandle listen_socket = ::socket(AF_INET, SOCK_STREAM, 0);
     if (listen_socket == kInvalidSocket) {
         running_ = false;
+        notifyReady();
         return;
     }
 
@@ -99,15 +192,19 @@ void MockSlmpServer::run(std::uint16_t port, Handler handler) {
     if (::bind(listen_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
         closeSocket(listen_socket);
         running_ = false;
+        notifyReady();
         return;
     }
 
     if (::listen(listen_socket, 1) < 0) {
         closeSocket(listen_socket);
         running_ = false;
+        notifyReady();
         return;
     }
 
+    notifyReady();
+
     while (running_.load()) {
         fd_set readfds;
         FD_ZERO(&readfds);
@@ -153,23 +250,49 @@ void MockSlmpServer::run(std::uint16_t port, Handler handler) {
         if (client == kInvalidSocket) {
             continue;
         }
+        {
+            std::lock_guard<std::mutex> lock(client_mutex_);
+            client_ = static_cast<std::intptr_t>(client);
+        }
 
-        while (running_.load()) {
+        // 1 回の recv に複数フレームが含まれる場合（パイプライン送信）に備え、フレーム単位で切り出す。
+        std::vector<std::uint8_t> pending;
+        bool client_open = true;
+        while (running_.load() && client_open) {
             std::vector<std::uint8_t> buffer(2048);
             const int received =
                 ::recv(client, reinterpret_cast<char*>(buffer.data()), static_cast<int>(buffer.size()), 0);
             if (received <= 0) {
                 break;
             }
-            buffer.resize(static_cast<std::size_t>(received));
-            auto response = handler(buffer);
-            if (!response.empty()) {
-                ::send(client, reinterpret_cast<const char*>(response.data()),
-                        static_cast<int>(response.size()), 0);
+            pending.insert(pending.end(), buffer.begin(), buffer.begin() + received);
+
+            std::size_t frame_length = 0;
+            while ((frame_length = completeFrameLength(pending)) > 0) {
+                std::vector<std::uint8_t> request(pending.begin(), pending.begin() + frame_length);
+                pending.erase(pending.begin(), pending.begin() + frame_length);
+                auto response = handler(request);
+                if (!response.empty()) {
+#ifdef MSG_NOSIGNAL
+                    // クライアントが応答の途中で切断しても SIGPIPE でテストを終了させない
+                    constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+                    constexpr int kSendFlags = 0;
+#endif
+                    if (::send(client, reinterpret_cast<const char*>(response.data()),
+                               static_cast<int>(response.size()), kSendFlags) < 0) {
+                        client_open = false;
+                        break;
+                    }
+                }
             }
         }
 
-        closeSocket(client);
+        {
+            std::lock_guard<std::mutex> lock(client_mutex_);
+            client_ = -1;
+            closeSocket(client);
+        }
     }
 
     running_ = false;
@@ -1,13 +1,22 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <mutex>
 #include <thread>
 #include <vector>
 
 namespace cpmcprotocol::testutil {
 
+// Binary 4E response to request: echoes the serial number and route fields back, then appends
+// the completion code and payload.
+std::vector<std::uint8_t> make4EBinaryResponse(const std::vector<std::uint8_t>& request,
+                                               const std::vector<std::uint8_t>& payload,
+                                               std::uint16_t completion = 0x0000);
+
 class MockSlmpServer {
 public:
     using Handler = std::function<std::vector<std::uint8_t>(const std::vector<std::uint8_t>&)>;
@@ -19,16 +28,28 @@ public:
     MockSlmpServer& operator=(const MockSlmpServer&) = delete;
 
     void start(std::uint16_t port, Handler handler);
+    // Stops listening and closes the active client connection (the client sees the peer close).
     void stop();
     bool isRunning() const;
 
 private:
     void run(std::uint16_t port, Handler handler);
     void wakeListener();
+    void notifyReady();
+
+    // Length of the first complete MC request frame in buffer, 0 if more data is needed.
+    // Unknown (non-MC) data is passed through as a single chunk.
+    static std::size_t completeFrameLength(const std::vector<std::uint8_t>& buffer);
 
     std::atomic<bool> running_{false};
+    std::mutex ready_mutex_;
+    std::condition_variable ready_cv_;
+    bool ready_ = false;
     std::atomic<std::uint16_t> port_{0};
     std::thread thread_;
+    // Connection being served (-1 if none). Guarded by client_mutex_ so stop() can shut it down.
+    std::mutex client_mutex_;
+    std::intptr_t client_ = -1;
 };
 
 } // namespace cpmcprotocol::testutil